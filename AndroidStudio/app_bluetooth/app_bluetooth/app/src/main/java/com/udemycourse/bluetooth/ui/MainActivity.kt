@@ -177,7 +177,8 @@ class MainActivity : AppCompatActivity() {
                 val value = characteristic.value
                 val buffer = ByteBuffer.wrap(value).order(ByteOrder.LITTLE_ENDIAN)
 
-                val sensorSizeBytes = 5 * 4
+                // 5 floats y la edad de la medida en segundos (uint32)
+                val sensorSizeBytes = 6 * 4
 
                 val numRecords = value.size / sensorSizeBytes
                 Log.d("BLE_RECEIVED", "ALL_SENSORS → Recibidos $numRecords registros:")
@@ -188,6 +189,7 @@ class MainActivity : AppCompatActivity() {
                     val humSoil = buffer.float
                     val lux = buffer.float
                     val batt = buffer.float
+                    val edadS = buffer.int.toLong() and 0xFFFFFFFFL
 
                     bleViewModel.addTemp(temp)
                     bleViewModel.addHumAir(humAir)
@@ -195,7 +197,7 @@ class MainActivity : AppCompatActivity() {
                     bleViewModel.addLux(lux)
                     bleViewModel.addBatt(batt)
 
-                    Log.d("BLE_RECEIVED", "   #${i+1} → Temp=$temp | HumAir=$humAir | HumSoil=$humSoil | Lux=$lux | Batt=$batt")
+                    Log.d("BLE_RECEIVED", "   #${i+1} → Temp=$temp | HumAir=$humAir | HumSoil=$humSoil | Lux=$lux | Batt=$batt | Edad=${edadS}s")
                 }
 
                 bleViewModel.lastConnectionTime = System.currentTimeMillis()
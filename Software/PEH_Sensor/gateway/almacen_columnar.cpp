@@ -0,0 +1,567 @@
+#include "almacen_columnar.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#define BYTES_FILA_COLA (8 + NUM_CAMPOS * 4)
+#define BYTES_CABECERA_BLOQUE ((1 + NUM_CAMPOS) * 4) // bytes de cada columna
+
+// --- BITS ---
+
+class EscritorBits
+{
+public:
+  explicit EscritorBits(std::vector<uint8_t> &salida) : _salida(salida) {}
+
+  void escribir(uint64_t valor, int bits)
+  {
+    if (bits > 32)
+    {
+      escribir(valor >> 32, bits - 32);
+      bits = 32;
+    }
+    _acumulado = _acumulado << bits | (valor & ((1ull << bits) - 1));
+    _bits += bits;
+    while (_bits >= 8)
+    {
+      _bits -= 8;
+      _salida.push_back((uint8_t)(_acumulado >> _bits));
+    }
+  }
+
+  void terminar()
+  {
+    if (_bits)
+      _salida.push_back((uint8_t)(_acumulado << (8 - _bits)));
+    _bits = 0;
+  }
+
+private:
+  std::vector<uint8_t> &_salida;
+  uint64_t _acumulado = 0;
+  int _bits = 0;
+};
+
+class LectorBits
+{
+public:
+  LectorBits(const uint8_t *datos, size_t bytes) : _p(datos), _fin(datos + bytes) {}
+
+  uint64_t leer(int bits)
+  {
+    if (bits > 32)
+    {
+      uint64_t alto = leer(bits - 32);
+      return alto << 32 | leer(32);
+    }
+    if (_bits < bits)
+      rellenar();
+    _bits -= bits;
+    return (_acumulado >> _bits) & ((1ull << bits) - 1);
+  }
+
+  bool bit() { return leer(1) != 0; }
+
+private:
+  void rellenar()
+  {
+    while (_bits <= 56)
+    {
+      _acumulado = _acumulado << 8 | (_p < _fin ? *_p++ : 0);
+      _bits += 8;
+    }
+  }
+
+  const uint8_t *_p;
+  const uint8_t *_fin;
+  uint64_t _acumulado = 0;
+  int _bits = 0;
+};
+
+// --- CODIFICACIÓN ---
+
+// Delta de deltas en zigzag con prefijos de longitud variable. Con muestras periódicas casi
+// todo cae en el '0' o en el '10'.
+static const int BITS_DOD[] = {7, 12, 20, 32};
+
+static void codificarMarcas(const std::vector<uint64_t> &marcas, std::vector<uint8_t> &salida)
+{
+  EscritorBits e(salida);
+  uint64_t anterior = 0;
+  int64_t deltaAnterior = 0;
+  for (size_t i = 0; i < marcas.size(); i++)
+  {
+    if (i == 0)
+    {
+      e.escribir(marcas[0], 64);
+      anterior = marcas[0];
+      continue;
+    }
+    int64_t delta = (int64_t)(marcas[i] - anterior);
+    int64_t dod = delta - deltaAnterior;
+    uint64_t z = ((uint64_t)dod << 1) ^ (uint64_t)(dod >> 63);
+    if (z == 0)
+      e.escribir(0, 1);
+    else
+    {
+      int caso = 0;
+      while (caso < 4 && z >> BITS_DOD[caso])
+        caso++;
+      // caso k: k+1 unos y un cero de prefijo; el último (k = 4) son cinco unos y 64 bits
+      e.escribir(caso < 4 ? ((1u << (caso + 2)) - 2) : 0x1F, caso < 4 ? caso + 2 : 5);
+      e.escribir(z, caso < 4 ? BITS_DOD[caso] : 64);
+    }
+    anterior = marcas[i];
+    deltaAnterior = delta;
+  }
+  e.terminar();
+}
+
+static void decodificarMarcas(const uint8_t *datos, size_t bytes, uint32_t n, std::vector<uint64_t> &marcas)
+{
+  LectorBits l(datos, bytes);
+  marcas.resize(n);
+  uint64_t anterior = 0;
+  int64_t delta = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (i == 0)
+    {
+      anterior = marcas[0] = l.leer(64);
+      continue;
+    }
+    if (l.bit())
+    {
+      int caso = 0;
+      while (caso < 4 && l.bit())
+        caso++;
+      uint64_t z = l.leer(caso < 4 ? BITS_DOD[caso] : 64);
+      delta += (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+    }
+    anterior += delta;
+    marcas[i] = anterior;
+  }
+}
+
+// XOR con el anterior; si los bits significativos caben en la ventana del último se
+// reutiliza, si no se manda una nueva (5 bits de ceros iniciales y 5 de longitud - 1)
+static void codificarFloats(const std::vector<float> &valores, std::vector<uint8_t> &salida)
+{
+  EscritorBits e(salida);
+  uint32_t anterior = 0;
+  int ceros = -1, finales = 0; // ventana: sin ventana todavía
+  for (size_t i = 0; i < valores.size(); i++)
+  {
+    uint32_t v;
+    memcpy(&v, &valores[i], 4);
+    if (i == 0)
+    {
+      e.escribir(v, 32);
+      anterior = v;
+      continue;
+    }
+    uint32_t x = v ^ anterior;
+    anterior = v;
+    if (!x)
+    {
+      e.escribir(0, 1);
+      continue;
+    }
+    int c = __builtin_clz(x);
+    int f = __builtin_ctz(x);
+    if (c > 31)
+      c = 31;
+    if (ceros >= 0 && c >= ceros && f >= finales)
+    {
+      e.escribir(0x2, 2);
+      e.escribir(x >> finales, 32 - ceros - finales);
+    }
+    else
+    {
+      int longitud = 32 - c - f;
+      e.escribir(0x3, 2);
+      e.escribir(c, 5);
+      e.escribir(longitud - 1, 5);
+      e.escribir(x >> f, longitud);
+      ceros = c;
+      finales = f;
+    }
+  }
+  e.terminar();
+}
+
+static void decodificarFloats(const uint8_t *datos, size_t bytes, uint32_t n, std::vector<float> &valores)
+{
+  LectorBits l(datos, bytes);
+  valores.resize(n);
+  uint32_t anterior = 0;
+  int ceros = 0, finales = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (i == 0)
+      anterior = (uint32_t)l.leer(32);
+    else if (l.bit())
+    {
+      if (l.bit())
+      {
+        ceros = (int)l.leer(5);
+        int longitud = (int)l.leer(5) + 1;
+        finales = 32 - ceros - longitud;
+      }
+      anterior ^= (uint32_t)l.leer(32 - ceros - finales) << finales;
+    }
+    memcpy(&valores[i], &anterior, 4);
+  }
+}
+
+// --- FICHEROS ---
+
+AlmacenColumnar::~AlmacenColumnar()
+{
+  for (auto &par : _series)
+  {
+    SerieNodo &s = par.second;
+    if (s.col.datos)
+      munmap((void *)s.col.datos, s.col.bytes);
+    if (s.idx.datos)
+      munmap((void *)s.idx.datos, s.idx.bytes);
+    if (s.cola)
+      fclose(s.cola);
+    if (s.fdCol >= 0)
+      close(s.fdCol);
+    if (s.fdIdx >= 0)
+      close(s.fdIdx);
+  }
+}
+
+std::string AlmacenColumnar::ruta(uint64_t nodo, const char *extension) const
+{
+  return _directorio + "/" + nombreNodo(nodo) + extension;
+}
+
+AlmacenColumnar::SerieNodo *AlmacenColumnar::serie(uint64_t nodo, bool crear)
+{
+  auto it = _series.find(nodo);
+  if (it != _series.end())
+    return &it->second;
+  if (!crear && access(ruta(nodo, ".idx").c_str(), F_OK) != 0)
+    return nullptr;
+  SerieNodo &s = _series[nodo];
+  if (!abrir(nodo, s))
+  {
+    _series.erase(nodo);
+    return nullptr;
+  }
+  return &s;
+}
+
+// Deja los tres ficheros coherentes tras una caída: un bloque escrito en .col sin su
+// entrada en .idx se descarta y la cola solo vale si es del bloque que sigue al último
+bool AlmacenColumnar::abrir(uint64_t nodo, SerieNodo &s)
+{
+  std::string rutaCol = ruta(nodo, ".col"), rutaIdx = ruta(nodo, ".idx");
+  s.fdCol = open(rutaCol.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  s.fdIdx = open(rutaIdx.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (s.fdCol < 0 || s.fdIdx < 0)
+  {
+    perror(rutaCol.c_str());
+    return false;
+  }
+
+  struct stat col, idx;
+  fstat(s.fdCol, &col);
+  fstat(s.fdIdx, &idx);
+  s.bloques = (uint32_t)(idx.st_size / sizeof(EntradaIndice));
+  s.bytesCol = 0;
+  while (s.bloques)
+  {
+    EntradaIndice ultima;
+    if (pread(s.fdIdx, &ultima, sizeof(ultima), (off_t)(s.bloques - 1) * sizeof(ultima)) != (ssize_t)sizeof(ultima))
+      return false;
+    if (ultima.posicion + ultima.bytes <= (uint64_t)col.st_size)
+    {
+      s.bytesCol = ultima.posicion + ultima.bytes;
+      break;
+    }
+    s.bloques--;
+  }
+  if (((uint64_t)idx.st_size != (uint64_t)s.bloques * sizeof(EntradaIndice) &&
+       ftruncate(s.fdIdx, (off_t)s.bloques * sizeof(EntradaIndice)) < 0) ||
+      ((uint64_t)col.st_size != s.bytesCol && ftruncate(s.fdCol, (off_t)s.bytesCol) < 0))
+  {
+    perror(rutaCol.c_str());
+    return false;
+  }
+
+  s.cola = fopen(ruta(nodo, ".cola").c_str(), "r+b");
+  uint32_t bloqueCola;
+  if (!s.cola || fread(&bloqueCola, 4, 1, s.cola) != 1 || bloqueCola != s.bloques)
+    return empezarCola(nodo, s);
+  uint8_t fila[BYTES_FILA_COLA];
+  while (s.abierto.size() < REGISTROS_BLOQUE && fread(fila, sizeof(fila), 1, s.cola) == 1)
+  {
+    Fila r;
+    memcpy(&r.marcaUs, fila, 8);
+    memcpy(r.valor, fila + 8, sizeof(r.valor));
+    s.abierto.push_back(r);
+  }
+  // Una fila a medias al final no debe quedar delante de las nuevas
+  long fin = 4 + (long)s.abierto.size() * BYTES_FILA_COLA;
+  if (fseek(s.cola, fin, SEEK_SET) != 0 || ftruncate(fileno(s.cola), fin) < 0)
+    return false;
+  return s.abierto.size() < REGISTROS_BLOQUE || cerrarBloque(nodo, s);
+}
+
+// Vacía la cola y la marca con el bloque que empieza
+bool AlmacenColumnar::empezarCola(uint64_t nodo, SerieNodo &s)
+{
+  if (s.cola)
+  {
+    fflush(s.cola);
+    if (ftruncate(fileno(s.cola), 0) < 0)
+      return false;
+    rewind(s.cola);
+  }
+  else
+  {
+    std::string rutaCola = ruta(nodo, ".cola");
+    s.cola = fopen(rutaCola.c_str(), "wb");
+    if (!s.cola)
+    {
+      perror(rutaCola.c_str());
+      return false;
+    }
+  }
+  return fwrite(&s.bloques, 4, 1, s.cola) == 1;
+}
+
+bool AlmacenColumnar::anadir(uint64_t nodo, uint64_t marcaUs, const VistaRegistro &registro)
+{
+  SerieNodo *s = serie(nodo, true);
+  if (!s)
+    return false;
+  if (!s->abierto.empty() && marcaUs / DURACION_MAX_BLOQUE_US != s->abierto.front().marcaUs / DURACION_MAX_BLOQUE_US &&
+      !cerrarBloque(nodo, *s))
+    return false;
+  Fila r;
+  r.marcaUs = marcaUs;
+  memcpy(r.valor, registro.bytes(), sizeof(r.valor));
+  s->abierto.push_back(r);
+  if (fwrite(&r.marcaUs, 8, 1, s->cola) != 1 || fwrite(r.valor, sizeof(r.valor), 1, s->cola) != 1)
+  {
+    s->abierto.pop_back();
+    return false;
+  }
+  return s->abierto.size() < REGISTROS_BLOQUE || cerrarBloque(nodo, *s);
+}
+
+void AlmacenColumnar::sincronizar()
+{
+  for (auto &par : _series)
+    fflush(par.second.cola);
+}
+
+uint64_t AlmacenColumnar::bytesDisco(uint64_t nodo)
+{
+  SerieNodo *s = serie(nodo, false);
+  return s ? s->bytesCol + (uint64_t)s->bloques * sizeof(EntradaIndice) + 4 + s->abierto.size() * BYTES_FILA_COLA : 0;
+}
+
+// --- BLOQUES ---
+
+static double tramo(uint64_t t0, float v0, uint64_t t1, float v1)
+{
+  return t1 - t0 <= HUECO_MAX_INTEGRAL_US ? (t1 - t0) / 1e6 * (v0 + v1) * 0.5 : 0;
+}
+
+bool AlmacenColumnar::cerrarBloque(uint64_t nodo, SerieNodo &s)
+{
+  const std::vector<Fila> &filas = s.abierto;
+  EntradaIndice e = {};
+  e.posicion = s.bytesCol;
+  e.registros = (uint32_t)filas.size();
+  e.tMinUs = filas.front().marcaUs;
+  e.tMaxUs = filas.back().marcaUs;
+
+  std::vector<uint8_t> bloque(BYTES_CABECERA_BLOQUE);
+  std::vector<uint64_t> marcas(filas.size());
+  for (size_t i = 0; i < filas.size(); i++)
+  {
+    marcas[i] = filas[i].marcaUs;
+    e.tMinUs = std::min(e.tMinUs, marcas[i]);
+    e.tMaxUs = std::max(e.tMaxUs, marcas[i]);
+  }
+  size_t inicio = bloque.size();
+  codificarMarcas(marcas, bloque);
+  uint32_t bytesColumna = (uint32_t)(bloque.size() - inicio);
+  memcpy(&bloque[0], &bytesColumna, 4);
+
+  std::vector<float> valores(filas.size());
+  for (int c = 0; c < NUM_CAMPOS; c++)
+  {
+    e.minimo[c] = INFINITY;
+    e.maximo[c] = -INFINITY;
+    for (size_t i = 0; i < filas.size(); i++)
+    {
+      float v = valores[i] = filas[i].valor[c];
+      e.minimo[c] = std::min(e.minimo[c], v);
+      e.maximo[c] = std::max(e.maximo[c], v);
+      e.suma[c] += v;
+      if (i)
+        e.integral[c] += tramo(marcas[i - 1], valores[i - 1], marcas[i], v);
+    }
+    e.primero[c] = valores.front();
+    e.ultimo[c] = valores.back();
+    inicio = bloque.size();
+    codificarFloats(valores, bloque);
+    bytesColumna = (uint32_t)(bloque.size() - inicio);
+    memcpy(&bloque[4 * (1 + c)], &bytesColumna, 4);
+  }
+  e.bytes = (uint32_t)bloque.size();
+
+  // Primero el bloque y luego su entrada: abrir() descarta un bloque sin entrada
+  if (write(s.fdCol, bloque.data(), bloque.size()) != (ssize_t)bloque.size() ||
+      write(s.fdIdx, &e, sizeof(e)) != (ssize_t)sizeof(e))
+  {
+    perror(nombreNodo(nodo).c_str());
+    return false;
+  }
+  s.bytesCol += bloque.size();
+  s.bloques++;
+  s.abierto.clear();
+  return empezarCola(nodo, s);
+}
+
+void AlmacenColumnar::proyectar(SerieNodo &s)
+{
+  uint64_t bytesIdx = (uint64_t)s.bloques * sizeof(EntradaIndice);
+  if (s.col.bytes == s.bytesCol && s.idx.bytes == bytesIdx)
+    return;
+  if (s.col.datos)
+    munmap((void *)s.col.datos, s.col.bytes);
+  if (s.idx.datos)
+    munmap((void *)s.idx.datos, s.idx.bytes);
+  s.col = Proyeccion();
+  s.idx = Proyeccion();
+  if (!s.bloques)
+    return;
+  void *col = mmap(nullptr, s.bytesCol, PROT_READ, MAP_SHARED, s.fdCol, 0);
+  void *idx = mmap(nullptr, bytesIdx, PROT_READ, MAP_SHARED, s.fdIdx, 0);
+  if (col != MAP_FAILED)
+    s.col = {(const uint8_t *)col, s.bytesCol};
+  if (idx != MAP_FAILED)
+    s.idx = {(const uint8_t *)idx, bytesIdx};
+}
+
+// --- CONSULTAS ---
+
+void AlmacenColumnar::recorrer(SerieNodo &s, CampoSerie campo, uint64_t desdeUs, uint64_t hastaUs, uint64_t intervaloUs,
+                               std::vector<Agregado> &salida)
+{
+  uint64_t rango = hastaUs - desdeUs;
+  salida.assign(rango / intervaloUs + (rango % intervaloUs != 0), Agregado{0, INFINITY, -INFINITY, 0, 0});
+  bool hayAnterior = false;
+  uint64_t tAnterior = 0;
+  float vAnterior = 0;
+
+  auto dentro = [&](uint64_t t) { return t >= desdeUs && t < hastaUs; };
+  auto cubeta = [&](uint64_t t) -> Agregado & { return salida[(t - desdeUs) / intervaloUs]; };
+  // El tramo desde la muestra anterior cuenta para el intervalo en el que empieza
+  auto enlazar = [&](uint64_t t, float v) {
+    if (hayAnterior && dentro(tAnterior) && t >= tAnterior)
+      cubeta(tAnterior).integral += tramo(tAnterior, vAnterior, t, v);
+  };
+  auto muestra = [&](uint64_t t, float v) {
+    enlazar(t, v);
+    if (dentro(t))
+    {
+      Agregado &a = cubeta(t);
+      a.registros++;
+      a.minimo = std::min(a.minimo, v);
+      a.maximo = std::max(a.maximo, v);
+      a.suma += v;
+    }
+    hayAnterior = true;
+    tAnterior = t;
+    vAnterior = v;
+  };
+
+  proyectar(s);
+  const EntradaIndice *indice = (const EntradaIndice *)s.idx.datos;
+  uint32_t bloques = s.idx.datos && s.col.datos ? (uint32_t)(s.idx.bytes / sizeof(EntradaIndice)) : 0;
+  std::vector<uint64_t> marcas;
+  std::vector<float> valores;
+  bool terminado = false;
+  for (uint32_t b = 0; b < bloques && !terminado; b++)
+  {
+    const EntradaIndice &e = indice[b];
+    if (e.tMaxUs < desdeUs)
+      continue;
+    if (e.tMinUs >= hastaUs)
+    {
+      enlazar(e.tMinUs, e.primero[campo]); // el tramo que sale del rango
+      terminado = true;
+      break;
+    }
+    if (dentro(e.tMinUs) && dentro(e.tMaxUs) && (e.tMinUs - desdeUs) / intervaloUs == (e.tMaxUs - desdeUs) / intervaloUs)
+    {
+      enlazar(e.tMinUs, e.primero[campo]);
+      Agregado &a = cubeta(e.tMinUs);
+      a.registros += e.registros;
+      a.minimo = std::min(a.minimo, e.minimo[campo]);
+      a.maximo = std::max(a.maximo, e.maximo[campo]);
+      a.suma += e.suma[campo];
+      a.integral += e.integral[campo];
+      hayAnterior = true;
+      tAnterior = e.tMaxUs;
+      vAnterior = e.ultimo[campo];
+      _estadisticas.bloquesIndice++;
+      continue;
+    }
+
+    const uint8_t *bloque = s.col.datos + e.posicion;
+    uint32_t bytesColumna[1 + NUM_CAMPOS];
+    memcpy(bytesColumna, bloque, sizeof(bytesColumna));
+    const uint8_t *columna = bloque + BYTES_CABECERA_BLOQUE;
+    decodificarMarcas(columna, bytesColumna[0], e.registros, marcas);
+    columna += bytesColumna[0];
+    for (int c = 0; c < campo; c++)
+      columna += bytesColumna[1 + c];
+    decodificarFloats(columna, bytesColumna[1 + campo], e.registros, valores);
+    _estadisticas.bloquesDecodificados++;
+    for (uint32_t i = 0; i < e.registros && !terminado; i++)
+    {
+      muestra(marcas[i], valores[i]);
+      terminado = marcas[i] >= hastaUs;
+    }
+  }
+  for (size_t i = 0; i < s.abierto.size() && !terminado; i++)
+  {
+    muestra(s.abierto[i].marcaUs, s.abierto[i].valor[campo]);
+    terminado = s.abierto[i].marcaUs >= hastaUs;
+  }
+}
+
+void AlmacenColumnar::agregarPorIntervalo(uint64_t nodo, CampoSerie campo, uint64_t desdeUs, uint64_t hastaUs,
+                                          uint64_t intervaloUs, std::vector<Agregado> &salida)
+{
+  SerieNodo *s = serie(nodo, false);
+  if (!s || hastaUs <= desdeUs || !intervaloUs)
+  {
+    salida.clear();
+    return;
+  }
+  recorrer(*s, campo, desdeUs, hastaUs, intervaloUs, salida);
+}
+
+Agregado AlmacenColumnar::agregar(uint64_t nodo, CampoSerie campo, uint64_t desdeUs, uint64_t hastaUs)
+{
+  std::vector<Agregado> salida;
+  agregarPorIntervalo(nodo, campo, desdeUs, hastaUs, hastaUs > desdeUs ? hastaUs - desdeUs : 1, salida);
+  return salida.empty() ? Agregado{0, INFINITY, -INFINITY, 0, 0} : salida[0];
+}
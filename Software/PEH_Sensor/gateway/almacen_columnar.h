@@ -0,0 +1,137 @@
+// Almacén columnar por nodo. Los registros se agrupan en bloques de REGISTROS_BLOQUE y cada
+// bloque guarda una columna por campo comprimida como en Gorilla: las marcas de tiempo con
+// delta de deltas y los float con XOR respecto al anterior. Por nodo hay tres ficheros,
+// todos de solo añadir:
+//
+//   <nodo>.col   bloques cerrados, uno detrás de otro, de hasta REGISTROS_BLOQUE registros
+//                y sin cruzar el cambio de día
+//   <nodo>.idx   una EntradaIndice por bloque: posición, rango de tiempo y, por campo,
+//                mínimo, máximo, suma e integral; las consultas resuelven con ella los
+//                bloques que caen enteros en el rango sin leer sus columnas
+//   <nodo>.cola  el bloque abierto en filas sin comprimir, para no perderlo si el gateway
+//                se cae; se vacía al cerrar el bloque
+//
+// Las consultas leen .col e .idx proyectados en memoria (mmap). Los ficheros están en el
+// orden de bytes del host.
+
+#ifndef ALMACEN_COLUMNAR_H
+#define ALMACEN_COLUMNAR_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "almacen_series.h"
+
+#define REGISTROS_BLOQUE 1024
+// Un bloque no pasa de un día UTC: las consultas por días o más largas se resuelven solo
+// con el índice
+#define DURACION_MAX_BLOQUE_US (86400ull * 1000000)
+// Dos muestras más separadas que esto no se integran: el nodo estuvo sin medir o sin datos
+#define HUECO_MAX_INTEGRAL_US (3600ull * 1000000)
+
+enum CampoSerie
+{
+  CAMPO_TEMP,
+  CAMPO_HUM_AIRE,
+  CAMPO_HUM_SUELO,
+  CAMPO_LUX,
+  CAMPO_BATT,
+  NUM_CAMPOS
+};
+
+struct EntradaIndice
+{
+  uint64_t posicion; // en .col
+  uint32_t bytes;
+  uint32_t registros;
+  uint64_t tMinUs;
+  uint64_t tMaxUs;
+  float minimo[NUM_CAMPOS];
+  float maximo[NUM_CAMPOS];
+  float primero[NUM_CAMPOS]; // para integrar entre un bloque y el siguiente
+  float ultimo[NUM_CAMPOS];
+  double suma[NUM_CAMPOS];
+  double integral[NUM_CAMPOS]; // trapecios dentro del bloque, valor·s
+};
+
+// Resultado de una consulta sobre un campo. La integral es la de los tramos que empiezan
+// dentro del intervalo.
+struct Agregado
+{
+  uint64_t registros;
+  float minimo;
+  float maximo;
+  double suma;
+  double integral;
+
+  double media() const { return registros ? suma / registros : 0; }
+};
+
+struct EstadisticasConsulta
+{
+  uint64_t bloquesIndice;      // resueltos solo con el índice
+  uint64_t bloquesDecodificados;
+};
+
+class AlmacenColumnar : public AlmacenSeries
+{
+public:
+  explicit AlmacenColumnar(const std::string &directorio) : _directorio(directorio) {}
+  ~AlmacenColumnar() override;
+
+  bool anadir(uint64_t nodo, uint64_t marcaUs, const VistaRegistro &registro) override;
+  void sincronizar() override;
+
+  // Registros con marca en [desdeUs, hastaUs)
+  Agregado agregar(uint64_t nodo, CampoSerie campo, uint64_t desdeUs, uint64_t hastaUs);
+  // Lo mismo en intervalos consecutivos de intervaloUs empezando en desdeUs
+  void agregarPorIntervalo(uint64_t nodo, CampoSerie campo, uint64_t desdeUs, uint64_t hastaUs, uint64_t intervaloUs,
+                           std::vector<Agregado> &salida);
+
+  EstadisticasConsulta estadisticas() const { return _estadisticas; }
+  uint64_t bytesDisco(uint64_t nodo);
+
+private:
+  struct Fila
+  {
+    uint64_t marcaUs;
+    float valor[NUM_CAMPOS];
+  };
+
+  struct Proyeccion
+  {
+    const uint8_t *datos = nullptr;
+    size_t bytes = 0;
+  };
+
+  struct SerieNodo
+  {
+    int fdCol = -1;
+    int fdIdx = -1;
+    FILE *cola = nullptr;
+    uint64_t bytesCol = 0;
+    uint32_t bloques = 0;
+    std::vector<Fila> abierto;
+    Proyeccion col;
+    Proyeccion idx;
+  };
+
+  SerieNodo *serie(uint64_t nodo, bool crear);
+  bool abrir(uint64_t nodo, SerieNodo &s);
+  bool cerrarBloque(uint64_t nodo, SerieNodo &s);
+  bool empezarCola(uint64_t nodo, SerieNodo &s);
+  void proyectar(SerieNodo &s);
+  // Recorre los registros en [desde, hasta) de un campo, usando el índice cuando un bloque
+  // cae entero en un mismo intervalo
+  void recorrer(SerieNodo &s, CampoSerie campo, uint64_t desdeUs, uint64_t hastaUs, uint64_t intervaloUs,
+                std::vector<Agregado> &salida);
+  std::string ruta(uint64_t nodo, const char *extension) const;
+
+  std::string _directorio;
+  std::unordered_map<uint64_t, SerieNodo> _series;
+  EstadisticasConsulta _estadisticas = {};
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include "almacen_series.h"
+
+#include <string.h>
+
+std::string nombreNodo(uint64_t direccion)
+{
+  char nombre[13];
+  snprintf(nombre, sizeof(nombre), "%012llx", (unsigned long long)(direccion & 0xFFFFFFFFFFFFull));
+  return nombre;
+}
+
+// --- PLANO ---
+
+AlmacenPlano::~AlmacenPlano()
+{
+  for (auto &f : _ficheros)
+    fclose(f.second);
+}
+
+bool AlmacenPlano::anadir(uint64_t nodo, uint64_t marcaUs, const VistaRegistro &registro)
+{
+  FILE *&f = _ficheros[nodo];
+  if (!f)
+  {
+    std::string ruta = _directorio + "/" + nombreNodo(nodo) + ".plano";
+    f = fopen(ruta.c_str(), "ab");
+    if (!f)
+    {
+      perror(ruta.c_str());
+      _ficheros.erase(nodo);
+      return false;
+    }
+  }
+  uint8_t fila[BYTES_FILA_PLANO];
+  memcpy(fila, &marcaUs, 8);
+  memcpy(fila + 8, registro.bytes(), BYTES_REGISTRO);
+  return fwrite(fila, sizeof(fila), 1, f) == 1;
+}
+
+void AlmacenPlano::sincronizar()
+{
+  for (auto &f : _ficheros)
+    fflush(f.second);
+}
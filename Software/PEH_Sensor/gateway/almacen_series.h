@@ -0,0 +1,44 @@
+// Dónde guarda el gateway los registros de cada nodo. La ingesta solo añade al final; el
+// nodo se identifica por su dirección BLE y cada registro lleva la marca de recepción,
+// porque los paquetes no traen la hora de la medida.
+
+#ifndef ALMACEN_SERIES_H
+#define ALMACEN_SERIES_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include "protocolo.h"
+
+class AlmacenSeries
+{
+public:
+  virtual ~AlmacenSeries() {}
+  virtual bool anadir(uint64_t nodo, uint64_t marcaUs, const VistaRegistro &registro) = 0;
+  // Lo añadido hasta ahora queda en disco
+  virtual void sincronizar() = 0;
+};
+
+// "aabbccddeeff": nombre de fichero de un nodo
+std::string nombreNodo(uint64_t direccion);
+
+// Un fichero binario por nodo con filas de marca (u64) y los 5 float tal cual llegaron:
+// lo mínimo que se puede hacer, y la referencia con la que comparar otros formatos
+class AlmacenPlano : public AlmacenSeries
+{
+public:
+  explicit AlmacenPlano(const std::string &directorio) : _directorio(directorio) {}
+  ~AlmacenPlano() override;
+
+  bool anadir(uint64_t nodo, uint64_t marcaUs, const VistaRegistro &registro) override;
+  void sincronizar() override;
+
+private:
+  std::string _directorio;
+  std::unordered_map<uint64_t, FILE *> _ficheros;
+};
+
+#define BYTES_FILA_PLANO (8 + BYTES_REGISTRO)
+
+#endif
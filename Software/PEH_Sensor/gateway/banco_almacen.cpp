@@ -0,0 +1,352 @@
+// Banco del almacén del gateway: varios años de registros sintéticos de varios nodos
+// guardados en CSV, en el formato plano (AlmacenPlano) y en el columnar, con el tamaño en
+// disco, lo que cuesta escribirlos y lo que tardan tres consultas típicas:
+//
+//   media diaria de lux de todo el histórico
+//   batería mínima de los últimos 30 días
+//   energía recogida por hora durante una semana (integral de lux por el panel)
+//
+// El CSV y el plano se recorren fila a fila desde el principio del rango (el plano busca
+// el principio por bisección, sus filas son de tamaño fijo); el columnar resuelve con el
+// índice los bloques que caen enteros en un intervalo. Los ficheros se leen con la caché
+// de páginas caliente.
+//
+//   c++ -std=c++17 -O2 -Wall -o banco_almacen banco_almacen.cpp almacen_columnar.cpp almacen_series.cpp
+//   ./banco_almacen [nodos=10] [años=3] [directorio=/tmp/banco_almacen]
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <functional>
+#include "almacen_columnar.h"
+
+#define PERIODO_US (10ull * 60 * 1000000) // MEASURE_CYCLE_MINUTES
+#define JITTER_US 2000                    // del temporizador de despertar
+#define US_POR_DIA (86400ull * 1000000)
+#define US_POR_HORA (3600ull * 1000000)
+#define INICIO_US 1700006400000000ull // medianoche UTC
+#define W_POR_LUX 5e-6 // panel de 0,5 W a 100 klx
+#define ADC_SUELO_SECO 3100
+#define ADC_SUELO_MOJADO 1300
+
+// --- DATOS SINTÉTICOS ---
+
+static uint32_t azar = 1;
+
+static uint32_t siguiente()
+{
+  azar ^= azar << 13;
+  azar ^= azar >> 17;
+  azar ^= azar << 5;
+  return azar;
+}
+
+static float ruido(float amplitud)
+{
+  return ((siguiente() >> 8) * (1.0f / 16777216.0f) * 2 - 1) * amplitud;
+}
+
+// Como sale de cada sensor: SHTC3 en cuentas de 16 bits, VEML7700 en cuentas de
+// VEML_LUX_POR_CUENTA, ADC de 12 bits para el suelo e INA226 a 1,25 mV
+static void muestraSintetica(uint64_t nodo, uint64_t t, float v[NUM_CAMPOS])
+{
+  double dias = (double)(t - INICIO_US) / US_POR_DIA;
+  double hora = fmod(dias, 1.0) * 24;
+  double estacion = sin(2 * M_PI * (dias - 80) / 365.25);
+  double sol = sin(M_PI * (hora - 6.0 - estacion) / (12.0 + 2 * estacion));
+  double diario = sin(2 * M_PI * (hora - 9.0) / 24.0);
+  float sombra = 0.5f + 0.05f * (nodo % 10);
+
+  double temp = 14 + 8 * estacion + 6 * diario + ruido(0.15f);
+  double hum = 60 - 15 * diario + ruido(0.8f);
+  double suelo = ADC_SUELO_SECO - (ADC_SUELO_SECO - ADC_SUELO_MOJADO) * fabs(cos(M_PI * dias / 9)) + ruido(8);
+  double nubes = 0.6 + 0.4 * fabs(ruido(1.0f));
+  double lux = sol > 0 ? sol * (25000 + 15000 * estacion) * sombra * nubes : 0;
+  double batt = 3.85 + 0.1 * (sol > 0 ? sol : 0) + ruido(0.005f);
+
+  v[CAMPO_TEMP] = -45 + 175 * (float)(uint16_t)((temp + 45) / 175 * 65536) / 65536;
+  v[CAMPO_HUM_AIRE] = 100 * (float)(uint16_t)(hum / 100 * 65536) / 65536;
+  v[CAMPO_HUM_SUELO] = (float)(int)suelo;
+  v[CAMPO_LUX] = (uint16_t)std::min(lux / 0.0576, 65535.0) * 0.0576f;
+  v[CAMPO_BATT] = (uint16_t)(batt / 1.25e-3) * 1.25e-3f;
+}
+
+// --- LÍNEA BASE ---
+
+// Misma semántica que AlmacenColumnar::recorrer() para que los resultados coincidan
+class Acumulador
+{
+public:
+  Acumulador(uint64_t desde, uint64_t hasta, uint64_t intervalo)
+      : _desde(desde), _hasta(hasta), _intervalo(intervalo),
+        salida((hasta - desde) / intervalo + ((hasta - desde) % intervalo != 0), Agregado{0, INFINITY, -INFINITY, 0, 0})
+  {
+  }
+
+  // false cuando ya no hace falta seguir
+  bool muestra(uint64_t t, float v)
+  {
+    if (_hay && dentro(_tAnt) && t >= _tAnt && t - _tAnt <= HUECO_MAX_INTEGRAL_US)
+      salida[(_tAnt - _desde) / _intervalo].integral += (t - _tAnt) / 1e6 * (v + _vAnt) * 0.5;
+    if (dentro(t))
+    {
+      Agregado &a = salida[(t - _desde) / _intervalo];
+      a.registros++;
+      a.minimo = std::min(a.minimo, v);
+      a.maximo = std::max(a.maximo, v);
+      a.suma += v;
+    }
+    _hay = true;
+    _tAnt = t;
+    _vAnt = v;
+    return t < _hasta;
+  }
+
+private:
+  bool dentro(uint64_t t) const { return t >= _desde && t < _hasta; }
+  uint64_t _desde, _hasta, _intervalo;
+  bool _hay = false;
+  uint64_t _tAnt = 0;
+  float _vAnt = 0;
+
+public:
+  std::vector<Agregado> salida;
+};
+
+struct Proyectado
+{
+  const uint8_t *datos;
+  size_t bytes;
+};
+
+static Proyectado proyectar(const std::string &ruta)
+{
+  int fd = open(ruta.c_str(), O_RDONLY);
+  struct stat st;
+  fstat(fd, &st);
+  void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  return {(const uint8_t *)p, (size_t)st.st_size};
+}
+
+static std::vector<Agregado> consultarPlano(const std::string &ruta, CampoSerie campo, uint64_t desde, uint64_t hasta,
+                                            uint64_t intervalo)
+{
+  Proyectado f = proyectar(ruta);
+  size_t filas = f.bytes / BYTES_FILA_PLANO;
+  auto marca = [&](size_t i) {
+    uint64_t t;
+    memcpy(&t, f.datos + i * BYTES_FILA_PLANO, 8);
+    return t;
+  };
+  size_t a = 0, b = filas;
+  while (a < b)
+  {
+    size_t m = (a + b) / 2;
+    if (marca(m) < desde)
+      a = m + 1;
+    else
+      b = m;
+  }
+  Acumulador acc(desde, hasta, intervalo);
+  for (size_t i = a; i < filas; i++)
+  {
+    const uint8_t *fila = f.datos + i * BYTES_FILA_PLANO;
+    if (!acc.muestra(marca(i), leerF32LE(fila + 8 + 4 * campo)))
+      break;
+  }
+  munmap((void *)f.datos, f.bytes);
+  return acc.salida;
+}
+
+static std::vector<Agregado> consultarCSV(const std::string &ruta, CampoSerie campo, uint64_t desde, uint64_t hasta,
+                                          uint64_t intervalo)
+{
+  Acumulador acc(desde, hasta, intervalo);
+  FILE *f = fopen(ruta.c_str(), "r");
+  char linea[256];
+  bool cabecera = true;
+  while (fgets(linea, sizeof(linea), f))
+  {
+    if (cabecera)
+    {
+      cabecera = false;
+      continue;
+    }
+    char *p;
+    uint64_t t = strtoull(linea, &p, 10);
+    if (t < desde)
+      continue;
+    float v = 0;
+    for (int c = 0; c <= campo; c++)
+      v = strtof(p + 1, &p);
+    if (!acc.muestra(t, v))
+      break;
+  }
+  fclose(f);
+  return acc.salida;
+}
+
+// --- BANCO ---
+
+static double segundosDesde(std::chrono::steady_clock::time_point inicio)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+static uint64_t bytesFichero(const std::string &ruta)
+{
+  struct stat st;
+  return stat(ruta.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+struct Consulta
+{
+  const char *nombre;
+  CampoSerie campo;
+  uint64_t desde;
+  uint64_t hasta;
+  uint64_t intervalo;
+};
+
+static double resumen(const std::vector<Agregado> &a, const Consulta &q)
+{
+  // Un número por consulta para comprobar que los tres formatos dicen lo mismo
+  double r = 0;
+  for (const Agregado &x : a)
+    r += q.campo == CAMPO_BATT ? (x.registros ? x.minimo : 0) : q.intervalo == US_POR_HORA ? x.integral : x.media();
+  return r;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t nodos = argc > 1 ? (uint32_t)atoi(argv[1]) : 10;
+  double anos = argc > 2 ? atof(argv[2]) : 3;
+  std::string dir = argc > 3 ? argv[3] : "/tmp/banco_almacen";
+  uint64_t duracion = (uint64_t)(anos * 365 * US_POR_DIA);
+  uint64_t registros = duracion / PERIODO_US;
+  mkdir(dir.c_str(), 0755);
+  for (const char *sub : {"/csv", "/plano", "/columnar"})
+  {
+    std::string d = dir + sub;
+    mkdir(d.c_str(), 0755);
+    if (system(("rm -f " + d + "/*").c_str()) != 0)
+      return 1;
+  }
+
+  printf("%u nodos x %.1f años = %llu registros por nodo, %llu en total\n\n", nodos, anos,
+         (unsigned long long)registros, (unsigned long long)registros * nodos);
+
+  // Las tres escrituras con los mismos datos: se generan una vez por nodo
+  double tCSV = 0, tPlano = 0, tColumnar = 0;
+  uint64_t bCSV = 0, bPlano = 0, bColumnar = 0;
+  {
+    AlmacenPlano plano(dir + "/plano");
+    AlmacenColumnar columnar(dir + "/columnar");
+    std::vector<uint64_t> marcas(registros);
+    std::vector<uint8_t> filas(registros * BYTES_REGISTRO);
+    for (uint32_t n = 0; n < nodos; n++)
+    {
+      uint64_t nodo = 0xC0FFEE000000ull + n;
+      azar = 0x9E3779B9u * (n + 1);
+      for (uint64_t i = 0; i < registros; i++)
+      {
+        marcas[i] = INICIO_US + i * PERIODO_US + siguiente() % JITTER_US;
+        float v[NUM_CAMPOS];
+        muestraSintetica(nodo, marcas[i], v);
+        memcpy(&filas[i * BYTES_REGISTRO], v, sizeof(v)); // la edad no se usa: las marcas ya son las de medida
+      }
+
+      auto inicio = std::chrono::steady_clock::now();
+      std::string rutaCSV = dir + "/csv/" + nombreNodo(nodo) + ".csv";
+      FILE *f = fopen(rutaCSV.c_str(), "w");
+      fprintf(f, "marca_us,temp,hum_aire,hum_suelo,lux,batt\n");
+      for (uint64_t i = 0; i < registros; i++)
+      {
+        VistaRegistro r(&filas[i * BYTES_REGISTRO]);
+        fprintf(f, "%llu,%.9g,%.9g,%.9g,%.9g,%.9g\n", (unsigned long long)marcas[i], r.temp(), r.humAir(), r.humSoil(),
+                r.lux(), r.batt());
+      }
+      fclose(f);
+      tCSV += segundosDesde(inicio);
+      bCSV += bytesFichero(rutaCSV);
+
+      inicio = std::chrono::steady_clock::now();
+      for (uint64_t i = 0; i < registros; i++)
+        plano.anadir(nodo, marcas[i], VistaRegistro(&filas[i * BYTES_REGISTRO]));
+      plano.sincronizar();
+      tPlano += segundosDesde(inicio);
+      bPlano += bytesFichero(dir + "/plano/" + nombreNodo(nodo) + ".plano");
+
+      inicio = std::chrono::steady_clock::now();
+      for (uint64_t i = 0; i < registros; i++)
+        columnar.anadir(nodo, marcas[i], VistaRegistro(&filas[i * BYTES_REGISTRO]));
+      columnar.sincronizar();
+      tColumnar += segundosDesde(inicio);
+      bColumnar += columnar.bytesDisco(nodo);
+    }
+  }
+
+  double total = (double)registros * nodos;
+  printf("%-10s %12s %9s %14s\n", "formato", "bytes", "B/reg", "escritura");
+  printf("%-10s %12llu %9.2f %10.2f Mreg/s\n", "CSV", (unsigned long long)bCSV, bCSV / total, total / tCSV / 1e6);
+  printf("%-10s %12llu %9.2f %10.2f Mreg/s\n", "plano", (unsigned long long)bPlano, bPlano / total, total / tPlano / 1e6);
+  printf("%-10s %12llu %9.2f %10.2f Mreg/s\n\n", "columnar", (unsigned long long)bColumnar, bColumnar / total,
+         total / tColumnar / 1e6);
+
+  uint64_t fin = INICIO_US + duracion;
+  uint64_t mitad = INICIO_US + duracion / 2;
+  Consulta consultas[] = {
+      {"media diaria de lux (todo)", CAMPO_LUX, INICIO_US, fin, US_POR_DIA},
+      {"batería mínima (30 días)", CAMPO_BATT, fin - 30 * US_POR_DIA, fin, 30 * US_POR_DIA},
+      {"energía por hora (7 días)", CAMPO_LUX, mitad, mitad + 7 * US_POR_DIA, US_POR_HORA},
+  };
+
+  // Un almacén recién abierto, como el de un proceso que solo consulta
+  AlmacenColumnar columnar(dir + "/columnar");
+  printf("%-28s %10s %10s %10s %8s  %s\n", "consulta (todos los nodos)", "CSV ms", "plano ms", "columnar ms", "x plano",
+         "bloques índice/decodificados");
+  for (const Consulta &q : consultas)
+  {
+    double t[3] = {};
+    double r[3] = {};
+    EstadisticasConsulta antes = columnar.estadisticas();
+    for (uint32_t n = 0; n < nodos; n++)
+    {
+      uint64_t nodo = 0xC0FFEE000000ull + n;
+      std::vector<Agregado> a;
+      auto inicio = std::chrono::steady_clock::now();
+      a = consultarCSV(dir + "/csv/" + nombreNodo(nodo) + ".csv", q.campo, q.desde, q.hasta, q.intervalo);
+      t[0] += segundosDesde(inicio);
+      r[0] += resumen(a, q);
+
+      inicio = std::chrono::steady_clock::now();
+      a = consultarPlano(dir + "/plano/" + nombreNodo(nodo) + ".plano", q.campo, q.desde, q.hasta, q.intervalo);
+      t[1] += segundosDesde(inicio);
+      r[1] += resumen(a, q);
+
+      inicio = std::chrono::steady_clock::now();
+      columnar.agregarPorIntervalo(nodo, q.campo, q.desde, q.hasta, q.intervalo, a);
+      t[2] += segundosDesde(inicio);
+      r[2] += resumen(a, q);
+    }
+    EstadisticasConsulta despues = columnar.estadisticas();
+    printf("%-28s %10.2f %10.2f %11.2f %8.1f  %llu/%llu\n", q.nombre, t[0] * 1e3, t[1] * 1e3, t[2] * 1e3, t[1] / t[2],
+           (unsigned long long)(despues.bloquesIndice - antes.bloquesIndice),
+           (unsigned long long)(despues.bloquesDecodificados - antes.bloquesDecodificados));
+    if (fabs(r[0] - r[2]) > 1e-6 * fabs(r[0]) + 1e-6 || fabs(r[1] - r[2]) > 1e-6 * fabs(r[1]) + 1e-6)
+    {
+      printf("  resultados distintos: CSV %.9g, plano %.9g, columnar %.9g\n", r[0], r[1], r[2]);
+      return 1;
+    }
+    if (q.intervalo == US_POR_HORA)
+      printf("  %.1f Wh recogidos por nodo y semana\n", r[2] * W_POR_LUX / 3600 / nodos);
+  }
+  return 0;
+}
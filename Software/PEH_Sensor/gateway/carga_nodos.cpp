@@ -0,0 +1,313 @@
+// Generador de carga para peh_gateway: muchos nodos drenando a la vez por el socket unix,
+// cada uno como enviarPaquetesSPIFFS() (paquetes de PACKET_SIZE registros, parada y espera
+// del "OK" con ACK_TIMEOUT_MS, el diagnóstico al final y desconexión). Mide el caudal
+// agregado y la latencia del ACK vista desde el nodo.
+// Con `difusion` cada nodo hace antes de cada drenaje lo de MODO_ANUNCIO: difunde cada
+// registro con los anteriores por la conexión del escáner (se pierde una de cada
+// PERDIDA_DIFUSION), manda la respuesta al escaneo y al conectarse espera el relleno y solo
+// manda desde ahí.
+//
+//   c++ -std=c++17 -O2 -Wall -o carga_nodos carga_nodos.cpp
+//   ./carga_nodos [nodos=100] [drenajes=20] [registros=200] [socket=/tmp/peh_gateway.sock] [difusion]
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <vector>
+#include "protocolo.h"
+#include "transporte_unix.h"
+
+#define PACKET_SIZE 5         // main.cpp
+#define ACK_TIMEOUT_MS 4000   // main.cpp
+#define BYTES_DIAG 112        // sizeof(DiagnosticoI2C)
+#define DIRECCION_BASE 0xC0FFEE000000ull
+#define REGISTROS_DIFUSION 8 // src/anuncio.h
+#define PERDIDA_DIFUSION 10
+
+struct NodoCarga
+{
+  int fd;
+  uint64_t direccion;
+  uint32_t drenajesRestantes;
+  uint32_t registrosEnviados; // en el drenaje actual
+  uint32_t registrosPaquete;  // del paquete a la espera de ACK
+  uint64_t enviadoUs;
+  uint16_t secuenciaDiag;
+  uint16_t secuencia; // del último registro difundido
+};
+
+static uint64_t ahoraUs()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+static uint32_t registrosPorDrenaje;
+static sockaddr_un dirGateway;
+static int epollCarga;
+static std::vector<uint32_t> latenciasUs;
+static uint64_t registrosConfirmados = 0;
+static uint32_t acksPerdidos = 0;
+static uint32_t nodosActivos = 0;
+static bool conDifusion = false;
+static int escaner = -1;
+static uint64_t difusiones = 0, difusionesPerdidas = 0;
+
+static bool enviar(NodoCarga &n, uint16_t handle, const uint8_t *datos, size_t bytes)
+{
+  uint8_t tx[BYTES_CABECERA_UNIX + MAX_BYTES_NOTIFICACION];
+  tx[0] = (uint8_t)handle;
+  tx[1] = (uint8_t)(handle >> 8);
+  memcpy(tx + BYTES_CABECERA_UNIX, datos, bytes);
+  return send(n.fd, tx, BYTES_CABECERA_UNIX + bytes, MSG_NOSIGNAL) == (ssize_t)(BYTES_CABECERA_UNIX + bytes);
+}
+
+// Medidas verosímiles que cambian de un registro a otro; k es su posición en el drenaje
+static void medida(uint32_t k, float r[5])
+{
+  r[0] = 20.0f + (k % 100) * 0.05f;
+  r[1] = 55.0f + (k % 37) * 0.2f;
+  r[2] = 40.0f - (k % 50) * 0.1f;
+  r[3] = (float)(k % 1000);
+  r[4] = 3.9f - (k % 200) * 0.001f;
+}
+
+static void enviarPaquete(NodoCarga &n)
+{
+  uint8_t paquete[PACKET_SIZE * BYTES_REGISTRO];
+  n.registrosPaquete = std::min<uint32_t>(PACKET_SIZE, registrosPorDrenaje - n.registrosEnviados);
+  for (uint32_t i = 0; i < n.registrosPaquete; i++)
+  {
+    uint32_t k = n.registrosEnviados + i;
+    float r[5];
+    medida(k, r);
+    uint32_t edadS = (registrosPorDrenaje - 1 - k) * 600; // un registro cada 10 min, el último recién medido
+    memcpy(paquete + i * BYTES_REGISTRO, r, sizeof(r));
+    memcpy(paquete + i * BYTES_REGISTRO + sizeof(r), &edadS, 4);
+  }
+  n.enviadoUs = ahoraUs();
+  enviar(n, HANDLE_DATOS, paquete, n.registrosPaquete * BYTES_REGISTRO);
+}
+
+static void terminarDrenaje(NodoCarga &n);
+
+static void escanear(const NodoCarga &n, const uint8_t *fabricante, size_t bytes)
+{
+  uint8_t tx[BYTES_CABECERA_UNIX + BYTES_DIRECCION + 255];
+  tx[0] = (uint8_t)HANDLE_ESCANEO;
+  tx[1] = (uint8_t)(HANDLE_ESCANEO >> 8);
+  for (int i = 0; i < BYTES_DIRECCION; i++)
+    tx[BYTES_CABECERA_UNIX + i] = (uint8_t)(n.direccion >> (8 * (BYTES_DIRECCION - 1 - i)));
+  memcpy(tx + BYTES_CABECERA_UNIX + BYTES_DIRECCION, fabricante, bytes);
+  send(escaner, tx, BYTES_CABECERA_UNIX + BYTES_DIRECCION + bytes, MSG_NOSIGNAL);
+}
+
+static uint8_t *escribirU16(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  return p + 2;
+}
+
+// La cabecera del anuncio de src/anuncio.cpp, con secuencia; con `registros` los de la
+// difusión en punto fijo como codificarDifusion(), del más antiguo (`primero`) al último
+static size_t anuncio(const NodoCarga &n, uint32_t pendientes, uint32_t primero, uint32_t registros, uint8_t *p)
+{
+  uint8_t *inicio = p;
+  p = escribirU16(p, ID_FABRICANTE);
+  *p++ = VERSION_ANUNCIO;
+  *p++ = ANUNCIO_SECUENCIA | (registros ? ANUNCIO_REGISTROS : 0);
+  p = escribirU16(p, pendientes);
+  p = escribirU16(p, 3900);
+  p = escribirU16(p, n.secuencia);
+  if (!registros)
+    return p - inicio;
+  *p++ = (uint8_t)registros;
+  for (uint32_t k = primero; k < primero + registros; k++)
+  {
+    float r[5];
+    medida(k, r);
+    uint32_t lux = (uint32_t)(r[3] * 100 + 0.5f), edad = (primero + registros - 1 - k) * 600;
+    p = escribirU16(p, (uint16_t)(int16_t)lroundf(r[0] * 100));
+    p = escribirU16(p, (uint32_t)(r[1] * 100 + 0.5f));
+    p = escribirU16(p, (uint32_t)(r[2] + 0.5f));
+    p = escribirU16(p, lux);
+    *p++ = (uint8_t)(lux >> 16);
+    p = escribirU16(p, (uint32_t)(r[4] * 1000 + 0.5f));
+    p = escribirU16(p, edad);
+    *p++ = (uint8_t)(edad >> 16);
+  }
+  return p - inicio;
+}
+
+// Lo que oiría el escáner durante el bloque: una difusión por registro nuevo y al final
+// la respuesta al escaneo del advertising conectable
+static void difundirBloque(NodoCarga &n)
+{
+  uint8_t datos[BYTES_ANUNCIO + 3 + REGISTROS_DIFUSION * BYTES_REGISTRO_DIFUSION];
+  for (uint32_t k = 0; k < registrosPorDrenaje; k++)
+  {
+    n.secuencia++;
+    difusiones++;
+    if (rand() % PERDIDA_DIFUSION == 0)
+    {
+      difusionesPerdidas++;
+      continue;
+    }
+    uint32_t registros = std::min<uint32_t>(k + 1, REGISTROS_DIFUSION);
+    escanear(n, datos, anuncio(n, k + 1, k + 1 - registros, registros, datos));
+  }
+  escanear(n, datos, anuncio(n, registrosPorDrenaje, 0, 0, datos));
+}
+
+static void conectar(NodoCarga &n)
+{
+  if (conDifusion)
+    difundirBloque(n);
+
+  n.fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (n.fd < 0 || connect(n.fd, (sockaddr *)&dirGateway, sizeof(dirGateway)) < 0)
+  {
+    perror("connect");
+    exit(1);
+  }
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.ptr = &n;
+  epoll_ctl(epollCarga, EPOLL_CTL_ADD, n.fd, &ev);
+
+  uint8_t hola[BYTES_DIRECCION];
+  for (int i = 0; i < BYTES_DIRECCION; i++)
+    hola[i] = (uint8_t)(n.direccion >> (8 * (BYTES_DIRECCION - 1 - i)));
+  enviar(n, HANDLE_HOLA, hola, sizeof(hola));
+  n.registrosEnviados = 0;
+  n.enviadoUs = ahoraUs();
+  if (!conDifusion)
+    enviarPaquete(n); // con difusión, al llegar el relleno
+}
+
+static void terminarDrenaje(NodoCarga &n)
+{
+  uint8_t diag[BYTES_DIAG] = {};
+  diag[0] = VERSION_DIAG_I2C;
+  diag[1] = 3;
+  n.secuenciaDiag++;
+  memcpy(diag + 2, &n.secuenciaDiag, 2);
+  enviar(n, HANDLE_DIAG, diag, sizeof(diag));
+
+  epoll_ctl(epollCarga, EPOLL_CTL_DEL, n.fd, nullptr);
+  close(n.fd);
+  n.fd = -1;
+  if (--n.drenajesRestantes)
+    conectar(n);
+  else
+    nodosActivos--;
+}
+
+static void recibir(NodoCarga &n)
+{
+  uint8_t rx[BYTES_CABECERA_UNIX + MAX_BYTES_NOTIFICACION];
+  ssize_t b = recv(n.fd, rx, sizeof(rx), 0);
+  if (b <= 0)
+  {
+    fprintf(stderr, "nodo %llx: el gateway cerró la conexión\n", (unsigned long long)n.direccion);
+    exit(1);
+  }
+  if (conDifusion && b == BYTES_CABECERA_UNIX + 2 && leerU16LE(rx) == HANDLE_RELLENO)
+  {
+    // Como inicioRelleno(): lo que falta desde la secuencia pedida hasta la última
+    uint16_t faltan = n.secuencia - leerU16LE(rx + BYTES_CABECERA_UNIX) + 1;
+    n.registrosEnviados = faltan > registrosPorDrenaje ? 0 : registrosPorDrenaje - faltan;
+    if (n.registrosEnviados < registrosPorDrenaje)
+      enviarPaquete(n);
+    else
+      terminarDrenaje(n);
+    return;
+  }
+  if (b != BYTES_CABECERA_UNIX + 2 || leerU16LE(rx) != HANDLE_ACK || memcmp(rx + BYTES_CABECERA_UNIX, ACK_DATOS, 2))
+    return;
+
+  latenciasUs.push_back((uint32_t)(ahoraUs() - n.enviadoUs));
+  registrosConfirmados += n.registrosPaquete;
+  n.registrosEnviados += n.registrosPaquete;
+  if (n.registrosEnviados < registrosPorDrenaje)
+    enviarPaquete(n);
+  else
+    terminarDrenaje(n);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t numNodos = argc > 1 ? (uint32_t)atoi(argv[1]) : 100;
+  uint32_t drenajes = argc > 2 ? (uint32_t)atoi(argv[2]) : 20;
+  registrosPorDrenaje = argc > 3 ? (uint32_t)atoi(argv[3]) : 200;
+  const char *ruta = argc > 4 ? argv[4] : "/tmp/peh_gateway.sock";
+  conDifusion = argc > 5 && !strcmp(argv[5], "difusion");
+  if (!numNodos || !drenajes || !registrosPorDrenaje)
+    return 1;
+
+  dirGateway.sun_family = AF_UNIX;
+  strncpy(dirGateway.sun_path, ruta, sizeof(dirGateway.sun_path) - 1);
+  epollCarga = epoll_create1(EPOLL_CLOEXEC);
+  if (conDifusion)
+  {
+    escaner = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (escaner < 0 || connect(escaner, (sockaddr *)&dirGateway, sizeof(dirGateway)) < 0)
+    {
+      perror("connect");
+      return 1;
+    }
+  }
+
+  std::vector<NodoCarga> nodos(numNodos);
+  uint64_t inicio = ahoraUs();
+  for (uint32_t i = 0; i < numNodos; i++)
+  {
+    nodos[i] = NodoCarga();
+    nodos[i].direccion = DIRECCION_BASE + i;
+    nodos[i].drenajesRestantes = drenajes;
+    conectar(nodos[i]);
+  }
+  nodosActivos = numNodos;
+
+  epoll_event eventos[MAX_EVENTOS_UNIX];
+  while (nodosActivos)
+  {
+    int n = epoll_wait(epollCarga, eventos, MAX_EVENTOS_UNIX, 100);
+    if (n < 0 && errno != EINTR)
+      return 1;
+    for (int i = 0; i < n; i++)
+      recibir(*(NodoCarga *)eventos[i].data.ptr);
+
+    // Como el nodo: sin "OK" en ACK_TIMEOUT_MS se rinde y deja el resto para otro drenaje
+    uint64_t ahora = ahoraUs();
+    for (NodoCarga &nodo : nodos)
+      if (nodo.fd >= 0 && ahora - nodo.enviadoUs > ACK_TIMEOUT_MS * 1000ull)
+      {
+        acksPerdidos++;
+        terminarDrenaje(nodo);
+      }
+  }
+  double segundos = (ahoraUs() - inicio) / 1e6;
+
+  std::sort(latenciasUs.begin(), latenciasUs.end());
+  auto percentil = [](double p) { return latenciasUs.empty() ? 0u : latenciasUs[(size_t)(p * (latenciasUs.size() - 1))]; };
+  printf("%u nodos x %u drenajes x %u registros en %.2f s\n", numNodos, drenajes, registrosPorDrenaje, segundos);
+  printf("registros confirmados %10llu  (%.0f/s, %.2f MB/s de carga útil)\n", (unsigned long long)registrosConfirmados,
+         registrosConfirmados / segundos, registrosConfirmados * BYTES_REGISTRO / segundos / 1e6);
+  printf("ACK perdidos          %10u\n", acksPerdidos);
+  if (conDifusion)
+    printf("difusiones            %10llu  (%llu perdidas; registros por conexión solo los que faltaban)\n",
+           (unsigned long long)difusiones, (unsigned long long)difusionesPerdidas);
+  printf("latencia del ACK      p50 %u µs, p99 %u µs, máx %u µs\n", percentil(0.5), percentil(0.99), percentil(1.0));
+  return 0;
+}
@@ -0,0 +1,276 @@
+#include "ingesta.h"
+
+#include <time.h>
+#include <algorithm>
+
+uint64_t relojUs()
+{
+  timespec t;
+  clock_gettime(CLOCK_REALTIME, &t);
+  return (uint64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+// Hora de la medida: la de llegada menos la edad que pone el nodo. Sin edad (medido antes
+// de un corte del nodo), la de llegada.
+static uint64_t marcaRegistro(uint64_t llegadaUs, const VistaRegistro &registro)
+{
+  uint64_t edadUs = (uint64_t)registro.edadS() * 1000000;
+  return registro.edadS() == EDAD_DESCONOCIDA || edadUs > llegadaUs ? llegadaUs : llegadaUs - edadUs;
+}
+
+bool OidosNodo::oido(uint16_t secuencia) const
+{
+  return _hay && (uint16_t)(_ultima - secuencia) < VENTANA_OIDOS && _bits[secuencia % VENTANA_OIDOS];
+}
+
+void OidosNodo::marcar(uint16_t secuencia)
+{
+  uint16_t avance = secuencia - _ultima;
+  if (!_hay || (avance < 32768 && avance >= VENTANA_OIDOS))
+    _bits.reset(); // la primera, o un salto (corte del nodo) que deja atrás toda la ventana
+  else if (avance < 32768)
+    for (uint16_t s = _ultima + 1; s != (uint16_t)(secuencia + 1); s++)
+      _bits[s % VENTANA_OIDOS] = false;
+  else if ((uint16_t)(_ultima - secuencia) >= VENTANA_OIDOS)
+    return; // anterior a la ventana
+  if (!_hay || avance < 32768)
+    _ultima = secuencia;
+  _hay = true;
+  _bits[secuencia % VENTANA_OIDOS] = true;
+}
+
+uint16_t OidosNodo::primeraSinOir(uint16_t ultima, uint16_t cantidad) const
+{
+  for (uint16_t i = cantidad; i > 0; i--)
+  {
+    uint16_t secuencia = ultima - i + 1;
+    if (!oido(secuencia))
+      return secuencia;
+  }
+  return ultima + 1;
+}
+
+void Ingesta::alConectar(IdConexion conexion, uint64_t direccion)
+{
+  if (conexion >= _direcciones.size())
+    _direcciones.resize(conexion + 1);
+  _direcciones[conexion] = direccion;
+
+  EstadisticasNodo &nodo = _nodos[direccion];
+  if (nodo.conectadoDesdeUs)
+  {
+    // El nodo se reconectó sin que viéramos la desconexión anterior: se cuenta hasta aquí
+    nodo.conectadoUs += relojUs() - nodo.conectadoDesdeUs;
+    _conectados--;
+  }
+  nodo.conexiones++;
+  nodo.conectadoDesdeUs = relojUs();
+  _conectados++;
+
+  // El nodo lo lee al terminar el drenaje: se escribe ya y en cada conexión hasta que
+  // lo confirme
+  if (_hayAjustes && !nodo.ajustesAlDia)
+    _transporte.escribir(conexion, HANDLE_AJUSTES, _ajustes, BYTES_AJUSTES);
+
+  // Un nodo con secuencia espera el relleno: desde el primero de los pendientes de su
+  // último anuncio que no llegó por difusión
+  SeguimientoNodo &s = _seguimiento[direccion];
+  s.llegados = 0;
+  s.relleno = s.hayAnuncio && (s.anuncio.banderas & ANUNCIO_SECUENCIA);
+  if (s.relleno)
+  {
+    s.desde = s.oidos.primeraSinOir(s.anuncio.secuencia, s.anuncio.registrosPendientes);
+    s.entero = false;
+    uint8_t relleno[2];
+    escribirRelleno(relleno, s.desde);
+    _transporte.escribir(conexion, HANDLE_RELLENO, relleno, sizeof(relleno));
+  }
+}
+
+void Ingesta::alRecibir(IdConexion conexion, uint16_t handle, const uint8_t *datos, size_t bytes)
+{
+  uint64_t direccion = _direcciones[conexion];
+  EstadisticasNodo &nodo = _nodos[direccion];
+  switch (handle)
+  {
+  case HANDLE_DATOS:
+    recibirDatos(nodo, direccion, conexion, datos, bytes);
+    break;
+  case HANDLE_LOTES:
+    recibirLote(nodo, direccion, conexion, datos, bytes);
+    break;
+  case HANDLE_DIAG:
+    recibirDiagnostico(nodo, datos, bytes);
+    break;
+  case HANDLE_AJUSTES:
+    recibirAjustes(nodo, datos, bytes);
+    break;
+  default:
+    break; // características que el gateway no usa
+  }
+}
+
+void Ingesta::alDesconectar(IdConexion conexion)
+{
+  EstadisticasNodo &nodo = _nodos[_direcciones[conexion]];
+  if (!nodo.conectadoDesdeUs)
+    return;
+  nodo.conectadoUs += relojUs() - nodo.conectadoDesdeUs;
+  nodo.conectadoDesdeUs = 0;
+  _conectados--;
+  _seguimiento[_direcciones[conexion]].relleno = false;
+}
+
+void Ingesta::alAnuncio(uint64_t direccion, const uint8_t *datos, size_t bytes)
+{
+  VistaDifusion difusion;
+  CabeceraAnuncio anuncio;
+  bool conRegistros = difusion.leer(datos, bytes);
+  if (conRegistros)
+    anuncio = difusion.anuncio();
+  else if (!leerAnuncio(datos, bytes, anuncio))
+    return; // de otro dispositivo o de una versión que no se entiende
+
+  EstadisticasNodo &nodo = _nodos[direccion];
+  SeguimientoNodo &s = _seguimiento[direccion];
+  s.anuncio = anuncio;
+  s.hayAnuncio = true;
+  if (conRegistros)
+    guardarDifusion(nodo, direccion, s, difusion);
+  nodo.atraso = atraso(s);
+}
+
+// Los que no se hayan oído ya en difusiones anteriores: cada registro va en varias
+void Ingesta::guardarDifusion(EstadisticasNodo &nodo, uint64_t direccion, SeguimientoNodo &s,
+                              const VistaDifusion &difusion)
+{
+  uint64_t llegada = relojUs();
+  uint8_t crudo[BYTES_REGISTRO];
+  for (size_t i = 0; i < difusion.registros(); i++)
+  {
+    uint16_t secuencia = difusion.secuencia(i);
+    if (s.oidos.oido(secuencia))
+      continue;
+    difusion.registro(i, crudo);
+    VistaRegistro registro(crudo);
+    if (!_almacen.anadir(direccion, marcaRegistro(llegada, registro), registro))
+      return; // sin marcar: se pedirá en el relleno
+    s.oidos.marcar(secuencia);
+    nodo.difundidos++;
+  }
+}
+
+// Secuencia del registro k del relleno; false si no tiene. El nodo manda desde la pedida,
+// salvo con registros de antes de un corte en el almacén: entonces todo, con esos primero
+// y sin edad, y los demás terminan en la secuencia de su anuncio.
+bool Ingesta::secuenciaRelleno(SeguimientoNodo &s, uint32_t k, const VistaRegistro &registro, uint16_t &secuencia)
+{
+  if (k == 0)
+    s.entero = registro.edadS() == EDAD_DESCONOCIDA;
+  if (!s.entero)
+  {
+    secuencia = s.desde + k;
+    return true;
+  }
+  if (registro.edadS() == EDAD_DESCONOCIDA || k >= s.anuncio.registrosPendientes)
+    return false;
+  secuencia = s.anuncio.secuencia - (uint16_t)(s.anuncio.registrosPendientes - 1 - k);
+  return true;
+}
+
+uint16_t Ingesta::atraso(const SeguimientoNodo &s)
+{
+  if (!(s.anuncio.banderas & ANUNCIO_SECUENCIA)) // sin difusiones: todo llega por conexión
+    return s.llegados >= s.anuncio.registrosPendientes ? 0 : s.anuncio.registrosPendientes - s.llegados;
+  return s.anuncio.secuencia + 1 - s.oidos.primeraSinOir(s.anuncio.secuencia, s.anuncio.registrosPendientes);
+}
+
+std::vector<uint64_t> Ingesta::porAtraso() const
+{
+  std::vector<uint64_t> direcciones;
+  for (const auto &n : _nodos)
+    if (n.second.atraso > 0 && !n.second.conectadoDesdeUs)
+      direcciones.push_back(n.first);
+  std::sort(direcciones.begin(), direcciones.end(),
+            [this](uint64_t a, uint64_t b) { return _nodos.at(a).atraso > _nodos.at(b).atraso; });
+  return direcciones;
+}
+
+void Ingesta::recibirDatos(EstadisticasNodo &nodo, uint64_t direccion, IdConexion conexion, const uint8_t *datos, size_t bytes)
+{
+  if (!VistaPaquete::valido(bytes))
+  {
+    nodo.invalidos++;
+    return;
+  }
+
+  guardarYConfirmar(nodo, direccion, conexion, VistaPaquete(datos, bytes), bytes);
+}
+
+void Ingesta::recibirLote(EstadisticasNodo &nodo, uint64_t direccion, IdConexion conexion, const uint8_t *datos, size_t bytes)
+{
+  if (!_lector.leer(datos, bytes))
+  {
+    nodo.invalidos++;
+    return;
+  }
+  guardarYConfirmar(nodo, direccion, conexion, _lector, bytes);
+}
+
+// VistaPaquete o LectorLote: registros() y operator[] que da un VistaRegistro
+template <typename TPaquete>
+void Ingesta::guardarYConfirmar(EstadisticasNodo &nodo, uint64_t direccion, IdConexion conexion, const TPaquete &paquete, size_t bytes)
+{
+  uint64_t llegada = relojUs();
+  SeguimientoNodo &s = _seguimiento[direccion];
+  for (size_t i = 0; i < paquete.registros(); i++)
+  {
+    uint16_t secuencia;
+    bool conSecuencia = s.relleno && secuenciaRelleno(s, s.llegados, paquete[i], secuencia);
+    s.llegados++;
+    if (conSecuencia && s.oidos.oido(secuencia))
+    {
+      nodo.repetidos++;
+      continue;
+    }
+    if (!_almacen.anadir(direccion, marcaRegistro(llegada, paquete[i]), paquete[i]))
+      return; // sin "OK": que el nodo lo conserve
+    if (conSecuencia)
+      s.oidos.marcar(secuencia);
+  }
+  if (s.hayAnuncio)
+    nodo.atraso = atraso(s);
+
+  nodo.paquetes++;
+  nodo.registros += paquete.registros();
+  nodo.bytes += bytes;
+  if (!_transporte.escribir(conexion, HANDLE_ACK, (const uint8_t *)ACK_DATOS, sizeof(ACK_DATOS) - 1))
+    nodo.fallosAck++;
+}
+
+void Ingesta::recibirDiagnostico(EstadisticasNodo &nodo, const uint8_t *datos, size_t bytes)
+{
+  size_t esperados = BYTES_CABECERA_DIAG + (bytes >= 2 ? datos[1] : 0) * BYTES_SALUD_DIAG + BYTES_COSECHA_DIAG;
+  if (bytes < BYTES_CABECERA_DIAG || datos[0] != VERSION_DIAG_I2C || bytes != esperados)
+  {
+    nodo.invalidos++;
+    return;
+  }
+  nodo.diagnosticos++;
+  nodo.ultimaSecuenciaDiag = leerU16LE(datos + 2);
+  nodo.bajadasVelocidadI2C = leerU16LE(datos + 4);
+  nodo.cargaCosechaMC = leerF32LE(datos + bytes - BYTES_COSECHA_DIAG + 8);
+}
+
+void Ingesta::recibirAjustes(EstadisticasNodo &nodo, const uint8_t *datos, size_t bytes)
+{
+  if (bytes != BYTES_AJUSTES || datos[0] != VERSION_AJUSTES ||
+      leerU16LE(datos + BYTES_AJUSTES - 2) != crc16Ccitt(datos, BYTES_AJUSTES - 2))
+  {
+    nodo.invalidos++;
+    return;
+  }
+  // Si no coinciden, el nodo rechazó los fijados (fuera de rango): se le vuelven a
+  // escribir en la próxima conexión y sigue sin estar al día
+  nodo.ajustesAlDia = _hayAjustes && memcmp(datos, _ajustes, BYTES_AJUSTES) == 0;
+}
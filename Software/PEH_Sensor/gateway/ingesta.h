@@ -0,0 +1,125 @@
+// Lado gateway de enviarPaquetesSPIFFS(): cada paquete de datos se valida, sus registros
+// se añaden al almacén leyéndolos del buffer de recepción, cada uno con la hora de su
+// medida (llegada menos edad), y solo entonces se escribe el "OK". Un paquete mal formado
+// no se confirma: el nodo lo reintentará en otro drenaje.
+// Lleva por nodo lo recibido y el tiempo conectado para el informe de caudal.
+// Con fijarAjustes() escribe además los ajustes de muestreo en cada conexión hasta que el
+// nodo notifica que son los vigentes.
+// De los nodos con MODO_ANUNCIO guarda los registros difundidos que oye el escáner, les
+// escribe al conectarse el relleno desde el primero que no oyó y descarta del relleno los
+// que ya tenía. porAtraso() da el orden en que conviene conectarse a ellos.
+
+#ifndef INGESTA_H
+#define INGESTA_H
+
+#include <stdint.h>
+#include <string.h>
+#include <bitset>
+#include <unordered_map>
+#include <vector>
+#include "transporte.h"
+#include "almacen_series.h"
+#include "lector_lote.h"
+
+struct EstadisticasNodo
+{
+  uint32_t conexiones;
+  uint64_t paquetes;
+  uint64_t registros;
+  uint64_t bytes;
+  uint64_t difundidos;   // registros guardados de las difusiones
+  uint32_t repetidos;    // del relleno que ya habían llegado por difusión
+  uint16_t atraso;       // registros del nodo que el gateway no tiene, según su último anuncio
+  uint32_t invalidos;    // paquetes de datos mal formados
+  uint32_t fallosAck;    // "OK" que no se pudo escribir
+  uint32_t diagnosticos;
+  uint16_t ultimaSecuenciaDiag;
+  uint16_t bajadasVelocidadI2C;
+  float cargaCosechaMC;      // acumulada en el nodo; 0 si no registra el cosechador
+  uint64_t conectadoUs;  // conexiones ya cerradas
+  uint64_t conectadoDesdeUs; // 0 si no está conectado
+  bool ajustesAlDia;         // el nodo notificó los ajustes fijados
+};
+
+// Secuencias de difusión oídas de un nodo, en las VENTANA_OIDOS que acaban en la última
+// (divide a 65536: el índice sigue valiendo al dar la vuelta). Más que los registros que
+// el nodo acumula entre dos rellenos; una más antigua cuenta como no oída.
+#define VENTANA_OIDOS 4096
+
+class OidosNodo
+{
+public:
+  bool oido(uint16_t secuencia) const;
+  void marcar(uint16_t secuencia);
+  // La primera sin oír de las `cantidad` que acaban en `ultima`; ultima + 1 si están todas
+  uint16_t primeraSinOir(uint16_t ultima, uint16_t cantidad) const;
+
+private:
+  std::bitset<VENTANA_OIDOS> _bits; // por secuencia % VENTANA_OIDOS
+  uint16_t _ultima = 0;
+  bool _hay = false;
+};
+
+class Ingesta : public ReceptorTransporte
+{
+public:
+  Ingesta(Transporte &transporte, AlmacenSeries &almacen) : _transporte(transporte), _almacen(almacen) {}
+
+  void alConectar(IdConexion conexion, uint64_t direccion) override;
+  void alRecibir(IdConexion conexion, uint16_t handle, const uint8_t *datos, size_t bytes) override;
+  void alDesconectar(IdConexion conexion) override;
+  void alAnuncio(uint64_t direccion, const uint8_t *datos, size_t bytes) override;
+
+  // Ajustes que se escriben a los nodos que aún no los tienen (construirAjustes())
+  void fijarAjustes(const uint8_t blob[BYTES_AJUSTES])
+  {
+    memcpy(_ajustes, blob, BYTES_AJUSTES);
+    _hayAjustes = true;
+  }
+
+  const std::unordered_map<uint64_t, EstadisticasNodo> &nodos() const { return _nodos; }
+  uint32_t conectados() const { return _conectados; }
+  // Nodos sin conexión abierta con atraso, de más a menos: el orden en que un transporte
+  // que inicia él las conexiones (BlueZ) debe atenderlos
+  std::vector<uint64_t> porAtraso() const;
+
+private:
+  // Lo que se sabe de un nodo por sus anuncios, y el relleno de la conexión en curso
+  struct SeguimientoNodo
+  {
+    CabeceraAnuncio anuncio;
+    bool hayAnuncio = false;
+    OidosNodo oidos;
+    bool relleno = false; // se le escribió el relleno en esta conexión
+    bool entero = false;  // manda el almacén entero: tiene registros de antes de un corte
+    uint16_t desde = 0;
+    uint32_t llegados = 0; // registros recibidos en esta conexión
+  };
+
+  void guardarDifusion(EstadisticasNodo &nodo, uint64_t direccion, SeguimientoNodo &seguimiento,
+                       const VistaDifusion &difusion);
+  static bool secuenciaRelleno(SeguimientoNodo &seguimiento, uint32_t k, const VistaRegistro &registro,
+                               uint16_t &secuencia);
+  static uint16_t atraso(const SeguimientoNodo &seguimiento);
+  void recibirDatos(EstadisticasNodo &nodo, uint64_t direccion, IdConexion conexion, const uint8_t *datos, size_t bytes);
+  void recibirLote(EstadisticasNodo &nodo, uint64_t direccion, IdConexion conexion, const uint8_t *datos, size_t bytes);
+  template <typename TPaquete>
+  void guardarYConfirmar(EstadisticasNodo &nodo, uint64_t direccion, IdConexion conexion, const TPaquete &paquete, size_t bytes);
+  void recibirDiagnostico(EstadisticasNodo &nodo, const uint8_t *datos, size_t bytes);
+  void recibirAjustes(EstadisticasNodo &nodo, const uint8_t *datos, size_t bytes);
+
+  Transporte &_transporte;
+  AlmacenSeries &_almacen;
+  std::unordered_map<uint64_t, EstadisticasNodo> _nodos;
+  std::unordered_map<uint64_t, SeguimientoNodo> _seguimiento;
+  std::vector<uint64_t> _direcciones; // por IdConexion
+  LectorLote _lector;
+  uint32_t _conectados = 0;
+  uint8_t _ajustes[BYTES_AJUSTES];
+  bool _hayAjustes = false;
+};
+
+// Reloj de pared en µs: llegada de los paquetes
+uint64_t relojUs();
+
+#endif
@@ -0,0 +1,58 @@
+#include "lector_lote.h"
+
+#include <math.h>
+
+// Orden de los campos float en el registro crudo (VistaRegistro); detrás va la edad
+static const char *const CAMPOS_REGISTRO[] = {"temp", "humAir", "humSoil", "lux", "batt"};
+#define NUM_CAMPOS_REGISTRO 5
+#define CAMPO_EDAD NUM_CAMPOS_REGISTRO
+#define COLUMNA_EDAD "edadS"
+
+bool LectorLote::leer(const uint8_t *datos, size_t bytes)
+{
+  _filas.clear();
+  if (deserializeMsgPack(_lote, datos, bytes) != DeserializationError::Ok)
+    return false;
+  if (_lote["v"] != VERSION_LOTE)
+    return false;
+  JsonArrayConst columnas = _lote["c"];
+  JsonArrayConst filas = _lote["r"];
+  if (columnas.isNull() || filas.isNull() || filas.size() == 0)
+    return false;
+
+  // Campo del registro de cada columna del lote, -1 si el gateway no la conoce
+  int8_t campo[MAX_COLUMNAS_LOTE];
+  size_t numColumnas = columnas.size();
+  if (numColumnas > MAX_COLUMNAS_LOTE)
+    return false;
+  for (size_t c = 0; c < numColumnas; c++)
+  {
+    campo[c] = -1;
+    for (int8_t f = 0; f < NUM_CAMPOS_REGISTRO; f++)
+      if (columnas[c] == CAMPOS_REGISTRO[f])
+        campo[c] = f;
+    if (columnas[c] == COLUMNA_EDAD)
+      campo[c] = CAMPO_EDAD;
+  }
+
+  _filas.resize(filas.size() * BYTES_REGISTRO);
+  uint8_t *p = _filas.data();
+  for (JsonArrayConst fila : filas)
+  {
+    if (fila.size() != numColumnas)
+    {
+      _filas.clear();
+      return false;
+    }
+    for (int f = 0; f < NUM_CAMPOS_REGISTRO; f++)
+      escribirF32LE(p + 4 * f, NAN);
+    escribirU32LE(p + 4 * CAMPO_EDAD, EDAD_DESCONOCIDA);
+    for (size_t c = 0; c < numColumnas; c++)
+      if (campo[c] == CAMPO_EDAD && fila[c].is<uint32_t>())
+        escribirU32LE(p + 4 * CAMPO_EDAD, fila[c].as<uint32_t>());
+      else if (campo[c] >= 0 && campo[c] != CAMPO_EDAD && fila[c].is<float>())
+        escribirF32LE(p + 4 * campo[c], fila[c].as<float>());
+    p += BYTES_REGISTRO;
+  }
+  return true;
+}
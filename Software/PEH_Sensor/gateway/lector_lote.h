@@ -0,0 +1,29 @@
+// Lotes MsgPack del nodo (src/lote.h, característica 0xAACC) vistos desde el gateway. Las
+// columnas se buscan por nombre: una que el gateway no conoce se ignora y un campo que el
+// lote no trae queda NaN (la edad, EDAD_DESCONOCIDA), así que nodo y gateway no tienen
+// que actualizarse a la vez.
+// Los registros se rehacen en el formato crudo para que el almacén no distinga el origen.
+
+#ifndef LECTOR_LOTE_H
+#define LECTOR_LOTE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <ArduinoJson.h>
+#include "protocolo.h"
+
+class LectorLote
+{
+public:
+  // false si no es un lote de una versión conocida; los registros anteriores se pierden
+  bool leer(const uint8_t *datos, size_t bytes);
+  size_t registros() const { return _filas.size() / BYTES_REGISTRO; }
+  VistaRegistro operator[](size_t i) const { return VistaRegistro(_filas.data() + i * BYTES_REGISTRO); }
+
+private:
+  JsonDocument _lote; // se reutiliza: tras el primer lote ya no pide memoria
+  std::vector<uint8_t> _filas;
+};
+
+#endif
@@ -0,0 +1,152 @@
+// Gateway de la red de nodos en Linux: acepta las conexiones de los nodos por el
+// transporte, confirma cada paquete de datos cuando ya está en el almacén, guarda lo que
+// oye de las difusiones y cada cierto tiempo saca por la salida estándar el caudal de cada
+// nodo y los que más registros tienen sin recoger. El transporte de momento es el socket
+// unix de transporte_unix.h; carga_nodos.cpp simula los nodos.
+//
+//   c++ -std=c++17 -O2 -Wall -I ../lib/ArduinoJson/src -o peh_gateway peh_gateway.cpp ingesta.cpp lector_lote.cpp transporte_unix.cpp almacen_series.cpp almacen_columnar.cpp
+//   ./peh_gateway [socket=/tmp/peh_gateway.sock] [directorio=.] [informe_s=10] [columnar|plano] [ajustes]
+//
+// `ajustes` = "ciclo_s,registros,paquete,timeout_s[,ganancia,integracion]" (los dos últimos
+// son los códigos VEML7700_GAIN_* / VEML7700_IT_*, 0 por defecto): se escriben a cada nodo
+// hasta que los confirma; la columna "ajus" del informe lo indica.
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "almacen_columnar.h"
+#include "ingesta.h"
+#include "transporte_unix.h"
+
+#define ESPERA_ATENDER_MS 200
+#define MAX_NODOS_INFORME 20 // los de más caudal; el total incluye a todos
+#define MAX_NODOS_ATRASO 5   // los primeros a los que conectarse
+
+static volatile sig_atomic_t terminar = 0;
+
+static void alSenal(int)
+{
+  terminar = 1;
+}
+
+struct Fila
+{
+  uint64_t direccion;
+  uint64_t registros; // en el intervalo
+  uint64_t difundidos;
+  uint64_t bytes;
+};
+
+// Registros y bytes de cada nodo en el último informe, para el caudal del intervalo
+static std::unordered_map<uint64_t, EstadisticasNodo> anterior;
+
+static void informe(const Ingesta &ingesta, double segundos, bool final)
+{
+  std::vector<Fila> filas;
+  uint64_t registros = 0, difundidos = 0, bytes = 0;
+  for (const auto &n : ingesta.nodos())
+  {
+    const EstadisticasNodo &a = anterior[n.first];
+    Fila f = {n.first, n.second.registros - a.registros, n.second.difundidos - a.difundidos, n.second.bytes - a.bytes};
+    registros += f.registros;
+    difundidos += f.difundidos;
+    bytes += f.bytes;
+    if (f.registros || f.difundidos || final)
+      filas.push_back(f);
+  }
+  std::sort(filas.begin(), filas.end(), [](const Fila &a, const Fila &b) { return a.registros > b.registros; });
+
+  printf("\n%s: %zu nodos vistos, %u conectados, %.0f registros/s, %.1f kB/s, %.1f difundidos/s\n",
+         final ? "total" : "intervalo", ingesta.nodos().size(), ingesta.conectados(), registros / segundos,
+         bytes / segundos / 1000, difundidos / segundos);
+  std::vector<uint64_t> atrasados = ingesta.porAtraso();
+  if (!atrasados.empty())
+  {
+    printf("conectar primero:");
+    for (size_t i = 0; i < std::min(atrasados.size(), (size_t)MAX_NODOS_ATRASO); i++)
+      printf(" %s (%u)", nombreNodo(atrasados[i]).c_str(), ingesta.nodos().at(atrasados[i]).atraso);
+    printf("\n");
+  }
+  if (filas.empty())
+    return;
+  printf("%-12s %6s %10s %10s %9s %9s %9s %5s %6s %5s %5s %5s %4s %9s\n", "nodo", "conex", "registros", "reg/s",
+         "kB/s", "conect/s", "difund", "rep", "atraso", "inval", "noack", "diag", "ajus", "cosecha");
+  size_t n = std::min(filas.size(), (size_t)MAX_NODOS_INFORME);
+  for (size_t i = 0; i < n; i++)
+  {
+    const EstadisticasNodo &e = ingesta.nodos().at(filas[i].direccion);
+    // Caudal mientras está conectado: lo que limita al nodo es el enlace, no el reloj
+    double conectadoS = (e.conectadoUs + (e.conectadoDesdeUs ? relojUs() - e.conectadoDesdeUs : 0)) / 1e6;
+    printf("%-12s %6u %10llu %10.0f %9.2f %9.0f %9llu %5u %6u %5u %5u %5u %4s %9.1f\n",
+           nombreNodo(filas[i].direccion).c_str(), e.conexiones, (unsigned long long)e.registros,
+           filas[i].registros / segundos, filas[i].bytes / segundos / 1000,
+           conectadoS > 0 ? e.registros / conectadoS : 0.0, (unsigned long long)e.difundidos, e.repetidos, e.atraso,
+           e.invalidos, e.fallosAck, e.diagnosticos, e.ajustesAlDia ? "sí" : "-", e.cargaCosechaMC);
+  }
+  if (filas.size() > n)
+    printf("... y %zu nodos más\n", filas.size() - n);
+}
+
+int main(int argc, char **argv)
+{
+  const char *ruta = argc > 1 ? argv[1] : "/tmp/peh_gateway.sock";
+  const char *directorio = argc > 2 ? argv[2] : ".";
+  double intervaloS = argc > 3 ? atof(argv[3]) : 10;
+  bool plano = argc > 4 && !strcmp(argv[4], "plano");
+  unsigned ciclo, registros, paquete, timeout, ganancia = 0, integracion = 0;
+  bool conAjustes = argc > 5;
+  if (conAjustes && sscanf(argv[5], "%u,%u,%u,%u,%u,%u", &ciclo, &registros, &paquete, &timeout, &ganancia,
+                           &integracion) < 4)
+  {
+    fprintf(stderr, "ajustes: se esperaba ciclo_s,registros,paquete,timeout_s[,ganancia,integracion]\n");
+    return 1;
+  }
+
+  signal(SIGINT, alSenal);
+  signal(SIGTERM, alSenal);
+  signal(SIGPIPE, SIG_IGN);
+
+  TransporteUnix transporte(ruta);
+  AlmacenPlano almacenPlano(directorio);
+  AlmacenColumnar almacenColumnar(directorio);
+  AlmacenSeries &almacen = plano ? (AlmacenSeries &)almacenPlano : almacenColumnar;
+  Ingesta ingesta(transporte, almacen);
+  if (conAjustes)
+  {
+    uint8_t blob[BYTES_AJUSTES];
+    construirAjustes(blob, ciclo, registros, paquete, timeout, ganancia, integracion);
+    ingesta.fijarAjustes(blob);
+  }
+  if (!transporte.iniciar())
+    return 1;
+  printf("escuchando en %s, registros en %s (%s)\n", ruta, directorio, plano ? "plano" : "columnar");
+  fflush(stdout);
+
+  uint64_t inicio = relojUs();
+  uint64_t ultimoInforme = inicio;
+  while (!terminar)
+  {
+    if (transporte.atender(ESPERA_ATENDER_MS, ingesta) < 0)
+    {
+      perror("epoll_wait");
+      break;
+    }
+    uint64_t ahora = relojUs();
+    if (intervaloS > 0 && ahora - ultimoInforme >= intervaloS * 1e6)
+    {
+      almacen.sincronizar();
+      informe(ingesta, (ahora - ultimoInforme) / 1e6, false);
+      fflush(stdout);
+      anterior = ingesta.nodos();
+      ultimoInforme = ahora;
+    }
+  }
+
+  almacen.sincronizar();
+  anterior.clear();
+  informe(ingesta, (relojUs() - inicio) / 1e6, true);
+  return 0;
+}
@@ -0,0 +1,256 @@
+// Protocolo del nodo visto desde el gateway (src/esp32/hal_esp32.cpp y MainActivity.kt).
+// El nodo notifica en la característica de datos paquetes de 1 a PACKET_SIZE registros
+// SensorData seguidos (5 float y un uint32 little-endian, 24 bytes cada uno) y espera "OK"
+// escrito en la de ACK antes de mandar el siguiente. Al final manda el diagnóstico I2C.
+// El uint32 es la edad del registro en segundos al enviarlo (EDAD_DESCONOCIDA si se midió
+// antes de un corte de alimentación del nodo): su hora es la de llegada menos la edad.
+// Con LOTES_MSGPACK los mismos registros van como lote MsgPack en la característica de
+// lotes (src/lote.h, lector_lote.h) y se confirman igual.
+// El gateway puede escribir en la de ajustes un blob de ajustes de muestreo (src/ajustes.h);
+// el nodo lo aplica al terminar el drenaje y notifica en la misma característica los que
+// quedan vigentes.
+//
+// Antes de conectarse, la respuesta al escaneo lleva en datos de fabricante los registros
+// pendientes y la batería (leerAnuncio(), src/anuncio.h), para atender primero a quien más
+// tiene. Con MODO_ANUNCIO el nodo difunde además sin conexión cada registro nuevo con los
+// anteriores, su secuencia y la edad de cada uno (VistaDifusion); al conectarse para el
+// relleno, el gateway escribe en la de relleno la secuencia del primero que le falta
+// (escribirRelleno()).
+// Tras un corte de alimentación la secuencia salta hacia delante; los registros de antes
+// del corte que sigan en el almacén no se difunden, y mientras queden el relleno manda el
+// almacén entero, aunque el gateway ya tenga por difusión los posteriores.
+//
+// Las características se identifican por los 16 bits cortos de su UUID.
+
+#ifndef PROTOCOLO_H
+#define PROTOCOLO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define HANDLE_DATOS 0xAAAA // CHAR_ALL_SENSORS_UUID
+#define HANDLE_DIAG 0xAABB  // CHAR_DIAG_UUID
+#define HANDLE_ACK 0xAAFF   // CHAR_ACK_UUID
+#define HANDLE_LOTES 0xAACC // CHAR_LOTES_UUID
+#define HANDLE_AJUSTES 0xAADD // CHAR_AJUSTES_UUID
+#define HANDLE_RELLENO 0xAAEE // CHAR_RELLENO_UUID
+
+#define BYTES_REGISTRO 24
+#define EDAD_DESCONOCIDA UINT32_MAX // como en src/sensores.h
+#define MAX_BYTES_NOTIFICACION 512 // ATT_MTU máximo - 3, de sobra para PACKET_SIZE registros
+#define ACK_DATOS "OK"
+
+#define VERSION_LOTE 1
+#define MAX_COLUMNAS_LOTE 16
+
+#define VERSION_DIAG_I2C 2
+#define BYTES_CABECERA_DIAG 6 // version, numDispositivos, secuencia, bajadasVelocidad
+#define BYTES_SALUD_DIAG 30   // por dispositivo I2C, detrás de la cabecera
+#define BYTES_COSECHA_DIAG 16 // al final: muestras, errores, carga (mA·s) y pico (mA) del INA226
+
+#define ID_FABRICANTE 0xFFFF // datos de fabricante del anuncio
+#define VERSION_ANUNCIO 2
+#define BYTES_ANUNCIO 8 // con el ID de fabricante
+#define ANUNCIO_LOTES_MSGPACK 0x01
+#define ANUNCIO_SECUENCIA 0x02
+#define ANUNCIO_REGISTROS 0x04
+#define BYTES_REGISTRO_DIFUSION 14
+#define EDAD_DIFUSION_DESCONOCIDA 0xFFFFFF
+
+#define VERSION_AJUSTES 1
+#define BYTES_AJUSTES 12 // AjustesNodo en src/ajustes.h
+
+inline float leerF32LE(const uint8_t *p)
+{
+  float f;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  memcpy(&f, p, 4);
+#else
+  uint32_t u = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+  memcpy(&f, &u, 4);
+#endif
+  return f;
+}
+
+inline uint16_t leerU16LE(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | p[1] << 8);
+}
+
+inline uint32_t leerU32LE(const uint8_t *p)
+{
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+inline void escribirU32LE(uint8_t *p, uint32_t u)
+{
+  p[0] = (uint8_t)u;
+  p[1] = (uint8_t)(u >> 8);
+  p[2] = (uint8_t)(u >> 16);
+  p[3] = (uint8_t)(u >> 24);
+}
+
+inline void escribirF32LE(uint8_t *p, float f)
+{
+  uint32_t u;
+  memcpy(&u, &f, 4);
+  escribirU32LE(p, u);
+}
+
+// AnuncioNodo en src/anuncio.h, tal como llega
+struct CabeceraAnuncio
+{
+  uint8_t banderas; // ANUNCIO_*
+  uint16_t registrosPendientes;
+  uint16_t bateriaMv; // 0 si el nodo no pudo medirla
+  uint16_t secuencia; // del último registro guardado, con ANUNCIO_SECUENCIA
+};
+
+// Datos de fabricante de la respuesta al escaneo o de una difusión (sin la cabecera
+// longitud/tipo del AD). false si no es de un nodo, es de una versión que no se entiende o
+// le falta la secuencia que anuncia. Es el único lector: el gateway simulado del host
+// (src/host/hal_host.cpp) usa también este.
+inline bool leerAnuncio(const uint8_t *datos, size_t bytes, CabeceraAnuncio &anuncio)
+{
+  if (bytes < BYTES_ANUNCIO || leerU16LE(datos) != ID_FABRICANTE || datos[2] != VERSION_ANUNCIO)
+    return false;
+  anuncio.banderas = datos[3];
+  anuncio.registrosPendientes = leerU16LE(datos + 4);
+  anuncio.bateriaMv = leerU16LE(datos + 6);
+  if ((anuncio.banderas & ANUNCIO_SECUENCIA) && bytes < BYTES_ANUNCIO + 2)
+    return false;
+  anuncio.secuencia = (anuncio.banderas & ANUNCIO_SECUENCIA) ? leerU16LE(datos + 8) : 0;
+  return true;
+}
+
+// Registros de una difusión, en punto fijo (src/anuncio.h). Los valores de fallo del nodo
+// vuelven como sus centinelas (-99 la temperatura, -1 el resto); la edad es la de los
+// paquetes de datos, en segundos al difundir.
+class VistaDifusion
+{
+public:
+  // false si no es una difusión completa de una versión conocida
+  bool leer(const uint8_t *datos, size_t bytes)
+  {
+    if (!leerAnuncio(datos, bytes, _anuncio) || !(_anuncio.banderas & ANUNCIO_REGISTROS) ||
+        !(_anuncio.banderas & ANUNCIO_SECUENCIA) || bytes < BYTES_ANUNCIO + 3)
+      return false;
+    _n = datos[BYTES_ANUNCIO + 2];
+    _p = datos + BYTES_ANUNCIO + 3;
+    return bytes >= BYTES_ANUNCIO + 3 + _n * BYTES_REGISTRO_DIFUSION;
+  }
+
+  const CabeceraAnuncio &anuncio() const { return _anuncio; }
+  size_t registros() const { return _n; }
+  // Del más antiguo (0) al último, que es el de anuncio().secuencia
+  uint16_t secuencia(size_t i) const { return _anuncio.secuencia - (uint16_t)(_n - 1 - i); }
+  float temp(size_t i) const
+  {
+    int16_t v = (int16_t)leerU16LE(r(i));
+    return v == INT16_MIN ? -99.0f : v / 100.0f;
+  }
+  float humAir(size_t i) const { return sinSigno(leerU16LE(r(i) + 2), 0xFFFF, 100); }
+  float humSoil(size_t i) const { return sinSigno(leerU16LE(r(i) + 4), 0xFFFF, 1); }
+  float lux(size_t i) const { return sinSigno(leerU24LE(r(i) + 6), 0xFFFFFF, 100); }
+  float batt(size_t i) const { return sinSigno(leerU16LE(r(i) + 9), 0xFFFF, 1000); }
+  uint32_t edadS(size_t i) const
+  {
+    uint32_t edad = leerU24LE(r(i) + 11);
+    return edad == EDAD_DIFUSION_DESCONOCIDA ? EDAD_DESCONOCIDA : edad;
+  }
+  // En el formato crudo (VistaRegistro), para que el almacén no distinga el origen
+  void registro(size_t i, uint8_t destino[BYTES_REGISTRO]) const
+  {
+    escribirF32LE(destino, temp(i));
+    escribirF32LE(destino + 4, humAir(i));
+    escribirF32LE(destino + 8, humSoil(i));
+    escribirF32LE(destino + 12, lux(i));
+    escribirF32LE(destino + 16, batt(i));
+    escribirU32LE(destino + 20, edadS(i));
+  }
+
+private:
+  const uint8_t *r(size_t i) const { return _p + i * BYTES_REGISTRO_DIFUSION; }
+  static uint32_t leerU24LE(const uint8_t *p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16; }
+  static float sinSigno(uint32_t v, uint32_t fallo, float escala) { return v == fallo ? -1.0f : v / escala; }
+
+  CabeceraAnuncio _anuncio = {};
+  const uint8_t *_p = nullptr;
+  size_t _n = 0;
+};
+
+// Lo que se escribe en la de relleno: el nodo manda desde ese registro hasta el último y
+// borra su almacén. Con secuencia + 1 no manda nada.
+inline void escribirRelleno(uint8_t destino[2], uint16_t desde)
+{
+  destino[0] = desde & 0xFF;
+  destino[1] = desde >> 8;
+}
+
+// CRC-16/CCITT-FALSE (polinomio 0x1021, valor inicial 0xFFFF), el de crcAjustes()
+inline uint16_t crc16Ccitt(const uint8_t *p, size_t bytes)
+{
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < bytes; i++)
+  {
+    crc ^= (uint16_t)p[i] << 8;
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// Blob de ajustes para la característica de ajustes. Los rangos los valida el nodo: uno
+// fuera de rango no se aplica y el nodo notifica los que ya tenía.
+inline void construirAjustes(uint8_t blob[BYTES_AJUSTES], uint16_t cicloS, uint16_t numRegistros, uint8_t tamPaquete,
+                             uint8_t timeoutBleS, uint8_t gananciaVeml, uint8_t integracionVeml)
+{
+  blob[0] = VERSION_AJUSTES;
+  blob[1] = tamPaquete;
+  blob[2] = cicloS & 0xFF;
+  blob[3] = cicloS >> 8;
+  blob[4] = numRegistros & 0xFF;
+  blob[5] = numRegistros >> 8;
+  blob[6] = timeoutBleS;
+  blob[7] = gananciaVeml;
+  blob[8] = integracionVeml;
+  blob[9] = 0;
+  uint16_t crc = crc16Ccitt(blob, BYTES_AJUSTES - 2);
+  blob[10] = crc & 0xFF;
+  blob[11] = crc >> 8;
+}
+
+// Un registro dentro del buffer de recepción: los campos se leen en su sitio, sin copiar
+// el registro. Válida mientras el buffer no se reutilice.
+class VistaRegistro
+{
+public:
+  explicit VistaRegistro(const uint8_t *p) : _p(p) {}
+  float temp() const { return leerF32LE(_p); }
+  float humAir() const { return leerF32LE(_p + 4); }
+  float humSoil() const { return leerF32LE(_p + 8); }
+  float lux() const { return leerF32LE(_p + 12); }
+  float batt() const { return leerF32LE(_p + 16); }
+  uint32_t edadS() const { return leerU32LE(_p + 20); }
+  const uint8_t *bytes() const { return _p; }
+
+private:
+  const uint8_t *_p;
+};
+
+// Los registros de una notificación de datos
+class VistaPaquete
+{
+public:
+  VistaPaquete(const uint8_t *datos, size_t bytes) : _p(datos), _n(bytes / BYTES_REGISTRO) {}
+  static bool valido(size_t bytes) { return bytes > 0 && bytes % BYTES_REGISTRO == 0; }
+  size_t registros() const { return _n; }
+  VistaRegistro operator[](size_t i) const { return VistaRegistro(_p + i * BYTES_REGISTRO); }
+
+private:
+  const uint8_t *_p;
+  size_t _n;
+};
+
+#endif
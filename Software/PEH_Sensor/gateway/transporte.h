@@ -0,0 +1,38 @@
+// Transporte entre el gateway y los nodos. La ingesta no sabe si debajo hay BlueZ o el
+// sustituto local: recibe los anuncios que oye el escáner, conexiones con la dirección del
+// nodo, notificaciones por característica y escribe en la de ACK.
+
+#ifndef TRANSPORTE_H
+#define TRANSPORTE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t IdConexion;
+
+class ReceptorTransporte
+{
+public:
+  virtual ~ReceptorTransporte() {}
+  // direccion: los 48 bits de la dirección BLE del nodo
+  virtual void alConectar(IdConexion conexion, uint64_t direccion) = 0;
+  // datos apunta al buffer de recepción del transporte: solo vale durante la llamada
+  virtual void alRecibir(IdConexion conexion, uint16_t handle, const uint8_t *datos, size_t bytes) = 0;
+  virtual void alDesconectar(IdConexion conexion) = 0;
+  // Datos de fabricante de un anuncio oído sin conexión: respuesta al escaneo o difusión.
+  // Como datos, solo vale durante la llamada.
+  virtual void alAnuncio(uint64_t direccion, const uint8_t *datos, size_t bytes) = 0;
+};
+
+class Transporte
+{
+public:
+  virtual ~Transporte() {}
+  virtual bool iniciar() = 0;
+  // Espera hasta esperaMs a que haya actividad y la entrega al receptor. -1 si falla.
+  virtual int atender(int esperaMs, ReceptorTransporte &receptor) = 0;
+  virtual bool escribir(IdConexion conexion, uint16_t handle, const uint8_t *datos, size_t bytes) = 0;
+  virtual void cerrar(IdConexion conexion) = 0;
+};
+
+#endif
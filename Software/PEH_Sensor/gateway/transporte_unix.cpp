@@ -0,0 +1,197 @@
+#include "transporte_unix.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Las conexiones se registran en epoll con su id + 1; el 0 es el socket de escucha
+#define DATO_ESCUCHA 0
+
+TransporteUnix::~TransporteUnix()
+{
+  for (IdConexion id = 0; id < _conexiones.size(); id++)
+    if (_conexiones[id].fd >= 0)
+      close(_conexiones[id].fd);
+  if (_escucha >= 0)
+  {
+    close(_escucha);
+    unlink(_ruta.c_str());
+  }
+  if (_epoll >= 0)
+    close(_epoll);
+}
+
+bool TransporteUnix::iniciar()
+{
+  sockaddr_un dir = {};
+  dir.sun_family = AF_UNIX;
+  if (_ruta.size() >= sizeof(dir.sun_path))
+  {
+    fprintf(stderr, "ruta de socket demasiado larga: %s\n", _ruta.c_str());
+    return false;
+  }
+  memcpy(dir.sun_path, _ruta.c_str(), _ruta.size() + 1);
+  unlink(_ruta.c_str());
+
+  _escucha = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (_escucha < 0 || bind(_escucha, (sockaddr *)&dir, sizeof(dir)) < 0 || listen(_escucha, SOMAXCONN) < 0)
+  {
+    perror(_ruta.c_str());
+    return false;
+  }
+
+  _epoll = epoll_create1(EPOLL_CLOEXEC);
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.u64 = DATO_ESCUCHA;
+  if (_epoll < 0 || epoll_ctl(_epoll, EPOLL_CTL_ADD, _escucha, &ev) < 0)
+  {
+    perror("epoll");
+    return false;
+  }
+  return true;
+}
+
+int TransporteUnix::atender(int esperaMs, ReceptorTransporte &receptor)
+{
+  epoll_event eventos[MAX_EVENTOS_UNIX];
+  int n = epoll_wait(_epoll, eventos, MAX_EVENTOS_UNIX, esperaMs);
+  if (n < 0)
+    return errno == EINTR ? 0 : -1;
+
+  for (int i = 0; i < n; i++)
+  {
+    if (eventos[i].data.u64 == DATO_ESCUCHA)
+    {
+      aceptar();
+      continue;
+    }
+    IdConexion id = (IdConexion)(eventos[i].data.u64 - 1);
+    if (id >= _conexiones.size() || _conexiones[id].fd < 0)
+      continue; // cerrada por el receptor en este mismo lote
+    if (eventos[i].events & EPOLLIN)
+      leer(id, receptor);
+    else if (eventos[i].events & (EPOLLHUP | EPOLLERR))
+      soltar(id, &receptor);
+  }
+  return n;
+}
+
+void TransporteUnix::aceptar()
+{
+  for (;;)
+  {
+    int fd = accept4(_escucha, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+      return; // EAGAIN: no hay más pendientes
+
+    IdConexion id;
+    if (!_libres.empty())
+    {
+      id = _libres.back();
+      _libres.pop_back();
+    }
+    else
+    {
+      id = (IdConexion)_conexiones.size();
+      _conexiones.push_back(Conexion());
+    }
+    _conexiones[id].fd = fd;
+    _conexiones[id].presentada = false;
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.u64 = (uint64_t)id + 1;
+    epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &ev);
+  }
+}
+
+// Todos los mensajes que haya en la conexión: con muchos nodos drenando a la vez se
+// vacía cada una en su turno en vez de volver a epoll por cada paquete
+void TransporteUnix::leer(IdConexion id, ReceptorTransporte &receptor)
+{
+  for (;;)
+  {
+    int fd = _conexiones[id].fd;
+    ssize_t n = recv(fd, _rx, sizeof(_rx), MSG_TRUNC);
+    if (n < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return;
+      soltar(id, &receptor);
+      return;
+    }
+    if (n == 0)
+    {
+      soltar(id, &receptor);
+      return;
+    }
+    if ((size_t)n > sizeof(_rx) || n < BYTES_CABECERA_UNIX)
+      continue; // más grande que cualquier notificación posible, o sin handle: se descarta
+
+    uint16_t handle = leerU16LE(_rx);
+    const uint8_t *valor = _rx + BYTES_CABECERA_UNIX;
+    size_t bytes = (size_t)n - BYTES_CABECERA_UNIX;
+
+    if (!_conexiones[id].presentada)
+    {
+      if ((handle != HANDLE_HOLA && handle != HANDLE_ESCANEO) || bytes < BYTES_DIRECCION ||
+          (handle == HANDLE_HOLA && bytes != BYTES_DIRECCION))
+      {
+        soltar(id, nullptr); // no es un nodo ni el escáner
+        return;
+      }
+      uint64_t direccion = 0;
+      for (int i = 0; i < BYTES_DIRECCION; i++)
+        direccion = direccion << 8 | valor[i];
+      if (handle == HANDLE_ESCANEO)
+      {
+        receptor.alAnuncio(direccion, valor + BYTES_DIRECCION, bytes - BYTES_DIRECCION);
+        continue;
+      }
+      _conexiones[id].presentada = true;
+      receptor.alConectar(id, direccion);
+      continue;
+    }
+
+    receptor.alRecibir(id, handle, valor, bytes);
+    if (_conexiones[id].fd < 0)
+      return; // el receptor la cerró
+  }
+}
+
+bool TransporteUnix::escribir(IdConexion id, uint16_t handle, const uint8_t *datos, size_t bytes)
+{
+  if (id >= _conexiones.size() || _conexiones[id].fd < 0 || bytes > MAX_BYTES_NOTIFICACION)
+    return false;
+  uint8_t tx[BYTES_CABECERA_UNIX + MAX_BYTES_NOTIFICACION];
+  tx[0] = (uint8_t)handle;
+  tx[1] = (uint8_t)(handle >> 8);
+  memcpy(tx + BYTES_CABECERA_UNIX, datos, bytes);
+  // Una escritura con respuesta corta: si el buffer del socket está lleno el nodo ya no lee
+  // y se pierde, como un ACK que no llega
+  return send(_conexiones[id].fd, tx, BYTES_CABECERA_UNIX + bytes, MSG_NOSIGNAL) == (ssize_t)(BYTES_CABECERA_UNIX + bytes);
+}
+
+void TransporteUnix::cerrar(IdConexion id)
+{
+  if (id < _conexiones.size() && _conexiones[id].fd >= 0)
+    soltar(id, nullptr);
+}
+
+void TransporteUnix::soltar(IdConexion id, ReceptorTransporte *receptor)
+{
+  bool presentada = _conexiones[id].presentada;
+  epoll_ctl(_epoll, EPOLL_CTL_DEL, _conexiones[id].fd, nullptr);
+  close(_conexiones[id].fd);
+  _conexiones[id].fd = -1;
+  _conexiones[id].presentada = false;
+  _libres.push_back(id);
+  if (receptor && presentada)
+    receptor->alDesconectar(id);
+}
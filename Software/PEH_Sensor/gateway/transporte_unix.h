@@ -0,0 +1,56 @@
+// Sustituto local del enlace BLE: un socket unix SOCK_SEQPACKET en el que cada nodo es una
+// conexión y cada mensaje una operación ATT. El mensaje lleva el handle corto de la
+// característica (2 bytes little-endian) y detrás el valor tal cual lo notificaría el nodo.
+// El primero de cada conexión es HANDLE_HOLA con los 6 bytes de la dirección del nodo,
+// lo que en BLE daría la propia conexión. Lo que oiría el escáner llega por conexiones que
+// no se presentan: cada mensaje HANDLE_ESCANEO lleva la dirección del nodo y detrás los
+// datos de fabricante de su anuncio.
+//
+// Un solo hilo con epoll no bloqueante atiende todas las conexiones; los mensajes se leen
+// en un único buffer que se reutiliza y se entregan al receptor sin copiarlos.
+
+#ifndef TRANSPORTE_UNIX_H
+#define TRANSPORTE_UNIX_H
+
+#include <string>
+#include <vector>
+#include "transporte.h"
+#include "protocolo.h"
+
+#define HANDLE_HOLA 0x0000
+#define HANDLE_ESCANEO 0x0001
+#define BYTES_DIRECCION 6
+#define BYTES_CABECERA_UNIX 2
+#define MAX_EVENTOS_UNIX 256
+
+class TransporteUnix : public Transporte
+{
+public:
+  explicit TransporteUnix(const std::string &ruta) : _ruta(ruta), _escucha(-1), _epoll(-1) {}
+  ~TransporteUnix() override;
+
+  bool iniciar() override;
+  int atender(int esperaMs, ReceptorTransporte &receptor) override;
+  bool escribir(IdConexion conexion, uint16_t handle, const uint8_t *datos, size_t bytes) override;
+  void cerrar(IdConexion conexion) override;
+
+private:
+  struct Conexion
+  {
+    int fd;           // -1 si el hueco está libre
+    bool presentada;  // ya mandó HANDLE_HOLA
+  };
+
+  void aceptar();
+  void leer(IdConexion id, ReceptorTransporte &receptor);
+  void soltar(IdConexion id, ReceptorTransporte *receptor);
+
+  std::string _ruta;
+  int _escucha;
+  int _epoll;
+  std::vector<Conexion> _conexiones; // IdConexion = índice
+  std::vector<IdConexion> _libres;
+  uint8_t _rx[BYTES_CABECERA_UNIX + MAX_BYTES_NOTIFICACION];
+};
+
+#endif
@@ -0,0 +1,39 @@
+// Interruptores de compilación compartidos por los módulos del firmware
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// ACTIVAR/DESACTIVAR DEBUG SERIAL
+// #define DEBUG_SERIAL
+
+// MUESTREO EN EL ULP RISC-V (lo define env:esp32-s3-ulp, que compila y embebe ulp/; ver ulp/main.c)
+// El ULP toma las muestras y el núcleo principal solo despierta para volcarlas y drenar por BLE.
+// #define USAR_ULP
+
+// LECTURA DE SHTC3, INA226 Y VEML7700 COMO TRANSACCIONES ENCOLADAS (lib/ColaI2C)
+// Las esperas de conversión dejan el bus libre para los demás sensores y la CPU cede
+// en vez de hacer busy-wait. Los drivers siguen usándose para begin() y configuración.
+// Lo definen env:esp32-s3-cola y env:native_cola.
+// #define USAR_COLA_I2C
+
+// LOTES EN MESSAGEPACK (src/lote.h) EN VEZ DE SensorData CRUDO
+// Se notifican en su propia característica (0xAACC) con el mismo ACK. El gateway entiende
+// los dos; la app Android de momento solo lee los paquetes crudos.
+// #define LOTES_MSGPACK
+
+// DIFUSIÓN SIN CONEXIÓN (requiere BLE 5: advertising extendido del ESP32-S3)
+// Cada registro guardado sale en un anuncio extendido no conectable con los anteriores y
+// una secuencia (src/anuncio.h): un gateway que escucha siempre los recoge sin conectarse.
+// El drenaje queda como relleno cada BLOQUES_RELLENO bloques (main.cpp), o en cada uno si
+// el gateway pierde difusiones: escribe en la característica 0xAAEE desde qué secuencia le
+// falta y el nodo manda solo eso antes de borrar el almacén.
+// #define MODO_ANUNCIO
+
+// LED DE ESTADO: recuento de registros antes del deep sleep, rojo durante el advertising y
+// azul al salir del light sleep. El perfil de producción ([env:esp32-s3-produccion]) define
+// SIN_LED_ESTADO y no se compila ni el NeoPixel ni el motor de efectos.
+#ifndef SIN_LED_ESTADO
+#define LED_ESTADO
+#endif
+
+#endif
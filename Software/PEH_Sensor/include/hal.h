@@ -0,0 +1,119 @@
+// Capa fina sobre el hardware que usa la máquina de estados del nodo (main.cpp):
+// reloj, sueño, almacén de registros, transporte hacia el gateway, ADC y LED.
+// Hay dos implementaciones que se eligen al enlazar: src/esp32/hal_esp32.cpp (Arduino
+// y ESP-IDF) y src/host/hal_host.cpp (tiempo virtual, flash en RAM y gateway simulado).
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+// Estado global del firmware que no está en RTC. En el host (arduino/Arduino.h) es
+// thread_local, como RTC_DATA_ATTR, para que cada hilo ejecute su propio nodo.
+#ifndef RAM_NODO
+#define RAM_NODO
+#endif
+
+// --- RELOJ ---
+// Tiempos desde el arranque de la app, como millis()/micros()
+uint32_t relojMs();
+uint32_t relojUs();
+// Segundos desde el encendido: sigue contando en deep sleep y tras reiniciarNodo() (el
+// temporizador RTC de la placa); un corte de alimentación lo devuelve a 0
+uint32_t relojNodoS();
+void esperarMs(uint32_t ms);
+uint32_t cpuMhz();
+void fijarCpuMhz(uint32_t mhz);
+
+// --- SUEÑO ---
+// Solo el temporizador: anula cualquier otra fuente de despertar programada
+void programarDespertar(uint64_t us);
+// En la placa no vuelve: el despertar arranca de nuevo en setup() con la RAM perdida
+// salvo RTC_DATA_ATTR. En el host vuelve tras avanzar el reloj y quien simula arranca.
+void dormirProfundo();
+// Vuelve al despertar con RAM y periféricos intactos
+void dormirLigero();
+// Como un arranque en frío: también se reinicializa la memoria RTC. No vuelve en la placa.
+void reiniciarNodo();
+// El arranque en curso viene de reiniciarNodo() y no de un encendido o un corte
+bool reinicioPedido();
+
+// --- ALMACÉN ---
+// Un único archivo de registros en flash al que solo se añade al final
+bool almacenMontar();
+size_t almacenBytes(); // 0 si no existe
+bool almacenAnadir(const void *datos, size_t bytes);
+bool almacenLeer(size_t desplazamiento, void *destino, size_t bytes);
+void almacenBorrar();
+
+// --- NVS ---
+// Blobs pequeños por clave, aparte del almacén: sobreviven a almacenBorrar() y a los reinicios
+size_t nvsLeer(const char *clave, void *destino, size_t capacidad); // bytes leídos; 0 si no hay
+bool nvsGuardar(const char *clave, const void *datos, size_t bytes);
+
+// --- TRANSPORTE ---
+// Servidor GATT en la placa: el gateway se conecta, recibe notificaciones y confirma
+// cada paquete de datos escribiendo "OK". `fabricante` va como datos de fabricante en la
+// respuesta al escaneo (src/anuncio.h): el gateway puede atender antes al que más tiene.
+void transporteIniciar(const uint8_t *fabricante, size_t bytes);
+bool transporteConectado(); // sondearlo mientras se espera: también pasa al anuncio lento
+void transporteEnviarDatos(const uint8_t *datos, size_t bytes); // descarta un ACK anterior
+void transporteEnviarLote(const uint8_t *datos, size_t bytes);  // lo mismo en la de lotes (LOTES_MSGPACK)
+bool transporteAckRecibido();
+void transporteEnviarDiagnostico(const uint8_t *datos, size_t bytes);
+// Último blob escrito en la característica de ajustes desde transporteIniciar(); lo
+// entrega una sola vez. 0 si no hay o no cabe.
+size_t transporteAjustesRecibidos(uint8_t *destino, size_t capacidad);
+void transporteEnviarAjustes(const uint8_t *datos, size_t bytes); // los vigentes, sin ACK
+void transporteParar();
+#ifdef MODO_ANUNCIO
+// Sin conexión: `eventos` anuncios extendidos no conectables con `datos` como datos de
+// fabricante. Vuelve con la radio apagada.
+void transporteDifundir(const uint8_t *datos, size_t bytes, uint8_t eventos);
+// Secuencia del primer registro que le falta al gateway, escrita en la característica de
+// relleno desde transporteIniciar(). false si no la escribió: hay que mandarlo todo.
+bool transporteRellenoDesde(uint16_t &secuencia);
+#endif
+
+// --- ADC Y GPIO ---
+uint16_t leerADC(uint8_t pin);
+void activarSalida(uint8_t pin, bool nivel); // configura el pin como salida y lo fija
+
+// --- LED ---
+#define COLOR_RGB(r, g, b) (((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+
+#define MAX_PASOS_LED 4
+
+struct PasoLed
+{
+  uint32_t color;
+  uint16_t ms; // 0: el efecto termina en este paso
+};
+
+#ifdef LED_ESTADO
+void ledIniciar();
+// Fijan el color y paran el efecto en curso
+void ledColor(uint32_t color);
+void ledApagar();
+// Reproduce los pasos `repeticiones` veces sin bloquear (un esp_timer en la placa) y
+// sustituye al efecto en curso. Al terminar el LED se queda con el color del último paso.
+// dormir*() corta el efecto y el LED sigue con el color que tenga.
+void ledEfecto(const PasoLed *pasos, uint8_t numPasos, uint8_t repeticiones);
+bool ledEfectoActivo();
+// Espera a que termine el efecto, como mucho maxMs. En la placa duerme en light sleep
+// entre pasos (el NeoPixel mantiene el color sin la CPU), así que anula los despertares
+// programados: llamar antes de programarDespertar(). Devuelve los µs dormidos.
+uint32_t ledEsperarEfecto(uint32_t maxMs);
+#else
+// Perfil sin LED de estado: nada que compilar ni que esperar
+inline void ledIniciar() {}
+inline void ledColor(uint32_t) {}
+inline void ledApagar() {}
+inline void ledEfecto(const PasoLed *, uint8_t, uint8_t) {}
+inline bool ledEfectoActivo() { return false; }
+inline uint32_t ledEsperarEfecto(uint32_t) { return 0; }
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+// Configuración de placa: pines y asignación de cada sensor a un controlador I2C.
+// El ESP32-S3 tiene dos controladores (Wire y Wire1); cada sensor se asigna a uno en
+// compilación. Con el INA226 en un bus propio su registro a alta frecuencia sigue
+// mientras SHTC3 y VEML7700 convierten en el otro.
+
+#ifndef PLACA_H
+#define PLACA_H
+
+// --- PINES ---
+#ifndef I2C0_SDA_PIN
+#define I2C0_SDA_PIN 4
+#endif
+#ifndef I2C0_SCL_PIN
+#define I2C0_SCL_PIN 5
+#endif
+#ifndef I2C1_SDA_PIN
+#define I2C1_SDA_PIN 8
+#endif
+#ifndef I2C1_SCL_PIN
+#define I2C1_SCL_PIN 9
+#endif
+
+#define A_IN_SKU 6
+#define EN_SKU 7
+#define LED_PIN 48
+#define LED_COUNT 1
+
+// --- BUS DE CADA SENSOR (0 = Wire, 1 = Wire1) ---
+// La placa actual lleva los tres sensores en el bus 0
+#ifndef BUS_SHTC3
+#define BUS_SHTC3 0
+#endif
+#ifndef BUS_VEML7700
+#define BUS_VEML7700 0
+#endif
+#ifndef BUS_INA226
+#define BUS_INA226 0
+#endif
+
+// Techo de reloj que admiten los pull-ups y el trazado de la placa
+#ifndef I2C_HZ_MAX_PLACA
+#define I2C_HZ_MAX_PLACA 400000
+#endif
+
+#define NUM_BUSES_I2C 2
+#define BUS_I2C_USADO(n) (BUS_SHTC3 == (n) || BUS_VEML7700 == (n) || BUS_INA226 == (n))
+#define INA226_EN_BUS_PROPIO (BUS_INA226 != BUS_SHTC3 && BUS_INA226 != BUS_VEML7700)
+
+// Requiere <Wire.h> en el punto de uso
+#define WIRE_I2C(n) ((n) == 0 ? Wire : Wire1)
+
+#endif
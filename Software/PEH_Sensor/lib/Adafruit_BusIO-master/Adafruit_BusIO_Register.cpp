@@ -118,6 +118,8 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(
 bool Adafruit_BusIO_Register::write(uint8_t *buffer, uint8_t len) {
   uint8_t addrbuffer[2] = {(uint8_t)(_address & 0xFF),
                            (uint8_t)(_address >> 8)};
+  // raw writes bypass the shadow copy
+  _cacheValid = false;
   if (_i2cdevice) {
     return _i2cdevice->write(buffer, len, true, addrbuffer, _addrwidth);
   }
@@ -166,6 +168,20 @@ bool Adafruit_BusIO_Register::write(uint32_t value, uint8_t numbytes) {
     return false;
   }
 
+  if (_cacheEnabled) {
+    // Inside beginUpdate()/endUpdate() only the shadow copy changes
+    if (_updating) {
+      _cached = value;
+      _cacheValid = true;
+      _dirty = true;
+      return true;
+    }
+    // The device already holds this value
+    if (_cacheValid && value == _cached) {
+      return true;
+    }
+  }
+
   // store a copy
   _cached = value;
 
@@ -177,7 +193,9 @@ bool Adafruit_BusIO_Register::write(uint32_t value, uint8_t numbytes) {
     }
     value >>= 8;
   }
-  return write(_buffer, numbytes);
+  bool ok = write(_buffer, numbytes);
+  _cacheValid = _cacheEnabled && ok;
+  return ok;
 }
 
 /*!
@@ -186,6 +204,10 @@ bool Adafruit_BusIO_Register::write(uint32_t value, uint8_t numbytes) {
  *    @return Returns 0xFFFFFFFF on failure, value otherwise
  */
 uint32_t Adafruit_BusIO_Register::read(void) {
+  if (_cacheEnabled && _cacheValid) {
+    return _cached;
+  }
+
   if (!read(_buffer, _width)) {
     return -1;
   }
@@ -201,6 +223,10 @@ uint32_t Adafruit_BusIO_Register::read(void) {
     }
   }
 
+  if (_cacheEnabled) {
+    _cached = value;
+    _cacheValid = true;
+  }
   return value;
 }
 
@@ -210,6 +236,47 @@ uint32_t Adafruit_BusIO_Register::read(void) {
  */
 uint32_t Adafruit_BusIO_Register::readCached(void) { return _cached; }
 
+/*!
+ *    @brief  Enable a write-through shadow copy of the register. Once it
+ * holds a value (after the first read or write), read() and read-modify-write
+ * through Adafruit_BusIO_RegisterBits are served from it and writes of an
+ * unchanged value are skipped. Only for registers that the device itself
+ * never changes (configuration, not data or status).
+ *    @param  enable True to enable the cache, false to disable it
+ */
+void Adafruit_BusIO_Register::enableCache(bool enable) {
+  _cacheEnabled = enable;
+  _cacheValid = false;
+}
+
+/*!
+ *    @brief  Forget the shadow copy, e.g. after the device was reset. The
+ * next access reads the register from the device again.
+ */
+void Adafruit_BusIO_Register::invalidateCache(void) { _cacheValid = false; }
+
+/*!
+ *    @brief  Start a batch of changes: writes only update the shadow copy
+ * until endUpdate(). Needs the cache enabled, otherwise writes go straight
+ * to the device as usual.
+ */
+void Adafruit_BusIO_Register::beginUpdate(void) { _updating = _cacheEnabled; }
+
+/*!
+ *    @brief  Finish a batch started with beginUpdate(), writing the register
+ * once if anything changed
+ *    @return True on successful write (or nothing to write)
+ */
+bool Adafruit_BusIO_Register::endUpdate(void) {
+  _updating = false;
+  if (!_dirty) {
+    return true;
+  }
+  _dirty = false;
+  _cacheValid = false; // so write() does not skip it as unchanged
+  return write(_cached, _width);
+}
+
 /*!
    @brief Read a number of bytes from a register into a buffer
    @param buffer Buffer to read data into
@@ -71,6 +71,11 @@ public:
   bool write(uint8_t *buffer, uint8_t len);
   bool write(uint32_t value, uint8_t numbytes = 0);
 
+  void enableCache(bool enable = true);
+  void invalidateCache(void);
+  void beginUpdate(void);
+  bool endUpdate(void);
+
   uint8_t width(void);
 
   void setWidth(uint8_t width);
@@ -90,6 +95,8 @@ private:
   uint8_t _buffer[4]; // we won't support anything larger than uint32 for
                       // non-buffered read
   uint32_t _cached = 0;
+  bool _cacheEnabled = false, _cacheValid = false;
+  bool _updating = false, _dirty = false;
 };
 
 /*!
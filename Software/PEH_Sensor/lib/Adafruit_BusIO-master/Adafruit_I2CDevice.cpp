@@ -2,6 +2,10 @@
 
 // #define DEBUG_SERIAL Serial
 
+Adafruit_I2CDevice_RecoveryHook Adafruit_I2CDevice::_recoveryHook = nullptr;
+Adafruit_I2CDevice_RetryResultHook Adafruit_I2CDevice::_retryResultHook =
+    nullptr;
+
 /*!
  *    @brief  Create an I2C device at a given address
  *    @param  addr The 7-bit I2C address for the device
@@ -102,6 +106,15 @@ bool Adafruit_I2CDevice::detected(void) {
 bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
                                const uint8_t *prefix_buffer,
                                size_t prefix_len) {
+  if (_write(buffer, len, stop, prefix_buffer, prefix_len))
+    return true;
+  return _recover() &&
+         _retried(_write(buffer, len, stop, prefix_buffer, prefix_len));
+}
+
+bool Adafruit_I2CDevice::_write(const uint8_t *buffer, size_t len, bool stop,
+                                const uint8_t *prefix_buffer,
+                                size_t prefix_len) {
   if ((len + prefix_len) > maxBufferSize()) {
     // currently not guaranteed to work if more than 32 bytes!
     // we will need to find out if some platforms have larger
@@ -181,6 +194,12 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
  *    @return True if read was successful, otherwise false.
  */
 bool Adafruit_I2CDevice::read(uint8_t *buffer, size_t len, bool stop) {
+  if (_readChunks(buffer, len, stop))
+    return true;
+  return _recover() && _retried(_readChunks(buffer, len, stop));
+}
+
+bool Adafruit_I2CDevice::_readChunks(uint8_t *buffer, size_t len, bool stop) {
   size_t pos = 0;
   while (pos < len) {
     size_t read_len =
@@ -247,11 +266,38 @@ bool Adafruit_I2CDevice::_read(uint8_t *buffer, size_t len, bool stop) {
 bool Adafruit_I2CDevice::write_then_read(const uint8_t *write_buffer,
                                          size_t write_len, uint8_t *read_buffer,
                                          size_t read_len, bool stop) {
-  if (!write(write_buffer, write_len, stop)) {
-    return false;
-  }
+  // A retry repeats the whole sequence: after a bus recovery the register
+  // pointer set by the write can no longer be trusted
+  if (_write(write_buffer, write_len, stop, nullptr, 0) &&
+      _readChunks(read_buffer, read_len, true))
+    return true;
+  return _recover() &&
+         _retried(_write(write_buffer, write_len, stop, nullptr, 0) &&
+                  _readChunks(read_buffer, read_len, true));
+}
+
+/*!
+ *    @brief  Install a hook shared by all devices that is called once when a
+ *    write, read or write_then_read fails. If it returns true the transfer
+ *    is retried once.
+ *    @param  hook The hook, or nullptr to disable retries
+ *    @param  resultHook Optional, called with the outcome of each retry
+ */
+void Adafruit_I2CDevice::setRecoveryHook(
+    Adafruit_I2CDevice_RecoveryHook hook,
+    Adafruit_I2CDevice_RetryResultHook resultHook) {
+  _recoveryHook = hook;
+  _retryResultHook = resultHook;
+}
+
+bool Adafruit_I2CDevice::_recover(void) {
+  return _recoveryHook && _recoveryHook(_wire);
+}
 
-  return read(read_buffer, read_len);
+bool Adafruit_I2CDevice::_retried(bool ok) {
+  if (_retryResultHook)
+    _retryResultHook(_wire, ok);
+  return ok;
 }
 
 /*!
@@ -4,6 +4,17 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+/*!
+ *    @brief  Called when a transfer fails. Returns true if the transfer should
+ *    be retried once (e.g. after clocking a stuck bus free).
+ */
+typedef bool (*Adafruit_I2CDevice_RecoveryHook)(TwoWire *wire);
+/*!
+ *    @brief  Called after the retry allowed by the recovery hook, with its
+ *    outcome.
+ */
+typedef void (*Adafruit_I2CDevice_RetryResultHook)(TwoWire *wire, bool ok);
+
 ///< The class which defines how we will talk to this device over I2C
 class Adafruit_I2CDevice {
 public:
@@ -21,6 +32,10 @@ public:
                        bool stop = false);
   bool setSpeed(uint32_t desiredclk);
 
+  static void
+  setRecoveryHook(Adafruit_I2CDevice_RecoveryHook hook,
+                  Adafruit_I2CDevice_RetryResultHook resultHook = nullptr);
+
   /*!   @brief  How many bytes we can read in a transaction
    *    @return The size of the Wire receive/transmit buffer */
   size_t maxBufferSize() { return _maxBufferSize; }
@@ -30,7 +45,14 @@ private:
   TwoWire *_wire;
   bool _begun;
   size_t _maxBufferSize;
+  static Adafruit_I2CDevice_RecoveryHook _recoveryHook;
+  static Adafruit_I2CDevice_RetryResultHook _retryResultHook;
   bool _read(uint8_t *buffer, size_t len, bool stop);
+  bool _readChunks(uint8_t *buffer, size_t len, bool stop);
+  bool _write(const uint8_t *buffer, size_t len, bool stop,
+              const uint8_t *prefix_buffer, size_t prefix_len);
+  bool _recover(void);
+  bool _retried(bool ok);
 };
 
 #endif // Adafruit_I2CDevice_h
@@ -88,10 +88,8 @@ Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t p, neoPixelType t)
   setPin(p);
 
 #if defined(ESP32)
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
   espInit();
 #endif
-#endif
 }
 
 /*!
@@ -3380,6 +3378,26 @@ if(is800KHz) {
   endTime = micros(); // Save EOD time for latch on next call
 }
 
+#if defined(ESP32)
+/*!
+  @brief   Start transmitting the pixel data and return without waiting for
+           the RMT to finish. The data is copied or encoded before this
+           returns, so the pixels may be changed right away. A later show()
+           or showAsync() waits for this frame and its latch time.
+  @param   done  Called from the esp_timer task when the frame has been sent
+                 and latched, or NULL.
+  @param   arg   Passed to done.
+  @return  false if nothing was sent (RMT busy for too long or unavailable).
+  @note    Call espShowWait() before light or deep sleep.
+*/
+bool Adafruit_NeoPixel::showAsync(espShowDone_t done, void *arg) {
+  if (!pixels || pin < 0)
+    return false;
+  // The latch after each frame is handled in esp.c, so endTime is not used
+  return espShowAsync(pin, pixels, numBytes, is800KHz, done, arg);
+}
+#endif
+
 /*!
   @brief   Set/change the NeoPixel output pin number. Previous pin,
            if any, is set to INPUT and the new pin is set to OUTPUT.
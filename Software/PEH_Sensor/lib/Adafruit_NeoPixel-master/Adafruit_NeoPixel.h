@@ -212,9 +212,15 @@ static const uint8_t PROGMEM _NeoPixelGammaTable[256] = {
     for specific hardware/library versions
 */
 #if defined(ESP32)
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+/*!
+    @brief  Called from the esp_timer task once a frame started with
+            showAsync() has been sent and latched. It may start the next one.
+*/
+typedef void (*espShowDone_t)(void *arg);
 extern "C" void espInit();
-#endif
+extern "C" bool espShowAsync(uint16_t pin, uint8_t *pixels, uint32_t numBytes,
+                             uint8_t is800KHz, espShowDone_t done, void *arg);
+extern "C" bool espShowWait(uint32_t timeoutMs);
 #endif
 
 /*!
@@ -232,6 +238,9 @@ public:
 
   bool begin(void);
   void show(void);
+#if defined(ESP32)
+  bool showAsync(espShowDone_t done = NULL, void *arg = NULL);
+#endif
   void setPin(int16_t p);
   void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
   void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
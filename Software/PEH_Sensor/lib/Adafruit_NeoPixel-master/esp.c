@@ -20,6 +20,7 @@
 #if defined(ESP32)
 
 #include <Arduino.h>
+#include "esp_timer.h"
 
 #if defined(ESP_IDF_VERSION)
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
@@ -30,96 +31,210 @@
 #endif
 #endif
 
+// Frames up to this many bytes are sent from a static buffer; longer strips
+// fall back to a heap buffer that grows as needed. 48 bytes = 16 RGB pixels.
+#ifndef ADAFRUIT_RMT_STATIC_BYTES
+#define ADAFRUIT_RMT_STATIC_BYTES 48
+#endif
 
-#ifdef HAS_ESP_IDF_5
+#define SEMAPHORE_TIMEOUT_MS 50
+#define LATCH_US 300 // line held low after the frame so the pixels latch it
+
+typedef void (*espShowDone_t)(void *arg);
+
+// Taken when a frame is handed to the RMT and given back once it has been
+// clocked out and latched, so frames never overlap or cut the latch short.
+// A binary semaphore rather than a mutex because it is given back from the
+// esp_timer task, not by the task that took it.
+static SemaphoreHandle_t show_sem = NULL;
+static esp_timer_handle_t show_timer = NULL;
+static espShowDone_t show_done = NULL;
+static void *show_arg = NULL;
+static bool show_late = false; // TX was still running at the expected end
+
+static bool txComplete(void); // per driver, below
+void espInit();
+
+// Runs in the esp_timer task, first at frame time + latch after the start
+static void showTimerCallback(void *unused) {
+  if (!txComplete()) {
+    // Started late (RMT or bus lock busy): look again one latch period on
+    show_late = true;
+    esp_timer_start_once(show_timer, LATCH_US);
+    return;
+  }
+  if (show_late) {
+    // Finished at some point since the last look: give it a full latch
+    show_late = false;
+    esp_timer_start_once(show_timer, LATCH_US);
+    return;
+  }
+  espShowDone_t done = show_done;
+  void *arg = show_arg;
+  show_done = NULL;
+  xSemaphoreGive(show_sem);
+  if (done)
+    done(arg); // may start the next frame
+}
 
-static SemaphoreHandle_t show_mutex = NULL;
+static bool showTake(void) {
+  if (!show_sem)
+    espInit(); // instance built with the empty constructor
+  if (!show_sem)
+    return false;
+  if (!show_timer) {
+    // Created on first use: esp_timer may not be running yet when global
+    // Adafruit_NeoPixel constructors call espInit()
+    const esp_timer_create_args_t args = {.callback = showTimerCallback,
+                                          .arg = NULL,
+                                          .dispatch_method = ESP_TIMER_TASK,
+                                          .name = "neopixel"};
+    if (esp_timer_create(&args, &show_timer) != ESP_OK)
+      return false;
+  }
+  return xSemaphoreTake(show_sem, SEMAPHORE_TIMEOUT_MS / portTICK_PERIOD_MS) ==
+         pdTRUE;
+}
 
-void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
-  // Note: Because rmtPin is shared between all instances, we will
-  //  end up releasing/initializing the RMT channels each time we
-  //  invoke on different pins. This is probably ok, just not
-  //  efficient. led_data is shared between all instances but will
-  //  be allocated with enough space for the largest instance; data
-  //  is not used beyond the mutex lock so this should be fine.
+static void showStarted(uint32_t frameUs, espShowDone_t done, void *arg) {
+  show_done = done;
+  show_arg = arg;
+  show_late = false;
+  esp_timer_start_once(show_timer, frameUs + LATCH_US);
+}
 
-#define SEMAPHORE_TIMEOUT_MS 50
+// Nothing was sent (release request or error): output is idle right away
+static bool showSkipped(bool ok, espShowDone_t done, void *arg) {
+  xSemaphoreGive(show_sem);
+  if (ok && done)
+    done(arg);
+  return ok;
+}
 
-  static rmt_data_t *led_data = NULL;
-  static uint32_t led_data_size = 0;
-  static int rmtPin = -1;
-
-  if (show_mutex && xSemaphoreTake(show_mutex, SEMAPHORE_TIMEOUT_MS / portTICK_PERIOD_MS) == pdTRUE) {
-    uint32_t requiredSize = numBytes * 8;
-    if (requiredSize > led_data_size) {
-      free(led_data);
-      if (led_data = (rmt_data_t *)malloc(requiredSize * sizeof(rmt_data_t))) {
-        led_data_size = requiredSize;
-      } else {
-        led_data_size = 0;
-      }
-    } else if (requiredSize == 0) {
-      // To release RMT resources (RMT channels and led_data), call
-      //  .updateLength(0) to set number of pixels/bytes to zero,
-      //  then call .show() to invoke this code and free resources.
-      free(led_data);
-      led_data = NULL;
-      if (rmtPin >= 0) {
-        rmtDeinit(rmtPin);
-        rmtPin = -1;
-      }
-      led_data_size = 0;
-    }
+static bool showWaitTicks(TickType_t ticks) {
+  if (!show_sem)
+    return true;
+  if (xSemaphoreTake(show_sem, ticks) != pdTRUE)
+    return false;
+  xSemaphoreGive(show_sem);
+  return true;
+}
 
-    if (led_data_size > 0 && requiredSize <= led_data_size) {
-      if (pin != rmtPin) {
-        if (rmtPin >= 0) {
-          rmtDeinit(rmtPin);
-          rmtPin = -1;
-        }
-        if (!rmtInit(pin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, 10000000)) {
-          log_e("Failed to init RMT TX mode on pin %d", pin);
-          return;
-        }
-        rmtPin = pin;
-      }
-
-      if (rmtPin >= 0) {
-        int i=0;
-        for (int b=0; b < numBytes; b++) {
-          for (int bit=0; bit<8; bit++){
-            if ( pixels[b] & (1<<(7-bit)) ) {
-              led_data[i].level0 = 1;
-              led_data[i].duration0 = 8;
-              led_data[i].level1 = 0;
-              led_data[i].duration1 = 4;
-            } else {
-              led_data[i].level0 = 1;
-              led_data[i].duration0 = 4;
-              led_data[i].level1 = 0;
-              led_data[i].duration1 = 8;
-            }
-            i++;
-          }
-        }
+/*!
+  @brief   Wait until the last frame started with espShowAsync() has been sent
+           and latched. Call before light or deep sleep, which would stop the
+           RMT mid-frame.
+  @param   timeoutMs  Maximum wait.
+  @return  true if the output is idle.
+*/
+bool espShowWait(uint32_t timeoutMs) {
+  return showWaitTicks(timeoutMs / portTICK_PERIOD_MS);
+}
 
-        rmtWrite(pin, led_data, numBytes * 8, RMT_WAIT_FOR_EVER);
-      }
-    }
+bool espShowAsync(uint16_t pin, uint8_t *pixels, uint32_t numBytes,
+                  uint8_t is800KHz, espShowDone_t done, void *arg);
 
-    xSemaphoreGive(show_mutex);
-  }
+// Blocking show, as called by Adafruit_NeoPixel::show()
+void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes,
+             boolean is800KHz) {
+  if (espShowAsync(pin, pixels, numBytes, is800KHz, NULL, NULL))
+    showWaitTicks(portMAX_DELAY);
 }
 
-// To avoid race condition initializing the mutex, all instances of
+// To avoid race condition initializing the semaphore, all instances of
 //  Adafruit_NeoPixel must be constructed before launching and child threads
 void espInit() {
-  if (!show_mutex) {
-    show_mutex = xSemaphoreCreateMutex();
+  if (!show_sem) {
+    show_sem = xSemaphoreCreateBinary();
+    xSemaphoreGive(show_sem);
   }
 }
 
-#else
+#ifdef HAS_ESP_IDF_5
+
+#include "esp_rmt_symbols.h"
+
+// Symbols for frames up to ADAFRUIT_RMT_STATIC_BYTES, 8 per byte
+static rmt_data_t static_data[ADAFRUIT_RMT_STATIC_BYTES * 8];
+static rmt_data_t *heap_data = NULL;
+static uint32_t heap_data_size = 0;
+static int rmtPin = -1;
+
+static bool txComplete(void) {
+  return rmtPin < 0 || rmtTransmitCompleted(rmtPin);
+}
+
+/*!
+  @brief   Start sending a frame and return without waiting for it.
+  @param   pin       Output pin.
+  @param   pixels    Pixel data; encoded before returning, so it may be
+                     changed right away.
+  @param   numBytes  Frame length. 0 releases the RMT channel and buffers.
+  @param   is800KHz  Unused with IDF 5 (800 KHz timing only).
+  @param   done      Called from the esp_timer task once the frame has been
+                     sent and latched, or NULL.
+  @param   arg       Passed to done.
+  @return  false if the previous frame did not finish within
+           SEMAPHORE_TIMEOUT_MS or the RMT could not be set up.
+*/
+bool espShowAsync(uint16_t pin, uint8_t *pixels, uint32_t numBytes,
+                  uint8_t is800KHz, espShowDone_t done, void *arg) {
+  // Note: Because rmtPin is shared between all instances, we will
+  //  end up releasing/initializing the RMT channels each time we
+  //  invoke on different pins. This is probably ok, just not
+  //  efficient. The symbol buffers are shared between all instances
+  //  but are only written while holding show_sem.
+  if (!showTake())
+    return false;
+
+  uint32_t requiredSize = numBytes * 8;
+  if (requiredSize == 0) {
+    // To release RMT resources (RMT channels and led_data), call
+    //  .updateLength(0) to set number of pixels/bytes to zero,
+    //  then call .show() to invoke this code and free resources.
+    free(heap_data);
+    heap_data = NULL;
+    heap_data_size = 0;
+    if (rmtPin >= 0) {
+      rmtDeinit(rmtPin);
+      rmtPin = -1;
+    }
+    return showSkipped(true, done, arg);
+  }
+
+  rmt_data_t *led_data = static_data;
+  if (numBytes > ADAFRUIT_RMT_STATIC_BYTES) {
+    if (requiredSize > heap_data_size) {
+      free(heap_data);
+      heap_data = (rmt_data_t *)malloc(requiredSize * sizeof(rmt_data_t));
+      heap_data_size = heap_data ? requiredSize : 0;
+    }
+    led_data = heap_data;
+    if (!led_data)
+      return showSkipped(false, done, arg);
+  }
+
+  if (pin != rmtPin) {
+    if (rmtPin >= 0) {
+      rmtDeinit(rmtPin);
+      rmtPin = -1;
+    }
+    if (!rmtInit(pin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, NEO_RMT_RES_HZ)) {
+      log_e("Failed to init RMT TX mode on pin %d", pin);
+      return showSkipped(false, done, arg);
+    }
+    rmtPin = pin;
+  }
+
+  neoRmtEncode(led_data, pixels, numBytes);
+  if (!rmtWriteAsync(pin, led_data, requiredSize))
+    return showSkipped(false, done, arg);
+  showStarted(requiredSize * NEO_RMT_TICKS_PER_BIT / (NEO_RMT_RES_HZ / 1000000),
+              done, arg);
+  return true;
+}
+
+#else // IDF 3/4: legacy RMT driver with a sample translator
 
 #include "driver/rmt.h"
 
@@ -152,6 +267,22 @@ static uint32_t t1l_ticks = 0;
 
 bool rmt_reserved_channels[ADAFRUIT_RMT_CHANNEL_MAX];
 
+// Items for every byte value (MSB first), filled in setupChannel() from the
+// timings of the channel: the translator copies one row per byte instead of
+// testing each bit. In DRAM because the translator runs in the RMT ISR, which
+// may fire while the flash cache is off.
+static DRAM_ATTR rmt_item32_t byte_items[256][8];
+
+static void fillByteItems(void) {
+    const rmt_item32_t bit0 = {{{ t0h_ticks, 1, t0l_ticks, 0 }}}; //Logical 0
+    const rmt_item32_t bit1 = {{{ t1h_ticks, 1, t1l_ticks, 0 }}}; //Logical 1
+    for (int v = 0; v < 256; v++) {
+        for (int i = 0; i < 8; i++) {
+            byte_items[v][i].val = (v & (0x80 >> i)) ? bit1.val : bit0.val;
+        }
+    }
+}
+
 static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
@@ -160,23 +291,14 @@ static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, si
         *item_num = 0;
         return;
     }
-    const rmt_item32_t bit0 = {{{ t0h_ticks, 1, t0l_ticks, 0 }}}; //Logical 0
-    const rmt_item32_t bit1 = {{{ t1h_ticks, 1, t1l_ticks, 0 }}}; //Logical 1
     size_t size = 0;
     size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
+    const uint8_t *psrc = (const uint8_t *)src;
     rmt_item32_t *pdest = dest;
     while (size < src_size && num < wanted_num) {
-        for (int i = 0; i < 8; i++) {
-            // MSB first
-            if (*psrc & (1 << (7 - i))) {
-                pdest->val =  bit1.val;
-            } else {
-                pdest->val =  bit0.val;
-            }
-            num++;
-            pdest++;
-        }
+        memcpy(pdest, byte_items[*psrc], sizeof(byte_items[0]));
+        num += 8;
+        pdest += 8;
         size++;
         psrc++;
     }
@@ -184,7 +306,32 @@ static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, si
     *item_num = num;
 }
 
-void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
+// The channel stays installed between frames on the same pin; the translator
+// reads the bytes from the ISR while the frame goes out, so they are copied.
+static rmt_channel_t show_channel = ADAFRUIT_RMT_CHANNEL_MAX;
+static int show_pin = -1;
+static bool show_800khz = false;
+static uint8_t static_bytes[ADAFRUIT_RMT_STATIC_BYTES];
+static uint8_t *heap_bytes = NULL;
+static uint32_t heap_bytes_size = 0;
+
+static bool txComplete(void) {
+    return show_channel == ADAFRUIT_RMT_CHANNEL_MAX ||
+           rmt_wait_tx_done(show_channel, 0) == ESP_OK;
+}
+
+static void releaseChannel(void) {
+    if (show_channel == ADAFRUIT_RMT_CHANNEL_MAX) {
+        return;
+    }
+    rmt_driver_uninstall(show_channel);
+    rmt_reserved_channels[show_channel] = false;
+    show_channel = ADAFRUIT_RMT_CHANNEL_MAX;
+    gpio_set_direction(show_pin, GPIO_MODE_OUTPUT);
+    show_pin = -1;
+}
+
+static bool setupChannel(uint8_t pin, bool is800KHz) {
     // Reserve channel
     rmt_channel_t channel = ADAFRUIT_RMT_CHANNEL_MAX;
     for (size_t i = 0; i < ADAFRUIT_RMT_CHANNEL_MAX; i++) {
@@ -196,7 +343,7 @@ void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz)
     }
     if (channel == ADAFRUIT_RMT_CHANNEL_MAX) {
         // Ran out of channels!
-        return;
+        return false;
     }
 
 #if defined(HAS_ESP_IDF_4)
@@ -257,18 +404,59 @@ void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz)
         t1l_ticks = (uint32_t)(ratio * WS2811_T1L_NS);
     }
 
+    fillByteItems();
+
     // Initialize automatic timing translator
     rmt_translator_init(config.channel, ws2812_rmt_adapter);
 
-    // Write and wait to finish
-    rmt_write_sample(config.channel, pixels, (size_t)numBytes, true);
-    rmt_wait_tx_done(config.channel, pdMS_TO_TICKS(100));
+    show_channel = channel;
+    show_pin = pin;
+    show_800khz = is800KHz;
+    return true;
+}
 
-    // Free channel again
-    rmt_driver_uninstall(config.channel);
-    rmt_reserved_channels[channel] = false;
+// See the IDF 5 version above for the parameters
+bool espShowAsync(uint16_t pin, uint8_t *pixels, uint32_t numBytes,
+                  uint8_t is800KHz, espShowDone_t done, void *arg) {
+    if (!showTake()) {
+        return false;
+    }
 
-    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
+    if (numBytes == 0) {
+        releaseChannel();
+        free(heap_bytes);
+        heap_bytes = NULL;
+        heap_bytes_size = 0;
+        return showSkipped(true, done, arg);
+    }
+
+    uint8_t *bytes = static_bytes;
+    if (numBytes > ADAFRUIT_RMT_STATIC_BYTES) {
+        if (numBytes > heap_bytes_size) {
+            free(heap_bytes);
+            heap_bytes = (uint8_t *)malloc(numBytes);
+            heap_bytes_size = heap_bytes ? numBytes : 0;
+        }
+        bytes = heap_bytes;
+        if (!bytes) {
+            return showSkipped(false, done, arg);
+        }
+    }
+
+    if (pin != show_pin || (bool)is800KHz != show_800khz) {
+        releaseChannel();
+        if (!setupChannel(pin, is800KHz)) {
+            return showSkipped(false, done, arg);
+        }
+    }
+
+    memcpy(bytes, pixels, numBytes);
+    if (rmt_write_sample(show_channel, bytes, (size_t)numBytes, false) != ESP_OK) {
+        return showSkipped(false, done, arg);
+    }
+    // 1.25 us per bit at 800 KHz, 2.5 us at 400 KHz
+    showStarted(numBytes * 8 * (is800KHz ? 125 : 250) / 100, done, arg);
+    return true;
 }
 
 #endif // ifndef IDF5
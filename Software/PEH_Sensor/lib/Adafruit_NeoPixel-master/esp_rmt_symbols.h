@@ -0,0 +1,62 @@
+/*!
+ * @file esp_rmt_symbols.h
+ *
+ * Byte-to-RMT-symbol lookup used by espShow() on ESP-IDF 5. Each entry holds
+ * the eight symbols (MSB first) for one data byte at the 10 MHz RMT resolution
+ * the Arduino core is initialised with: 800/400 ns high for a 1 bit, 400/800 ns
+ * for a 0 bit. The table is const so it lives in flash; encoding a byte is one
+ * 32-byte copy instead of eight test-and-branch steps.
+ *
+ * Plain C with no Arduino or IDF dependencies, so the encoder can also be
+ * built and timed on a host (see examples/bench_encode_host).
+ */
+
+#ifndef ESP_RMT_SYMBOLS_H
+#define ESP_RMT_SYMBOLS_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Same bit layout as rmt_data_t / rmt_symbol_word_t:
+// duration0:15, level0:1, duration1:15, level1:1
+#define NEO_RMT_SYMBOL(high, low)                                              \
+  ((uint32_t)(high) | (1UL << 15) | ((uint32_t)(low) << 16))
+#define NEO_RMT_BIT1 NEO_RMT_SYMBOL(8, 4)
+#define NEO_RMT_BIT0 NEO_RMT_SYMBOL(4, 8)
+#define NEO_RMT_RES_HZ 10000000
+#define NEO_RMT_TICKS_PER_BIT 12
+
+#define NEO_RMT_B(v, m) (((v) & (m)) ? NEO_RMT_BIT1 : NEO_RMT_BIT0)
+#define NEO_RMT_ROW(v)                                                         \
+  {NEO_RMT_B(v, 0x80), NEO_RMT_B(v, 0x40), NEO_RMT_B(v, 0x20),                 \
+   NEO_RMT_B(v, 0x10), NEO_RMT_B(v, 0x08), NEO_RMT_B(v, 0x04),                 \
+   NEO_RMT_B(v, 0x02), NEO_RMT_B(v, 0x01)}
+#define NEO_RMT_ROW4(v)                                                        \
+  NEO_RMT_ROW(v), NEO_RMT_ROW((v) + 1), NEO_RMT_ROW((v) + 2),                  \
+      NEO_RMT_ROW((v) + 3)
+#define NEO_RMT_ROW16(v)                                                       \
+  NEO_RMT_ROW4(v), NEO_RMT_ROW4((v) + 4), NEO_RMT_ROW4((v) + 8),               \
+      NEO_RMT_ROW4((v) + 12)
+#define NEO_RMT_ROW64(v)                                                       \
+  NEO_RMT_ROW16(v), NEO_RMT_ROW16((v) + 16), NEO_RMT_ROW16((v) + 32),          \
+      NEO_RMT_ROW16((v) + 48)
+
+static const uint32_t neoRmtByteSymbols[256][8] = {
+    NEO_RMT_ROW64(0), NEO_RMT_ROW64(64), NEO_RMT_ROW64(128),
+    NEO_RMT_ROW64(192)};
+
+/*!
+  @brief   Expand bytes into RMT symbols, 8 per byte (32 bytes of output per
+           input byte).
+  @param   symbols   Destination, numBytes * 8 words.
+  @param   bytes     Pixel data as stored by Adafruit_NeoPixel.
+  @param   numBytes  Number of bytes to encode.
+*/
+static inline void neoRmtEncode(void *symbols, const uint8_t *bytes,
+                                uint32_t numBytes) {
+  uint8_t *out = (uint8_t *)symbols;
+  for (uint32_t b = 0; b < numBytes; b++, out += sizeof(neoRmtByteSymbols[0]))
+    memcpy(out, neoRmtByteSymbols[bytes[b]], sizeof(neoRmtByteSymbols[0]));
+}
+
+#endif // ESP_RMT_SYMBOLS_H
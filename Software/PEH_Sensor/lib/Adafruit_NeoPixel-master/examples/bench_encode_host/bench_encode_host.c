@@ -0,0 +1,113 @@
+// Host microbenchmark of the RMT symbol encoding in espShow() (IDF 5 path):
+// the previous bit-by-bit loop against the 256-entry lookup table in
+// esp_rmt_symbols.h. Checks both produce the same symbols and prints the
+// encode cost per pixel (3 bytes) for a few strip lengths.
+//
+//   cc -O2 -I../.. -o bench_encode_host bench_encode_host.c
+//   ./bench_encode_host
+
+#include <esp_rmt_symbols.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// rmt_data_t from esp32-hal-rmt.h
+typedef union {
+  struct {
+    uint32_t duration0 : 15;
+    uint32_t level0 : 1;
+    uint32_t duration1 : 15;
+    uint32_t level1 : 1;
+  };
+  uint32_t val;
+} rmt_data_t;
+
+// What espShow() did before the table
+static void encodeBits(rmt_data_t *led_data, const uint8_t *pixels,
+                       uint32_t numBytes) {
+  int i = 0;
+  for (uint32_t b = 0; b < numBytes; b++) {
+    for (int bit = 0; bit < 8; bit++) {
+      if (pixels[b] & (1 << (7 - bit))) {
+        led_data[i].level0 = 1;
+        led_data[i].duration0 = 8;
+        led_data[i].level1 = 0;
+        led_data[i].duration1 = 4;
+      } else {
+        led_data[i].level0 = 1;
+        led_data[i].duration0 = 4;
+        led_data[i].level1 = 0;
+        led_data[i].duration1 = 8;
+      }
+      i++;
+    }
+  }
+}
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Keeps the compiler from dropping the encode loops
+static volatile uint32_t sink;
+
+static double nsPerPixel(int table, rmt_data_t *out, const uint8_t *pixels,
+                         uint32_t numPixels) {
+  uint32_t numBytes = numPixels * 3;
+  uint32_t reps = 20000000 / numBytes + 1;
+  double start = now();
+  for (uint32_t r = 0; r < reps; r++) {
+    if (table)
+      neoRmtEncode(out, pixels, numBytes);
+    else
+      encodeBits(out, pixels, numBytes);
+    sink += out[r % (numBytes * 8)].val;
+  }
+  return (now() - start) * 1e9 / ((double)reps * numPixels);
+}
+
+int main(void) {
+  const uint32_t lengths[] = {1, 16, 144, 1000};
+  const uint32_t maxPixels = 1000;
+  uint8_t *pixels = malloc(maxPixels * 3);
+  rmt_data_t *a = malloc(maxPixels * 3 * 8 * sizeof(rmt_data_t));
+  rmt_data_t *b = malloc(maxPixels * 3 * 8 * sizeof(rmt_data_t));
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < maxPixels * 3; i++) {
+    seed = seed * 1103515245 + 12345;
+    pixels[i] = (uint8_t)(seed >> 16);
+  }
+
+  // Every byte value, then random data
+  uint8_t all[256];
+  for (int v = 0; v < 256; v++)
+    all[v] = (uint8_t)v;
+  encodeBits(a, all, 256);
+  neoRmtEncode(b, all, 256);
+  if (memcmp(a, b, 256 * 8 * sizeof(rmt_data_t))) {
+    printf("table and bit loop disagree\n");
+    return 1;
+  }
+
+  printf("%8s %14s %14s %8s\n", "pixels", "bits ns/px", "table ns/px",
+         "speedup");
+  for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    uint32_t n = lengths[i];
+    double bits = nsPerPixel(0, a, pixels, n);
+    double table = nsPerPixel(1, b, pixels, n);
+    if (memcmp(a, b, n * 3 * 8 * sizeof(rmt_data_t))) {
+      printf("table and bit loop disagree at %u pixels\n", n);
+      return 1;
+    }
+    printf("%8u %14.2f %14.2f %7.1fx\n", n, bits, table, bits / table);
+  }
+  printf("symbol buffer: %u bytes per pixel; table: %u bytes of flash\n",
+         (unsigned)(3 * 8 * sizeof(rmt_data_t)),
+         (unsigned)sizeof(neoRmtByteSymbols));
+  free(pixels);
+  free(a);
+  free(b);
+  return 0;
+}
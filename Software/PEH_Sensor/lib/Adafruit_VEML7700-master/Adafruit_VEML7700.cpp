@@ -32,14 +32,58 @@
 /*!
  *    @brief  Instantiates a new VEML7700 class
  */
-Adafruit_VEML7700::Adafruit_VEML7700(void) {}
+Adafruit_VEML7700::Adafruit_VEML7700(void)
+    : ALS_Config(NULL), ALS_Data(NULL), White_Data(NULL),
+      ALS_HighThreshold(NULL), ALS_LowThreshold(NULL), Power_Saving(NULL),
+      Interrupt_Status(NULL), ALS_Shutdown(NULL), ALS_Interrupt_Enable(NULL),
+      ALS_Persistence(NULL), ALS_Integration_Time(NULL), ALS_Gain(NULL),
+      PowerSave_Enable(NULL), PowerSave_Mode(NULL), i2c_dev(NULL) {}
 
 /*!
- *    @brief  Sets up the hardware for talking to the VEML7700
+ *    @brief  Releases the I2C device and register objects
+ */
+Adafruit_VEML7700::~Adafruit_VEML7700(void) { freeRegisters(); }
+
+/*!
+ *    @brief  Deletes whatever a previous begin() allocated, so begin() can be
+ * called again (retries, or a host simulation running many wake cycles)
+ */
+void Adafruit_VEML7700::freeRegisters(void) {
+  delete ALS_Shutdown;
+  delete ALS_Interrupt_Enable;
+  delete ALS_Persistence;
+  delete ALS_Integration_Time;
+  delete ALS_Gain;
+  delete PowerSave_Enable;
+  delete PowerSave_Mode;
+  delete ALS_Config;
+  delete ALS_HighThreshold;
+  delete ALS_LowThreshold;
+  delete Power_Saving;
+  delete ALS_Data;
+  delete White_Data;
+  delete Interrupt_Status;
+  delete i2c_dev;
+  ALS_Shutdown = ALS_Interrupt_Enable = ALS_Persistence = NULL;
+  ALS_Integration_Time = ALS_Gain = PowerSave_Enable = PowerSave_Mode = NULL;
+  ALS_Config = ALS_HighThreshold = ALS_LowThreshold = Power_Saving = NULL;
+  ALS_Data = White_Data = Interrupt_Status = NULL;
+  i2c_dev = NULL;
+}
+
+/*!
+ *    @brief  Sets up the hardware for talking to the VEML7700. The ALS
+ * configuration and power saving registers are written once each, with
+ * nothing read back.
  *    @param  theWire An optional pointer to an I2C interface
+ *    @param  gain Gain constant, see setGain()
+ *    @param  it Integration time constant, see setIntegrationTime()
+ *    @param  powerSave True to enable power saving mode
  *    @return True if initialization was successful, otherwise false.
  */
-bool Adafruit_VEML7700::begin(TwoWire *theWire) {
+bool Adafruit_VEML7700::begin(TwoWire *theWire, uint8_t gain, uint8_t it,
+                              bool powerSave) {
+  freeRegisters();
   i2c_dev = new Adafruit_I2CDevice(VEML7700_I2CADDR_DEFAULT, theWire);
 
   if (!i2c_dev->begin()) {
@@ -69,19 +113,44 @@ bool Adafruit_VEML7700::begin(TwoWire *theWire) {
   PowerSave_Enable = new Adafruit_I2CRegisterBits(Power_Saving, 1, 0);
   PowerSave_Mode = new Adafruit_I2CRegisterBits(Power_Saving, 2, 1);
 
-  enable(false);
+  // The device never changes its configuration registers, so they are
+  // shadowed: read-modify-writes and gain/IT lookups cost no bus reads
+  ALS_Config->enableCache();
+  Power_Saving->enableCache();
+
+  // Every field is set, so the shadow starts from 0 instead of a bus read
+  ALS_Config->beginUpdate();
+  ALS_Config->write(0);
   interruptEnable(false);
   setPersistence(VEML7700_PERS_1);
-  setGain(VEML7700_GAIN_1_8);
-  setIntegrationTime(VEML7700_IT_100MS);
-  powerSaveEnable(false);
-  enable(true);
+  ALS_Gain->write(gain);
+  ALS_Integration_Time->write(it);
+  ALS_Shutdown->write(0);
+  ALS_Config->endUpdate();
+  Power_Saving->beginUpdate();
+  Power_Saving->write(0);
+  powerSaveEnable(powerSave);
+  Power_Saving->endUpdate();
+  delay(5); // 2.5 ms after power on (see enable()), doubled
 
   lastRead = millis();
 
   return true;
 }
 
+/*!
+ *    @brief Forget the shadowed configuration registers, so the next getter
+ * or read-modify-write reads them from the device again. Call it when the
+ * sensor may have changed state behind the driver, e.g. after a bus recovery
+ * or a brownout of the sensor. begin() starts a fresh shadow by itself.
+ */
+void Adafruit_VEML7700::invalidateCache(void) {
+  if (ALS_Config)
+    ALS_Config->invalidateCache();
+  if (Power_Saving)
+    Power_Saving->invalidateCache();
+}
+
 /*!
  *    @brief Read the calibrated lux value. See app note lux table on page 5
  *    @param method Lux comptation method to use. One of
@@ -83,7 +83,10 @@ typedef enum {
 class Adafruit_VEML7700 {
 public:
   Adafruit_VEML7700();
-  bool begin(TwoWire *theWire = &Wire);
+  ~Adafruit_VEML7700();
+  bool begin(TwoWire *theWire = &Wire, uint8_t gain = VEML7700_GAIN_1_8,
+             uint8_t it = VEML7700_IT_100MS, bool powerSave = false);
+  void invalidateCache(void);
 
   void enable(bool enable);
   bool enabled(void);
@@ -121,6 +124,7 @@ private:
   float computeLux(uint16_t rawALS, bool corrected = false);
   float autoLux(void);
   void readWait(void);
+  void freeRegisters(void);
   unsigned long lastRead;
 
   Adafruit_I2CRegister *ALS_Config, *ALS_Data, *White_Data, *ALS_HighThreshold,
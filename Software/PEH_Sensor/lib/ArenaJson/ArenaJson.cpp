@@ -0,0 +1,79 @@
+#include "ArenaJson.h"
+
+#include <string.h>
+
+static size_t redondear(size_t bytes)
+{
+  return (bytes + ALINEACION_ARENA_JSON - 1) & ~(size_t)(ALINEACION_ARENA_JSON - 1);
+}
+
+ArenaJson::ArenaJson(void *memoria, size_t capacidad)
+    : _memoria((uint8_t *)memoria), _capacidad(capacidad & ~(size_t)(ALINEACION_ARENA_JSON - 1)), _usados(0),
+      _maximo(0), _ultimo(nullptr), _peticiones(0), _fallos(0)
+{
+}
+
+uint8_t *ArenaJson::reservar(size_t bytes)
+{
+  _peticiones++;
+  bytes = redondear(bytes ? bytes : 1);
+  if (bytes > _capacidad - _usados)
+  {
+    _fallos++;
+    return nullptr;
+  }
+  uint8_t *p = _memoria + _usados;
+  _usados += bytes;
+  if (_usados > _maximo)
+    _maximo = _usados;
+  _ultimo = p;
+  return p;
+}
+
+void *ArenaJson::allocate(size_t bytes)
+{
+  return reservar(bytes);
+}
+
+void ArenaJson::deallocate(void *p)
+{
+  // Solo el último vuelve a la arena; el resto espera a reiniciar()
+  if (p && p == _ultimo)
+  {
+    _usados = _ultimo - _memoria;
+    _ultimo = nullptr;
+  }
+}
+
+void *ArenaJson::reallocate(void *p, size_t bytes)
+{
+  if (!p)
+    return reservar(bytes);
+
+  if (p == _ultimo)
+  {
+    size_t inicio = _ultimo - _memoria;
+    size_t nuevo = redondear(bytes ? bytes : 1);
+    if (nuevo > _capacidad - inicio)
+    {
+      _peticiones++;
+      _fallos++;
+      return nullptr; // p sigue siendo válido, como con realloc()
+    }
+    if (inicio + nuevo > _usados)
+      _peticiones++;
+    _usados = inicio + nuevo;
+    if (_usados > _maximo)
+      _maximo = _usados;
+    return p;
+  }
+
+  // No se sabe el tamaño del bloque: se copia lo que hay de él hasta el final ocupado,
+  // que incluye todo el bloque; lo que sobra es basura que quien llama no lee
+  uint8_t *anterior = (uint8_t *)p;
+  size_t disponible = _usados - (anterior - _memoria);
+  uint8_t *nuevo = reservar(bytes);
+  if (nuevo)
+    memcpy(nuevo, anterior, bytes < disponible ? bytes : disponible);
+  return nuevo;
+}
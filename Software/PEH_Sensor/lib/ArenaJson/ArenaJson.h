@@ -0,0 +1,86 @@
+// Allocator de ArduinoJson sobre un buffer fijo (estático o en RTC) para que los documentos
+// del nodo no toquen el heap: los pools y las cadenas salen de la arena en orden y nada se
+// devuelve hasta reiniciar(), que la vacía de golpe (O(1)) entre lote y lote. Así el heap no
+// se fragmenta entre un BLEDevice::init() y el siguiente.
+//
+//   static ArenaJsonFija<4096> arena;
+//   {
+//     JsonDocument doc(&arena);
+//     deserializeJson(doc, texto);
+//     ...
+//   }                  // el documento se destruye antes de reiniciar
+//   arena.reiniciar();
+//
+// El último bloque servido se puede liberar o redimensionar en su sitio: es lo que hace
+// StringBuilder al crecer una cadena, así que leer cadenas no desperdicia arena. Un bloque
+// anterior que se redimensiona se copia al final; por eso quien la use compila
+// ArduinoJson con ARDUINOJSON_AUTO_SHRINK=0 (como [env:native_json]): shrinkToFit() encogería el
+// último pool, que casi nunca es el último bloque, y lo duplicaría.
+// Lleva la marca de agua (máximo ocupado) para dimensionar la arena con datos reales.
+//
+// Uso desde un único contexto; no es segura entre tareas.
+
+#ifndef ARENA_JSON_H
+#define ARENA_JSON_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoJson.h>
+
+// Alineación de cada bloque: la de los slots de variantes (double, uint64_t)
+#define ALINEACION_ARENA_JSON 8
+
+class ArenaJson : public ArduinoJson::Allocator
+{
+public:
+  ArenaJson(void *memoria, size_t capacidad);
+
+  void *allocate(size_t bytes) override;
+  void deallocate(void *p) override;
+  void *reallocate(void *p, size_t bytes) override;
+
+  // Todo lo servido queda libre. Los documentos que usan la arena deben estar destruidos
+  // o vacíos (clear()): sus punteros dejan de ser válidos.
+  void reiniciar()
+  {
+    _usados = 0;
+    _ultimo = nullptr;
+  }
+
+  size_t capacidad() const { return _capacidad; }
+  size_t usados() const { return _usados; }
+  size_t maximo() const { return _maximo; } // marca de agua desde el arranque o reiniciarMaximo()
+  uint32_t peticiones() const { return _peticiones; } // allocate() y reallocate() que piden sitio nuevo
+  uint32_t fallos() const { return _fallos; }         // peticiones sin sitio (el documento da NoMemory)
+  void reiniciarMaximo()
+  {
+    _maximo = _usados;
+    _peticiones = 0;
+    _fallos = 0;
+  }
+
+private:
+  uint8_t *reservar(size_t bytes);
+
+  uint8_t *_memoria;
+  size_t _capacidad;
+  size_t _usados;
+  size_t _maximo;
+  uint8_t *_ultimo; // último bloque servido, el único que se puede liberar o mover el final
+  uint32_t _peticiones;
+  uint32_t _fallos;
+};
+
+// Arena con su propio buffer. En la placa se puede declarar RTC_DATA_ATTR para sacarla
+// de la RAM principal (8 KB de RTC rápida en el ESP32-S3, compartidos con el resto).
+template <size_t N>
+class ArenaJsonFija : public ArenaJson
+{
+public:
+  ArenaJsonFija() : ArenaJson(_buffer, N) {}
+
+private:
+  alignas(ALINEACION_ARENA_JSON) uint8_t _buffer[N];
+};
+
+#endif
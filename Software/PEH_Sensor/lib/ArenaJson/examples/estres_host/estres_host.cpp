@@ -0,0 +1,294 @@
+// Estrés de ArenaJson en el host: deserializa muchas veces documentos representativos del
+// nodo (lote MsgPack de registros, configuración y diagnóstico en JSON) con el Allocator
+// por defecto (malloc, contado) y con la arena, y da por documento las peticiones de
+// memoria, el máximo ocupado y el tiempo. Después mezcla los documentos al azar reiniciando
+// la arena entre uno y otro, y comprueba que la marca de agua no crece, que una arena
+// pequeña da NoMemory sin romper nada y que los dos caminos leen lo mismo.
+//
+//   g++ -std=c++11 -O2 -I../.. -I../../../ArduinoJson/src estres_host.cpp ../../ArenaJson.cpp -o estres_host
+//   ./estres_host [documentos]
+//
+// El perfil de [env:native_json] (platformio.ini) se prueba añadiendo sus -D:
+//   -DARDUINOJSON_POOL_CAPACITY=32 -DARDUINOJSON_AUTO_SHRINK=0
+// En un host de 64 bits los slots ocupan el doble que en la placa (16 B frente a 8).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ArenaJson.h>
+
+#define TAM_ARENA 8192
+
+// --- ALLOCATOR POR DEFECTO, CONTADO ---
+// malloc con una cabecera que guarda el tamaño para llevar lo vivo y su máximo
+class HeapContado : public ArduinoJson::Allocator
+{
+public:
+  void *allocate(size_t bytes) override
+  {
+    peticiones++;
+    size_t *p = (size_t *)malloc(sizeof(size_t) + bytes);
+    if (!p)
+      return nullptr;
+    *p = bytes;
+    sumar(bytes);
+    return p + 1;
+  }
+
+  void deallocate(void *q) override
+  {
+    if (!q)
+      return;
+    size_t *p = (size_t *)q - 1;
+    vivos -= *p;
+    free(p);
+  }
+
+  void *reallocate(void *q, size_t bytes) override
+  {
+    if (!q)
+      return allocate(bytes);
+    size_t *p = (size_t *)q - 1;
+    size_t anterior = *p;
+    if (bytes > anterior)
+      peticiones++;
+    size_t *nuevo = (size_t *)realloc(p, sizeof(size_t) + bytes);
+    if (!nuevo)
+      return nullptr;
+    *nuevo = bytes;
+    vivos -= anterior;
+    sumar(bytes);
+    return nuevo + 1;
+  }
+
+  void reiniciarMaximo()
+  {
+    maximo = vivos;
+    peticiones = 0;
+  }
+
+  size_t vivos = 0;
+  size_t maximo = 0;
+  uint32_t peticiones = 0;
+
+private:
+  void sumar(size_t bytes)
+  {
+    vivos += bytes;
+    if (vivos > maximo)
+      maximo = vivos;
+  }
+};
+
+// --- DOCUMENTOS ---
+struct Carga
+{
+  const char *nombre;
+  std::string bytes;
+  bool msgpack;
+};
+
+static uint32_t azar = 7;
+static uint32_t siguiente()
+{
+  azar ^= azar << 13;
+  azar ^= azar >> 17;
+  azar ^= azar << 5;
+  return azar;
+}
+
+// Lote de src/lote.h con 5 registros
+static std::string loteMsgPack()
+{
+  JsonDocument doc;
+  doc["v"] = 1;
+  JsonArray c = doc["c"].to<JsonArray>();
+  for (const char *nombre : {"temp", "humAir", "humSoil", "lux", "batt"})
+    c.add(nombre);
+  JsonArray r = doc["r"].to<JsonArray>();
+  for (int i = 0; i < 5; i++)
+  {
+    JsonArray fila = r.add<JsonArray>();
+    fila.add(21.37f + i);
+    fila.add(55.1f - i);
+    fila.add(2150 + i);
+    fila.add(820.25f * i);
+    fila.add(3.951f);
+  }
+  std::string s;
+  serializeMsgPack(doc, s);
+  return s;
+}
+
+// Ajustes de muestreo escritos por BLE (la forma que tendría en JSON)
+static const char CONFIGURACION[] =
+    "{\"version\":3,\"ciclo_min\":10,\"registros\":10,\"paquete\":5,\"timeout_ble_s\":20,"
+    "\"veml\":{\"ganancia\":\"x1\",\"integracion_ms\":100},"
+    "\"banda\":{\"temp\":0.2,\"hum_aire\":1.0,\"hum_suelo\":40,\"lux_abs\":2.0,\"lux_rel\":0.05,\"batt\":0.02},"
+    "\"heartbeat\":6,\"sitio\":\"invernadero-norte-3\",\"notas\":\"riego por goteo; sombra 30%\"}";
+
+// Diagnóstico I2C con los contadores de cada dispositivo
+static std::string diagnosticoJson()
+{
+  JsonDocument doc;
+  doc["version"] = 1;
+  doc["secuencia"] = 4711;
+  doc["bajadas"] = 2;
+  JsonArray dispositivos = doc["dispositivos"].to<JsonArray>();
+  for (const char *nombre : {"SHTC3", "VEML7700", "INA226"})
+  {
+    JsonObject d = dispositivos.add<JsonObject>();
+    d["nombre"] = nombre;
+    d["transacciones"] = 120000 + siguiente() % 1000;
+    d["nacks"] = siguiente() % 5;
+    d["crc"] = siguiente() % 3;
+    JsonArray latencia = d["latencia"].to<JsonArray>();
+    for (int i = 0; i < 8; i++)
+      latencia.add(siguiente() % 5000);
+  }
+  std::string s;
+  serializeJson(doc, s);
+  return s;
+}
+
+static DeserializationError leer(JsonDocument &doc, const Carga &carga)
+{
+  return carga.msgpack ? deserializeMsgPack(doc, carga.bytes.data(), carga.bytes.size())
+                       : deserializeJson(doc, carga.bytes.data(), carga.bytes.size());
+}
+
+static std::string comoTexto(const JsonDocument &doc)
+{
+  std::string s;
+  serializeJson(doc, s);
+  return s;
+}
+
+typedef std::chrono::steady_clock Reloj;
+
+int main(int argc, char **argv)
+{
+  uint32_t documentos = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 100000;
+  if (documentos == 0)
+    documentos = 1;
+
+  Carga cargas[] = {
+      {"lote msgpack", loteMsgPack(), true},
+      {"configuracion", CONFIGURACION, false},
+      {"diagnostico", diagnosticoJson(), false},
+  };
+  const size_t numCargas = sizeof(cargas) / sizeof(cargas[0]);
+
+  static ArenaJsonFija<TAM_ARENA> arena;
+  HeapContado heap;
+  bool correcto = true;
+
+  printf("ARDUINOJSON_POOL_CAPACITY %d, AUTO_SHRINK %d, punteros de %u bytes; arena de %u bytes\n\n",
+         ARDUINOJSON_POOL_CAPACITY, ARDUINOJSON_AUTO_SHRINK, (unsigned)sizeof(void *), TAM_ARENA);
+  printf("%-14s %7s | %12s %10s %9s | %12s %10s %9s\n", "documento", "bytes", "heap pet/doc", "heap máx",
+         "heap ns", "arena pet/doc", "arena máx", "arena ns");
+
+  uint32_t vueltas = documentos / numCargas + 1;
+  size_t maximoCarga[numCargas];
+  for (size_t i = 0; i < numCargas; i++)
+  {
+    const Carga &carga = cargas[i];
+    std::string referencia;
+    {
+      JsonDocument doc(&heap);
+      if (leer(doc, carga) != DeserializationError::Ok)
+      {
+        printf("%s: no se puede leer\n", carga.nombre);
+        return 1;
+      }
+      referencia = comoTexto(doc);
+    }
+
+    heap.reiniciarMaximo();
+    Reloj::time_point inicio = Reloj::now();
+    for (uint32_t v = 0; v < vueltas; v++)
+    {
+      JsonDocument doc(&heap);
+      leer(doc, carga);
+    }
+    double nsHeap = std::chrono::duration<double, std::nano>(Reloj::now() - inicio).count() / vueltas;
+    double peticionesHeap = (double)heap.peticiones / vueltas;
+
+    arena.reiniciar();
+    arena.reiniciarMaximo();
+    inicio = Reloj::now();
+    for (uint32_t v = 0; v < vueltas; v++)
+    {
+      {
+        JsonDocument doc(&arena);
+        leer(doc, carga);
+      }
+      arena.reiniciar();
+    }
+    double nsArena = std::chrono::duration<double, std::nano>(Reloj::now() - inicio).count() / vueltas;
+    double peticionesArena = (double)arena.peticiones() / vueltas;
+
+    {
+      JsonDocument doc(&arena);
+      if (leer(doc, carga) != DeserializationError::Ok || comoTexto(doc) != referencia)
+      {
+        printf("%s: la arena no lee lo mismo que el heap\n", carga.nombre);
+        correcto = false;
+      }
+    }
+    arena.reiniciar();
+    maximoCarga[i] = arena.maximo();
+
+    printf("%-14s %7zu | %12.1f %10zu %9.0f | %12.1f %10zu %9.0f\n", carga.nombre, carga.bytes.size(),
+           peticionesHeap, heap.maximo, nsHeap, peticionesArena, arena.maximo(), nsArena);
+  }
+
+  // Mezcla al azar: la marca de agua debe ser la del documento más grande, no crecer
+  arena.reiniciarMaximo();
+  size_t maximoTrasPrimeros = 0;
+  for (uint32_t n = 0; n < documentos; n++)
+  {
+    {
+      JsonDocument doc(&arena);
+      if (leer(doc, cargas[siguiente() % numCargas]) != DeserializationError::Ok)
+      {
+        printf("documento %u: error en la mezcla\n", n);
+        correcto = false;
+        break;
+      }
+    }
+    arena.reiniciar();
+    if (n == 1000)
+      maximoTrasPrimeros = arena.maximo();
+  }
+  printf("\nmezcla de %u documentos: máximo %zu bytes (%zu tras los 1000 primeros), %u fallos\n", documentos,
+         arena.maximo(), maximoTrasPrimeros, arena.fallos());
+  if (documentos > 1000 && arena.maximo() != maximoTrasPrimeros)
+    correcto = false;
+
+  // Sin sitio: con la mitad de lo que necesita el diagnóstico debe dar NoMemory, y la
+  // arena sigue sirviendo tras reiniciar
+  size_t tamPequena = maximoCarga[2] / 2;
+  std::vector<uint64_t> memoriaPequena(tamPequena / sizeof(uint64_t));
+  ArenaJson pequena(memoriaPequena.data(), memoriaPequena.size() * sizeof(uint64_t));
+  DeserializationError error;
+  {
+    JsonDocument doc(&pequena);
+    error = leer(doc, cargas[2]);
+  }
+  pequena.reiniciar();
+  bool recupera;
+  {
+    JsonDocument doc(&pequena);
+    recupera = deserializeJson(doc, "\"nodo\"") == DeserializationError::Ok && doc == "nodo" && pequena.usados() > 0;
+  }
+  printf("arena de %zu bytes con el diagnóstico: %s (%u fallos); después: %s\n", tamPequena, error.c_str(),
+         pequena.fallos(), recupera ? "bien" : "MAL");
+  if (error != DeserializationError::NoMemory || !recupera)
+    correcto = false;
+
+  return correcto ? 0 : 1;
+}
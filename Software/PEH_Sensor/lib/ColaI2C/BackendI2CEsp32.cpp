@@ -0,0 +1,99 @@
+#include "BackendI2CEsp32.h"
+
+#ifdef BACKEND_I2C_ESP32
+#include <esp_timer.h>
+#include <esp_rom_sys.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+BackendI2CEsp32::BackendI2CEsp32(i2c_port_t puerto, uint32_t timeoutMs)
+    : _puerto(puerto), _timeoutMs(timeoutMs)
+{
+}
+
+// El maestro responde NACK solo al último byte que lee antes del STOP o de un repeated
+// start; varios pasos de lectura seguidos son una única lectura para el esclavo
+static bool ultimaLectura(const PasoI2C *pasos, uint8_t i, uint8_t numPasos)
+{
+  for (uint8_t j = i + 1; j < numPasos; j++)
+  {
+    if (pasos[j].tipo == I2C_REPEATED_START)
+      return true;
+    if (pasos[j].longitud > 0)
+      return false;
+  }
+  return true;
+}
+
+ResultadoI2C BackendI2CEsp32::ejecutar(uint8_t direccion, const PasoI2C *pasos, uint8_t numPasos)
+{
+  i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(_enlace, sizeof(_enlace));
+  if (!cmd)
+    return I2C_ERROR;
+
+  // START + dirección al principio y tras cada repeated start; el sentido lo marca el
+  // primer paso de datos de la fase
+  bool direccionar = true;
+  esp_err_t err = ESP_OK;
+  for (uint8_t i = 0; i < numPasos && err == ESP_OK; i++)
+  {
+    const PasoI2C &p = pasos[i];
+    if (p.tipo == I2C_REPEATED_START)
+    {
+      direccionar = true;
+      continue;
+    }
+    if (direccionar)
+    {
+      err = i2c_master_start(cmd);
+      if (err == ESP_OK)
+        err = i2c_master_write_byte(cmd, (direccion << 1) | (p.tipo == I2C_LEER ? I2C_MASTER_READ : I2C_MASTER_WRITE), true);
+      direccionar = false;
+    }
+    if (err != ESP_OK)
+      break;
+    if (p.tipo == I2C_ESCRIBIR && p.longitud > 0)
+      err = i2c_master_write(cmd, p.datosEscribir, p.longitud, true);
+    else if (p.tipo == I2C_LEER && p.longitud > 0)
+    {
+      i2c_ack_type_t ack = ultimaLectura(pasos, i, numPasos) ? I2C_MASTER_LAST_NACK : I2C_MASTER_ACK;
+      err = i2c_master_read(cmd, p.datosLeer, p.longitud, ack);
+    }
+  }
+  if (err == ESP_OK)
+    err = i2c_master_stop(cmd);
+  if (err == ESP_OK)
+    err = i2c_master_cmd_begin(_puerto, cmd, pdMS_TO_TICKS(_timeoutMs));
+  i2c_cmd_link_delete_static(cmd);
+
+  switch (err)
+  {
+  case ESP_OK:
+    return I2C_OK;
+  case ESP_FAIL:
+    return I2C_NACK;
+  case ESP_ERR_TIMEOUT:
+    return I2C_TIMEOUT;
+  default:
+    return I2C_ERROR;
+  }
+}
+
+uint32_t BackendI2CEsp32::ahoraUs()
+{
+  return (uint32_t)esp_timer_get_time();
+}
+
+void BackendI2CEsp32::dormirUs(uint32_t us)
+{
+  // Los ticks enteros se ceden al planificador (la CPU puede entrar en idle); el resto,
+  // por debajo de un tick, no compensa un cambio de contexto
+  uint32_t ticks = us / (portTICK_PERIOD_MS * 1000);
+  if (ticks > 0)
+    vTaskDelay(ticks);
+  uint32_t resto = us - ticks * portTICK_PERIOD_MS * 1000;
+  if (resto > 0)
+    esp_rom_delay_us(resto);
+}
+
+#endif
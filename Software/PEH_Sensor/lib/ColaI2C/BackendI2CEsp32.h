@@ -0,0 +1,36 @@
+// Backend de ColaI2C sobre el driver I2C maestro legacy de ESP-IDF (driver/i2c.h).
+// Comparte el puerto con Wire, así que solo vale si Wire usa ese mismo driver: el core de
+// Arduino 2.x, sobre ESP-IDF 4.4. Llamar después de Wire.begin(), que instala el driver.
+// Con ESP-IDF 5 (core 3.x) no se compila y BACKEND_I2C_ESP32 queda sin definir: allí va
+// BackendI2CWire.
+
+#ifndef BACKEND_I2C_ESP32_H
+#define BACKEND_I2C_ESP32_H
+
+#ifdef ESP_PLATFORM
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION_MAJOR < 5
+#define BACKEND_I2C_ESP32
+
+#include "ColaI2C.h"
+#include <driver/i2c.h>
+
+class BackendI2CEsp32 : public BackendI2C
+{
+public:
+  explicit BackendI2CEsp32(i2c_port_t puerto = I2C_NUM_0, uint32_t timeoutMs = 50);
+
+  ResultadoI2C ejecutar(uint8_t direccion, const PasoI2C *pasos, uint8_t numPasos) override;
+  uint32_t ahoraUs() override;
+  void dormirUs(uint32_t us) override;
+
+private:
+  i2c_port_t _puerto;
+  uint32_t _timeoutMs;
+  // Enlace de comandos estático: sin malloc por transacción
+  uint8_t _enlace[I2C_LINK_RECOMMENDED_SIZE(8)];
+};
+
+#endif
+#endif
+#endif
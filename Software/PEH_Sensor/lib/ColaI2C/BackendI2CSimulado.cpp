@@ -0,0 +1,68 @@
+#include "BackendI2CSimulado.h"
+
+BackendI2CSimulado::BackendI2CSimulado(uint32_t relojHz)
+    : _numDispositivos(0), _relojHz(relojHz), _ahoraUs(0), _bytes(0), _segmentos(0)
+{
+}
+
+bool BackendI2CSimulado::agregar(DispositivoI2CSimulado &dispositivo)
+{
+  if (_numDispositivos >= MAX_DISPOSITIVOS)
+    return false;
+  _dispositivos[_numDispositivos++] = &dispositivo;
+  return true;
+}
+
+DispositivoI2CSimulado *BackendI2CSimulado::buscar(uint8_t direccion)
+{
+  for (uint8_t i = 0; i < _numDispositivos; i++)
+    if (_dispositivos[i]->direccion() == direccion)
+      return _dispositivos[i];
+  return nullptr;
+}
+
+ResultadoI2C BackendI2CSimulado::ejecutar(uint8_t direccion, const PasoI2C *pasos, uint8_t numPasos)
+{
+  _segmentos++;
+  DispositivoI2CSimulado *d = buscar(direccion);
+  ResultadoI2C resultado = I2C_OK;
+  bool direccionar = true;
+
+  for (uint8_t i = 0; i < numPasos && resultado == I2C_OK; i++)
+  {
+    const PasoI2C &p = pasos[i];
+    if (p.tipo == I2C_REPEATED_START)
+    {
+      direccionar = true;
+      continue;
+    }
+    if (direccionar)
+    {
+      // Igual que el driver real: la transferencia se aborta tras un NACK
+      avanzarBytes(1);
+      _bytes++;
+      if (!d || !d->direccionar(p.tipo == I2C_LEER, _ahoraUs))
+        resultado = I2C_NACK;
+      direccionar = false;
+      if (resultado != I2C_OK)
+        break;
+      if (p.tipo == I2C_LEER)
+        _ahoraUs += d->esperaLecturaUs(_ahoraUs);
+    }
+    for (uint16_t n = 0; n < p.longitud && resultado == I2C_OK; n++)
+    {
+      avanzarBytes(1);
+      _bytes++;
+      if (p.tipo == I2C_ESCRIBIR)
+      {
+        if (!d->escribir(p.datosEscribir[n], _ahoraUs))
+          resultado = I2C_NACK;
+      }
+      else if (p.tipo == I2C_LEER)
+        p.datosLeer[n] = d->leer(_ahoraUs);
+    }
+  }
+  if (d)
+    d->parar(_ahoraUs);
+  return resultado;
+}
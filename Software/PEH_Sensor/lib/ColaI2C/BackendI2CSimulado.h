@@ -0,0 +1,41 @@
+// Backend de ColaI2C para el host: reproduce las transacciones contra dispositivos
+// simulados (SimuladorI2C) con un reloj virtual que avanza según la velocidad del bus.
+
+#ifndef BACKEND_I2C_SIMULADO_H
+#define BACKEND_I2C_SIMULADO_H
+
+#include "ColaI2C.h"
+#include <DispositivoI2CSimulado.h>
+
+class BackendI2CSimulado : public BackendI2C
+{
+public:
+  static const uint8_t MAX_DISPOSITIVOS = 8;
+
+  explicit BackendI2CSimulado(uint32_t relojHz = 400000);
+
+  bool agregar(DispositivoI2CSimulado &dispositivo);
+  void fijarReloj(uint32_t relojHz) { _relojHz = relojHz; }
+
+  ResultadoI2C ejecutar(uint8_t direccion, const PasoI2C *pasos, uint8_t numPasos) override;
+  uint32_t ahoraUs() override { return _ahoraUs; }
+  void dormirUs(uint32_t us) override { _ahoraUs += us; }
+
+  // Contadores de tráfico para perfilar drivers
+  uint32_t bytesTransferidos() const { return _bytes; }
+  uint32_t segmentos() const { return _segmentos; }
+
+private:
+  DispositivoI2CSimulado *buscar(uint8_t direccion);
+  // 9 ciclos de SCL por byte (8 bits + ACK)
+  void avanzarBytes(uint32_t bytes) { _ahoraUs += (bytes * 9 * 1000000UL + _relojHz - 1) / _relojHz; }
+
+  DispositivoI2CSimulado *_dispositivos[MAX_DISPOSITIVOS];
+  uint8_t _numDispositivos;
+  uint32_t _relojHz;
+  uint32_t _ahoraUs;
+  uint32_t _bytes;
+  uint32_t _segmentos;
+};
+
+#endif
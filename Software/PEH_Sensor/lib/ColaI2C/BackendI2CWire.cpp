@@ -0,0 +1,61 @@
+#include "BackendI2CWire.h"
+
+ResultadoI2C BackendI2CWire::ejecutar(uint8_t direccion, const PasoI2C *pasos, uint8_t numPasos)
+{
+  uint8_t i = 0;
+  while (i < numPasos)
+  {
+    // Fase: hasta el siguiente repeated start; el STOP solo al final del segmento. El
+    // sentido lo marca su primer paso.
+    uint8_t fin = i;
+    while (fin < numPasos && pasos[fin].tipo != I2C_REPEATED_START)
+      fin++;
+    bool stop = fin >= numPasos;
+
+    if (fin > i && pasos[i].tipo == I2C_LEER)
+    {
+      for (uint8_t p = i; p < fin; p++)
+      {
+        size_t n = pasos[p].longitud;
+        if (_wire.requestFrom((uint16_t)direccion, n, stop && p + 1 == fin) != n)
+          return I2C_NACK;
+        for (size_t k = 0; k < n; k++)
+          pasos[p].datosLeer[k] = (uint8_t)_wire.read();
+      }
+    }
+    else if (fin > i)
+    {
+      _wire.beginTransmission(direccion);
+      for (uint8_t p = i; p < fin; p++)
+        if (_wire.write(pasos[p].datosEscribir, pasos[p].longitud) != pasos[p].longitud)
+          return I2C_ERROR; // no cabe en el buffer de Wire
+      switch (_wire.endTransmission(stop))
+      {
+      case 0:
+        break;
+      case 2: // NACK a la dirección
+      case 3: // NACK a un dato
+        return I2C_NACK;
+      case 5:
+        return I2C_TIMEOUT;
+      default:
+        return I2C_ERROR;
+      }
+    }
+    i = fin + 1;
+  }
+  return I2C_OK;
+}
+
+uint32_t BackendI2CWire::ahoraUs()
+{
+  return micros();
+}
+
+void BackendI2CWire::dormirUs(uint32_t us)
+{
+  // delay() cede la CPU al planificador; el resto, por debajo de 1 ms, no compensa
+  delay(us / 1000);
+  if (us % 1000 > 0)
+    delayMicroseconds(us % 1000);
+}
@@ -0,0 +1,25 @@
+// Backend de ColaI2C sobre un TwoWire de Arduino: cada segmento es una o varias
+// transferencias de Wire enlazadas con repeated start. Vale con cualquier versión del
+// core (no toca el driver de ESP-IDF que haya debajo de Wire) y en el host sobre el
+// TwoWire simulado. Las esperas ceden la CPU con delay().
+
+#ifndef BACKEND_I2C_WIRE_H
+#define BACKEND_I2C_WIRE_H
+
+#include "ColaI2C.h"
+#include <Wire.h>
+
+class BackendI2CWire : public BackendI2C
+{
+public:
+  explicit BackendI2CWire(TwoWire &wire) : _wire(wire) {}
+
+  ResultadoI2C ejecutar(uint8_t direccion, const PasoI2C *pasos, uint8_t numPasos) override;
+  uint32_t ahoraUs() override;
+  void dormirUs(uint32_t us) override;
+
+private:
+  TwoWire &_wire;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "ColaI2C.h"
+
+ColaI2C::ColaI2C(BackendI2C &backend) : _backend(backend), _cabeza(nullptr), _ultima(nullptr)
+{
+  reiniciarEstadisticas();
+}
+
+void ColaI2C::reiniciarEstadisticas()
+{
+  _estadisticas = EstadisticasColaI2C{0, 0, 0, 0, 0, 0};
+}
+
+void ColaI2C::enviar(TransaccionI2C &transaccion, CallbackI2C alCompletar, void *ctx)
+{
+  if (alCompletar)
+  {
+    transaccion.alCompletar = alCompletar;
+    transaccion.ctx = ctx;
+  }
+  transaccion.resultado = I2C_PENDIENTE;
+  transaccion.duracionUs = 0;
+  transaccion.siguientePaso = 0;
+  transaccion.enviadaUs = _backend.ahoraUs();
+  transaccion.listaUs = transaccion.enviadaUs;
+  transaccion.siguiente = nullptr;
+
+  // FIFO: a igualdad de disponibilidad se respeta el orden de envío
+  if (_ultima)
+    _ultima->siguiente = &transaccion;
+  else
+    _cabeza = &transaccion;
+  _ultima = &transaccion;
+}
+
+void ColaI2C::completar(TransaccionI2C *transaccion, TransaccionI2C *anterior, ResultadoI2C resultado)
+{
+  if (anterior)
+    anterior->siguiente = transaccion->siguiente;
+  else
+    _cabeza = transaccion->siguiente;
+  if (_ultima == transaccion)
+    _ultima = anterior;
+  transaccion->siguiente = nullptr;
+
+  transaccion->duracionUs = _backend.ahoraUs() - transaccion->enviadaUs;
+  _estadisticas.transacciones++;
+  if (resultado != I2C_OK)
+    _estadisticas.errores++;
+
+  // El resultado se publica al final: quien sondea completada() ve la duración ya escrita
+  transaccion->resultado = resultado;
+  if (transaccion->alCompletar)
+    transaccion->alCompletar(*transaccion, transaccion->ctx);
+}
+
+bool ColaI2C::ejecutarUno()
+{
+  uint32_t ahora = _backend.ahoraUs();
+
+  // La primera transacción de la lista que ya no esté esperando
+  TransaccionI2C *anterior = nullptr;
+  TransaccionI2C *t = _cabeza;
+  while (t && (int32_t)(ahora - t->listaUs) < 0)
+  {
+    anterior = t;
+    t = t->siguiente;
+  }
+  if (!t)
+    return false;
+
+  // Segmento: desde el paso actual hasta la siguiente espera o el final
+  uint8_t inicio = t->siguientePaso;
+  uint8_t fin = inicio;
+  while (fin < t->numPasos && t->pasos[fin].tipo != I2C_ESPERAR)
+    fin++;
+
+  ResultadoI2C resultado = I2C_OK;
+  if (fin > inicio)
+  {
+    uint32_t antes = _backend.ahoraUs();
+    resultado = _backend.ejecutar(t->direccion, &t->pasos[inicio], fin - inicio);
+    _estadisticas.ocupadoUs += _backend.ahoraUs() - antes;
+    _estadisticas.segmentos++;
+  }
+
+  if (resultado != I2C_OK || fin >= t->numPasos)
+  {
+    completar(t, anterior, resultado);
+    return true;
+  }
+
+  // Espera: la transacción queda aparcada y el bus libre para las demás
+  t->listaUs = _backend.ahoraUs() + t->pasos[fin].esperaUs;
+  t->siguientePaso = fin + 1;
+  return true;
+}
+
+uint32_t ColaI2C::esperaHastaListo()
+{
+  if (!_cabeza)
+    return 0;
+  uint32_t ahora = _backend.ahoraUs();
+  uint32_t minimo = UINT32_MAX;
+  for (TransaccionI2C *t = _cabeza; t; t = t->siguiente)
+  {
+    int32_t resta = (int32_t)(t->listaUs - ahora);
+    if (resta <= 0)
+      return 0;
+    if ((uint32_t)resta < minimo)
+      minimo = resta;
+  }
+  return minimo;
+}
+
+void ColaI2C::ejecutarTodo()
+{
+  uint32_t inicio = _backend.ahoraUs();
+  while (_cabeza)
+  {
+    if (ejecutarUno())
+      continue;
+    uint32_t espera = esperaHastaListo();
+    uint32_t antes = _backend.ahoraUs();
+    _backend.dormirUs(espera);
+    _estadisticas.dormidoUs += _backend.ahoraUs() - antes;
+  }
+  _estadisticas.ejecucionUs += _backend.ahoraUs() - inicio;
+}
+
+float ColaI2C::utilizacion() const
+{
+  if (_estadisticas.ejecucionUs == 0)
+    return 0;
+  return (float)_estadisticas.ocupadoUs / _estadisticas.ejecucionUs;
+}
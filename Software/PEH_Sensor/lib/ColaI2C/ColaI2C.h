@@ -0,0 +1,150 @@
+// Motor de transacciones I2C encoladas para el bus compartido.
+//
+// Cada driver describe su transacción como una lista de pasos (escribir, repeated
+// start, leer, esperar) y la envía a la cola sin bloquear. La cola ejecuta en el bus
+// los segmentos de pasos comprendidos entre esperas y, mientras una transacción espera
+// (p. ej. la conversión del SHTC3), atiende las de otros sensores. Al terminar avisa
+// por callback o por el propio descriptor (completada()), que hace de futuro.
+//
+// Sin memoria dinámica: los descriptores los aporta quien envía y la cola los enlaza.
+// Uso desde un único contexto (el bucle de adquisición); no es segura entre tareas.
+
+#ifndef COLA_I2C_H
+#define COLA_I2C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum TipoPasoI2C : uint8_t
+{
+  I2C_ESCRIBIR,
+  I2C_REPEATED_START, // el siguiente paso reutiliza el bus sin STOP
+  I2C_LEER,
+  I2C_ESPERAR, // cierra el segmento con STOP y libera el bus durante esperaUs
+};
+
+enum ResultadoI2C : uint8_t
+{
+  I2C_PENDIENTE,
+  I2C_OK,
+  I2C_NACK,
+  I2C_TIMEOUT,
+  I2C_ERROR,
+};
+
+struct PasoI2C
+{
+  TipoPasoI2C tipo;
+  uint16_t longitud;
+  uint32_t esperaUs;
+  const uint8_t *datosEscribir;
+  uint8_t *datosLeer;
+};
+
+inline PasoI2C pasoEscribir(const uint8_t *datos, uint16_t longitud)
+{
+  return PasoI2C{I2C_ESCRIBIR, longitud, 0, datos, nullptr};
+}
+
+inline PasoI2C pasoRepeatedStart()
+{
+  return PasoI2C{I2C_REPEATED_START, 0, 0, nullptr, nullptr};
+}
+
+inline PasoI2C pasoLeer(uint8_t *destino, uint16_t longitud)
+{
+  return PasoI2C{I2C_LEER, longitud, 0, nullptr, destino};
+}
+
+inline PasoI2C pasoEsperar(uint32_t us)
+{
+  return PasoI2C{I2C_ESPERAR, 0, us, nullptr, nullptr};
+}
+
+struct TransaccionI2C;
+typedef void (*CallbackI2C)(TransaccionI2C &transaccion, void *ctx);
+
+struct TransaccionI2C
+{
+  uint8_t direccion;
+  const PasoI2C *pasos;
+  uint8_t numPasos;
+  CallbackI2C alCompletar; // opcional
+  void *ctx;
+
+  // Rellenado por la cola
+  volatile ResultadoI2C resultado;
+  uint32_t duracionUs; // desde el envío hasta completarse
+
+  bool completada() const { return resultado != I2C_PENDIENTE; }
+
+  // --- Estado interno de la cola ---
+  uint8_t siguientePaso;
+  uint32_t enviadaUs;
+  uint32_t listaUs;
+  TransaccionI2C *siguiente;
+};
+
+inline TransaccionI2C transaccionI2C(uint8_t direccion, const PasoI2C *pasos, uint8_t numPasos)
+{
+  TransaccionI2C t = {};
+  t.direccion = direccion;
+  t.pasos = pasos;
+  t.numPasos = numPasos;
+  return t;
+}
+
+// Acceso físico al bus: ejecuta un segmento sin esperas (START ... STOP)
+class BackendI2C
+{
+public:
+  virtual ~BackendI2C() {}
+  virtual ResultadoI2C ejecutar(uint8_t direccion, const PasoI2C *pasos, uint8_t numPasos) = 0;
+  virtual uint32_t ahoraUs() = 0;
+  // Cede la CPU hasta que pase el tiempo indicado (nada que hacer en el bus)
+  virtual void dormirUs(uint32_t us) = 0;
+};
+
+struct EstadisticasColaI2C
+{
+  uint32_t transacciones;
+  uint32_t segmentos;
+  uint32_t errores;
+  uint32_t ocupadoUs;   // tiempo con el bus en uso
+  uint32_t ejecucionUs; // tiempo total dentro de ejecutarTodo()
+  uint32_t dormidoUs;   // tiempo cedido esperando a los sensores
+};
+
+class ColaI2C
+{
+public:
+  explicit ColaI2C(BackendI2C &backend);
+
+  // Encola la transacción; no toca el bus. El descriptor y sus pasos deben seguir
+  // vivos hasta que complete.
+  void enviar(TransaccionI2C &transaccion, CallbackI2C alCompletar = nullptr, void *ctx = nullptr);
+
+  // Ejecuta en el bus el siguiente segmento listo. false si no había ninguno listo.
+  bool ejecutarUno();
+  // Vacía la cola durmiendo mientras todas las transacciones pendientes esperan
+  void ejecutarTodo();
+
+  bool vacia() const { return _cabeza == nullptr; }
+  // Microsegundos hasta que algún segmento esté listo (0 = ya hay uno listo)
+  uint32_t esperaHastaListo();
+
+  const EstadisticasColaI2C &estadisticas() const { return _estadisticas; }
+  void reiniciarEstadisticas();
+  // Fracción del tiempo de ejecución con el bus ocupado
+  float utilizacion() const;
+
+private:
+  void completar(TransaccionI2C *transaccion, TransaccionI2C *anterior, ResultadoI2C resultado);
+
+  BackendI2C &_backend;
+  TransaccionI2C *_cabeza;
+  TransaccionI2C *_ultima;
+  EstadisticasColaI2C _estadisticas;
+};
+
+#endif
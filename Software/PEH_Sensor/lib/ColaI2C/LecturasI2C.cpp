@@ -0,0 +1,80 @@
+#include "LecturasI2C.h"
+
+static const uint8_t CMD_DESPERTAR_SHTC3[2] = {0x35, 0x17};
+static const uint8_t CMD_MEDIR_SHTC3[2] = {0x78, 0x66};
+static const uint8_t CMD_DORMIR_SHTC3[2] = {0xB0, 0x98};
+static const uint8_t REG_BUS_INA226 = 0x02;
+static const uint8_t REG_ALS_VEML7700 = 0x04;
+
+uint8_t crcShtc3(const uint8_t *datos)
+{
+  uint8_t crc = 0xFF;
+  for (int i = 0; i < 2; i++)
+  {
+    crc ^= datos[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+  }
+  return crc;
+}
+
+// --- SHTC3 ---
+LecturaShtc3::LecturaShtc3()
+    : _rx(),
+      _pasos{pasoEscribir(CMD_DESPERTAR_SHTC3, 2), pasoEsperar(SHTC3_T_DESPERTAR_US),
+             pasoEscribir(CMD_MEDIR_SHTC3, 2), pasoEsperar(SHTC3_T_CONVERSION_US),
+             pasoLeer(_rx, 6), pasoEsperar(0),
+             pasoEscribir(CMD_DORMIR_SHTC3, 2)}
+{
+  transaccion = transaccionI2C(SHTC3_DIRECCION_I2C, _pasos, sizeof(_pasos) / sizeof(PasoI2C));
+}
+
+bool LecturaShtc3::crcCorrecto() const
+{
+  return crcShtc3(&_rx[0]) == _rx[2] && crcShtc3(&_rx[3]) == _rx[5];
+}
+
+bool LecturaShtc3::valida() const
+{
+  return transaccion.resultado == I2C_OK && crcCorrecto();
+}
+
+bool LecturaShtc3::errorDatos() const
+{
+  return transaccion.resultado == I2C_OK && !crcCorrecto();
+}
+
+float LecturaShtc3::temperatura() const
+{
+  return -45 + 175 * ((_rx[0] << 8) | _rx[1]) / 65536.0;
+}
+
+float LecturaShtc3::humedad() const
+{
+  return 100 * ((_rx[3] << 8) | _rx[4]) / 65536.0;
+}
+
+// --- INA226 --- (registros big-endian)
+LecturaIna226::LecturaIna226()
+    : _rx(), _pasos{pasoEscribir(&REG_BUS_INA226, 1), pasoRepeatedStart(), pasoLeer(_rx, 2)}
+{
+  transaccion = transaccionI2C(INA226_DIRECCION_I2C, _pasos, sizeof(_pasos) / sizeof(PasoI2C));
+}
+
+float LecturaIna226::tensionBus() const
+{
+  return ((_rx[0] << 8) | _rx[1]) * 1.25e-3;
+}
+
+// --- VEML7700 --- (registros little-endian)
+LecturaVeml7700::LecturaVeml7700(uint32_t esperaUs)
+    : _rx(),
+      _pasos{pasoEsperar(esperaUs), pasoEscribir(&REG_ALS_VEML7700, 1), pasoRepeatedStart(), pasoLeer(_rx, 2)}
+{
+  transaccion = transaccionI2C(VEML7700_DIRECCION_I2C, _pasos, sizeof(_pasos) / sizeof(PasoI2C));
+}
+
+uint16_t LecturaVeml7700::cuentas() const
+{
+  return (uint16_t)((_rx[1] << 8) | _rx[0]);
+}
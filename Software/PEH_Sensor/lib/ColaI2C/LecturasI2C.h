@@ -0,0 +1,85 @@
+// Lecturas de SHTC3, INA226 y VEML7700 como transacciones de ColaI2C: el lado encolable
+// de cada driver. Cada lectura lleva sus buffers, sus pasos y el descriptor que se envía a
+// la cola, y decodifica el resultado igual que el driver de lib/. El descriptor apunta a
+// los pasos y buffers del propio objeto, así que no se copia.
+
+#ifndef LECTURAS_I2C_H
+#define LECTURAS_I2C_H
+
+#include "ColaI2C.h"
+
+#define SHTC3_DIRECCION_I2C 0x70
+#define INA226_DIRECCION_I2C 0x40
+#define VEML7700_DIRECCION_I2C 0x10
+
+#define SHTC3_T_DESPERTAR_US 240
+#define SHTC3_T_CONVERSION_US 12100
+
+class LecturaI2C
+{
+public:
+  LecturaI2C(const LecturaI2C &) = delete;
+  LecturaI2C &operator=(const LecturaI2C &) = delete;
+
+  TransaccionI2C transaccion;
+
+  // Completada y con datos correctos. Una lectura que no llegó a ejecutarse no vale: los
+  // buffers empiezan a cero y no se comprueba nada sobre ellos.
+  virtual bool valida() const { return transaccion.resultado == I2C_OK; }
+  // Leída del bus pero con datos corruptos (CRC)
+  virtual bool errorDatos() const { return false; }
+
+protected:
+  LecturaI2C() : transaccion() {}
+  virtual ~LecturaI2C() {}
+};
+
+// Despertar, medir (T primero, sin clock stretching), leer T y HR con su CRC y dormir
+class LecturaShtc3 : public LecturaI2C
+{
+public:
+  LecturaShtc3();
+
+  bool valida() const override;
+  bool errorDatos() const override;
+  float temperatura() const; // °C
+  float humedad() const;     // %HR
+
+private:
+  bool crcCorrecto() const;
+
+  uint8_t _rx[6];
+  PasoI2C _pasos[7];
+};
+
+// Registro de tensión de bus (1.25 mV/LSB)
+class LecturaIna226 : public LecturaI2C
+{
+public:
+  LecturaIna226();
+
+  float tensionBus() const; // V
+
+private:
+  uint8_t _rx[2];
+  PasoI2C _pasos[3];
+};
+
+// Registro ALS, tras la espera que fije quien envía (lo que falte de la integración)
+class LecturaVeml7700 : public LecturaI2C
+{
+public:
+  explicit LecturaVeml7700(uint32_t esperaUs = 0);
+
+  void fijarEspera(uint32_t us) { _pasos[0].esperaUs = us; }
+  uint16_t cuentas() const;
+
+private:
+  uint8_t _rx[2];
+  PasoI2C _pasos[4];
+};
+
+// CRC-8 de una palabra del SHTC3: polinomio 0x31, valor inicial 0xFF
+uint8_t crcShtc3(const uint8_t *datos);
+
+#endif
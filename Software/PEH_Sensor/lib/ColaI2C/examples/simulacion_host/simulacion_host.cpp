@@ -0,0 +1,88 @@
+// Reproduce en el host la lectura encolada del nodo (SHTC3 + INA226 + VEML7700) contra
+// dispositivos simulados y compara el tiempo con la misma secuencia en serie.
+//
+//   g++ -std=c++11 -I../.. -I../../../SimuladorI2C simulacion_host.cpp ../../ColaI2C.cpp ../../BackendI2CSimulado.cpp ../../../SimuladorI2C/*.cpp -o simulacion_host
+
+#include <ColaI2C.h>
+#include <BackendI2CSimulado.h>
+#include <cstdio>
+
+// SHTC3 en modo polling: NACK a la lectura hasta que termina la conversión
+class Shtc3Minimo : public DispositivoI2CSimulado
+{
+public:
+  Shtc3Minimo() : DispositivoI2CSimulado(0x70), _listoUs(0) {}
+  bool direccionar(bool lectura, uint32_t ahoraUs) override { return !lectura || ahoraUs >= _listoUs; }
+  bool escribir(uint8_t dato, uint32_t ahoraUs) override
+  {
+    if (dato == 0x66)
+      _listoUs = ahoraUs + 12100;
+    return true;
+  }
+  uint8_t leer(uint32_t) override { return 0x66; }
+
+private:
+  uint32_t _listoUs;
+};
+
+static const uint8_t cmdDespertar[2] = {0x35, 0x17};
+static const uint8_t cmdMedir[2] = {0x78, 0x66};
+static const uint8_t cmdDormir[2] = {0xB0, 0x98};
+static const uint8_t regBus = 0x02;
+static const uint8_t regALS = 0x04;
+static uint8_t shtc3Rx[6], inaRx[2], vemlRx[2];
+
+static PasoI2C pasosShtc3[] = {
+    pasoEscribir(cmdDespertar, 2), pasoEsperar(240),
+    pasoEscribir(cmdMedir, 2), pasoEsperar(12100),
+    pasoLeer(shtc3Rx, 6), pasoEsperar(0),
+    pasoEscribir(cmdDormir, 2)};
+static PasoI2C pasosIna[] = {pasoEscribir(&regBus, 1), pasoRepeatedStart(), pasoLeer(inaRx, 2)};
+static PasoI2C pasosVeml[] = {pasoEsperar(5000), pasoEscribir(&regALS, 1), pasoRepeatedStart(), pasoLeer(vemlRx, 2)};
+
+static void avisar(TransaccionI2C &t, void *ctx)
+{
+  printf("  0x%02X completada en %u us (resultado %d)\n", t.direccion, t.duracionUs, t.resultado);
+  (*(int *)ctx)++;
+}
+
+static uint32_t medir(bool enSerie)
+{
+  BackendI2CSimulado backend(400000);
+  Shtc3Minimo shtc3;
+  DispositivoRegistrosSimulado ina(0x40, 8, true);
+  DispositivoRegistrosSimulado veml(0x10, 8, false);
+  ina.fijarRegistro(0x02, 3000); // 3.75 V
+  veml.fijarRegistro(0x04, 1000);
+  backend.agregar(shtc3);
+  backend.agregar(ina);
+  backend.agregar(veml);
+
+  ColaI2C cola(backend);
+  TransaccionI2C t[] = {
+      transaccionI2C(0x70, pasosShtc3, sizeof(pasosShtc3) / sizeof(PasoI2C)),
+      transaccionI2C(0x40, pasosIna, sizeof(pasosIna) / sizeof(PasoI2C)),
+      transaccionI2C(0x10, pasosVeml, sizeof(pasosVeml) / sizeof(PasoI2C))};
+  int completadas = 0;
+  for (TransaccionI2C &tr : t)
+  {
+    cola.enviar(tr, avisar, &completadas);
+    if (enSerie)
+      cola.ejecutarTodo();
+  }
+  cola.ejecutarTodo();
+
+  const EstadisticasColaI2C &e = cola.estadisticas();
+  printf("%s: %d completadas, %u segmentos, %u bytes, %u us totales, bus ocupado %.1f %%\n",
+         enSerie ? "En serie" : "Encolado", completadas, e.segmentos, backend.bytesTransferidos(),
+         backend.ahoraUs(), cola.utilizacion() * 100);
+  return backend.ahoraUs();
+}
+
+int main()
+{
+  uint32_t serie = medir(true);
+  uint32_t cola = medir(false);
+  printf("Ahorro por intercalado: %u us (%.1f %%)\n", serie - cola, 100.0 * (serie - cola) / serie);
+  return 0;
+}
@@ -0,0 +1,116 @@
+// Ahorro de tiempo de despertar según la velocidad del bus: reproduce en el host las
+// transacciones que hacen los drivers en cada despertar (begin/configuración y lectura
+// de SHTC3, VEML7700 e INA226, en serie como en main.cpp) a 100 kHz, 400 kHz y 1 MHz.
+// La conversión del SHTC3 (clock stretching) no depende del reloj y se suma aparte.
+//
+//   g++ -std=c++11 -I../.. -I../../../SimuladorI2C velocidad_host.cpp ../../ColaI2C.cpp ../../BackendI2CSimulado.cpp ../../../SimuladorI2C/*.cpp -o velocidad_host
+
+#include <ColaI2C.h>
+#include <BackendI2CSimulado.h>
+#include <cstdio>
+
+#define T_CONVERSION_SHTC3_US 12100
+#define CORRIENTE_80MHZ_MA 22.0
+#define TENSION_ALIMENTACION 3.3
+
+// Solo cuenta el tiempo de bus: hace ACK a todo y devuelve ceros
+class DispositivoPasivo : public DispositivoI2CSimulado
+{
+public:
+  explicit DispositivoPasivo(uint8_t direccion) : DispositivoI2CSimulado(direccion) {}
+  bool direccionar(bool, uint32_t) override { return true; }
+  bool escribir(uint8_t, uint32_t) override { return true; }
+  uint8_t leer(uint32_t) override { return 0x00; }
+};
+
+struct Secuencia
+{
+  const char *nombre;
+  uint8_t direccion;
+  const PasoI2C *pasos;
+  uint8_t numPasos;
+};
+
+static const uint8_t shtc3Despertar[2] = {0x35, 0x17};
+static const uint8_t shtc3Id[2] = {0xEF, 0xC8};
+static const uint8_t shtc3Medir[2] = {0x7C, 0xA2};
+static const uint8_t shtc3Dormir[2] = {0xB0, 0x98};
+static const uint8_t vemlConf[3] = {0x00, 0x00, 0x00};
+static const uint8_t vemlPsm[3] = {0x03, 0x01, 0x00};
+static const uint8_t vemlAls = 0x04;
+static const uint8_t inaCal[3] = {0x05, 0x0A, 0x00};
+static const uint8_t inaBus = 0x02;
+static const uint8_t inaFab = 0xFE;
+static uint8_t rx[6];
+
+#define N(p) (uint8_t)(sizeof(p) / sizeof(PasoI2C))
+static const PasoI2C pShtc3Despertar[] = {pasoEscribir(shtc3Despertar, 2)};
+static const PasoI2C pShtc3Id[] = {pasoEscribir(shtc3Id, 2), pasoRepeatedStart(), pasoLeer(rx, 3)};
+static const PasoI2C pShtc3Medir[] = {pasoEscribir(shtc3Medir, 2), pasoRepeatedStart(), pasoLeer(rx, 6)};
+static const PasoI2C pShtc3Dormir[] = {pasoEscribir(shtc3Dormir, 2)};
+static const PasoI2C pVemlConf[] = {pasoEscribir(vemlConf, 3)};
+static const PasoI2C pVemlPsm[] = {pasoEscribir(vemlPsm, 3)};
+static const PasoI2C pVemlAls[] = {pasoEscribir(&vemlAls, 1), pasoRepeatedStart(), pasoLeer(rx, 2)};
+static const PasoI2C pInaSondeo[] = {pasoEscribir(nullptr, 0)};
+static const PasoI2C pInaFab[] = {pasoEscribir(&inaFab, 1), pasoRepeatedStart(), pasoLeer(rx, 2)};
+static const PasoI2C pInaCal[] = {pasoEscribir(inaCal, 3)};
+static const PasoI2C pInaBus[] = {pasoEscribir(&inaBus, 1), pasoRepeatedStart(), pasoLeer(rx, 2)};
+
+static const Secuencia DESPERTAR[] = {
+    // iniciarSensores()
+    {"SHTC3 wake", 0x70, pShtc3Despertar, N(pShtc3Despertar)},
+    {"SHTC3 ID", 0x70, pShtc3Id, N(pShtc3Id)},
+    {"SHTC3 sleep", 0x70, pShtc3Dormir, N(pShtc3Dormir)},
+    {"VEML sondeo", 0x10, pInaSondeo, N(pInaSondeo)},
+    {"VEML ALS_CONF", 0x10, pVemlConf, N(pVemlConf)},
+    {"VEML PSM", 0x10, pVemlPsm, N(pVemlPsm)},
+    {"INA sondeo", 0x40, pInaSondeo, N(pInaSondeo)},
+    {"INA fabricante", 0x40, pInaFab, N(pInaFab)},
+    {"INA calibración", 0x40, pInaCal, N(pInaCal)},
+    // leerSensores()
+    {"SHTC3 wake", 0x70, pShtc3Despertar, N(pShtc3Despertar)},
+    {"SHTC3 medida", 0x70, pShtc3Medir, N(pShtc3Medir)},
+    {"SHTC3 sleep", 0x70, pShtc3Dormir, N(pShtc3Dormir)},
+    {"INA bus", 0x40, pInaBus, N(pInaBus)},
+    {"VEML ALS", 0x10, pVemlAls, N(pVemlAls)},
+};
+
+static uint32_t tiempoBusUs(uint32_t relojHz, uint32_t &bytes)
+{
+  BackendI2CSimulado backend(relojHz);
+  DispositivoPasivo shtc3(0x70), veml(0x10), ina(0x40);
+  backend.agregar(shtc3);
+  backend.agregar(veml);
+  backend.agregar(ina);
+
+  ColaI2C cola(backend);
+  for (const Secuencia &s : DESPERTAR)
+  {
+    TransaccionI2C t = transaccionI2C(s.direccion, s.pasos, s.numPasos);
+    cola.enviar(t);
+    cola.ejecutarTodo();
+  }
+  bytes = backend.bytesTransferidos();
+  return backend.ahoraUs();
+}
+
+int main()
+{
+  const uint32_t RELOJES[] = {100000, 400000, 1000000};
+  uint32_t bytes = 0;
+  uint32_t base = tiempoBusUs(RELOJES[0], bytes);
+
+  printf("%u transacciones, %u bytes por despertar (conversión SHTC3 aparte: %u us)\n\n",
+         (unsigned)(sizeof(DESPERTAR) / sizeof(Secuencia)), bytes, T_CONVERSION_SHTC3_US);
+  printf("%10s %10s %12s %10s %10s %12s\n", "reloj", "bus (us)", "total (us)", "ahorro", "ahorro %", "mJ/despertar");
+  for (uint32_t hz : RELOJES)
+  {
+    uint32_t bus = tiempoBusUs(hz, bytes);
+    uint32_t total = bus + T_CONVERSION_SHTC3_US;
+    uint32_t ahorro = base - bus;
+    double mj = CORRIENTE_80MHZ_MA * TENSION_ALIMENTACION * total / 1e6;
+    printf("%7u kHz %10u %12u %10u %9.1f%% %12.3f\n", hz / 1000, bus, total, ahorro,
+           100.0 * ahorro / (base + T_CONVERSION_SHTC3_US), mj);
+  }
+  return 0;
+}
@@ -0,0 +1,643 @@
+// Serialización de estructuras de forma fija (SensorData y parecidas) a JSON y MsgPack sin
+// JsonDocument: el esquema es una lista de campos conocida en compilación y cada función
+// se despliega en una secuencia recta de escrituras (claves constantes y un valor por
+// campo) o en una cadena de comparaciones de clave al leer. Los valores los formatean las
+// primitivas de ArduinoJson: TextFormatter para JSON y MsgPackSerializer para MsgPack;
+// parseNumber() lee los números de JSON.
+//
+//   struct Punto { float x; int32_t y; };
+//   CAMPO_ESQUEMA(Punto, x);
+//   CAMPO_ESQUEMA(Punto, y);
+//   typedef Esquema<CAMPO(Punto, x), CAMPO(Punto, y)> EsquemaPunto;
+//
+//   EsquemaPunto::escribirJson(p, escritor);    // {"x":1.5,"y":-3}
+//   EsquemaPunto::escribirMsgPack(p, escritor); // mapa {"x": 1.5, "y": -3}
+//   EsquemaPunto::leerMsgPack(datos, bytes, p);
+//
+// El escritor es cualquier clase con write(uint8_t) y write(const uint8_t *, size_t), como
+// los Writer personalizados de ArduinoJson. Al leer, las claves que el esquema no conoce
+// se saltan y los campos que faltan no se tocan; un número que no cabe en el tipo de su
+// campo (o NaN en un entero) es un error de lectura. Solo campos numéricos (enteros de
+// hasta 32 bits y float).
+// C++11: compila con el core 2.x de Arduino-ESP32.
+
+#ifndef ESQUEMA_H
+#define ESQUEMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <limits>
+#include <ArduinoJson.h>
+
+// Profundidad máxima de los valores desconocidos que se saltan al leer
+#ifndef ESQUEMA_MAX_ANIDAMIENTO
+#define ESQUEMA_MAX_ANIDAMIENTO 8
+#endif
+// Caracteres de un número JSON (el resto de un número más largo se rechaza)
+#define ESQUEMA_MAX_NUMERO_JSON 32
+
+// Describe el miembro `miembro` de `Estructura`; el nombre de la clave es el del miembro
+#define CAMPO_ESQUEMA(Estructura, miembro) CAMPO_ESQUEMA_CLAVE(Estructura, miembro, miembro)
+// Igual, con otra clave: cuando lo que viaja no es lo que el miembro guarda en memoria
+#define CAMPO_ESQUEMA_CLAVE(Estructura, miembro, clave)                            \
+  struct CampoEsquema_##Estructura##_##miembro                                     \
+  {                                                                                \
+    typedef Estructura TipoEstructura;                                             \
+    typedef decltype(Estructura::miembro) Tipo;                                    \
+    static const char *nombre() { return #clave; }                                 \
+    static constexpr size_t longitud() { return sizeof(#clave) - 1; }              \
+    static Tipo leer(const Estructura &e) { return e.miembro; }                    \
+    static void escribir(Estructura &e, Tipo valor) { e.miembro = valor; }         \
+    static_assert(sizeof(#clave) - 1 < 32, "nombre de campo demasiado largo");     \
+  }
+#define CAMPO(Estructura, miembro) CampoEsquema_##Estructura##_##miembro
+
+namespace esquema
+{
+  using ArduinoJson::detail::MsgPackSerializer;
+  using ArduinoJson::detail::TextFormatter;
+  using ArduinoJson::detail::Writer;
+
+  // --- VALORES ---
+  template <typename TSerializador>
+  inline void valorMsgPack(TSerializador &s, float v) { s.visit(v); }
+  template <typename TSerializador>
+  inline void valorMsgPack(TSerializador &s, double v) { s.visit(v); }
+  template <typename TSerializador>
+  inline void valorMsgPack(TSerializador &s, int32_t v) { s.visit(ArduinoJson::JsonInteger(v)); }
+  template <typename TSerializador>
+  inline void valorMsgPack(TSerializador &s, uint32_t v) { s.visit(ArduinoJson::JsonUInt(v)); }
+  template <typename TSerializador>
+  inline void valorMsgPack(TSerializador &s, int16_t v) { s.visit(ArduinoJson::JsonInteger(v)); }
+  template <typename TSerializador>
+  inline void valorMsgPack(TSerializador &s, uint16_t v) { s.visit(ArduinoJson::JsonUInt(v)); }
+  template <typename TSerializador>
+  inline void valorMsgPack(TSerializador &s, int8_t v) { s.visit(ArduinoJson::JsonInteger(v)); }
+  template <typename TSerializador>
+  inline void valorMsgPack(TSerializador &s, uint8_t v) { s.visit(ArduinoJson::JsonUInt(v)); }
+
+  template <typename TFormateador>
+  inline void valorJson(TFormateador &f, float v) { f.writeFloat(v); }
+  template <typename TFormateador>
+  inline void valorJson(TFormateador &f, double v) { f.writeFloat(v); }
+  template <typename TFormateador, typename T>
+  inline void valorJson(TFormateador &f, T v) { f.writeInteger(v); }
+
+  // Número leído (como double, que guarda cualquier float y enteros de hasta 53 bits) al
+  // tipo del campo; false si no cabe. El dato viene de fuera y convertir a entero un valor
+  // fuera de rango o NaN es comportamiento indefinido, así que se comprueba antes.
+  template <typename T>
+  inline bool convertir(double v, T &destino)
+  {
+    static_assert(sizeof(T) <= 4, "enteros de hasta 32 bits: sus límites ±1 son exactos en double");
+    // Se trunca hacia cero: vale todo lo que quede por dentro de los límites ±1. NaN no
+    // cumple ninguna comparación.
+    if (!(v > (double)std::numeric_limits<T>::min() - 1 && v < (double)std::numeric_limits<T>::max() + 1))
+      return false;
+    destino = (T)v;
+    return true;
+  }
+  inline bool convertir(double v, float &destino)
+  {
+    if (isfinite(v) && fabs(v) > FLT_MAX) // infinito y NaN pasan tal cual
+      return false;
+    destino = (float)v;
+    return true;
+  }
+  inline bool convertir(double v, double &destino)
+  {
+    destino = v;
+    return true;
+  }
+
+  // --- LECTURA DE MSGPACK ---
+  class LectorMsgPack
+  {
+  public:
+    LectorMsgPack(const uint8_t *datos, size_t bytes) : _p(datos), _fin(datos + bytes), _error(false) {}
+
+    bool error() const { return _error; }
+    bool terminado() const { return _p == _fin; }
+
+    // Elementos de un mapa (o de un array); false si lo siguiente no lo es
+    bool cabecera(bool mapa, uint32_t &n)
+    {
+      uint8_t t = byte();
+      uint8_t corto = mapa ? 0x80 : 0x90;
+      if ((t & 0xF0) == corto)
+        n = t & 0x0F;
+      else if (t == (mapa ? 0xDE : 0xDC))
+        n = entero(2);
+      else if (t == (mapa ? 0xDF : 0xDD))
+        n = entero(4);
+      else
+        return fallar();
+      return !_error;
+    }
+
+    bool cadena(const char *&s, uint32_t &n)
+    {
+      uint8_t t = byte();
+      if ((t & 0xE0) == 0xA0)
+        n = t & 0x1F;
+      else if (t == 0xD9)
+        n = entero(1);
+      else if (t == 0xDA)
+        n = entero(2);
+      else if (t == 0xDB)
+        n = entero(4);
+      else
+        return fallar();
+      if (_error || n > (size_t)(_fin - _p))
+        return fallar();
+      s = (const char *)_p;
+      _p += n;
+      return true;
+    }
+
+    // Cualquier número de MsgPack; false (sin avanzar) si lo siguiente no es un número
+    bool numero(double &v)
+    {
+      if (_p == _fin)
+        return fallar();
+      const uint8_t *inicio = _p;
+      uint8_t t = byte();
+      if (t <= 0x7F)
+        v = t;
+      else if (t >= 0xE0)
+        v = (int8_t)t;
+      else if (t == 0xCA)
+      {
+        uint32_t u = entero(4);
+        float f;
+        memcpy(&f, &u, 4);
+        v = f;
+      }
+      else if (t == 0xCB)
+      {
+        uint64_t u = entero(8);
+        memcpy(&v, &u, 8);
+      }
+      else if (t >= 0xCC && t <= 0xCF)
+        v = (double)entero(1 << (t - 0xCC));
+      else if (t >= 0xD0 && t <= 0xD3)
+      {
+        uint8_t n = 1 << (t - 0xD0);
+        uint64_t u = entero(n);
+        v = n == 8 ? (double)(int64_t)u : (double)((int64_t)(u << (64 - 8 * n)) >> (64 - 8 * n));
+      }
+      else
+      {
+        _p = inicio;
+        return false;
+      }
+      return !_error;
+    }
+
+    bool saltar(uint8_t profundidad = 0)
+    {
+      double v;
+      if (numero(v))
+        return true;
+      if (_error || _p == _fin)
+        return fallar();
+      uint8_t t = *_p;
+      if (t == 0xC0 || t == 0xC2 || t == 0xC3)
+        return avanzar(1);
+      if ((t & 0xE0) == 0xA0 || (t >= 0xD9 && t <= 0xDB))
+      {
+        const char *s;
+        uint32_t n;
+        return cadena(s, n);
+      }
+      if (t >= 0xC4 && t <= 0xC6) // bin
+      {
+        _p++;
+        uint32_t n = entero(1 << (t - 0xC4));
+        return !_error && avanzar(n);
+      }
+      bool mapa = (t & 0xF0) == 0x80 || t == 0xDE || t == 0xDF;
+      uint32_t n;
+      if (profundidad >= ESQUEMA_MAX_ANIDAMIENTO || !cabecera(mapa, n))
+        return fallar();
+      for (uint32_t i = 0; i < (mapa ? 2 * n : n); i++)
+        if (!saltar(profundidad + 1))
+          return false;
+      return true;
+    }
+
+  private:
+    uint8_t byte()
+    {
+      if (_p == _fin)
+      {
+        _error = true;
+        return 0xC1; // no usado en MsgPack: no coincide con ningún tipo
+      }
+      return *_p++;
+    }
+
+    uint64_t entero(uint8_t n) // big-endian
+    {
+      if (n > (size_t)(_fin - _p))
+      {
+        _error = true;
+        return 0;
+      }
+      uint64_t v = 0;
+      for (uint8_t i = 0; i < n; i++)
+        v = v << 8 | *_p++;
+      return v;
+    }
+
+    bool avanzar(size_t n)
+    {
+      if (n > (size_t)(_fin - _p))
+        return fallar();
+      _p += n;
+      return true;
+    }
+
+    bool fallar()
+    {
+      _error = true;
+      return false;
+    }
+
+    const uint8_t *_p;
+    const uint8_t *_fin;
+    bool _error;
+  };
+
+  // --- LECTURA DE JSON ---
+  class LectorJson
+  {
+  public:
+    LectorJson(const char *texto, size_t bytes) : _p(texto), _fin(texto + bytes), _error(false) {}
+
+    bool error() const { return _error; }
+    bool terminado()
+    {
+      blancos();
+      return _p == _fin;
+    }
+
+    // Consume `c` tras los blancos; false (sin error) si lo siguiente es otra cosa
+    bool signo(char c)
+    {
+      blancos();
+      if (_p == _fin || *_p != c)
+        return false;
+      _p++;
+      return true;
+    }
+
+    bool esperar(char c) { return signo(c) || fallar(); }
+
+    // Cadena sin secuencias de escape (las claves del esquema no las llevan); una clave
+    // con escapes se devuelve tal cual y no coincide con ningún campo
+    bool cadena(const char *&s, size_t &n)
+    {
+      if (!esperar('"'))
+        return false;
+      s = _p;
+      while (_p < _fin && *_p != '"')
+        _p += *_p == '\\' ? 2 : 1;
+      if (_p >= _fin)
+        return fallar();
+      n = _p - s;
+      _p++;
+      return true;
+    }
+
+    bool numero(double &v)
+    {
+      blancos();
+      char texto[ESQUEMA_MAX_NUMERO_JSON + 1];
+      size_t n = 0;
+      while (_p < _fin && n < ESQUEMA_MAX_NUMERO_JSON && caracterNumero(*_p))
+        texto[n++] = *_p++;
+      if (n == 0 || (_p < _fin && caracterNumero(*_p)))
+        return fallar();
+      texto[n] = '\0';
+      ArduinoJson::detail::Number numero = ArduinoJson::detail::parseNumber(texto);
+      if (numero.type() == ArduinoJson::detail::NumberType::Invalid)
+        return fallar();
+      v = numero.convertTo<double>();
+      return true;
+    }
+
+    bool saltar(uint8_t profundidad = 0)
+    {
+      blancos();
+      if (_p == _fin)
+        return fallar();
+      char c = *_p;
+      if (c == '"')
+      {
+        const char *s;
+        size_t n;
+        return cadena(s, n);
+      }
+      if (c == '{' || c == '[')
+      {
+        if (profundidad >= ESQUEMA_MAX_ANIDAMIENTO)
+          return fallar();
+        _p++;
+        char cierre = c == '{' ? '}' : ']';
+        if (signo(cierre))
+          return true;
+        do
+        {
+          if (c == '{')
+          {
+            const char *s;
+            size_t n;
+            if (!cadena(s, n) || !esperar(':'))
+              return false;
+          }
+          if (!saltar(profundidad + 1))
+            return false;
+        } while (signo(','));
+        return esperar(cierre);
+      }
+      if (literal("true") || literal("false") || literal("null"))
+        return true;
+      double v;
+      return numero(v);
+    }
+
+  private:
+    static bool caracterNumero(char c)
+    {
+      return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    void blancos()
+    {
+      while (_p < _fin && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r'))
+        _p++;
+    }
+
+    template <size_t N>
+    bool literal(const char (&s)[N])
+    {
+      if (N - 1 > (size_t)(_fin - _p) || memcmp(_p, s, N - 1) != 0)
+        return false;
+      _p += N - 1;
+      return true;
+    }
+
+    bool fallar()
+    {
+      _error = true;
+      return false;
+    }
+
+    const char *_p;
+    const char *_fin;
+    bool _error;
+  };
+
+  // --- LISTA DE CAMPOS ---
+  // Recursión sobre los campos: cada nivel escribe o compara uno y pasa al siguiente.
+  // Con optimización todo se despliega en línea.
+  template <typename... Campos>
+  struct Lista;
+
+  template <>
+  struct Lista<>
+  {
+    static constexpr size_t numero = 0;
+    static const char *nombre(size_t) { return nullptr; }
+    template <typename E, typename S>
+    static void valoresMsgPack(const E &, S &) {}
+    template <typename W>
+    static void clavesMsgPack(W &) {}
+    template <typename E, typename W, typename S>
+    static void paresMsgPack(const E &, W &, S &) {}
+    template <typename E, typename F>
+    static void paresJson(const E &, F &, bool) {}
+    template <typename E>
+    static bool asignar(E &, const char *, size_t, double) { return true; }
+  };
+
+  template <typename Campo, typename... Resto>
+  struct Lista<Campo, Resto...>
+  {
+    static constexpr size_t numero = 1 + sizeof...(Resto);
+
+    static const char *nombre(size_t i) { return i == 0 ? Campo::nombre() : Lista<Resto...>::nombre(i - 1); }
+
+    template <typename E, typename S>
+    static void valoresMsgPack(const E &e, S &s)
+    {
+      valorMsgPack(s, Campo::leer(e));
+      Lista<Resto...>::valoresMsgPack(e, s);
+    }
+
+    template <typename W>
+    static void clavesMsgPack(W &w)
+    {
+      clave(w);
+      Lista<Resto...>::clavesMsgPack(w);
+    }
+
+    template <typename E, typename W, typename S>
+    static void paresMsgPack(const E &e, W &w, S &s)
+    {
+      clave(w);
+      valorMsgPack(s, Campo::leer(e));
+      Lista<Resto...>::paresMsgPack(e, w, s);
+    }
+
+    template <typename E, typename F>
+    static void paresJson(const E &e, F &f, bool primero)
+    {
+      if (!primero)
+        f.writeRaw(',');
+      f.writeRaw('"');
+      f.writeRaw(Campo::nombre(), Campo::longitud());
+      f.writeRaw("\":");
+      valorJson(f, Campo::leer(e));
+      Lista<Resto...>::paresJson(e, f, false);
+    }
+
+    // Una clave desconocida no es un error; un valor que no cabe en su campo, sí
+    template <typename E>
+    static bool asignar(E &e, const char *s, size_t n, double v)
+    {
+      if (n == Campo::longitud() && memcmp(s, Campo::nombre(), n) == 0)
+      {
+        typename Campo::Tipo valor;
+        if (!convertir(v, valor))
+          return false;
+        Campo::escribir(e, valor);
+        return true;
+      }
+      return Lista<Resto...>::asignar(e, s, n, v);
+    }
+
+  private:
+    // fixstr: la cabecera y la clave son constantes
+    template <typename W>
+    static void clave(W &w)
+    {
+      w.write((uint8_t)(0xA0 + Campo::longitud()));
+      w.write((const uint8_t *)Campo::nombre(), Campo::longitud());
+    }
+  };
+
+  template <typename W>
+  inline void cabeceraMsgPack(W &w, uint8_t tipoCorto, uint8_t tipo16, size_t n)
+  {
+    if (n < 16)
+    {
+      w.write((uint8_t)(tipoCorto + n));
+      return;
+    }
+    const uint8_t cabecera[3] = {tipo16, (uint8_t)(n >> 8), (uint8_t)n};
+    w.write(cabecera, sizeof(cabecera));
+  }
+} // namespace esquema
+
+template <typename... Campos>
+struct Esquema
+{
+  typedef esquema::Lista<Campos...> Lista;
+  static constexpr size_t NUM_CAMPOS = Lista::numero;
+
+  static const char *nombre(size_t i) { return Lista::nombre(i); }
+
+  // --- ESCRITURA ---
+  // {"campo": valor, ...}
+  template <typename E, typename W>
+  static void escribirMsgPack(const E &e, W &w)
+  {
+    esquema::MsgPackSerializer<esquema::Writer<W>> s(esquema::Writer<W>(w), nullptr);
+    esquema::cabeceraMsgPack(w, 0x80, 0xDE, NUM_CAMPOS);
+    Lista::paresMsgPack(e, w, s);
+  }
+
+  // [valor, ...]: una fila de una tabla cuyas columnas son nombresMsgPack()
+  template <typename E, typename W>
+  static void escribirFilaMsgPack(const E &e, W &w)
+  {
+    esquema::MsgPackSerializer<esquema::Writer<W>> s(esquema::Writer<W>(w), nullptr);
+    esquema::cabeceraMsgPack(w, 0x90, 0xDC, NUM_CAMPOS);
+    Lista::valoresMsgPack(e, s);
+  }
+
+  // ["campo", ...]
+  template <typename W>
+  static void escribirNombresMsgPack(W &w)
+  {
+    esquema::cabeceraMsgPack(w, 0x90, 0xDC, NUM_CAMPOS);
+    Lista::clavesMsgPack(w);
+  }
+
+  // {"campo":valor,...} sin espacios
+  template <typename E, typename W>
+  static void escribirJson(const E &e, W &w)
+  {
+    esquema::TextFormatter<esquema::Writer<W>> f{esquema::Writer<W>(w)};
+    f.writeRaw('{');
+    Lista::paresJson(e, f, true);
+    f.writeRaw('}');
+  }
+
+  // --- LECTURA ---
+  // Un mapa/objeto con los campos en cualquier orden; false si está mal formado o si
+  // queda algo detrás
+  template <typename E>
+  static bool leerMsgPack(const uint8_t *datos, size_t bytes, E &e)
+  {
+    esquema::LectorMsgPack l(datos, bytes);
+    uint32_t n;
+    if (!l.cabecera(true, n))
+      return false;
+    for (uint32_t i = 0; i < n; i++)
+      if (!leerParMsgPack(l, e))
+        return false;
+    return l.terminado();
+  }
+
+  // La fila de escribirFilaMsgPack() dentro de un lector (para tablas)
+  template <typename E>
+  static bool leerFilaMsgPack(esquema::LectorMsgPack &l, E &e)
+  {
+    uint32_t n;
+    if (!l.cabecera(false, n) || n != NUM_CAMPOS)
+      return false;
+    return leerValores(l, e, (Lista *)nullptr);
+  }
+
+  template <typename E>
+  static bool leerJson(const char *texto, size_t bytes, E &e)
+  {
+    esquema::LectorJson l(texto, bytes);
+    if (!l.esperar('{'))
+      return false;
+    if (!l.signo('}'))
+    {
+      do
+      {
+        const char *clave;
+        size_t n;
+        double v;
+        if (!l.cadena(clave, n) || !l.esperar(':'))
+          return false;
+        esquema::LectorJson copia = l;
+        if (copia.numero(v))
+        {
+          l = copia;
+          if (!Lista::asignar(e, clave, n, v))
+            return false;
+        }
+        else if (!l.saltar())
+          return false;
+      } while (l.signo(','));
+      if (!l.esperar('}'))
+        return false;
+    }
+    return l.terminado();
+  }
+
+private:
+  template <typename E>
+  static bool leerParMsgPack(esquema::LectorMsgPack &l, E &e)
+  {
+    const char *clave;
+    uint32_t n;
+    double v;
+    if (!l.cadena(clave, n))
+      return false;
+    if (l.numero(v))
+    {
+      if (!Lista::asignar(e, clave, n, v))
+        return false;
+    }
+    else if (!l.saltar())
+      return false;
+    return !l.error();
+  }
+
+  template <typename E>
+  static bool leerValores(esquema::LectorMsgPack &, E &, esquema::Lista<> *) { return true; }
+
+  template <typename E, typename Campo, typename... Resto>
+  static bool leerValores(esquema::LectorMsgPack &l, E &e, esquema::Lista<Campo, Resto...> *)
+  {
+    double v;
+    typename Campo::Tipo valor;
+    if (!l.numero(v) || !esquema::convertir(v, valor))
+      return false;
+    Campo::escribir(e, valor);
+    return leerValores(l, e, (esquema::Lista<Resto...> *)nullptr);
+  }
+};
+
+#endif
@@ -0,0 +1,215 @@
+// Esquema en compilación frente a JsonDocument para un registro de forma fija (Lectura,
+// como SensorData): ns por registro al escribir y leer JSON y MsgPack, y comprobación de
+// que los dos caminos producen los mismos bytes y se leen el uno al otro, y de que Esquema
+// rechaza los números que no caben en su campo. El código de cada camino se mide aparte
+// con size(1) sobre su objeto.
+//
+//   g++ -std=c++11 -O2 -I../.. -I../../../ArduinoJson/src banco_host.cpp codificadores_dom.cpp codificadores_esquema.cpp -o banco_host
+//   ./banco_host [registros] [vueltas]
+//   g++ -std=c++11 -Os -I../.. -I../../../ArduinoJson/src -c codificadores_dom.cpp codificadores_esquema.cpp && size codificadores_*.o
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <Esquema.h>
+#include "codificadores.h"
+
+#define MAX_BYTES 128
+
+static volatile size_t sumidero;
+
+static uint32_t azar = 1;
+static uint32_t siguiente()
+{
+  azar ^= azar << 13;
+  azar ^= azar >> 17;
+  azar ^= azar << 5;
+  return azar;
+}
+
+// Valores con la resolución de cada sensor (como los da sensores.cpp)
+static Lectura lecturaSimulada(uint32_t i)
+{
+  Lectura l;
+  l.temp = -45 + 175.0f * (uint16_t)(26000 + 800 * sinf(i * 0.0436f) + siguiente() % 64) / 65536.0f;
+  l.humAir = 100.0f * (uint16_t)(36000 + 6000 * cosf(i * 0.0436f) + siguiente() % 128) / 65536.0f;
+  l.humSoil = (float)(1800 + siguiente() % 600);
+  l.lux = 0.0576f * (siguiente() % 20000);
+  l.batt = 0.00125f * (3000 + siguiente() % 400);
+  if (i % 97 == 0)
+    l.temp = l.humAir = -99; // SHTC3 caído
+  return l;
+}
+
+static bool igual(const Lectura &a, const Lectura &b, float tolerancia)
+{
+  return fabsf(a.temp - b.temp) <= tolerancia * fabsf(a.temp) && fabsf(a.humAir - b.humAir) <= tolerancia * fabsf(a.humAir) &&
+         fabsf(a.humSoil - b.humSoil) <= tolerancia * fabsf(a.humSoil) && fabsf(a.lux - b.lux) <= tolerancia * fabsf(a.lux) &&
+         fabsf(a.batt - b.batt) <= tolerancia * fabsf(a.batt);
+}
+
+// Un entero corto y un float para los valores que no caben en su campo
+struct Acotado
+{
+  uint8_t n;
+  float f;
+};
+CAMPO_ESQUEMA(Acotado, n);
+CAMPO_ESQUEMA(Acotado, f);
+typedef Esquema<CAMPO(Acotado, n), CAMPO(Acotado, f)> EsquemaAcotado;
+
+// Lo que viene de fuera puede no caber en el campo: error de lectura, no un cast indefinido
+static bool rechazaFueraDeRango()
+{
+  static const char *const jsonValidos[] = {"{\"n\": 255, \"f\": 1}", "{\"n\": 0.5}"};
+  static const char *const jsonInvalidos[] = {"{\"n\": 256}", "{\"n\": -1}", "{\"n\": 1e300}", "{\"f\": 1e39}"};
+  static const uint8_t nanEnEntero[] = {0x81, 0xA1, 'n', 0xCA, 0x7F, 0xC0, 0x00, 0x00};  // {"n": NaN}
+  static const uint8_t filaFueraDeRango[] = {0x92, 0xCD, 0x01, 0x00, 0x00};               // [256, 0]
+  bool correcto = true;
+  for (const char *j : jsonValidos)
+  {
+    Acotado a = {};
+    if (!EsquemaAcotado::leerJson(j, strlen(j), a))
+    {
+      printf("Esquema: rechaza %s\n", j);
+      correcto = false;
+    }
+  }
+  for (const char *j : jsonInvalidos)
+  {
+    Acotado a = {};
+    if (EsquemaAcotado::leerJson(j, strlen(j), a))
+    {
+      printf("Esquema: acepta %s\n", j);
+      correcto = false;
+    }
+  }
+  Acotado a = {};
+  esquema::LectorMsgPack fila(filaFueraDeRango, sizeof(filaFueraDeRango));
+  if (EsquemaAcotado::leerMsgPack(nanEnEntero, sizeof(nanEnEntero), a) || EsquemaAcotado::leerFilaMsgPack(fila, a))
+  {
+    printf("Esquema: acepta en MsgPack un entero NaN o fuera de rango\n");
+    correcto = false;
+  }
+  return correcto;
+}
+
+typedef std::chrono::steady_clock Reloj;
+
+static double nsPorRegistro(Reloj::time_point inicio, size_t registros)
+{
+  return std::chrono::duration<double, std::nano>(Reloj::now() - inicio).count() / registros;
+}
+
+int main(int argc, char **argv)
+{
+  size_t numRegistros = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000;
+  int vueltas = argc > 2 ? atoi(argv[2]) : 200;
+  if (numRegistros == 0)
+    numRegistros = 1;
+
+  Lectura *lecturas = new Lectura[numRegistros];
+  for (size_t i = 0; i < numRegistros; i++)
+    lecturas[i] = lecturaSimulada(i);
+
+  const Codificadores *caminos[] = {&codificadoresDom, &codificadoresEsquema};
+  bool correcto = true;
+
+  // Mismos bytes y lectura cruzada
+  size_t bytesJson = 0, bytesMsgPack = 0;
+  for (size_t i = 0; i < numRegistros && correcto; i++)
+  {
+    char json[2][MAX_BYTES];
+    uint8_t msgpack[2][MAX_BYTES];
+    size_t nJson[2], nMsgPack[2];
+    for (int c = 0; c < 2; c++)
+    {
+      nJson[c] = caminos[c]->escribirJson(lecturas[i], json[c], MAX_BYTES);
+      nMsgPack[c] = caminos[c]->escribirMsgPack(lecturas[i], msgpack[c], MAX_BYTES);
+    }
+    if (nJson[0] == 0 || nJson[0] != nJson[1] || memcmp(json[0], json[1], nJson[0]) ||
+        nMsgPack[0] == 0 || nMsgPack[0] != nMsgPack[1] || memcmp(msgpack[0], msgpack[1], nMsgPack[0]))
+    {
+      printf("registro %zu: los dos caminos no escriben lo mismo (%.*s / %.*s)\n", i, (int)nJson[0], json[0],
+             (int)nJson[1], json[1]);
+      correcto = false;
+    }
+    bytesJson += nJson[1];
+    bytesMsgPack += nMsgPack[1];
+    for (int c = 0; c < 2; c++)
+    {
+      Lectura deJson = {}, deMsgPack = {};
+      // JSON lleva 6 decimales: se compara con tolerancia; MsgPack es exacto
+      if (!caminos[c]->leerJson(json[1 - c], nJson[1 - c], deJson) || !igual(deJson, lecturas[i], 1e-5f) ||
+          !caminos[c]->leerMsgPack(msgpack[1 - c], nMsgPack[1 - c], deMsgPack) || !igual(deMsgPack, lecturas[i], 0))
+      {
+        printf("registro %zu: %s no lee lo que escribe el otro camino\n", i, caminos[c]->nombre);
+        correcto = false;
+      }
+    }
+  }
+
+  // Claves desconocidas, desordenadas o que faltan: las dos deben dejar igual lo que no viene
+  const char cambiado[] = "{\"lux\": 12.5, \"nuevo\": {\"a\": [1, 2, \"x\"]}, \"temp\": -3, \"extra\": null}";
+  for (int c = 0; c < 2; c++)
+  {
+    Lectura l = {1, 2, 3, 4, 5};
+    if (!caminos[c]->leerJson(cambiado, sizeof(cambiado) - 1, l) || l.lux != 12.5f || l.temp != -3 || l.humAir != 2 ||
+        l.batt != 5)
+    {
+      printf("%s: esquema cambiado mal leído\n", caminos[c]->nombre);
+      correcto = false;
+    }
+  }
+
+  if (!rechazaFueraDeRango())
+    correcto = false;
+
+  printf("%zu registros, %d vueltas; JSON %.1f B/registro, MsgPack %.1f B/registro\n\n", numRegistros, vueltas,
+         (double)bytesJson / numRegistros, (double)bytesMsgPack / numRegistros);
+  printf("%-14s %12s %12s %12s %12s\n", "ns/registro", "JSON esc", "MsgPack esc", "JSON lee", "MsgPack lee");
+
+  char *json = new char[numRegistros * MAX_BYTES];
+  uint8_t *msgpack = new uint8_t[numRegistros * MAX_BYTES];
+  size_t *nJson = new size_t[numRegistros];
+  size_t *nMsgPack = new size_t[numRegistros];
+  size_t total = numRegistros * vueltas;
+  for (const Codificadores *c : caminos)
+  {
+    Reloj::time_point inicio = Reloj::now();
+    for (int v = 0; v < vueltas; v++)
+      for (size_t i = 0; i < numRegistros; i++)
+        nJson[i] = c->escribirJson(lecturas[i], json + i * MAX_BYTES, MAX_BYTES);
+    double escJson = nsPorRegistro(inicio, total);
+
+    inicio = Reloj::now();
+    for (int v = 0; v < vueltas; v++)
+      for (size_t i = 0; i < numRegistros; i++)
+        nMsgPack[i] = c->escribirMsgPack(lecturas[i], msgpack + i * MAX_BYTES, MAX_BYTES);
+    double escMsgPack = nsPorRegistro(inicio, total);
+
+    Lectura l;
+    inicio = Reloj::now();
+    for (int v = 0; v < vueltas; v++)
+      for (size_t i = 0; i < numRegistros; i++)
+        sumidero = sumidero + c->leerJson(json + i * MAX_BYTES, nJson[i], l);
+    double leeJson = nsPorRegistro(inicio, total);
+
+    inicio = Reloj::now();
+    for (int v = 0; v < vueltas; v++)
+      for (size_t i = 0; i < numRegistros; i++)
+        sumidero = sumidero + c->leerMsgPack(msgpack + i * MAX_BYTES, nMsgPack[i], l);
+    double leeMsgPack = nsPorRegistro(inicio, total);
+
+    printf("%-14s %12.1f %12.1f %12.1f %12.1f\n", c->nombre, escJson, escMsgPack, leeJson, leeMsgPack);
+  }
+
+  delete[] lecturas;
+  delete[] json;
+  delete[] msgpack;
+  delete[] nJson;
+  delete[] nMsgPack;
+  return correcto ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+// Los dos caminos que compara banco_host.cpp, con la misma interfaz. Cada uno en su propia
+// unidad de compilación para poder medir su código con size(1).
+
+#ifndef CODIFICADORES_H
+#define CODIFICADORES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Como SensorData en src/sensores.h
+struct Lectura
+{
+  float temp;
+  float humAir;
+  float humSoil;
+  float lux;
+  float batt;
+};
+
+// Devuelven los bytes escritos (0 si no caben) o si se pudo leer
+struct Codificadores
+{
+  const char *nombre;
+  size_t (*escribirJson)(const Lectura &l, char *destino, size_t capacidad);
+  size_t (*escribirMsgPack)(const Lectura &l, uint8_t *destino, size_t capacidad);
+  bool (*leerJson)(const char *texto, size_t bytes, Lectura &l);
+  bool (*leerMsgPack)(const uint8_t *datos, size_t bytes, Lectura &l);
+};
+
+extern const Codificadores codificadoresDom;     // JsonDocument
+extern const Codificadores codificadoresEsquema; // Esquema.h
+
+#endif
@@ -0,0 +1,57 @@
+// Camino con documento: se rellena un JsonDocument y se serializa, o se deserializa y se
+// leen los miembros. El documento se crea en cada llamada, como se usaría en el nodo.
+#include <ArduinoJson.h>
+#include "codificadores.h"
+
+static void rellenar(JsonDocument &doc, const Lectura &l)
+{
+  doc["temp"] = l.temp;
+  doc["humAir"] = l.humAir;
+  doc["humSoil"] = l.humSoil;
+  doc["lux"] = l.lux;
+  doc["batt"] = l.batt;
+}
+
+static void extraer(const JsonDocument &doc, Lectura &l)
+{
+  l.temp = doc["temp"] | l.temp;
+  l.humAir = doc["humAir"] | l.humAir;
+  l.humSoil = doc["humSoil"] | l.humSoil;
+  l.lux = doc["lux"] | l.lux;
+  l.batt = doc["batt"] | l.batt;
+}
+
+static size_t escribirJson(const Lectura &l, char *destino, size_t capacidad)
+{
+  JsonDocument doc;
+  rellenar(doc, l);
+  size_t n = serializeJson(doc, destino, capacidad);
+  return n < capacidad ? n : 0; // serializeJson() deja sitio para el '\0'
+}
+
+static size_t escribirMsgPack(const Lectura &l, uint8_t *destino, size_t capacidad)
+{
+  JsonDocument doc;
+  rellenar(doc, l);
+  return measureMsgPack(doc) <= capacidad ? serializeMsgPack(doc, destino, capacidad) : 0;
+}
+
+static bool leerJson(const char *texto, size_t bytes, Lectura &l)
+{
+  JsonDocument doc;
+  if (deserializeJson(doc, texto, bytes) != DeserializationError::Ok || !doc.is<JsonObject>())
+    return false;
+  extraer(doc, l);
+  return true;
+}
+
+static bool leerMsgPack(const uint8_t *datos, size_t bytes, Lectura &l)
+{
+  JsonDocument doc;
+  if (deserializeMsgPack(doc, datos, bytes) != DeserializationError::Ok || !doc.is<JsonObject>())
+    return false;
+  extraer(doc, l);
+  return true;
+}
+
+const Codificadores codificadoresDom = {"JsonDocument", escribirJson, escribirMsgPack, leerJson, leerMsgPack};
@@ -0,0 +1,64 @@
+// Camino con esquema: sin documento, secuencia recta de escrituras generada por Esquema.h
+#include <Esquema.h>
+#include "codificadores.h"
+
+CAMPO_ESQUEMA(Lectura, temp);
+CAMPO_ESQUEMA(Lectura, humAir);
+CAMPO_ESQUEMA(Lectura, humSoil);
+CAMPO_ESQUEMA(Lectura, lux);
+CAMPO_ESQUEMA(Lectura, batt);
+typedef Esquema<CAMPO(Lectura, temp), CAMPO(Lectura, humAir), CAMPO(Lectura, humSoil), CAMPO(Lectura, lux),
+                CAMPO(Lectura, batt)>
+    EsquemaLectura;
+
+// Escritor sobre un buffer fijo: si no cabe, deja de escribir y lo recuerda
+class EscritorFijo
+{
+public:
+  EscritorFijo(uint8_t *destino, size_t capacidad) : _p(destino), _capacidad(capacidad), _bytes(0), _lleno(false) {}
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t *datos, size_t n)
+  {
+    if (_lleno || n > _capacidad - _bytes)
+    {
+      _lleno = true;
+      return 0;
+    }
+    memcpy(_p + _bytes, datos, n);
+    _bytes += n;
+    return n;
+  }
+  size_t resultado() const { return _lleno ? 0 : _bytes; }
+
+private:
+  uint8_t *_p;
+  size_t _capacidad;
+  size_t _bytes;
+  bool _lleno;
+};
+
+static size_t escribirJson(const Lectura &l, char *destino, size_t capacidad)
+{
+  EscritorFijo w((uint8_t *)destino, capacidad);
+  EsquemaLectura::escribirJson(l, w);
+  return w.resultado();
+}
+
+static size_t escribirMsgPack(const Lectura &l, uint8_t *destino, size_t capacidad)
+{
+  EscritorFijo w(destino, capacidad);
+  EsquemaLectura::escribirMsgPack(l, w);
+  return w.resultado();
+}
+
+static bool leerJson(const char *texto, size_t bytes, Lectura &l)
+{
+  return EsquemaLectura::leerJson(texto, bytes, l);
+}
+
+static bool leerMsgPack(const uint8_t *datos, size_t bytes, Lectura &l)
+{
+  return EsquemaLectura::leerMsgPack(datos, bytes, l);
+}
+
+const Codificadores codificadoresEsquema = {"Esquema", escribirJson, escribirMsgPack, leerJson, leerMsgPack};
@@ -0,0 +1,78 @@
+// Dispositivos I2C simulados para ejecutar drivers y lógica de adquisición en el host.
+// La interfaz es a nivel de byte, como el bus real: direccionamiento tras START o
+// repeated start, bytes escritos con ACK/NACK, bytes leídos y STOP. El tiempo es virtual
+// y lo aporta quien mueve el bus (backend de ColaI2C o TwoWire simulado).
+
+#ifndef DISPOSITIVO_I2C_SIMULADO_H
+#define DISPOSITIVO_I2C_SIMULADO_H
+
+#include <stdint.h>
+
+class DispositivoI2CSimulado
+{
+public:
+  explicit DispositivoI2CSimulado(uint8_t direccion) : _direccion(direccion) {}
+  virtual ~DispositivoI2CSimulado() {}
+
+  uint8_t direccion() const { return _direccion; }
+
+  // START o repeated start con esta dirección. false = NACK a la dirección
+  virtual bool direccionar(bool lectura, uint32_t ahoraUs) = 0;
+  // false = NACK al byte
+  virtual bool escribir(uint8_t dato, uint32_t ahoraUs) = 0;
+  virtual uint8_t leer(uint32_t ahoraUs) = 0;
+  virtual void parar(uint32_t ahoraUs) { (void)ahoraUs; }
+  // Clock stretching: microsegundos que el esclavo retiene SCL antes del primer byte leído
+  virtual uint32_t esperaLecturaUs(uint32_t ahoraUs)
+  {
+    (void)ahoraUs;
+    return 0;
+  }
+
+private:
+  uint8_t _direccion;
+};
+
+// Mapa de registros de 16 bits con puntero: el primer byte de cada escritura fija el
+// puntero y los siguientes escriben el registro apuntado; las lecturas devuelven el
+// registro apuntado. Sirve de base para INA226 (MSB primero) y VEML7700 (LSB primero).
+class DispositivoRegistrosSimulado : public DispositivoI2CSimulado
+{
+public:
+  static const uint16_t MAX_REGISTROS = 256;
+
+  DispositivoRegistrosSimulado(uint8_t direccion, uint16_t numRegistros, bool msbPrimero);
+
+  uint16_t registro(uint8_t reg) const { return _regs[reg]; }
+  void fijarRegistro(uint8_t reg, uint16_t valor) { _regs[reg] = valor; }
+  uint32_t escrituras(uint8_t reg) const { return _escrituras[reg]; }
+  uint32_t lecturas(uint8_t reg) const { return _lecturas[reg]; }
+
+  bool direccionar(bool lectura, uint32_t ahoraUs) override;
+  bool escribir(uint8_t dato, uint32_t ahoraUs) override;
+  uint8_t leer(uint32_t ahoraUs) override;
+  void parar(uint32_t ahoraUs) override;
+
+protected:
+  // Punteros que el dispositivo acepta (ACK); el INA226, por ejemplo, tiene sus IDs en 0xFE/0xFF
+  virtual bool registroValido(uint8_t reg) const { return reg < _numRegistros; }
+  // Ganchos para simuladores concretos: se llaman al completar un registro
+  virtual void alEscribirRegistro(uint8_t reg, uint16_t valor, uint32_t ahoraUs);
+  virtual uint16_t alLeerRegistro(uint8_t reg, uint32_t ahoraUs);
+
+  uint16_t _regs[MAX_REGISTROS];
+
+private:
+  uint16_t _numRegistros;
+  bool _msbPrimero;
+  uint8_t _puntero;
+  int _bytesEscritos; // en la transferencia actual, incluido el puntero
+  int _bytesLeidos;
+  uint16_t _valorEscrito;
+  uint16_t _valorLeido;
+  bool _punteroValido;
+  uint32_t _escrituras[MAX_REGISTROS];
+  uint32_t _lecturas[MAX_REGISTROS];
+};
+
+#endif
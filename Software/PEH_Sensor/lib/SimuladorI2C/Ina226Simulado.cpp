@@ -0,0 +1,61 @@
+#include "Ina226Simulado.h"
+
+#define INA226_CONFIG_RESET 0x4127
+#define INA226_BIT_RESET 0x8000
+
+Ina226Simulado::Ina226Simulado(uint8_t direccion, float shuntOhm)
+    : DispositivoRegistrosSimulado(direccion, 8, true), _shuntOhm(shuntOhm), _voltios(3.9f), _amperios(0.012f)
+{
+  reiniciar();
+}
+
+void Ina226Simulado::reiniciar()
+{
+  for (uint8_t r = 0; r < 8; r++)
+    _regs[r] = 0;
+  _regs[REG_CONFIG] = INA226_CONFIG_RESET;
+  _regs[REG_FABRICANTE] = 0x5449; // "TI"
+  _regs[REG_DIE_ID] = 0x2260;
+}
+
+bool Ina226Simulado::registroValido(uint8_t reg) const
+{
+  return reg <= REG_ALERTA || reg == REG_FABRICANTE || reg == REG_DIE_ID;
+}
+
+void Ina226Simulado::alEscribirRegistro(uint8_t reg, uint16_t valor, uint32_t ahoraUs)
+{
+  (void)ahoraUs;
+  if (reg == REG_CONFIG && (valor & INA226_BIT_RESET))
+    reiniciar();
+}
+
+// Conversión continua: cada lectura devuelve la medida actual. Corriente y potencia
+// salen de la calibración como en el chip: I = Vshunt·CAL/2048, P = I·Vbus/20000
+uint16_t Ina226Simulado::alLeerRegistro(uint8_t reg, uint32_t ahoraUs)
+{
+  (void)ahoraUs;
+  int32_t shunt = (int32_t)(_amperios * _shuntOhm / 2.5e-6f);
+  if (shunt > 32767)
+    shunt = 32767;
+  if (shunt < -32768)
+    shunt = -32768;
+  uint32_t bus = (uint32_t)(_voltios / 1.25e-3f);
+  if (bus > 0x7FFF)
+    bus = 0x7FFF;
+  int32_t corriente = shunt * (int32_t)_regs[REG_CALIBRACION] / 2048;
+
+  switch (reg)
+  {
+  case REG_SHUNT:
+    return (uint16_t)(int16_t)shunt;
+  case REG_BUS:
+    return (uint16_t)bus;
+  case REG_CORRIENTE:
+    return (uint16_t)(int16_t)corriente;
+  case REG_POTENCIA:
+    return (uint16_t)((uint32_t)(corriente < 0 ? -corriente : corriente) * bus / 20000);
+  default:
+    return _regs[reg];
+  }
+}
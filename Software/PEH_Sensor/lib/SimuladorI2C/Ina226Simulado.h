@@ -0,0 +1,45 @@
+// INA226 simulado: mapa de registros de 16 bits MSB primero con puntero, IDs en
+// 0xFE/0xFF y conversiones de shunt, bus, corriente y potencia a partir de la tensión
+// y la corriente fijadas, con la calibración que haya escrito el driver.
+
+#ifndef INA226_SIMULADO_H
+#define INA226_SIMULADO_H
+
+#include "DispositivoI2CSimulado.h"
+
+class Ina226Simulado : public DispositivoRegistrosSimulado
+{
+public:
+  static const uint8_t REG_CONFIG = 0x00;
+  static const uint8_t REG_SHUNT = 0x01;
+  static const uint8_t REG_BUS = 0x02;
+  static const uint8_t REG_POTENCIA = 0x03;
+  static const uint8_t REG_CORRIENTE = 0x04;
+  static const uint8_t REG_CALIBRACION = 0x05;
+  static const uint8_t REG_MASK_ENABLE = 0x06;
+  static const uint8_t REG_ALERTA = 0x07;
+  static const uint8_t REG_FABRICANTE = 0xFE;
+  static const uint8_t REG_DIE_ID = 0xFF;
+
+  explicit Ina226Simulado(uint8_t direccion = 0x40, float shuntOhm = 0.1f);
+
+  void fijarMedida(float voltios, float amperios)
+  {
+    _voltios = voltios;
+    _amperios = amperios;
+  }
+
+protected:
+  bool registroValido(uint8_t reg) const override;
+  void alEscribirRegistro(uint8_t reg, uint16_t valor, uint32_t ahoraUs) override;
+  uint16_t alLeerRegistro(uint8_t reg, uint32_t ahoraUs) override;
+
+private:
+  void reiniciar();
+
+  float _shuntOhm;
+  float _voltios;
+  float _amperios;
+};
+
+#endif
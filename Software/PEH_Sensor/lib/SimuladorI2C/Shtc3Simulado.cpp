@@ -0,0 +1,183 @@
+#include "Shtc3Simulado.h"
+
+#define SHTC3_DIRECCION 0x70
+#define SHTC3_ID 0x0807 // bits 11 y 5:0 fijados por la hoja de datos
+
+#define CMD_WAKEUP 0x3517
+#define CMD_SLEEP 0xB098
+#define CMD_RESET 0x805D
+#define CMD_ID 0xEFC8
+
+Shtc3Simulado::Shtc3Simulado()
+    : DispositivoI2CSimulado(SHTC3_DIRECCION), _tempC(21.5f), _humedad(48.0f), _dormido(true),
+      _listoUs(0), _plazoPendiente(false), _midiendo(false), _estirar(false), _tempPrimero(true), _bytesComando(0),
+      _comandoAlto(0), _longitudSalida(0), _posicionSalida(0), _crcCorruptos(0),
+      _comandos(0), _medidas(0), _despertares(0), _rechazados(0), _ignorados(0)
+{
+}
+
+uint8_t Shtc3Simulado::crc(uint8_t alto, uint8_t bajo)
+{
+  uint8_t c = 0xFF;
+  uint8_t datos[2] = {alto, bajo};
+  for (int i = 0; i < 2; i++)
+  {
+    c ^= datos[i];
+    for (int b = 0; b < 8; b++)
+      c = (c & 0x80) ? (uint8_t)((c << 1) ^ 0x31) : (uint8_t)(c << 1);
+  }
+  return c;
+}
+
+void Shtc3Simulado::cargarPalabra(uint8_t indice, uint16_t valor, bool corromper)
+{
+  _salida[indice] = (uint8_t)(valor >> 8);
+  _salida[indice + 1] = (uint8_t)valor;
+  _salida[indice + 2] = crc(_salida[indice], _salida[indice + 1]) ^ (corromper ? 0x5A : 0);
+}
+
+void Shtc3Simulado::fijarPlazo(uint32_t listoUs)
+{
+  _listoUs = listoUs;
+  _plazoPendiente = true;
+}
+
+// El plazo se olvida al vencer: con el reloj de 32 bits, una comparación tras un sueño
+// de más de 35 min daría la vuelta
+bool Shtc3Simulado::ocupado(uint32_t ahoraUs)
+{
+  if (_plazoPendiente && (int32_t)(ahoraUs - _listoUs) >= 0)
+    _plazoPendiente = false;
+  return _plazoPendiente;
+}
+
+// Dormido o despertando no hay lectura posible; en modo sin clock stretching la
+// lectura se rechaza hasta que termina la medida
+bool Shtc3Simulado::direccionar(bool lectura, uint32_t ahoraUs)
+{
+  _bytesComando = 0;
+  _posicionSalida = 0;
+  if (!lectura)
+    return true;
+  if (_dormido || (ocupado(ahoraUs) && !(_midiendo && _estirar)))
+    return false;
+  return _longitudSalida > 0;
+}
+
+bool Shtc3Simulado::escribir(uint8_t dato, uint32_t ahoraUs)
+{
+  if (_bytesComando == 0)
+  {
+    _comandoAlto = dato;
+    _bytesComando = 1;
+    return true;
+  }
+  if (_bytesComando == 1)
+  {
+    _bytesComando = 2;
+    uint16_t comando = (uint16_t)(_comandoAlto << 8) | dato;
+    // Dormido acepta los bytes pero solo atiende al wakeup (el driver manda sleep
+    // dos veces seguidas en begin()); ocupado no reconoce ningún comando
+    if (_dormido && comando != CMD_WAKEUP)
+    {
+      _ignorados++;
+      return true;
+    }
+    if (!_dormido && ocupado(ahoraUs))
+    {
+      _rechazados++;
+      return false;
+    }
+    ejecutar(comando, ahoraUs);
+    return true;
+  }
+  return false;
+}
+
+void Shtc3Simulado::ejecutar(uint16_t comando, uint32_t ahoraUs)
+{
+  _comandos++;
+  _longitudSalida = 0;
+  _midiendo = false;
+  switch (comando)
+  {
+  case CMD_WAKEUP:
+    if (_dormido)
+    {
+      _despertares++;
+      fijarPlazo(ahoraUs + T_DESPERTAR_US);
+    }
+    _dormido = false;
+    return;
+  case CMD_SLEEP:
+    _dormido = true;
+    return;
+  case CMD_RESET:
+    fijarPlazo(ahoraUs + T_DESPERTAR_US);
+    return;
+  case CMD_ID:
+    cargarPalabra(0, SHTC3_ID, false);
+    _longitudSalida = 3;
+    return;
+  }
+
+  // Medidas: bit de clock stretching y orden T/RH según el código del comando
+  bool bajoConsumo;
+  switch (comando)
+  {
+  case 0x7CA2: _estirar = true;  _tempPrimero = true;  bajoConsumo = false; break;
+  case 0x5C24: _estirar = true;  _tempPrimero = false; bajoConsumo = false; break;
+  case 0x6458: _estirar = true;  _tempPrimero = true;  bajoConsumo = true;  break;
+  case 0x44DE: _estirar = true;  _tempPrimero = false; bajoConsumo = true;  break;
+  case 0x7866: _estirar = false; _tempPrimero = true;  bajoConsumo = false; break;
+  case 0x58E0: _estirar = false; _tempPrimero = false; bajoConsumo = false; break;
+  case 0x609C: _estirar = false; _tempPrimero = true;  bajoConsumo = true;  break;
+  case 0x401A: _estirar = false; _tempPrimero = false; bajoConsumo = true;  break;
+  default:
+    _comandos--;
+    _rechazados++;
+    return;
+  }
+  _medidas++;
+  _midiendo = true;
+  fijarPlazo(ahoraUs + (bajoConsumo ? T_MEDIDA_BAJO_CONSUMO_US : T_MEDIDA_NORMAL_US));
+
+  float t = (_tempC + 45.0f) / 175.0f * 65536.0f;
+  float h = _humedad / 100.0f * 65536.0f;
+  uint16_t crudaT = (uint16_t)(t < 0 ? 0 : t > 65535 ? 65535 : t);
+  uint16_t crudaH = (uint16_t)(h < 0 ? 0 : h > 65535 ? 65535 : h);
+  bool corromper = _crcCorruptos > 0;
+  if (corromper)
+    _crcCorruptos--;
+  cargarPalabra(_tempPrimero ? 0 : 3, crudaT, corromper);
+  cargarPalabra(_tempPrimero ? 3 : 0, crudaH, false);
+  _longitudSalida = 6;
+}
+
+uint32_t Shtc3Simulado::esperaLecturaUs(uint32_t ahoraUs)
+{
+  if (!_midiendo || !_estirar || !ocupado(ahoraUs))
+    return 0;
+  return _listoUs - ahoraUs;
+}
+
+uint8_t Shtc3Simulado::leer(uint32_t ahoraUs)
+{
+  (void)ahoraUs;
+  if (_posicionSalida >= _longitudSalida)
+    return 0xFF;
+  return _salida[_posicionSalida++];
+}
+
+void Shtc3Simulado::parar(uint32_t ahoraUs)
+{
+  (void)ahoraUs;
+  _bytesComando = 0;
+  if (_posicionSalida > 0)
+  {
+    // Los datos se entregan una sola vez
+    _longitudSalida = 0;
+    _midiendo = false;
+  }
+  _posicionSalida = 0;
+}
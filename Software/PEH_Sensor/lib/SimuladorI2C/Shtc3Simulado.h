@@ -0,0 +1,71 @@
+// SHTC3 simulado (0x70): comandos de 16 bits, sleep/wakeup, ID, medidas con y sin
+// clock stretching en modo normal o de bajo consumo y CRC-8 (0x31, inicial 0xFF) en
+// cada palabra. Se pueden inyectar CRC corruptos para ejercitar los reintentos.
+
+#ifndef SHTC3_SIMULADO_H
+#define SHTC3_SIMULADO_H
+
+#include "DispositivoI2CSimulado.h"
+
+class Shtc3Simulado : public DispositivoI2CSimulado
+{
+public:
+  // Tiempos máximos de la hoja de datos
+  static const uint32_t T_DESPERTAR_US = 240;
+  static const uint32_t T_MEDIDA_NORMAL_US = 12100;
+  static const uint32_t T_MEDIDA_BAJO_CONSUMO_US = 800;
+
+  Shtc3Simulado();
+
+  void fijarAmbiente(float tempC, float humedad)
+  {
+    _tempC = tempC;
+    _humedad = humedad;
+  }
+  // Las próximas n medidas llegan con el CRC de la temperatura alterado
+  void corromperCRC(uint32_t n) { _crcCorruptos = n; }
+
+  bool dormido() const { return _dormido; }
+  uint32_t comandos() const { return _comandos; }
+  uint32_t medidas() const { return _medidas; }
+  uint32_t despertares() const { return _despertares; }
+  uint32_t comandosRechazados() const { return _rechazados; } // NACK por estar ocupado
+  uint32_t comandosIgnorados() const { return _ignorados; }   // recibidos estando dormido
+
+  static uint8_t crc(uint8_t alto, uint8_t bajo);
+
+  bool direccionar(bool lectura, uint32_t ahoraUs) override;
+  bool escribir(uint8_t dato, uint32_t ahoraUs) override;
+  uint8_t leer(uint32_t ahoraUs) override;
+  void parar(uint32_t ahoraUs) override;
+  uint32_t esperaLecturaUs(uint32_t ahoraUs) override;
+
+private:
+  void ejecutar(uint16_t comando, uint32_t ahoraUs);
+  void fijarPlazo(uint32_t listoUs);
+  bool ocupado(uint32_t ahoraUs);
+  void cargarPalabra(uint8_t indice, uint16_t valor, bool corromper);
+
+  float _tempC;
+  float _humedad;
+  bool _dormido;
+  uint32_t _listoUs;  // fin del despertar o de la medida en curso
+  bool _plazoPendiente;
+  bool _midiendo;
+  bool _estirar;      // medida con clock stretching
+  bool _tempPrimero;
+  uint8_t _bytesComando;
+  uint8_t _comandoAlto;
+  uint8_t _salida[6];
+  uint8_t _longitudSalida;
+  uint8_t _posicionSalida;
+  uint32_t _crcCorruptos;
+
+  uint32_t _comandos;
+  uint32_t _medidas;
+  uint32_t _despertares;
+  uint32_t _rechazados;
+  uint32_t _ignorados;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "Veml7700Simulado.h"
+
+#define VEML7700_DIRECCION 0x10
+#define VEML7700_ID 0xC481
+
+#define CONF_SD 0x0001 // apagado (valor de reset)
+#define PSM_EN 0x0001
+
+Veml7700Simulado::Veml7700Simulado()
+    : DispositivoRegistrosSimulado(VEML7700_DIRECCION, 8, false), _lux(350.0f), _integrando(false),
+      _hayDato(false), _inicioUs(0), _als(0), _prematuras(0)
+{
+  _regs[REG_ALS_CONF] = CONF_SD;
+  _regs[REG_ID] = VEML7700_ID;
+}
+
+uint32_t Veml7700Simulado::integracionUs(uint16_t conf)
+{
+  switch ((conf >> 6) & 0x0F)
+  {
+  case 0x0C: return 25000;
+  case 0x08: return 50000;
+  case 0x01: return 200000;
+  case 0x02: return 400000;
+  case 0x03: return 800000;
+  default:   return 100000;
+  }
+}
+
+// 0.0036 lux/cuenta con ganancia 2 e integración de 800 ms; escala inversa con ambas
+float Veml7700Simulado::luxPorCuenta(uint16_t conf)
+{
+  static const float GANANCIA[4] = {1.0f, 2.0f, 0.125f, 0.25f};
+  float ganancia = GANANCIA[(conf >> 11) & 0x03];
+  return 0.0036f * (800000.0f / integracionUs(conf)) * (2.0f / ganancia);
+}
+
+// Con PSM activo el sensor descansa entre integraciones 500/1000/2000/4000 ms
+void Veml7700Simulado::actualizar(uint32_t ahoraUs)
+{
+  if (!_integrando)
+    return;
+  uint16_t conf = _regs[REG_ALS_CONF];
+  uint32_t ciclo = integracionUs(conf);
+  if (_regs[REG_PSM] & PSM_EN)
+    ciclo += 500000UL << ((_regs[REG_PSM] >> 1) & 0x03);
+  if (ahoraUs - _inicioUs < integracionUs(conf))
+    return;
+  _hayDato = true;
+  float cuentas = _lux / luxPorCuenta(conf);
+  _als = (uint16_t)(cuentas > 65535.0f ? 65535.0f : cuentas);
+  _regs[REG_WHITE] = _als;
+  _inicioUs += (ahoraUs - _inicioUs) / ciclo * ciclo;
+}
+
+void Veml7700Simulado::alEscribirRegistro(uint8_t reg, uint16_t valor, uint32_t ahoraUs)
+{
+  if (reg != REG_ALS_CONF)
+    return;
+  // Encender o cambiar ganancia/integración reinicia el ciclo de medida
+  _integrando = !(valor & CONF_SD);
+  _inicioUs = ahoraUs;
+  _hayDato = false;
+}
+
+uint16_t Veml7700Simulado::alLeerRegistro(uint8_t reg, uint32_t ahoraUs)
+{
+  if (reg != REG_ALS && reg != REG_WHITE)
+    return _regs[reg];
+  actualizar(ahoraUs);
+  if (!_hayDato && reg == REG_ALS)
+    _prematuras++;
+  return reg == REG_ALS ? _als : _regs[REG_WHITE];
+}
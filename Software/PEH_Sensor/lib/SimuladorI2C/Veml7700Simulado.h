@@ -0,0 +1,43 @@
+// VEML7700 simulado (0x10): registros de 16 bits LSB primero. ALS se actualiza solo al
+// completar una integración entera desde el encendido o el último cambio de ALS_CONF,
+// con la resolución que dan la ganancia y el tiempo de integración configurados.
+
+#ifndef VEML7700_SIMULADO_H
+#define VEML7700_SIMULADO_H
+
+#include "DispositivoI2CSimulado.h"
+
+class Veml7700Simulado : public DispositivoRegistrosSimulado
+{
+public:
+  static const uint8_t REG_ALS_CONF = 0x00;
+  static const uint8_t REG_PSM = 0x03;
+  static const uint8_t REG_ALS = 0x04;
+  static const uint8_t REG_WHITE = 0x05;
+  static const uint8_t REG_ID = 0x07;
+
+  Veml7700Simulado();
+
+  void fijarLux(float lux) { _lux = lux; }
+  // Lecturas de ALS hechas antes de que terminase la primera integración (dato viejo o 0)
+  uint32_t lecturasPrematuras() const { return _prematuras; }
+
+  static uint32_t integracionUs(uint16_t conf);
+  static float luxPorCuenta(uint16_t conf);
+
+protected:
+  void alEscribirRegistro(uint8_t reg, uint16_t valor, uint32_t ahoraUs) override;
+  uint16_t alLeerRegistro(uint8_t reg, uint32_t ahoraUs) override;
+
+private:
+  void actualizar(uint32_t ahoraUs);
+
+  float _lux;
+  bool _integrando;
+  bool _hayDato; // integración completa con la configuración actual
+  uint32_t _inicioUs; // inicio de la integración en curso
+  uint16_t _als;
+  uint32_t _prematuras;
+};
+
+#endif
@@ -0,0 +1,58 @@
+# Informe de arranque en la salida del build (extra_scripts = post:scripts/informe_arranque.py).
+#
+# En cada arranque, también al despertar de deep sleep, el bootloader copia la app desde
+# flash y comprueba su hash, así que el tamaño de la imagen y la configuración de flash fijan
+# buena parte del tiempo hasta setup(). El informe solo depende del binario y de
+# platformio.ini, de modo que es reproducible y una regresión hace fallar el build.
+#
+# Es una estimación a partir del tamaño, no una medida: el tiempo medido hasta la primera
+# muestra (desde la app, sin ROM ni bootloader) lo da DEBUG_SERIAL en "[PERFIL] primera
+# muestra" (primeraMuestraUs en src/sensores.h).
+#
+# Opciones en platformio.ini:
+#   custom_presupuesto_carga_ms = 200   ; tiempo estimado de carga + verificación admitido
+
+Import("env")
+
+import os
+
+# Rendimiento efectivo medio de la carga por caché frente al teórico del bus de flash
+EFICIENCIA_LECTURA_FLASH = 0.5
+# SHA-256 de la verificación de imagen en el bootloader (MB/s, aproximado para el S3)
+VELOCIDAD_SHA_MBS = 10.0
+LINEAS_POR_MODO = {"qio": 4, "qout": 4, "dio": 2, "dout": 2}
+
+
+def estimar_carga_ms(tam_bytes, f_flash_hz, lineas):
+    bytes_s = f_flash_hz * lineas / 8.0 * EFICIENCIA_LECTURA_FLASH
+    lectura = tam_bytes / bytes_s * 1000.0
+    sha = tam_bytes / (VELOCIDAD_SHA_MBS * 1e6) * 1000.0
+    return lectura, sha
+
+
+def informe_arranque(source, target, env):
+    binario = str(target[0])
+    tam = os.path.getsize(binario)
+
+    placa = env.BoardConfig()
+    f_flash = int(str(placa.get("build.f_flash", "40000000L")).rstrip("L"))
+    modo = placa.get("build.flash_mode", "dio")
+    lineas = LINEAS_POR_MODO.get(modo, 1)
+
+    lectura, sha = estimar_carga_ms(tam, f_flash, lineas)
+    total = lectura + sha
+    presupuesto = float(env.GetProjectOption("custom_presupuesto_carga_ms", "0"))
+
+    print("=== Informe de arranque (estimado a partir de la imagen, no medido) ===")
+    print("  imagen app      : %d bytes" % tam)
+    print("  flash           : %s @ %d MHz" % (modo, f_flash // 1000000))
+    print("  carga estimada  : %.1f ms (lectura %.1f + verificación %.1f)" % (total, lectura, sha))
+    if presupuesto > 0:
+        print("  presupuesto     : %.1f ms" % presupuesto)
+        if total > presupuesto:
+            print("ERROR: la carga estimada supera custom_presupuesto_carga_ms")
+            return 1
+    return 0
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", informe_arranque)
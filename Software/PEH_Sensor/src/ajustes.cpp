@@ -0,0 +1,109 @@
+#include "ajustes.h"
+#include <string.h>
+
+RTC_DATA_ATTR AjustesNodo ajustes; // a cero tras un arranque en frío: versión 0, no válida
+
+#define CLAVE_NVS_AJUSTES "ajustes"
+
+// CRC-16/CCITT-FALSE: polinomio 0x1021, valor inicial 0xFFFF
+uint16_t crcAjustes(const AjustesNodo &a)
+{
+  const uint8_t *p = (const uint8_t *)&a;
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < offsetof(AjustesNodo, crc); i++)
+  {
+    crc ^= (uint16_t)p[i] << 8;
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+uint16_t msIntegracionVeml(uint8_t codigo)
+{
+  switch (codigo)
+  {
+  case 0x0C:
+    return 25;
+  case 0x08:
+    return 50;
+  case 0x00:
+    return 100;
+  case 0x01:
+    return 200;
+  case 0x02:
+    return 400;
+  case 0x03:
+    return 800;
+  default:
+    return 0;
+  }
+}
+
+bool ajustesValidos(const AjustesNodo &a)
+{
+  return a.version == VERSION_AJUSTES && a.crc == crcAjustes(a) && a.tamPaquete >= 1 &&
+         a.tamPaquete <= MAX_PACKET_SIZE && a.cicloS >= MIN_CICLO_S && a.cicloS <= MAX_CICLO_S &&
+         a.numRegistros >= 1 && a.numRegistros <= MAX_NUM_REGISTROS && a.timeoutBleS >= MIN_TIMEOUT_BLE_S &&
+         a.timeoutBleS <= MAX_TIMEOUT_BLE_S && a.gananciaVeml <= 0x03 && msIntegracionVeml(a.integracionVeml) > 0;
+}
+
+static AjustesNodo ajustesDeFabrica()
+{
+  AjustesNodo a;
+  memset(&a, 0, sizeof(a));
+  a.version = VERSION_AJUSTES;
+  a.tamPaquete = PACKET_SIZE;
+  a.cicloS = (uint16_t)(MEASURE_CYCLE_MINUTES * 60 + 0.5);
+  a.numRegistros = NUM_REGISTROS;
+  a.timeoutBleS = BLE_TIMEOUT_SECONDS;
+  a.gananciaVeml = GANANCIA_VEML_FABRICA;
+  a.integracionVeml = INTEGRACION_VEML_FABRICA;
+  a.crc = crcAjustes(a);
+  return a;
+}
+
+void cargarAjustes()
+{
+  if (ajustesValidos(ajustes))
+    return; // despertar normal: nada que leer
+
+  AjustesNodo nvs;
+  bool deNvs = nvsLeer(CLAVE_NVS_AJUSTES, &nvs, sizeof(nvs)) == sizeof(nvs) && ajustesValidos(nvs);
+  ajustes = deNvs ? nvs : ajustesDeFabrica();
+#ifdef DEBUG_SERIAL
+  Serial.printf("[AJUSTES] %s: ciclo %u s, %u registros, paquete %u, BLE %u s, VEML ganancia 0x%02X integración %u ms\n",
+                deNvs ? "de NVS" : "de fábrica", ajustes.cicloS, ajustes.numRegistros, ajustes.tamPaquete,
+                ajustes.timeoutBleS, ajustes.gananciaVeml, msIntegracionVeml(ajustes.integracionVeml));
+#endif
+}
+
+bool aplicarAjustes(const uint8_t *datos, size_t bytes)
+{
+  AjustesNodo nuevos;
+  if (bytes != sizeof(nuevos))
+    return false;
+  memcpy(&nuevos, datos, sizeof(nuevos));
+  if (!ajustesValidos(nuevos))
+    return false;
+  if (memcmp(&nuevos, &ajustes, sizeof(nuevos)) == 0)
+    return true; // ya vigentes: sin escribir la flash
+  if (!nvsGuardar(CLAVE_NVS_AJUSTES, &nuevos, sizeof(nuevos)))
+    return false;
+  ajustes = nuevos;
+  return true;
+}
+
+uint64_t cicloUs()
+{
+  return ajustes.cicloS * 1000000ULL;
+}
+
+// Resolución del VEML7700: 0.0036 lux/cuenta con ganancia 2 e integración de 800 ms,
+// inversa a las dos
+float luxPorCuentaVeml()
+{
+  static const float GANANCIA[4] = {1.0f, 2.0f, 0.125f, 0.25f};
+  uint16_t ms = msIntegracionVeml(ajustes.integracionVeml);
+  return 0.0036f * (800.0f / (ms ? ms : 100)) * (2.0f / GANANCIA[ajustes.gananciaVeml & 0x03]);
+}
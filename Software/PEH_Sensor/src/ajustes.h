@@ -0,0 +1,91 @@
+// Ajustes de muestreo que se pueden cambiar sin reflashear: el gateway escribe un blob
+// pequeño, versionado y con CRC en la característica de ajustes (0xAADD), el nodo lo
+// valida, lo guarda en NVS y lo aplica al terminar el drenaje. Al arrancar en frío se
+// carga de NVS a memoria RTC; en los despertares siguientes se usa la copia RTC tal cual
+// (solo se comprueba su CRC). Sin blob válido en NVS valen los de fábrica de abajo.
+//
+// Blob (little-endian, 12 bytes), en gateway/protocolo.h visto desde el gateway:
+//
+//   0  version            VERSION_AJUSTES
+//   1  tamPaquete         registros por notificación, 1..MAX_PACKET_SIZE
+//   2  cicloS             segundos entre medidas (uint16)
+//   4  numRegistros       registros por bloque de drenaje (uint16)
+//   6  timeoutBleS        segundos de advertising por intento de drenaje
+//   7  gananciaVeml       código ALS_GAIN del VEML7700 (VEML7700_GAIN_*)
+//   8  integracionVeml    código ALS_IT del VEML7700 (VEML7700_IT_*)
+//   9  reservado          0
+//  10  crc                CRC-16/CCITT-FALSE de los bytes 0..9 (uint16)
+
+#ifndef AJUSTES_H
+#define AJUSTES_H
+
+#include <Arduino.h>
+#include "hal.h"
+
+// --- VALORES DE FÁBRICA ---
+// Se pueden fijar en build_flags (los simuladores del host lo hacen)
+#ifndef PACKET_SIZE
+#define PACKET_SIZE 5
+#endif
+#ifndef MEASURE_CYCLE_MINUTES
+#define MEASURE_CYCLE_MINUTES 0.1
+#endif
+#ifndef BLE_TIMEOUT_SECONDS
+#define BLE_TIMEOUT_SECONDS 20
+#endif
+#ifndef NUM_REGISTROS
+#define NUM_REGISTROS 10
+#endif
+#define GANANCIA_VEML_FABRICA 0x00    // VEML7700_GAIN_1
+#define INTEGRACION_VEML_FABRICA 0x00 // VEML7700_IT_100MS
+
+#define VERSION_AJUSTES 1
+
+// Límites de un blob recibido. El paquete más grande cabe en una notificación con el
+// ATT_MTU que negocia el gateway (247): 10 registros crudos son 240 bytes y el peor lote
+// MsgPack de 6, 234 (MAX_BYTES_LOTE en src/lote.h).
+#ifdef LOTES_MSGPACK
+#define MAX_PACKET_SIZE 6
+#else
+#define MAX_PACKET_SIZE 10
+#endif
+#define MIN_CICLO_S 5
+#define MAX_CICLO_S 43200 // 12 h
+#define MAX_NUM_REGISTROS 1000
+#define MIN_TIMEOUT_BLE_S 2
+#define MAX_TIMEOUT_BLE_S 120
+
+#if PACKET_SIZE > MAX_PACKET_SIZE
+#error "PACKET_SIZE de fábrica mayor que MAX_PACKET_SIZE"
+#endif
+
+struct __attribute__((packed)) AjustesNodo
+{
+  uint8_t version;
+  uint8_t tamPaquete;
+  uint16_t cicloS;
+  uint16_t numRegistros;
+  uint8_t timeoutBleS;
+  uint8_t gananciaVeml;
+  uint8_t integracionVeml;
+  uint8_t reservado;
+  uint16_t crc;
+};
+
+// Los vigentes: en RTC, sobreviven al deep sleep
+extern RTC_DATA_ATTR AjustesNodo ajustes;
+
+// Deja en `ajustes` la copia RTC si es válida; si no (arranque en frío, esp_restart() o
+// RTC corrupta), los de NVS o los de fábrica
+void cargarAjustes();
+// Valida un blob recibido, lo guarda en NVS y solo entonces lo hace vigente. false si
+// no es válido o no se pudo guardar: siguen los anteriores.
+bool aplicarAjustes(const uint8_t *datos, size_t bytes);
+bool ajustesValidos(const AjustesNodo &a);
+uint16_t crcAjustes(const AjustesNodo &a);
+
+uint64_t cicloUs();
+uint16_t msIntegracionVeml(uint8_t codigo); // 0 si el código no existe
+float luxPorCuentaVeml();                  // con la ganancia y la integración vigentes
+
+#endif
@@ -0,0 +1,87 @@
+#include "anuncio.h"
+#include "config.h"
+
+static uint8_t *escribirU16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+  return p + 2;
+}
+
+// Redondeado y recortado a [0, maximo]; un valor negativo (centinela de fallo) o NaN
+// queda como `maximo`
+static uint32_t fijoSinSigno(float valor, float escala, uint32_t maximo)
+{
+  if (!(valor >= 0))
+    return maximo;
+  float v = valor * escala + 0.5f;
+  return v >= maximo ? maximo - 1 : (uint32_t)v;
+}
+
+static int16_t fijoTemperatura(float temp)
+{
+  if (!(temp > -90)) // -99: fallo del SHTC3
+    return INT16_MIN;
+  float v = temp * 100;
+  v += v < 0 ? -0.5f : 0.5f;
+  return v >= INT16_MAX ? INT16_MAX : v <= INT16_MIN + 1 ? INT16_MIN + 1 : (int16_t)v;
+}
+
+static uint8_t *escribirU24(uint8_t *p, uint32_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = v >> 16;
+  return p + 3;
+}
+
+static uint8_t *escribirCabecera(const AnuncioNodo &anuncio, uint8_t banderas, uint8_t *p)
+{
+#ifdef LOTES_MSGPACK
+  banderas |= ANUNCIO_LOTES_MSGPACK;
+#endif
+  if (anuncio.conSecuencia)
+    banderas |= ANUNCIO_SECUENCIA;
+  p = escribirU16(p, ID_FABRICANTE);
+  *p++ = VERSION_ANUNCIO;
+  *p++ = banderas;
+  p = escribirU16(p, anuncio.registrosPendientes);
+  p = escribirU16(p, anuncio.bateriaMv);
+  if (anuncio.conSecuencia)
+    p = escribirU16(p, anuncio.secuencia);
+  return p;
+}
+
+size_t codificarAnuncio(const AnuncioNodo &anuncio, uint8_t *destino, size_t capacidad)
+{
+  size_t bytes = BYTES_CABECERA_ANUNCIO + (anuncio.conSecuencia ? 2 : 0);
+  if (bytes > capacidad)
+    return 0;
+  escribirCabecera(anuncio, 0, destino);
+  return bytes;
+}
+
+size_t codificarDifusion(const AnuncioNodo &anuncio, const SensorData *registros, size_t cantidad, uint32_t ahoraS,
+                         uint8_t *destino, size_t capacidad)
+{
+  if (cantidad > REGISTROS_DIFUSION || !anuncio.conSecuencia)
+    return 0;
+  size_t bytes = BYTES_CABECERA_ANUNCIO + 3 + cantidad * BYTES_REGISTRO_DIFUSION;
+  if (bytes > capacidad)
+    return 0;
+
+  uint8_t *p = escribirCabecera(anuncio, ANUNCIO_REGISTROS, destino);
+  *p++ = (uint8_t)cantidad;
+  for (size_t i = 0; i < cantidad; i++)
+  {
+    const SensorData &r = registros[i];
+    p = escribirU16(p, (uint16_t)fijoTemperatura(r.temp));
+    p = escribirU16(p, (uint16_t)fijoSinSigno(r.humAir, 100, 0xFFFF));
+    p = escribirU16(p, (uint16_t)fijoSinSigno(r.humSoil, 1, 0xFFFF));
+    p = escribirU24(p, fijoSinSigno(r.lux, 100, 0xFFFFFF));
+    p = escribirU16(p, (uint16_t)fijoSinSigno(r.batt, 1000, 0xFFFF));
+    uint32_t edad = ahoraS - r.tiempoS;
+    p = escribirU24(p, r.tiempoS > ahoraS || edad >= EDAD_DIFUSION_DESCONOCIDA ? EDAD_DIFUSION_DESCONOCIDA : edad);
+  }
+  return bytes;
+}
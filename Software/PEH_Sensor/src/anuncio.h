@@ -0,0 +1,63 @@
+// Datos de fabricante que el nodo pone en el aire sin conexión: en la respuesta al escaneo
+// del advertising conectable (transporteIniciar()) y, con MODO_ANUNCIO, en la difusión de
+// los últimos registros (transporteDifundir()). Little-endian, como los registros; el
+// gateway los lee con leerAnuncio() de gateway/protocolo.h, también el simulado del host.
+//
+//   0  ID_FABRICANTE       uint16
+//   2  VERSION_ANUNCIO
+//   3  banderas            ANUNCIO_*
+//   4  registrosPendientes uint16, en el almacén
+//   6  bateriaMv           uint16, 0 si no se pudo medir
+//   8  secuencia           uint16, del último registro guardado (con ANUNCIO_SECUENCIA)
+//  10  registros           cuántos siguen (con ANUNCIO_REGISTROS)
+//  11  registros           del más antiguo al último, BYTES_REGISTRO_DIFUSION cada uno
+//
+// El registro difundido va en punto fijo (14 bytes frente a los 24 de SensorData):
+//
+//   temp int16 en centésimas de °C, humAir uint16 en centésimas de %, humSoil uint16 en
+//   cuentas de ADC, lux uint24 en centésimas de lux, batt uint16 en mV, edad uint24 en
+//   segundos al difundir (como la de los paquetes; EDAD_DIFUSION_DESCONOCIDA si no cabe)
+//
+// Los centinelas de fallo (-99 y -1) se codifican como el valor más bajo del int16 o el
+// más alto de los sin signo. El relleno por conexión sigue mandando SensorData sin pérdida.
+
+#ifndef ANUNCIO_H
+#define ANUNCIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sensores.h"
+
+#define ID_FABRICANTE 0xFFFF // reservado por el Bluetooth SIG para pruebas y uso interno
+#define VERSION_ANUNCIO 2
+#define ANUNCIO_LOTES_MSGPACK 0x01
+#define ANUNCIO_SECUENCIA 0x02
+#define ANUNCIO_REGISTROS 0x04
+
+#define BYTES_CABECERA_ANUNCIO 8
+#define BYTES_REGISTRO_DIFUSION 14
+#define EDAD_DIFUSION_DESCONOCIDA 0xFFFFFF // unos 194 días
+// Cada registro se repite en las difusiones de los REGISTROS_DIFUSION siguientes: un
+// gateway que pierde menos seguidas no necesita relleno
+#define REGISTROS_DIFUSION 8
+#define MAX_BYTES_ANUNCIO (BYTES_CABECERA_ANUNCIO + 3 + REGISTROS_DIFUSION * BYTES_REGISTRO_DIFUSION)
+// Anuncios extendidos por difusión: repetir en el aire cubre la pérdida de un paquete
+// suelto sin coste de CPU
+#define EVENTOS_DIFUSION 3
+
+struct AnuncioNodo
+{
+  uint16_t registrosPendientes;
+  uint16_t bateriaMv;
+  bool conSecuencia;
+  uint16_t secuencia;
+};
+
+// Para la respuesta al escaneo; 0 si no cabe en `capacidad`
+size_t codificarAnuncio(const AnuncioNodo &anuncio, uint8_t *destino, size_t capacidad);
+// El anuncio con los `cantidad` últimos registros (como mucho REGISTROS_DIFUSION); el
+// último es el de anuncio.secuencia. Las edades salen de tiempoS y ahoraS (relojNodoS()).
+size_t codificarDifusion(const AnuncioNodo &anuncio, const SensorData *registros, size_t cantidad, uint32_t ahoraS,
+                         uint8_t *destino, size_t capacidad);
+
+#endif
@@ -0,0 +1,729 @@
+// Implementación de include/hal.h sobre Arduino-ESP32: SPIFFS, NVS (Preferences), BLE
+// (Bluedroid), esp_sleep y NeoPixel
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLEUtils.h>
+#include <BLE2902.h>
+#include <FS.h>
+#include <SPIFFS.h>
+#include <Preferences.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include "config.h"
+#ifdef LED_ESTADO
+#include <Adafruit_NeoPixel.h>
+#endif
+#include "placa.h"
+#include "hal.h"
+
+#define DEVICE_ID "NODE_SENSOR"
+#define SERVICE_UUID "12345678-1234-1234-1234-1234567890ab"
+#define CHAR_ALL_SENSORS_UUID "0000aaaa-0000-1000-8000-00805f9b34fb"
+#define CHAR_ACK_UUID "0000aaff-0000-1000-8000-00805f9b34fb"
+#define CHAR_DIAG_UUID "0000aabb-0000-1000-8000-00805f9b34fb"
+#define CHAR_LOTES_UUID "0000aacc-0000-1000-8000-00805f9b34fb"
+#define CHAR_AJUSTES_UUID "0000aadd-0000-1000-8000-00805f9b34fb"
+#define CHAR_RELLENO_UUID "0000aaee-0000-1000-8000-00805f9b34fb"
+
+#define SPIFFS_PATH "/sensores.dat"
+#define NVS_ESPACIO "peh"
+#define MAX_BYTES_AJUSTES 32
+
+// Enlace que se pide al conectar, en unidades de la especificación (intervalo en 1.25 ms,
+// supervision timeout en 10 ms). El gateway puede negarse a cualquiera de las tres cosas:
+// la conexión sigue con lo que haya y solo cambia el caudal del drenaje.
+#define INTERVALO_MIN_CONEXION 6  // 7.5 ms
+#define INTERVALO_MAX_CONEXION 12 // 15 ms
+#define INTERVALO_MAX_RELAJADO 40 // 50 ms: segundo intento si rechaza el corto
+#define TIMEOUT_SUPERVISION 400   // 4 s
+#define BYTES_PDU_DLE 251         // LE Data Length Extension; sin ella, 27
+
+// Advertising en dos fases (intervalos en unidades de 0.625 ms): una ráfaga rápida para
+// que un gateway que ya escanea conecte en pocos cientos de ms y, si no aparece, un
+// intervalo lento hasta el timeout que gasta una fracción de la radio
+#define ANUNCIO_RAPIDO_MS 3000
+#define INTERVALO_ANUNCIO_RAPIDO_MIN 32 // 20 ms
+#define INTERVALO_ANUNCIO_RAPIDO_MAX 48 // 30 ms
+#define INTERVALO_ANUNCIO_LENTO_MIN 668 // 417.5 ms
+#define INTERVALO_ANUNCIO_LENTO_MAX 874 // 546.25 ms
+
+#ifdef MODO_ANUNCIO
+#ifndef CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+#error "MODO_ANUNCIO usa advertising extendido: requiere Bluedroid con BLE 5 (ESP32-S3/C3)"
+#endif
+// Difusión: no conectable, primario en 1M (lo escanea cualquier gateway BLE 5) y los datos
+// en el canal secundario a 2M, donde 100 bytes son unos 0.4 ms de aire
+#define INSTANCIA_DIFUSION 0
+#define INTERVALO_DIFUSION 32 // 20 ms
+#define ESPERA_DIFUSION_MS 500 // por si el controlador no avisa del final
+#define ESPERA_PASO_GAP_MS 100
+#endif
+
+// --- RELOJ ---
+uint32_t relojMs() { return millis(); }
+uint32_t relojUs() { return micros(); }
+
+// gettimeofday() sale del temporizador RTC y de la hora de arranque que el IDF guarda en
+// registros RTC: los dos sobreviven al deep sleep y a esp_restart()
+uint32_t relojNodoS()
+{
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return (uint32_t)t.tv_sec;
+}
+
+void esperarMs(uint32_t ms) { delay(ms); }
+uint32_t cpuMhz() { return getCpuFrequencyMhz(); }
+void fijarCpuMhz(uint32_t mhz) { setCpuFrequencyMhz(mhz); }
+
+// --- SUEÑO ---
+void programarDespertar(uint64_t us)
+{
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+  esp_sleep_enable_timer_wakeup(us);
+}
+
+void pararLed(); // en --- LED ---: corta el efecto y espera la última trama
+
+void dormirProfundo()
+{
+  pararLed();
+  btStop();
+  esp_deep_sleep_start();
+}
+
+void dormirLigero()
+{
+  pararLed();
+  btStop();
+  esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+  esp_light_sleep_start();
+}
+
+void reiniciarNodo()
+{
+  esp_restart();
+}
+
+bool reinicioPedido()
+{
+  return esp_reset_reason() == ESP_RST_SW;
+}
+
+// --- ALMACÉN ---
+bool almacenMontar()
+{
+  return SPIFFS.begin(true);
+}
+
+size_t almacenBytes()
+{
+  File file = SPIFFS.open(SPIFFS_PATH, FILE_READ);
+  if (!file)
+    return 0;
+  size_t bytes = file.size();
+  file.close();
+  return bytes;
+}
+
+bool almacenAnadir(const void *datos, size_t bytes)
+{
+  File file = SPIFFS.open(SPIFFS_PATH, FILE_APPEND);
+  if (!file)
+    return false;
+  bool ok = file.write((const uint8_t *)datos, bytes) == bytes;
+  file.close();
+  return ok;
+}
+
+bool almacenLeer(size_t desplazamiento, void *destino, size_t bytes)
+{
+  File file = SPIFFS.open(SPIFFS_PATH, FILE_READ);
+  if (!file)
+    return false;
+  bool ok = file.seek(desplazamiento) && file.read((uint8_t *)destino, bytes) == bytes;
+  file.close();
+  return ok;
+}
+
+void almacenBorrar()
+{
+  SPIFFS.remove(SPIFFS_PATH);
+}
+
+// --- NVS ---
+size_t nvsLeer(const char *clave, void *destino, size_t capacidad)
+{
+  Preferences nvs;
+  if (!nvs.begin(NVS_ESPACIO, true))
+    return 0; // sin el espacio: nunca se guardó nada
+  size_t bytes = nvs.getBytesLength(clave);
+  bytes = bytes <= capacidad ? nvs.getBytes(clave, destino, capacidad) : 0;
+  nvs.end();
+  return bytes;
+}
+
+bool nvsGuardar(const char *clave, const void *datos, size_t bytes)
+{
+  Preferences nvs;
+  if (!nvs.begin(NVS_ESPACIO, false))
+    return false;
+  // NVS escribe la entrada nueva antes de invalidar la anterior: un corte deja una de las dos
+  bool ok = nvs.putBytes(clave, datos, bytes) == bytes;
+  nvs.end();
+  return ok;
+}
+
+// --- TRANSPORTE ---
+BLEServer *pServer;
+BLEService *pService;
+BLECharacteristic *pCharAllSensors;
+BLECharacteristic *pCharAck;
+BLECharacteristic *pCharDiag;
+#ifdef LOTES_MSGPACK
+BLECharacteristic *pCharLotes;
+#endif
+BLECharacteristic *pCharAjustes;
+
+volatile bool ack_received = false;
+
+// Lo escribe la tarea de Bluedroid y lo recoge el bucle de main.cpp
+static uint8_t ajustesRecibidos[MAX_BYTES_AJUSTES];
+static size_t bytesAjustesRecibidos = 0;
+static portMUX_TYPE muxAjustes = portMUX_INITIALIZER_UNLOCKED;
+
+#ifdef MODO_ANUNCIO
+BLECharacteristic *pCharRelleno;
+static volatile bool hayRelleno = false;
+static volatile uint16_t rellenoDesde;
+
+// Pasos de la difusión que confirma el controlador, en eventoGap()
+static volatile uint8_t pasosDifusion;
+static volatile bool difusionTerminada;
+#endif
+
+// Comienzo de la ráfaga y si ya se pasó al intervalo lento. Solo los toca la tarea
+// principal: el cambio lo hace transporteConectado(), que main sondea mientras espera
+static uint32_t inicioRafagaMs;
+static bool anuncioLento;
+
+// Fin de la ráfaga: el mismo advertising con el intervalo lento
+static void anunciarLento()
+{
+  anuncioLento = true;
+  BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
+  pAdvertising->stop();
+  pAdvertising->setMinInterval(INTERVALO_ANUNCIO_LENTO_MIN);
+  pAdvertising->setMaxInterval(INTERVALO_ANUNCIO_LENTO_MAX);
+  pAdvertising->start();
+#ifdef DEBUG_SERIAL
+  Serial.println("[BLE] fin de la ráfaga: advertising lento.");
+#endif
+}
+
+// Cliente de la conexión en curso, para repetir la petición de intervalo
+static esp_bd_addr_t direccionCliente;
+static bool intervaloRelajado = false;
+
+static void pedirIntervalo(uint16_t maximo)
+{
+  esp_ble_conn_update_params_t p = {};
+  memcpy(p.bda, direccionCliente, sizeof(esp_bd_addr_t));
+  p.min_int = INTERVALO_MIN_CONEXION;
+  p.max_int = maximo;
+  p.latency = 0; // el nodo tiene datos en cada evento: la latencia solo retrasaría el ACK
+  p.timeout = TIMEOUT_SUPERVISION;
+  esp_ble_gap_update_conn_params(&p);
+}
+
+// Respuestas del controlador y del gateway a las peticiones de onConnect(). Corre en la
+// tarea de Bluedroid.
+static void eventoGap(esp_gap_ble_cb_event_t evento, esp_ble_gap_cb_param_t *param)
+{
+  switch (evento)
+  {
+  case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+    if (param->update_conn_params.status != ESP_BT_STATUS_SUCCESS && !intervaloRelajado)
+    {
+      // Hay centrales que no bajan de cierto intervalo: un rango más ancho suele pasar
+      intervaloRelajado = true;
+      pedirIntervalo(INTERVALO_MAX_RELAJADO);
+    }
+#ifdef DEBUG_SERIAL
+    Serial.printf("[BLE] intervalo %.2f ms, latencia %u, supervisión %u ms (estado %d)\n",
+                  param->update_conn_params.conn_int * 1.25f, param->update_conn_params.latency,
+                  param->update_conn_params.timeout * 10, param->update_conn_params.status);
+#endif
+    break;
+  case ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT:
+#ifdef DEBUG_SERIAL
+    if (param->pkt_data_lenth_cmpl.status == ESP_BT_STATUS_SUCCESS)
+      Serial.printf("[BLE] PDU de datos: tx %u, rx %u bytes\n", param->pkt_data_lenth_cmpl.params.tx_len,
+                    param->pkt_data_lenth_cmpl.params.rx_len);
+    else
+      Serial.printf("[BLE] sin DLE (estado %d): PDU de 27 bytes\n", param->pkt_data_lenth_cmpl.status);
+#endif
+    break;
+#ifdef MODO_ANUNCIO
+  case ESP_GAP_BLE_EXT_ADV_SET_PARAMS_COMPLETE_EVT:
+  case ESP_GAP_BLE_EXT_ADV_DATA_SET_COMPLETE_EVT:
+  case ESP_GAP_BLE_EXT_ADV_START_COMPLETE_EVT:
+    pasosDifusion++;
+    break;
+  case ESP_GAP_BLE_ADV_TERMINATED_EVT:
+    difusionTerminada = true;
+    break;
+#endif
+#ifdef CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+  case ESP_GAP_BLE_PHY_UPDATE_COMPLETE_EVT:
+#ifdef DEBUG_SERIAL
+    // 1 = 1M, 2 = 2M, 3 = Coded; si el gateway no soporta 2M se queda en 1M
+    Serial.printf("[BLE] PHY tx %u, rx %u (estado %d)\n", param->phy_update.tx_phy, param->phy_update.rx_phy,
+                  param->phy_update.status);
+#endif
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+class MyServerCallbacks : public BLEServerCallbacks
+{
+  void onConnect(BLEServer *pServer)
+  {
+#ifdef DEBUG_SERIAL
+    Serial.println("Cliente BLE conectado.");
+#endif
+  }
+  // La conexión empieza con lo que eligió el gateway (suele ser un intervalo de 30-50 ms,
+  // PDU de 27 bytes y 1M). Para el drenaje se pide lo más rápido que admita: cada paquete
+  // espera su ACK, así que el intervalo marca el caudal. Las respuestas llegan a eventoGap().
+  void onConnect(BLEServer *pServer, esp_ble_gatts_cb_param_t *param)
+  {
+    memcpy(direccionCliente, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+    intervaloRelajado = false;
+    pedirIntervalo(INTERVALO_MAX_CONEXION);
+    esp_ble_gap_set_pkt_data_len(direccionCliente, BYTES_PDU_DLE);
+#ifdef CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+    esp_ble_gap_set_preferred_phy(direccionCliente, 0, ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                  ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+  }
+  void onDisconnect(BLEServer *pServer)
+  {
+#ifdef DEBUG_SERIAL
+    Serial.println("Cliente BLE desconectado.");
+#endif
+  }
+};
+
+class AckCallbacks : public BLECharacteristicCallbacks
+{
+  void onWrite(BLECharacteristic *pCharacteristic)
+  {
+    std::string value = pCharacteristic->getValue();
+    if (value == "OK")
+    {
+      ack_received = true;
+#ifdef DEBUG_SERIAL
+      Serial.println("ACK recibido.");
+#endif
+    }
+  }
+};
+
+class AjustesCallbacks : public BLECharacteristicCallbacks
+{
+  void onWrite(BLECharacteristic *pCharacteristic)
+  {
+    std::string value = pCharacteristic->getValue();
+    if (value.empty() || value.size() > MAX_BYTES_AJUSTES)
+      return;
+    portENTER_CRITICAL(&muxAjustes);
+    memcpy(ajustesRecibidos, value.data(), value.size());
+    bytesAjustesRecibidos = value.size();
+    portEXIT_CRITICAL(&muxAjustes);
+#ifdef DEBUG_SERIAL
+    Serial.printf("Ajustes recibidos (%u bytes).\n", (unsigned)value.size());
+#endif
+  }
+};
+
+#ifdef MODO_ANUNCIO
+class RellenoCallbacks : public BLECharacteristicCallbacks
+{
+  void onWrite(BLECharacteristic *pCharacteristic)
+  {
+    std::string value = pCharacteristic->getValue();
+    if (value.size() != 2)
+      return;
+    rellenoDesde = (uint8_t)value[0] | (uint8_t)value[1] << 8;
+    hayRelleno = true;
+#ifdef DEBUG_SERIAL
+    Serial.printf("Relleno pedido desde la secuencia %u.\n", rellenoDesde);
+#endif
+  }
+};
+#endif
+
+void transporteIniciar(const uint8_t *fabricante, size_t bytes)
+{
+#ifdef DEBUG_SERIAL
+  Serial.println("Inicializando BLE...");
+#endif
+
+  BLEDevice::init(DEVICE_ID);
+  pServer = BLEDevice::createServer();
+  pServer->setCallbacks(new MyServerCallbacks());
+  BLEDevice::setCustomGapHandler(eventoGap);
+
+  pService = pServer->createService(SERVICE_UUID);
+
+  pCharAllSensors = pService->createCharacteristic(CHAR_ALL_SENSORS_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+  BLE2902 *p2902 = new BLE2902();
+  pCharAllSensors->addDescriptor(p2902);
+
+  pCharAck = pService->createCharacteristic(CHAR_ACK_UUID, BLECharacteristic::PROPERTY_WRITE);
+  pCharAck->setCallbacks(new AckCallbacks());
+
+  pCharDiag = pService->createCharacteristic(CHAR_DIAG_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+  pCharDiag->addDescriptor(new BLE2902());
+
+#ifdef LOTES_MSGPACK
+  pCharLotes = pService->createCharacteristic(CHAR_LOTES_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+  pCharLotes->addDescriptor(new BLE2902());
+#endif
+
+  pCharAjustes = pService->createCharacteristic(CHAR_AJUSTES_UUID, BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_NOTIFY);
+  pCharAjustes->addDescriptor(new BLE2902());
+  pCharAjustes->setCallbacks(new AjustesCallbacks());
+  bytesAjustesRecibidos = 0;
+
+#ifdef MODO_ANUNCIO
+  pCharRelleno = pService->createCharacteristic(CHAR_RELLENO_UUID, BLECharacteristic::PROPERTY_WRITE);
+  pCharRelleno->setCallbacks(new RellenoCallbacks());
+  hayRelleno = false;
+#endif
+
+  pService->start();
+
+  BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
+  pAdvertising->addServiceUUID(SERVICE_UUID);
+  pAdvertising->setScanResponse(true);
+  // Rango de intervalo preferido en el advertising: el gateway puede conectarse ya con él
+  pAdvertising->setMinPreferred(INTERVALO_MIN_CONEXION);
+  pAdvertising->setMaxPreferred(INTERVALO_MAX_CONEXION);
+
+  // En la respuesta al escaneo: en el paquete de advertising no caben junto al UUID de 128 bits
+  BLEAdvertisementData respuesta;
+  respuesta.setName(DEVICE_ID);
+  respuesta.setManufacturerData(std::string((const char *)fabricante, bytes));
+  pAdvertising->setScanResponseData(respuesta);
+
+  pAdvertising->setMinInterval(INTERVALO_ANUNCIO_RAPIDO_MIN);
+  pAdvertising->setMaxInterval(INTERVALO_ANUNCIO_RAPIDO_MAX);
+  BLEDevice::startAdvertising();
+
+  inicioRafagaMs = millis();
+  anuncioLento = false;
+
+#ifdef DEBUG_SERIAL
+  Serial.println("BLE advertising activo.");
+#endif
+}
+
+bool transporteConectado()
+{
+  if (pServer->getConnectedCount() > 0)
+    return true;
+  if (!anuncioLento && millis() - inicioRafagaMs >= ANUNCIO_RAPIDO_MS)
+    anunciarLento();
+  return false;
+}
+
+void transporteEnviarDatos(const uint8_t *datos, size_t bytes)
+{
+  ack_received = false;
+  pCharAllSensors->setValue((uint8_t *)datos, bytes);
+  pCharAllSensors->notify();
+}
+
+#ifdef LOTES_MSGPACK
+void transporteEnviarLote(const uint8_t *datos, size_t bytes)
+{
+  ack_received = false;
+  pCharLotes->setValue((uint8_t *)datos, bytes);
+  pCharLotes->notify();
+}
+#endif
+
+bool transporteAckRecibido()
+{
+  return ack_received;
+}
+
+void transporteEnviarDiagnostico(const uint8_t *datos, size_t bytes)
+{
+  pCharDiag->setValue((uint8_t *)datos, bytes);
+  pCharDiag->notify();
+}
+
+size_t transporteAjustesRecibidos(uint8_t *destino, size_t capacidad)
+{
+  portENTER_CRITICAL(&muxAjustes);
+  size_t bytes = bytesAjustesRecibidos <= capacidad ? bytesAjustesRecibidos : 0;
+  memcpy(destino, ajustesRecibidos, bytes);
+  bytesAjustesRecibidos = 0;
+  portEXIT_CRITICAL(&muxAjustes);
+  return bytes;
+}
+
+void transporteEnviarAjustes(const uint8_t *datos, size_t bytes)
+{
+  pCharAjustes->setValue((uint8_t *)datos, bytes);
+  pCharAjustes->notify();
+}
+
+void transporteParar()
+{
+  BLEDevice::deinit(false);
+#ifdef DEBUG_SERIAL
+  Serial.println("BLE detenido.");
+#endif
+}
+
+#ifdef MODO_ANUNCIO
+bool transporteRellenoDesde(uint16_t &secuencia)
+{
+  if (!hayRelleno)
+    return false;
+  secuencia = rellenoDesde;
+  return true;
+}
+
+// Las llamadas de GAP son asíncronas: cada una espera la confirmación de la anterior
+static bool esperarPasoGap(uint8_t paso)
+{
+  uint32_t inicio = millis();
+  while (pasosDifusion < paso)
+  {
+    if (millis() - inicio > ESPERA_PASO_GAP_MS)
+      return false;
+    delay(1);
+  }
+  return true;
+}
+
+void transporteDifundir(const uint8_t *datos, size_t bytes, uint8_t eventos)
+{
+  // Un único AD de datos de fabricante: cabe en el AUX_ADV_IND sin encadenar paquetes
+  uint8_t ad[2 + 251];
+  if (bytes + 2 > sizeof(ad) || bytes + 1 > 255)
+    return;
+  ad[0] = bytes + 1;
+  ad[1] = ESP_BLE_AD_MANUFACTURER_SPECIFIC_TYPE;
+  memcpy(ad + 2, datos, bytes);
+
+  BLEDevice::init(DEVICE_ID);
+  BLEDevice::setCustomGapHandler(eventoGap);
+  pasosDifusion = 0;
+  difusionTerminada = false;
+
+  esp_ble_gap_ext_adv_params_t params = {};
+  params.type = ESP_BLE_GAP_SET_EXT_ADV_PROP_NONCONN_NONSCANNABLE_UNDIRECTED;
+  params.interval_min = INTERVALO_DIFUSION;
+  params.interval_max = INTERVALO_DIFUSION;
+  params.channel_map = ADV_CHNL_ALL;
+  params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
+  params.filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
+  params.tx_power = EXT_ADV_TX_PWR_NO_PREFERENCE;
+  params.primary_phy = ESP_BLE_GAP_PHY_1M;
+  params.max_skip = 0;
+  params.secondary_phy = ESP_BLE_GAP_PHY_2M;
+  params.sid = INSTANCIA_DIFUSION;
+  params.scan_req_notif = false;
+
+  // Sin duración: termina tras `eventos` anuncios y lo avisa ESP_GAP_BLE_ADV_TERMINATED_EVT
+  esp_ble_gap_ext_adv_t adv = {INSTANCIA_DIFUSION, 0, eventos};
+  bool ok = esp_ble_gap_ext_adv_set_params(INSTANCIA_DIFUSION, &params) == ESP_OK && esperarPasoGap(1) &&
+            esp_ble_gap_config_ext_adv_data_raw(INSTANCIA_DIFUSION, bytes + 2, ad) == ESP_OK && esperarPasoGap(2) &&
+            esp_ble_gap_ext_adv_start(1, &adv) == ESP_OK && esperarPasoGap(3);
+  uint32_t inicio = millis();
+  while (ok && !difusionTerminada && millis() - inicio < ESPERA_DIFUSION_MS)
+    delay(2);
+
+#ifdef DEBUG_SERIAL
+  Serial.printf("[BLE] difusión de %u bytes: %s en %lu ms\n", (unsigned)bytes,
+                !ok ? "fallo del GAP" : difusionTerminada ? "emitida" : "sin confirmar", millis() - inicio);
+#endif
+  BLEDevice::deinit(false);
+}
+#endif
+
+// --- ADC Y GPIO ---
+uint16_t leerADC(uint8_t pin)
+{
+  return analogRead(pin);
+}
+
+void activarSalida(uint8_t pin, bool nivel)
+{
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, nivel);
+}
+
+// --- LED ---
+#ifdef LED_ESTADO
+// Lo que dura como mucho una trama del LED con su latch
+#define ESPERA_TRAMA_LED_MS 5
+// Por debajo de esto no compensa dormir entre dos pasos de un efecto
+#define MIN_LIGERO_LED_US 2000
+
+// showAsync(): la trama sale por el RMT mientras el nodo sigue; el NeoPixel guarda el color
+Adafruit_NeoPixel pixel(LED_COUNT, LED_PIN, NEO_GRB + NEO_KHZ800);
+
+// Efecto en curso. Lo avanza la tarea de esp_timer; el núcleo que lo programa y el que
+// lo avanza pueden ser distintos, por eso el spinlock.
+struct EfectoLed
+{
+  PasoLed pasos[MAX_PASOS_LED];
+  uint8_t numPasos;
+  uint8_t paso;
+  uint8_t repeticiones; // que quedan, incluida la actual
+  volatile bool activo;
+  int64_t finPasoUs; // esp_timer_get_time()
+};
+
+static EfectoLed efecto;
+static esp_timer_handle_t temporizadorLed = nullptr;
+static portMUX_TYPE muxLed = portMUX_INITIALIZER_UNLOCKED;
+
+static void mostrarColor(uint32_t color)
+{
+  pixel.setPixelColor(0, color);
+  pixel.showAsync();
+}
+
+static void pasoLed(void *)
+{
+  portENTER_CRITICAL(&muxLed);
+  bool seguir = efecto.activo;
+  if (seguir && ++efecto.paso == efecto.numPasos)
+  {
+    efecto.paso = 0;
+    seguir = --efecto.repeticiones > 0;
+  }
+  PasoLed paso = efecto.pasos[efecto.paso];
+  if (seguir)
+  {
+    efecto.finPasoUs += paso.ms * 1000LL;
+    efecto.activo = paso.ms > 0;
+  }
+  else
+    efecto.activo = false; // el último paso se queda
+  portEXIT_CRITICAL(&muxLed);
+
+  if (!seguir)
+    return;
+  mostrarColor(paso.color);
+  if (paso.ms)
+    esp_timer_start_once(temporizadorLed, paso.ms * 1000ULL);
+}
+
+void pararLed()
+{
+  if (temporizadorLed)
+    esp_timer_stop(temporizadorLed);
+  efecto.activo = false;
+  espShowWait(ESPERA_TRAMA_LED_MS); // dormido a mitad de trama, el LED queda con el color a medias
+}
+
+void ledIniciar()
+{
+  pixel.begin(); // Inicializa el pin
+  pixel.clear(); // Apaga cualquier LED residual
+  pixel.showAsync();
+}
+
+void ledColor(uint32_t color)
+{
+  if (temporizadorLed)
+    esp_timer_stop(temporizadorLed);
+  efecto.activo = false;
+  mostrarColor(color);
+}
+
+void ledApagar()
+{
+  ledColor(0);
+}
+
+void ledEfecto(const PasoLed *pasos, uint8_t numPasos, uint8_t repeticiones)
+{
+  if (!temporizadorLed)
+  {
+    esp_timer_create_args_t args = {};
+    args.callback = pasoLed;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "led";
+    if (esp_timer_create(&args, &temporizadorLed) != ESP_OK)
+      return;
+  }
+  esp_timer_stop(temporizadorLed);
+  if (numPasos == 0 || repeticiones == 0)
+    return;
+
+  numPasos = min(numPasos, (uint8_t)MAX_PASOS_LED);
+  portENTER_CRITICAL(&muxLed);
+  memcpy(efecto.pasos, pasos, numPasos * sizeof(PasoLed));
+  efecto.numPasos = numPasos;
+  efecto.paso = 0;
+  efecto.repeticiones = repeticiones;
+  efecto.finPasoUs = esp_timer_get_time() + pasos[0].ms * 1000LL;
+  efecto.activo = pasos[0].ms > 0;
+  portEXIT_CRITICAL(&muxLed);
+
+  mostrarColor(pasos[0].color);
+  if (efecto.activo)
+    esp_timer_start_once(temporizadorLed, pasos[0].ms * 1000ULL);
+}
+
+bool ledEfectoActivo()
+{
+  return efecto.activo;
+}
+
+uint32_t ledEsperarEfecto(uint32_t maxMs)
+{
+  uint32_t inicio = micros();
+  uint32_t dormidoUs = 0;
+  while (efecto.activo && micros() - inicio < maxMs * 1000UL)
+  {
+    portENTER_CRITICAL(&muxLed);
+    int64_t faltaUs = efecto.finPasoUs - esp_timer_get_time();
+    portEXIT_CRITICAL(&muxLed);
+    faltaUs = min(faltaUs, (int64_t)maxMs * 1000 - (int64_t)(micros() - inicio));
+#ifndef DEBUG_SERIAL
+    // Entre pasos no hay nada que hacer: el esp_timer vence al despertar y cambia el color
+    if (faltaUs > MIN_LIGERO_LED_US)
+    {
+      espShowWait(ESPERA_TRAMA_LED_MS);
+      esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+      esp_sleep_enable_timer_wakeup(faltaUs);
+      uint32_t antes = micros();
+      esp_light_sleep_start();
+      dormidoUs += micros() - antes;
+      continue;
+    }
+#endif
+    // Con DEBUG_SERIAL no se duerme: el light sleep corta el USB CDC
+    delay(faltaUs > 1000 ? faltaUs / 1000 : 1);
+  }
+  return dormidoUs;
+}
+#else
+void pararLed() {}
+#endif
@@ -0,0 +1,116 @@
+#include "Arduino.h"
+#include "SPI.h"
+#include <stdarg.h>
+#include <vector>
+
+#define NUM_PINES 64
+
+static thread_local uint64_t relojUs = 0;
+static thread_local uint64_t arranqueUs = 0;
+static thread_local int nivelEntrada[NUM_PINES];
+static thread_local uint8_t nivelSalidaPin[NUM_PINES];
+static thread_local uint16_t lecturaAnalogica[NUM_PINES];
+static thread_local bool nivelesIniciados = false;
+
+SerialHost Serial;
+SPIClass SPI;
+
+uint64_t relojHostUs() { return relojUs; }
+void fijarRelojHost(uint64_t us) { relojUs = us; }
+void avanzarRelojHost(uint64_t us) { relojUs += us; }
+void arrancarHost() { arranqueUs = relojUs; }
+
+uint32_t millis() { return (uint32_t)((relojUs - arranqueUs) / 1000); }
+uint32_t micros() { return (uint32_t)(relojUs - arranqueUs); }
+void delay(uint32_t ms) { relojUs += (uint64_t)ms * 1000; }
+void delayMicroseconds(uint32_t us) { relojUs += us; }
+void yield() {}
+
+// El enlazador define los límites de las secciones con nombre de identificador C. La
+// sección es TLS, así que declarados thread_local dan los límites en el hilo que llama
+// (con local-exec: el modelo por defecto en PIE no sabe resolver estos símbolos).
+#define TLS_EJECUTABLE __attribute__((tls_model("local-exec")))
+extern thread_local uint8_t __start_rtc_data[] TLS_EJECUTABLE;
+extern thread_local uint8_t __stop_rtc_data[] TLS_EJECUTABLE;
+static thread_local std::vector<uint8_t> imagenRTC;
+
+size_t bytesMemoriaRTC() { return __stop_rtc_data - __start_rtc_data; }
+void copiarMemoriaRTC(void *destino) { memcpy(destino, __start_rtc_data, bytesMemoriaRTC()); }
+void cargarMemoriaRTC(const void *origen) { memcpy(__start_rtc_data, origen, bytesMemoriaRTC()); }
+
+void guardarMemoriaRTC()
+{
+  imagenRTC.resize(bytesMemoriaRTC());
+  copiarMemoriaRTC(imagenRTC.data());
+}
+
+void restaurarMemoriaRTC()
+{
+  if (!imagenRTC.empty())
+    cargarMemoriaRTC(imagenRTC.data());
+}
+
+// Con el bus libre los pull-ups mantienen las líneas en alto
+static void iniciarNiveles()
+{
+  if (nivelesIniciados)
+    return;
+  for (int i = 0; i < NUM_PINES; i++)
+    nivelEntrada[i] = HIGH;
+  nivelesIniciados = true;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t nivel)
+{
+  if (pin < NUM_PINES)
+    nivelSalidaPin[pin] = nivel;
+}
+
+int digitalRead(uint8_t pin)
+{
+  iniciarNiveles();
+  return pin < NUM_PINES ? nivelEntrada[pin] : LOW;
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+  return pin < NUM_PINES ? lecturaAnalogica[pin] : 0;
+}
+
+void fijarNivelPin(uint8_t pin, int nivel)
+{
+  iniciarNiveles();
+  if (pin < NUM_PINES)
+    nivelEntrada[pin] = nivel;
+}
+
+void fijarLecturaAnalogica(uint8_t pin, uint16_t valor)
+{
+  if (pin < NUM_PINES)
+    lecturaAnalogica[pin] = valor;
+}
+
+uint8_t nivelSalida(uint8_t pin)
+{
+  return pin < NUM_PINES ? nivelSalidaPin[pin] : LOW;
+}
+
+size_t Print::print(const char *texto) { return fputs(texto, stdout) >= 0 ? strlen(texto) : 0; }
+size_t Print::print(char c) { return putchar(c) != EOF; }
+size_t Print::print(int valor, int base) { return print((long)valor, base); }
+size_t Print::print(unsigned int valor, int base) { return print((unsigned long)valor, base); }
+size_t Print::print(long valor, int base) { return ::printf(base == HEX ? "%lx" : "%ld", valor); }
+size_t Print::print(unsigned long valor, int base) { return ::printf(base == HEX ? "%lx" : "%lu", valor); }
+size_t Print::print(double valor, int decimales) { return ::printf("%.*f", decimales, valor); }
+size_t Print::println() { return putchar('\n') != EOF; }
+
+size_t Print::printf(const char *formato, ...)
+{
+  va_list args;
+  va_start(args, formato);
+  int n = vprintf(formato, args);
+  va_end(args);
+  return n > 0 ? n : 0;
+}
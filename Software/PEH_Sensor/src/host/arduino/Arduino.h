@@ -0,0 +1,115 @@
+// Sustituto mínimo del núcleo Arduino para compilar drivers y adquisición en el host
+// ([env:native]). El tiempo es virtual: delay() y las transferencias I2C lo avanzan,
+// así que los tiempos medidos son los que marcan los drivers, no los del PC.
+
+#ifndef ARDUINO_HOST_H
+#define ARDUINO_HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define OUTPUT_OPEN_DRAIN 0x13
+
+#define DEC 10
+#define HEX 16
+
+enum BitOrder
+{
+  LSBFIRST = 0,
+  MSBFIRST = 1
+};
+
+// La memoria RTC va a una sección propia: sobrevive a los despertares simulados y
+// restaurarMemoriaRTC() la devuelve a sus valores iniciales, como un arranque en frío.
+// Como el resto del estado del nodo (RAM_NODO, ver include/hal.h) es por hilo: cada
+// hilo del simulador de flota ejecuta su propia copia del firmware.
+#define RTC_DATA_ATTR __attribute__((section("rtc_data"))) thread_local
+#define RAM_NODO thread_local
+
+class __FlashStringHelper;
+#define F(cadena) (cadena)
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t modo);
+void digitalWrite(uint8_t pin, uint8_t nivel);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+// Toda la salida va a stdout
+class Print
+{
+public:
+  size_t print(const char *texto);
+  size_t print(char c);
+  size_t print(int valor, int base = DEC);
+  size_t print(unsigned int valor, int base = DEC);
+  size_t print(long valor, int base = DEC);
+  size_t print(unsigned long valor, int base = DEC);
+  size_t print(double valor, int decimales = 2);
+  size_t println();
+  template <typename T>
+  size_t println(T valor)
+  {
+    size_t n = print(valor);
+    return n + println();
+  }
+  template <typename T>
+  size_t println(T valor, int formato)
+  {
+    size_t n = print(valor, formato);
+    return n + println();
+  }
+  size_t printf(const char *formato, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print
+{
+};
+
+class SerialHost : public Stream
+{
+public:
+  void begin(unsigned long) {}
+  operator bool() const { return true; }
+};
+
+extern SerialHost Serial;
+
+// --- Control del entorno simulado ---
+// Todo es del hilo que llama. millis()/micros() cuentan desde el último arranque
+// simulado; relojHostUs() es absoluto.
+uint64_t relojHostUs();
+void fijarRelojHost(uint64_t us);
+void avanzarRelojHost(uint64_t us);
+void arrancarHost();
+void guardarMemoriaRTC(); // al empezar la simulación, antes de tocar nada en RTC
+void restaurarMemoriaRTC();
+// Para mover un nodo entre hilos: la memoria RTC entera como bloque de bytes
+size_t bytesMemoriaRTC();
+void copiarMemoriaRTC(void *destino);
+void cargarMemoriaRTC(const void *origen);
+void fijarNivelPin(uint8_t pin, int nivel); // nivel que leerá digitalRead en un pin de entrada
+void fijarLecturaAnalogica(uint8_t pin, uint16_t valor);
+uint8_t nivelSalida(uint8_t pin); // último digitalWrite
+
+#endif
@@ -0,0 +1,39 @@
+// SPI vacío: ningún periférico del nodo va por SPI, pero BusIO solo compila sus
+// registros (usados por el driver del VEML7700) si hay SPI hardware declarado.
+
+#ifndef SPI_HOST_H
+#define SPI_HOST_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+class SPISettings
+{
+public:
+  SPISettings() {}
+  SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+class SPIClass
+{
+public:
+  void begin() {}
+  void end() {}
+  void beginTransaction(SPISettings) {}
+  void endTransaction() {}
+  uint8_t transfer(uint8_t) { return 0xFF; }
+  void transfer(void *, size_t) {}
+  void transferBytes(const uint8_t *, uint8_t *salida, uint32_t n)
+  {
+    if (salida)
+      memset(salida, 0xFF, n);
+  }
+};
+
+extern SPIClass SPI;
+
+#endif
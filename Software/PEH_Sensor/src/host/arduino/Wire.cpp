@@ -0,0 +1,193 @@
+#include "Wire.h"
+
+// Los dispositivos siguen encendidos entre arranques: ven el reloj absoluto
+static uint32_t ahoraUs() { return (uint32_t)relojHostUs(); }
+
+thread_local TwoWire Wire(0);
+thread_local TwoWire Wire1(1);
+
+TwoWire::TwoWire(uint8_t bus)
+    : _bus(bus), _iniciado(false), _relojHz(100000), _numDispositivos(0), _sinStop(nullptr),
+      _txDireccion(0), _txLongitud(0), _rxLongitud(0), _rxPosicion(0)
+{
+  reiniciarContadores();
+}
+
+bool TwoWire::begin()
+{
+  _iniciado = true;
+  return true;
+}
+
+// Igual que en ESP32: sin frecuencia explícita se arranca a 100 kHz
+bool TwoWire::begin(int, int, uint32_t frecuencia)
+{
+  _relojHz = frecuencia ? frecuencia : 100000;
+  _iniciado = true;
+  return true;
+}
+
+bool TwoWire::end()
+{
+  parar();
+  _iniciado = false;
+  return true;
+}
+
+bool TwoWire::setClock(uint32_t hz)
+{
+  _relojHz = hz;
+  return true;
+}
+
+bool TwoWire::conectar(DispositivoI2CSimulado &dispositivo)
+{
+  if (_numDispositivos >= MAX_DISPOSITIVOS)
+    return false;
+  _dispositivos[_numDispositivos++] = &dispositivo;
+  return true;
+}
+
+void TwoWire::desconectar()
+{
+  _numDispositivos = 0;
+  _sinStop = nullptr;
+}
+
+void TwoWire::reiniciarContadores()
+{
+  memset(_porDireccion, 0, sizeof(_porDireccion));
+  memset(&_totales, 0, sizeof(_totales));
+}
+
+DispositivoI2CSimulado *TwoWire::buscar(uint8_t direccion)
+{
+  for (uint8_t i = 0; i < _numDispositivos; i++)
+    if (_dispositivos[i]->direccion() == direccion)
+      return _dispositivos[i];
+  return nullptr;
+}
+
+void TwoWire::transferirBytes(uint8_t direccion, uint32_t bytes)
+{
+  uint32_t us = (bytes * 9 * 1000000UL + _relojHz - 1) / _relojHz;
+  avanzarRelojHost(us);
+  ContadoresI2C &c = _porDireccion[direccion & 0x7F];
+  c.bytes += bytes;
+  c.ocupadoUs += us;
+  _totales.bytes += bytes;
+  _totales.ocupadoUs += us;
+}
+
+bool TwoWire::direccionar(uint8_t direccion, bool lectura, DispositivoI2CSimulado *&dispositivo)
+{
+  // Un START con otro dispositivo cierra la transferencia que quedó abierta
+  dispositivo = buscar(direccion);
+  if (_sinStop && _sinStop != dispositivo)
+    parar();
+
+  ContadoresI2C &c = _porDireccion[direccion & 0x7F];
+  c.transferencias++;
+  _totales.transferencias++;
+  transferirBytes(direccion, 1);
+  if (dispositivo && dispositivo->direccionar(lectura, ahoraUs()))
+    return true;
+  c.nacks++;
+  _totales.nacks++;
+  return false;
+}
+
+void TwoWire::parar()
+{
+  if (_sinStop)
+    _sinStop->parar(ahoraUs());
+  _sinStop = nullptr;
+}
+
+void TwoWire::beginTransmission(uint8_t direccion)
+{
+  _txDireccion = direccion;
+  _txLongitud = 0;
+}
+
+size_t TwoWire::write(uint8_t dato)
+{
+  if (_txLongitud >= I2C_BUFFER_LENGTH)
+    return 0;
+  _tx[_txLongitud++] = dato;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *datos, size_t cantidad)
+{
+  size_t n = 0;
+  while (n < cantidad && write(datos[n]))
+    n++;
+  return n;
+}
+
+// Códigos de Arduino: 0 OK, 2 NACK a la dirección, 3 NACK a un dato, 4 otro error
+uint8_t TwoWire::endTransmission(bool stop)
+{
+  if (!_iniciado)
+    return 4;
+
+  DispositivoI2CSimulado *d;
+  uint8_t resultado = 0;
+  if (!direccionar(_txDireccion, false, d))
+    resultado = 2;
+  for (size_t i = 0; i < _txLongitud && resultado == 0; i++)
+  {
+    transferirBytes(_txDireccion, 1);
+    if (!d->escribir(_tx[i], ahoraUs()))
+    {
+      _porDireccion[_txDireccion & 0x7F].nacks++;
+      _totales.nacks++;
+      resultado = 3;
+    }
+  }
+  _txLongitud = 0;
+
+  if (d && d != _sinStop)
+    _sinStop = d;
+  if (stop || resultado != 0)
+    parar();
+  return resultado;
+}
+
+size_t TwoWire::requestFrom(uint16_t direccion, size_t cantidad, bool stop)
+{
+  _rxLongitud = 0;
+  _rxPosicion = 0;
+  if (!_iniciado)
+    return 0;
+  if (cantidad > I2C_BUFFER_LENGTH)
+    cantidad = I2C_BUFFER_LENGTH;
+
+  DispositivoI2CSimulado *d;
+  if (!direccionar((uint8_t)direccion, true, d))
+  {
+    _sinStop = d;
+    parar();
+    return 0;
+  }
+  _sinStop = d;
+
+  // Clock stretching: el esclavo retiene SCL hasta tener el dato
+  uint32_t espera = d->esperaLecturaUs(ahoraUs());
+  if (espera)
+  {
+    avanzarRelojHost(espera);
+    _porDireccion[direccion & 0x7F].estiradoUs += espera;
+    _totales.estiradoUs += espera;
+  }
+
+  for (size_t i = 0; i < cantidad; i++)
+  {
+    transferirBytes((uint8_t)direccion, 1);
+    _rx[_rxLongitud++] = d->leer(ahoraUs());
+  }
+  if (stop)
+    parar();
+  return _rxLongitud;
+}
@@ -0,0 +1,89 @@
+// TwoWire simulado: las transferencias se reproducen contra los dispositivos de
+// lib/SimuladorI2C conectados al bus y avanzan el reloj virtual según la velocidad
+// fijada con setClock() (9 ciclos de SCL por byte, más el clock stretching del esclavo).
+
+#ifndef WIRE_HOST_H
+#define WIRE_HOST_H
+
+#include "Arduino.h"
+#include <DispositivoI2CSimulado.h>
+
+#define I2C_BUFFER_LENGTH 128
+
+struct ContadoresI2C
+{
+  uint32_t transferencias; // fases de dirección (START o repeated start)
+  uint32_t bytes;          // incluida la dirección
+  uint32_t nacks;
+  uint64_t ocupadoUs;  // transmitiendo bytes
+  uint64_t estiradoUs; // SCL retenida por el esclavo (clock stretching)
+};
+
+class TwoWire
+{
+public:
+  explicit TwoWire(uint8_t bus);
+
+  bool begin();
+  bool begin(int sda, int scl, uint32_t frecuencia = 0);
+  bool end();
+  bool setClock(uint32_t hz);
+  uint32_t getClock() { return _relojHz; }
+
+  void beginTransmission(uint8_t direccion);
+  void beginTransmission(int direccion) { beginTransmission((uint8_t)direccion); }
+  uint8_t endTransmission(bool stop);
+  uint8_t endTransmission() { return endTransmission(true); }
+
+  size_t write(uint8_t dato);
+  size_t write(const uint8_t *datos, size_t cantidad);
+
+  size_t requestFrom(uint16_t direccion, size_t cantidad, bool stop);
+  uint8_t requestFrom(uint8_t direccion, uint8_t cantidad, uint8_t stop) { return (uint8_t)requestFrom((uint16_t)direccion, (size_t)cantidad, stop != 0); }
+  uint8_t requestFrom(uint8_t direccion, uint8_t cantidad) { return requestFrom(direccion, cantidad, (uint8_t) true); }
+  uint8_t requestFrom(int direccion, int cantidad, int stop) { return (uint8_t)requestFrom((uint16_t)direccion, (size_t)cantidad, stop != 0); }
+  uint8_t requestFrom(int direccion, int cantidad) { return requestFrom(direccion, cantidad, 1); }
+
+  int available() { return _rxLongitud - _rxPosicion; }
+  int read() { return _rxPosicion < _rxLongitud ? _rx[_rxPosicion++] : -1; }
+  int peek() { return _rxPosicion < _rxLongitud ? _rx[_rxPosicion] : -1; }
+  void flush() {}
+
+  // --- Simulación ---
+  bool conectar(DispositivoI2CSimulado &dispositivo);
+  void desconectar(); // todos: para conectar los de otro nodo
+  const ContadoresI2C &contadores(uint8_t direccion) const { return _porDireccion[direccion & 0x7F]; }
+  const ContadoresI2C &totales() const { return _totales; }
+  void reiniciarContadores();
+
+private:
+  static const uint8_t MAX_DISPOSITIVOS = 8;
+
+  DispositivoI2CSimulado *buscar(uint8_t direccion);
+  bool direccionar(uint8_t direccion, bool lectura, DispositivoI2CSimulado *&dispositivo);
+  void transferirBytes(uint8_t direccion, uint32_t bytes);
+  void parar();
+
+  uint8_t _bus;
+  bool _iniciado;
+  uint32_t _relojHz;
+  DispositivoI2CSimulado *_dispositivos[MAX_DISPOSITIVOS];
+  uint8_t _numDispositivos;
+  DispositivoI2CSimulado *_sinStop; // transferencia abierta a la espera de repeated start
+
+  uint8_t _txDireccion;
+  uint8_t _tx[I2C_BUFFER_LENGTH];
+  size_t _txLongitud;
+  uint8_t _rx[I2C_BUFFER_LENGTH];
+  int _rxLongitud;
+  int _rxPosicion;
+
+  ContadoresI2C _porDireccion[128];
+  ContadoresI2C _totales;
+};
+
+// Uno por hilo, como el resto del estado del nodo simulado
+extern thread_local TwoWire Wire;
+extern thread_local TwoWire Wire1;
+
+#endif
@@ -0,0 +1,340 @@
+// Banco de los deserializadores de ArduinoJson en el host ([env:native_json]): la
+// configuración escrita por BLE en JSON (compacta, con espacios, filtrada y con límites de
+// anidamiento) y registros en JSON y en MsgPack (el lote de src/lote.h tal como lo manda el
+// nodo, con y sin el filtro de registrosLote(), y una exportación de 50 registros). Da por
+// caso el caudal (MB/s), las peticiones de memoria por documento, el máximo pedido y lo que
+// ocupa el documento en sus pools.
+//
+//   pio run -e native_json && .pio/build/native_json/program [vueltas] [resultados.csv] [referencia.csv]
+//
+// resultados.csv lleva una fila por caso con la versión y la configuración de ArduinoJson.
+// Con una referencia (la de src/host/banco_json.csv está medida con este env) sale con
+// código 1 si un caso cambia de resultado o pide más memoria o más veces que entonces: al
+// actualizar ArduinoJson se ve qué ha empeorado. El caudal solo avisa si cae a menos de la
+// mitad, porque depende de la CPU del host.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <ArduinoJson.h>
+#include "lote.h"
+
+#define VUELTAS_POR_DEFECTO 20000
+#define REGISTROS_EXPORTACION 50
+#define NIVELES_ANIDADO 20
+
+using ArduinoJson::detail::VariantAttorney;
+
+// --- MEMORIA ---
+// malloc con una cabecera que guarda el tamaño para llevar lo vivo y su máximo
+class MemoriaContada : public ArduinoJson::Allocator
+{
+public:
+  void *allocate(size_t bytes) override
+  {
+    peticiones++;
+    size_t *p = (size_t *)malloc(sizeof(size_t) + bytes);
+    if (!p)
+      return nullptr;
+    *p = bytes;
+    sumar(bytes);
+    return p + 1;
+  }
+
+  void deallocate(void *q) override
+  {
+    if (!q)
+      return;
+    size_t *p = (size_t *)q - 1;
+    vivos -= *p;
+    free(p);
+  }
+
+  void *reallocate(void *q, size_t bytes) override
+  {
+    if (!q)
+      return allocate(bytes);
+    size_t *p = (size_t *)q - 1;
+    size_t anterior = *p;
+    if (bytes > anterior)
+      peticiones++;
+    size_t *nuevo = (size_t *)realloc(p, sizeof(size_t) + bytes);
+    if (!nuevo)
+      return nullptr;
+    *nuevo = bytes;
+    vivos -= anterior;
+    sumar(bytes);
+    return nuevo + 1;
+  }
+
+  void reiniciar()
+  {
+    maximo = vivos;
+    peticiones = 0;
+  }
+
+  size_t vivos = 0;
+  size_t maximo = 0;
+  uint32_t peticiones = 0;
+
+private:
+  void sumar(size_t bytes)
+  {
+    vivos += bytes;
+    if (vivos > maximo)
+      maximo = vivos;
+  }
+};
+
+// --- CASOS ---
+struct Caso
+{
+  const char *nombre;
+  bool msgpack;
+  std::string entrada;
+  const JsonDocument *filtro; // nullptr: sin filtro
+  uint8_t anidamiento;        // límite de anidamiento
+  DeserializationError esperado;
+};
+
+struct Resultado
+{
+  DeserializationError error;
+  double mbs;
+  double nsDoc;
+  uint32_t peticiones;
+  size_t maximo;
+  size_t pool;
+};
+
+static DeserializationError leer(JsonDocument &doc, const Caso &caso)
+{
+  DeserializationOption::NestingLimit limite(caso.anidamiento);
+  const char *p = caso.entrada.data();
+  size_t n = caso.entrada.size();
+  if (caso.filtro)
+  {
+    DeserializationOption::Filter filtro(*caso.filtro);
+    return caso.msgpack ? deserializeMsgPack(doc, p, n, filtro, limite) : deserializeJson(doc, p, n, filtro, limite);
+  }
+  return caso.msgpack ? deserializeMsgPack(doc, p, n, limite) : deserializeJson(doc, p, n, limite);
+}
+
+static Resultado medir(const Caso &caso, uint32_t vueltas)
+{
+  MemoriaContada memoria;
+  Resultado r;
+
+  // Memoria de un documento nuevo, lo que pasa en cada escritura de la característica
+  {
+    JsonDocument doc(&memoria);
+    memoria.reiniciar();
+    r.error = leer(doc, caso);
+    r.peticiones = memoria.peticiones;
+    r.maximo = memoria.maximo;
+    r.pool = VariantAttorney::getResourceManager(doc)->size();
+  }
+
+  // Calentamiento: cachés y el heap del host
+  for (uint32_t v = 0; v < vueltas / 10; v++)
+  {
+    JsonDocument doc(&memoria);
+    leer(doc, caso);
+  }
+
+  std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+  for (uint32_t v = 0; v < vueltas; v++)
+  {
+    JsonDocument doc(&memoria);
+    leer(doc, caso);
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count();
+  r.nsDoc = ns / vueltas;
+  r.mbs = (double)caso.entrada.size() * vueltas / ns * 1e3;
+  return r;
+}
+
+// Ajustes de muestreo tal como los escribiría la app
+static const char CONFIGURACION[] =
+    "{\"version\":3,\"ciclo_min\":10,\"registros\":10,\"paquete\":5,\"timeout_ble_s\":20,"
+    "\"veml\":{\"ganancia\":\"x1\",\"integracion_ms\":100},"
+    "\"banda\":{\"temp\":0.2,\"hum_aire\":1.0,\"hum_suelo\":40,\"lux_abs\":2.0,\"lux_rel\":0.05,\"batt\":0.02},"
+    "\"heartbeat\":6,\"sitio\":\"invernadero-norte-3\",\"notas\":\"riego por goteo; sombra 30%\"}";
+
+static SensorData registroSintetico(uint32_t i)
+{
+  float hora = (i % 144) / 6.0f;
+  return {18.0f + 0.25f * hora, 62.5f - 0.5f * hora, (float)(2100 + i % 37), hora < 6 ? 0.0f : 95.5f * hora,
+          4.05f - 0.0001f * i, (i % 144) * 600};
+}
+
+static std::string loteMsgPack()
+{
+  SensorData registros[5];
+  for (uint32_t i = 0; i < 5; i++)
+    registros[i] = registroSintetico(i + 60);
+  uint8_t lote[MAX_BYTES_LOTE(5)];
+  size_t bytes = codificarLote(registros, 5, lote, sizeof(lote));
+  return std::string((const char *)lote, bytes);
+}
+
+// Exportación de registros del gateway: un objeto por registro con su marca de tiempo
+static void exportacion(JsonDocument &doc)
+{
+  JsonArray registros = doc.to<JsonArray>();
+  for (uint32_t i = 0; i < REGISTROS_EXPORTACION; i++)
+  {
+    SensorData d = registroSintetico(i);
+    JsonObject r = registros.add<JsonObject>();
+    r["t"] = 1760000000u + i * 600;
+    r["temp"] = d.temp;
+    r["humAir"] = d.humAir;
+    r["humSoil"] = d.humSoil;
+    r["lux"] = d.lux;
+    r["batt"] = d.batt;
+  }
+}
+
+static std::string anidado()
+{
+  std::string s;
+  for (int i = 0; i < NIVELES_ANIDADO; i++)
+    s += "{\"n\":";
+  s += "1";
+  for (int i = 0; i < NIVELES_ANIDADO; i++)
+    s += "}";
+  return s;
+}
+
+// --- REFERENCIA ---
+// Busca el caso en el CSV de referencia; false si no está o se midió con otros pools,
+// que no se pueden comparar. La versión puede cambiar: es lo que se quiere comparar.
+static bool leerReferencia(FILE *f, const char *nombre, char *error, uint32_t &peticiones, size_t &maximo,
+                           double &mbs)
+{
+  char linea[512];
+  rewind(f);
+  while (fgets(linea, sizeof(linea), f))
+  {
+    // version,pool,auto_shrink,caso,formato,bytes,error,mb_s,ns_doc,peticiones,max_bytes,pool_bytes
+    char *campos[12];
+    int n = 0;
+    for (char *c = strtok(linea, ",\n"); c && n < 12; c = strtok(nullptr, ",\n"))
+      campos[n++] = c;
+    if (n == 12 && strcmp(campos[3], nombre) == 0)
+    {
+      if (atoi(campos[1]) != ARDUINOJSON_POOL_CAPACITY || atoi(campos[2]) != ARDUINOJSON_AUTO_SHRINK)
+        return false;
+      strcpy(error, campos[6]);
+      mbs = atof(campos[7]);
+      peticiones = strtoul(campos[9], nullptr, 10);
+      maximo = strtoul(campos[10], nullptr, 10);
+      return true;
+    }
+  }
+  return false;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t vueltas = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : VUELTAS_POR_DEFECTO;
+  if (vueltas == 0)
+    vueltas = 1;
+  FILE *salida = argc > 2 ? fopen(argv[2], "w") : nullptr;
+  FILE *referencia = argc > 3 ? fopen(argv[3], "r") : nullptr;
+  if ((argc > 2 && !salida) || (argc > 3 && !referencia))
+  {
+    printf("no se puede abrir %s\n", argc > 2 && !salida ? argv[2] : argv[3]);
+    return 1;
+  }
+
+  // Filtros: los ajustes de muestreo de la configuración y lo que mira registrosLote()
+  JsonDocument filtroConfiguracion;
+  for (const char *clave : {"version", "ciclo_min", "registros", "paquete", "timeout_ble_s", "veml"})
+    filtroConfiguracion[clave] = true;
+  JsonDocument filtroLote;
+  filtroLote["v"] = true;
+  filtroLote["r"] = true;
+  JsonDocument filtroExportacion;
+  filtroExportacion[0]["t"] = true;
+  filtroExportacion[0]["batt"] = true;
+
+  JsonDocument doc;
+  deserializeJson(doc, CONFIGURACION);
+  std::string configuracionEspacios;
+  serializeJsonPretty(doc, configuracionEspacios);
+  exportacion(doc);
+  std::string exportacionJson, exportacionMsgPack;
+  serializeJson(doc, exportacionJson);
+  serializeMsgPack(doc, exportacionMsgPack);
+
+  const uint8_t limite = ARDUINOJSON_DEFAULT_NESTING_LIMIT;
+  const Caso casos[] = {
+      {"config", false, CONFIGURACION, nullptr, limite, DeserializationError::Ok},
+      {"config_espacios", false, configuracionEspacios, nullptr, limite, DeserializationError::Ok},
+      {"config_filtro", false, CONFIGURACION, &filtroConfiguracion, limite, DeserializationError::Ok},
+      {"config_limite_1", false, CONFIGURACION, nullptr, 1, DeserializationError::TooDeep},
+      {"anidado_20", false, anidado(), nullptr, limite, DeserializationError::TooDeep},
+      {"anidado_20_limite_32", false, anidado(), nullptr, 32, DeserializationError::Ok},
+      {"lote_5", true, loteMsgPack(), nullptr, limite, DeserializationError::Ok},
+      {"lote_5_filtro", true, loteMsgPack(), &filtroLote, limite, DeserializationError::Ok},
+      {"exportacion_json", false, exportacionJson, nullptr, limite, DeserializationError::Ok},
+      {"exportacion_msgpack", true, exportacionMsgPack, nullptr, limite, DeserializationError::Ok},
+      {"exportacion_json_filtro", false, exportacionJson, &filtroExportacion, limite, DeserializationError::Ok},
+      {"exportacion_msgpack_filtro", true, exportacionMsgPack, &filtroExportacion, limite, DeserializationError::Ok},
+  };
+
+  printf("ArduinoJson %s, pools de %d slots, AUTO_SHRINK %d, %u vueltas\n\n", ARDUINOJSON_VERSION,
+         ARDUINOJSON_POOL_CAPACITY, ARDUINOJSON_AUTO_SHRINK, vueltas);
+  printf("%-27s %7s %9s %8s %9s %8s %9s %8s\n", "caso", "bytes", "error", "MB/s", "ns/doc", "pet/doc", "máx B",
+         "pool B");
+  if (salida)
+    fprintf(salida, "version,pool,auto_shrink,caso,formato,bytes,error,mb_s,ns_doc,peticiones,max_bytes,pool_bytes\n");
+
+  bool correcto = true;
+  for (const Caso &caso : casos)
+  {
+    Resultado r = medir(caso, vueltas);
+    printf("%-27s %7zu %9s %8.1f %9.0f %8u %9zu %8zu\n", caso.nombre, caso.entrada.size(), r.error.c_str(), r.mbs,
+           r.nsDoc, r.peticiones, r.maximo, r.pool);
+    if (salida)
+      fprintf(salida, "%s,%d,%d,%s,%s,%zu,%s,%.1f,%.0f,%u,%zu,%zu\n", ARDUINOJSON_VERSION, ARDUINOJSON_POOL_CAPACITY,
+              ARDUINOJSON_AUTO_SHRINK, caso.nombre, caso.msgpack ? "msgpack" : "json", caso.entrada.size(),
+              r.error.c_str(), r.mbs, r.nsDoc, r.peticiones, r.maximo, r.pool);
+
+    if (r.error != caso.esperado)
+    {
+      printf("  FALLO: se esperaba %s\n", caso.esperado.c_str());
+      correcto = false;
+    }
+
+    char errorRef[32];
+    uint32_t peticionesRef;
+    size_t maximoRef;
+    double mbsRef;
+    if (referencia && leerReferencia(referencia, caso.nombre, errorRef, peticionesRef, maximoRef, mbsRef))
+    {
+      if (strcmp(errorRef, r.error.c_str()) != 0)
+      {
+        printf("  REGRESIÓN: la referencia daba %s\n", errorRef);
+        correcto = false;
+      }
+      if (r.peticiones > peticionesRef || r.maximo > maximoRef)
+      {
+        printf("  REGRESIÓN: la referencia pedía %u veces y %zu B como máximo\n", peticionesRef, maximoRef);
+        correcto = false;
+      }
+      if (r.mbs < mbsRef / 2)
+        printf("  aviso: la referencia leía %.1f MB/s\n", mbsRef);
+    }
+  }
+
+  if (salida)
+    fclose(salida);
+  if (referencia)
+    fclose(referencia);
+  printf("%s\n", correcto ? "OK" : "FALLO");
+  return correcto ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// Banco de codificación de paquetes en el host ([env:native_lotes]): registros de la traza
+// de entorno.h leídos con sensores.cpp sobre los sensores simulados, empaquetados como en
+// enviarPaquetesSPIFFS() de las dos formas: SensorData crudo y lote MsgPack (src/lote.h).
+// Da los bytes por registro según el tamaño del paquete y el coste de codificar, comprueba
+// que el lote se decodifica a los mismos valores y que codificar no pide memoria dinámica.
+// Sale con código 1 si algo de eso falla.
+//
+//   pio run -e native_lotes && .pio/build/native_lotes/program [registros] [vueltas]
+//
+// Los tiempos son de la CPU del host: sirven para comparar los dos caminos, no como
+// medida de la placa.
+
+#include <stdlib.h>
+#include <chrono>
+#include <new>
+#include <ArduinoJson.h>
+#include <Wire.h>
+#include <Shtc3Simulado.h>
+#include <Veml7700Simulado.h>
+#include <Ina226Simulado.h>
+#include "sensores.h"
+#include "lote.h"
+#include "entorno.h"
+#include "hal_host.h"
+
+#define PACKET_SIZE 5 // main.cpp
+#define PERIODO_US (10 * 60 * 1000000ULL)
+
+Shtc3Simulado shtc3Sim;
+Veml7700Simulado vemlSim;
+Ina226Simulado inaSim;
+EntornoNodo entorno;
+
+// --- MEMORIA DINÁMICA ---
+// Cuenta las peticiones al heap mientras se codifica
+static bool contandoHeap = false;
+static uint64_t peticionesHeap = 0;
+
+void *operator new(size_t bytes)
+{
+  if (contandoHeap)
+    peticionesHeap++;
+  void *p = malloc(bytes ? bytes : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// Evita que el compilador descarte un resultado que no se usa
+static volatile uint32_t sumidero;
+
+static double nsDesde(std::chrono::steady_clock::time_point inicio)
+{
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+static bool mismoFloat(float a, float b)
+{
+  return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+// Decodifica el lote con ArduinoJson (como haría el gateway) y lo compara con el original
+static bool comprobarLote(const uint8_t *lote, size_t bytes, const SensorData *registros, size_t cantidad)
+{
+  JsonDocument doc;
+  if (deserializeMsgPack(doc, lote, bytes) != DeserializationError::Ok || doc["v"] != VERSION_LOTE)
+    return false;
+  JsonArrayConst columnas = doc["c"];
+  JsonArrayConst filas = doc["r"];
+  if (columnas.size() != NUM_COLUMNAS_LOTE || filas.size() != cantidad)
+    return false;
+  for (size_t c = 0; c < NUM_COLUMNAS_LOTE; c++)
+    if (columnas[c] != EsquemaSensorData::nombre(c))
+      return false;
+  for (size_t i = 0; i < cantidad; i++)
+  {
+    const SensorData &r = registros[i];
+    const float esperado[] = {r.temp, r.humAir, r.humSoil, r.lux, r.batt};
+    for (size_t c = 0; c < sizeof(esperado) / sizeof(float); c++)
+      if (!mismoFloat(filas[i][c].as<float>(), esperado[c]))
+        return false;
+    if (filas[i][NUM_COLUMNAS_LOTE - 1].as<uint32_t>() != r.tiempoS)
+      return false;
+  }
+  return registrosLote(lote, bytes) == cantidad;
+}
+
+int main(int argc, char **argv)
+{
+  size_t numRegistros = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2016; // dos semanas a 10 min
+  int vueltas = argc > 2 ? atoi(argv[2]) : 200;
+  if (numRegistros < PACKET_SIZE)
+    numRegistros = PACKET_SIZE;
+
+  iniciarEntorno(entorno, 1);
+  WIRE_I2C(BUS_SHTC3).conectar(shtc3Sim);
+  WIRE_I2C(BUS_VEML7700).conectar(vemlSim);
+  WIRE_I2C(BUS_INA226).conectar(inaSim);
+
+  SensorData *registros = new SensorData[numRegistros];
+  for (size_t i = 0; i < numRegistros; i++)
+  {
+    aplicarEntorno(entorno, i * PERIODO_US, shtc3Sim, vemlSim, inaSim);
+    comprobarBusI2CArranque();
+    iniciarBusesI2C();
+    iniciarSensores();
+    registros[i] = leerSensores();
+    terminarBusesI2C();
+  }
+
+  bool correcto = true;
+  printf("%zu registros de la traza simulada, %d vueltas\n\n", numRegistros, vueltas);
+  printf("%-8s %12s %12s %12s %12s\n", "paquete", "crudo B/reg", "lote B/reg", "crudo ns/reg", "lote ns/reg");
+
+  for (uint8_t tam = 1; tam <= PACKET_SIZE; tam++)
+  {
+    size_t paquetes = numRegistros / tam;
+    uint8_t crudo[PACKET_SIZE * sizeof(SensorData)];
+    uint8_t lote[MAX_BYTES_LOTE(PACKET_SIZE)];
+
+    // Tamaños y decodificación
+    uint64_t bytesLote = 0;
+    size_t maxLote = 0;
+    for (size_t p = 0; p < paquetes; p++)
+    {
+      size_t bytes = codificarLote(registros + p * tam, tam, lote, sizeof(lote));
+      if (bytes == 0 || !comprobarLote(lote, bytes, registros + p * tam, tam))
+      {
+        printf("paquete %zu de %u registros: el lote no vuelve a los mismos valores\n", p, tam);
+        correcto = false;
+        break;
+      }
+      bytesLote += bytes;
+      maxLote = max(maxLote, bytes);
+    }
+
+    // Tiempos: el crudo es la copia que hace setValue() con el paquete ya leído
+    auto inicio = std::chrono::steady_clock::now();
+    for (int v = 0; v < vueltas; v++)
+      for (size_t p = 0; p < paquetes; p++)
+      {
+        memcpy(crudo, registros + p * tam, tam * sizeof(SensorData));
+        sumidero = sumidero + crudo[v % sizeof(crudo)];
+      }
+    double nsCrudo = nsDesde(inicio) / ((double)vueltas * paquetes * tam);
+
+    contandoHeap = true;
+    inicio = std::chrono::steady_clock::now();
+    for (int v = 0; v < vueltas; v++)
+      for (size_t p = 0; p < paquetes; p++)
+        sumidero = sumidero + codificarLote(registros + p * tam, tam, lote, sizeof(lote));
+    double nsLote = nsDesde(inicio) / ((double)vueltas * paquetes * tam);
+    contandoHeap = false;
+
+    printf("%-8u %12.1f %12.1f %12.1f %12.1f   (lote máximo %zu B)\n", tam, (double)sizeof(SensorData),
+           (double)bytesLote / (paquetes * tam), nsCrudo, nsLote, maxLote);
+  }
+
+  if (peticionesHeap)
+  {
+    printf("\ncodificarLote() pidió memoria dinámica %llu veces\n", (unsigned long long)peticionesHeap);
+    correcto = false;
+  }
+  else
+    printf("\nsin memoria dinámica al codificar\n");
+
+  // El peor caso (ningún valor entero y la edad en 32 bits) debe caber en MAX_BYTES_LOTE
+  SensorData peor[PACKET_SIZE];
+  for (SensorData &r : peor)
+    r = {21.37f, 55.55f, 2150.5f, 820.1f, 3.951f, EDAD_DESCONOCIDA};
+  uint8_t lote[MAX_BYTES_LOTE(PACKET_SIZE)];
+  size_t bytesPeor = codificarLote(peor, PACKET_SIZE, lote, sizeof(lote));
+  printf("peor caso de %u registros: %zu B de %u reservados\n", PACKET_SIZE, bytesPeor,
+         (unsigned)MAX_BYTES_LOTE(PACKET_SIZE));
+  if (bytesPeor == 0 || !comprobarLote(lote, bytesPeor, peor, PACKET_SIZE))
+    correcto = false;
+
+  delete[] registros;
+  return correcto ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+// Banco de adquisición en el host ([env:native]): sensores.cpp y los drivers reales
+// sobre el TwoWire simulado, con SHTC3, VEML7700 e INA226 simulados en el bus. Repite
+// el ciclo de un despertar (comprobar bus, begin, lectura) y da por dispositivo las
+// transferencias, bytes y tiempo de bus, más la duración del despertar en tiempo virtual.
+// Sale con código 1 si algún valor supera su presupuesto: sirve de prueba de regresión.
+//
+//   pio run -e native && .pio/build/native/program [despertares]
+//
+// Entre despertares solo sobrevive lo que está en RTC en la placa; aquí sobrevive toda
+// la RAM, así que los drivers conservan su estado (igual que si el begin() fuera barato).
+
+#include <stdlib.h>
+#include <Wire.h>
+#include <Shtc3Simulado.h>
+#include <Veml7700Simulado.h>
+#include <Ina226Simulado.h>
+#include "sensores.h"
+
+// --- PRESUPUESTOS POR DESPERTAR ---
+// Medidos con los drivers de lib/ a 400 kHz; subirlos solo con una razón en el commit
+#define PRESUPUESTO_TRANSFERENCIAS_SHTC3 11
+#define PRESUPUESTO_TRANSFERENCIAS_VEML7700 5
+#define PRESUPUESTO_TRANSFERENCIAS_INA226 4
+#define PRESUPUESTO_BUS_US 1500 // bytes en el bus, sin contar el clock stretching
+#define PRESUPUESTO_DESPERTAR_US 210000
+
+#define ESPERA_ENTRE_DESPERTARES_MS 60000
+
+Shtc3Simulado shtc3Sim;
+Veml7700Simulado vemlSim;
+Ina226Simulado inaSim;
+
+struct PerfilDispositivo
+{
+  const char *nombre;
+  uint8_t direccion;
+  uint8_t bus;
+  uint32_t presupuestoTransferencias;
+  uint32_t maxTransferencias;
+  uint64_t transferencias;
+  uint64_t bytes;
+  uint64_t ocupadoUs;
+  uint64_t estiradoUs;
+};
+
+PerfilDispositivo perfiles[NUM_DISP_I2C] = {
+    {"SHTC3", 0x70, BUS_SHTC3, PRESUPUESTO_TRANSFERENCIAS_SHTC3, 0, 0, 0, 0, 0},
+    {"VEML7700", 0x10, BUS_VEML7700, PRESUPUESTO_TRANSFERENCIAS_VEML7700, 0, 0, 0, 0, 0},
+    {"INA226", 0x40, BUS_INA226, PRESUPUESTO_TRANSFERENCIAS_INA226, 0, 0, 0, 0, 0},
+};
+
+bool cerca(float medido, float esperado, float tolerancia)
+{
+  return fabsf(medido - esperado) <= tolerancia;
+}
+
+int main(int argc, char **argv)
+{
+  int despertares = argc > 1 ? atoi(argv[1]) : 20;
+  if (despertares < 2)
+    despertares = 2;
+  // Un CRC corrupto en el último despertar recorre el reintento. Va al final porque el
+  // fallo baja la velocidad del SHTC3 y los demás despertares miden el régimen normal.
+  int despertarCRC = despertares - 1;
+
+  WIRE_I2C(BUS_SHTC3).conectar(shtc3Sim);
+  WIRE_I2C(BUS_VEML7700).conectar(vemlSim);
+  WIRE_I2C(BUS_INA226).conectar(inaSim);
+  shtc3Sim.fijarAmbiente(22.4f, 55.0f);
+  vemlSim.fijarLux(820.0f);
+  inaSim.fijarMedida(3.95f, 0.015f);
+  fijarLecturaAnalogica(A_IN_SKU, 2150);
+
+  bool correcto = true;
+  uint32_t maxDespertarUs = 0;
+  uint32_t maxBusUs = 0;
+  int despertaresConfVeml = 0; // los que no escribieron ALS_CONF exactamente una vez
+  uint64_t totalDespertarUs = 0;
+
+  for (int n = 0; n < despertares; n++)
+  {
+    if (n == despertarCRC)
+      shtc3Sim.corromperCRC(1);
+    Wire.reiniciarContadores();
+    Wire1.reiniciarContadores();
+
+    uint32_t escriturasConfVeml = vemlSim.escrituras(Veml7700Simulado::REG_ALS_CONF);
+    uint32_t inicio = micros();
+    comprobarBusI2CArranque();
+    iniciarBusesI2C();
+    iniciarSensores();
+    SensorData d = leerSensores();
+    terminarBusesI2C();
+    uint32_t despertarUs = micros() - inicio;
+    // Ganancia, integración y encendido van en una sola escritura de ALS_CONF
+    if (vemlSim.escrituras(Veml7700Simulado::REG_ALS_CONF) - escriturasConfVeml != 1)
+      despertaresConfVeml++;
+
+    uint32_t busUs = (uint32_t)(Wire.totales().ocupadoUs + Wire1.totales().ocupadoUs);
+    totalDespertarUs += despertarUs;
+    if (n != despertarCRC)
+    {
+      maxDespertarUs = max(maxDespertarUs, despertarUs);
+      maxBusUs = max(maxBusUs, busUs);
+    }
+    for (uint8_t i = 0; i < NUM_DISP_I2C; i++)
+    {
+      const ContadoresI2C &c = WIRE_I2C(perfiles[i].bus).contadores(perfiles[i].direccion);
+      perfiles[i].transferencias += c.transferencias;
+      perfiles[i].bytes += c.bytes;
+      perfiles[i].ocupadoUs += c.ocupadoUs;
+      perfiles[i].estiradoUs += c.estiradoUs;
+      // El despertar con CRC corrupto lleva un reintento: no cuenta para el presupuesto
+      if (n != despertarCRC)
+        perfiles[i].maxTransferencias = max(perfiles[i].maxTransferencias, c.transferencias);
+    }
+
+    if (!cerca(d.temp, 22.4f, 0.05f) || !cerca(d.humAir, 55.0f, 0.05f) || !cerca(d.lux, 820.0f, 1.0f) ||
+        !cerca(d.batt, 3.95f, 0.00125f) || d.humSoil != 2150)
+    {
+      printf("despertar %d: lectura incorrecta T=%.2f HR=%.2f lux=%.1f batt=%.3f suelo=%.0f\n", n, d.temp, d.humAir,
+             d.lux, d.batt, d.humSoil);
+      correcto = false;
+    }
+
+    delay(ESPERA_ENTRE_DESPERTARES_MS);
+  }
+
+  printf("%d despertares simulados, bus a %u Hz tras la negociación\n\n", despertares, Wire.getClock());
+  printf("%-10s %14s %12s %12s %10s %12s\n", "disp", "transf/desp", "max transf", "bytes/desp", "bus us",
+         "stretch us");
+  for (uint8_t i = 0; i < NUM_DISP_I2C; i++)
+  {
+    const PerfilDispositivo &p = perfiles[i];
+    printf("%-10s %14.2f %12u %12.1f %10.1f %12.1f\n", p.nombre, (double)p.transferencias / despertares,
+           p.maxTransferencias, (double)p.bytes / despertares, (double)p.ocupadoUs / despertares,
+           (double)p.estiradoUs / despertares);
+    if (p.maxTransferencias > p.presupuestoTransferencias)
+    {
+      printf("  REGRESIÓN: %u transferencias > presupuesto %u\n", p.maxTransferencias, p.presupuestoTransferencias);
+      correcto = false;
+    }
+  }
+
+  printf("\ndespertar: medio %.1f ms, máximo %.1f ms (presupuesto %.1f ms)\n",
+         totalDespertarUs / 1000.0 / despertares, maxDespertarUs / 1000.0, PRESUPUESTO_DESPERTAR_US / 1000.0);
+  printf("bus: máximo %u us por despertar (presupuesto %u us)\n", maxBusUs, PRESUPUESTO_BUS_US);
+  printf("SHTC3: %u medidas, %u comandos rechazados, %u ignorados estando dormido\n", shtc3Sim.medidas(),
+         shtc3Sim.comandosRechazados(), shtc3Sim.comandosIgnorados());
+  printf("VEML7700: ALS_CONF escrito %u veces, ALS leído %u veces, %u lecturas prematuras\n",
+         vemlSim.escrituras(Veml7700Simulado::REG_ALS_CONF), vemlSim.lecturas(Veml7700Simulado::REG_ALS),
+         vemlSim.lecturasPrematuras());
+  printf("diagnóstico:");
+  for (uint8_t i = 0; i < NUM_DISP_I2C; i++)
+  {
+    const SaludDispositivoI2C &s = diagnosticoI2C.dispositivos[i];
+    printf(" %s tx=%u nack=%u crc=%u reint=%u", NOMBRE_DISP_I2C[i], (unsigned)s.transacciones, (unsigned)s.nacks,
+           (unsigned)s.erroresCRC, (unsigned)s.reintentos);
+  }
+  printf("\n");
+
+  if (maxDespertarUs > PRESUPUESTO_DESPERTAR_US)
+  {
+    printf("REGRESIÓN: despertar de %u us\n", maxDespertarUs);
+    correcto = false;
+  }
+  if (maxBusUs > PRESUPUESTO_BUS_US)
+  {
+    printf("REGRESIÓN: %u us de bus\n", maxBusUs);
+    correcto = false;
+  }
+  if (despertaresConfVeml > 0)
+  {
+    printf("REGRESIÓN: %d despertares sin exactamente una escritura de ALS_CONF\n", despertaresConfVeml);
+    correcto = false;
+  }
+  if (vemlSim.lecturasPrematuras() > 0)
+  {
+    printf("REGRESIÓN: readLux() antes de completar la integración\n");
+    correcto = false;
+  }
+  if (diagnosticoI2C.dispositivos[DISP_SHTC3].erroresCRC != 1)
+  {
+    printf("REGRESIÓN: el CRC inyectado no llegó al diagnóstico\n");
+    correcto = false;
+  }
+  // Un CRC malo es de datos, no del reloj: no debe bajar la velocidad del bus
+  if (bajadasVelocidadI2C != 0)
+  {
+    printf("REGRESIÓN: %u bajadas de velocidad sin errores de bus\n", bajadasVelocidadI2C);
+    correcto = false;
+  }
+
+  printf("%s\n", correcto ? "OK" : "FALLO");
+  return correcto ? 0 : 1;
+}
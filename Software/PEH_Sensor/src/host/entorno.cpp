@@ -0,0 +1,38 @@
+#include <Arduino.h>
+#include "entorno.h"
+#include "placa.h"
+#include "hal_host.h"
+
+static float ruido(EntornoNodo &e, float amplitud)
+{
+  return amplitud * (2.0f * azarHostUnidad(e.azar) - 1.0f);
+}
+
+void iniciarEntorno(EntornoNodo &e, uint32_t semilla)
+{
+  e.azar = semilla * 2654435761u;
+  if (!e.azar)
+    e.azar = 1;
+  e.desfaseTempC = ruido(e, 1.5f);
+  e.sombra = 0.5f + 0.5f * azarHostUnidad(e.azar);
+  e.secadoPorDia = 120.0f + ruido(e, 40.0f);
+}
+
+void aplicarEntorno(EntornoNodo &e, uint64_t us, Shtc3Simulado &shtc3, Veml7700Simulado &veml, Ina226Simulado &ina)
+{
+  double dias = (double)us / US_POR_DIA;
+  double hora = (dias - (uint64_t)dias) * 24.0;
+  double sol = sin(M_PI * (hora - 6.0) / 12.0);
+  double diario = sin(2 * M_PI * (hora - 9.0) / 24.0);
+  float temp = 18.0f + e.desfaseTempC + 6.0f * (float)diario + ruido(e, 0.15f);
+  float hum = 60.0f - 15.0f * (float)diario + ruido(e, 0.8f);
+  float nubes = 0.6f + 0.4f * fabsf(ruido(e, 1.0f));
+  float lux = sol > 0 ? (float)(sol * 20000.0) * e.sombra * nubes : 0.5f;
+  float batt = 3.85f + 0.1f * (float)(sol > 0 ? sol : 0) + ruido(e, 0.005f);
+  uint16_t suelo = (uint16_t)(1500 + e.secadoPorDia * fmod(dias, 7.0) + ruido(e, 10.0f));
+
+  shtc3.fijarAmbiente(temp, hum);
+  veml.fijarLux(lux);
+  ina.fijarMedida(batt, 0.012f);
+  fijarLecturaAnalogica(A_IN_SKU, suelo);
+}
@@ -0,0 +1,28 @@
+// Traza de sensores de un nodo simulado: ciclo diario de temperatura, humedad y luz con
+// nubes, batería que sube con la cosecha y suelo que se seca y se riega cada semana.
+// Cada nodo tiene su propio microclima (desfases, sombra, secado) y su propio ruido.
+
+#ifndef ENTORNO_H
+#define ENTORNO_H
+
+#include <stdint.h>
+#include <Shtc3Simulado.h>
+#include <Veml7700Simulado.h>
+#include <Ina226Simulado.h>
+
+#define US_POR_DIA 86400000000ULL
+
+struct EntornoNodo
+{
+  uint32_t azar;
+  float desfaseTempC;
+  float sombra;        // fracción de luz que llega al VEML7700
+  float secadoPorDia;  // cuentas de ADC que sube el suelo cada día sin riego
+};
+
+void iniciarEntorno(EntornoNodo &entorno, uint32_t semilla);
+// Fija en los sensores simulados y en el ADC del hilo actual el estado del entorno en us
+void aplicarEntorno(EntornoNodo &entorno, uint64_t us, Shtc3Simulado &shtc3, Veml7700Simulado &veml,
+                    Ina226Simulado &ina);
+
+#endif
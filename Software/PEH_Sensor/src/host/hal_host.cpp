@@ -0,0 +1,490 @@
+#include <Arduino.h>
+#include <vector>
+#include <ArduinoJson.h>
+#include "hal.h"
+#include "hal_host.h"
+#include "lote.h"
+#include "../../gateway/protocolo.h" // el gateway simulado lee los anuncios como el de verdad
+
+#ifdef USAR_ULP
+#error "El host no simula el ULP"
+#endif
+
+ModeloGateway modeloGateway = {0.9f, 300, 3000, 30, 150, 0.01f};
+CostesHost costesHost = {25000, 1500, 400, 8000, 6000, 250000, 20000, 1000};
+
+static NodoHost nodoPorDefecto;
+static GatewayAleatorio *gatewayPorDefecto = nullptr;
+static thread_local NodoHost *nodo = &nodoPorDefecto;
+
+uint64_t GatewayAleatorio::anunciar(uint64_t ahoraUs)
+{
+  bool presente = azarHostUnidad(_azar) < _modelo.probabilidadPresente;
+  uint64_t conexionUs = ahoraUs + 1000ULL * azarHostEntre(_azar, _modelo.conexionMinMs, _modelo.conexionMaxMs);
+  return presente ? conexionUs : NUNCA;
+}
+
+uint64_t GatewayAleatorio::notificar(uint64_t ahoraUs, size_t, size_t registros)
+{
+  // Los datos llegan aunque se pierda el "OK"
+  for (size_t i = 0; i < registros; i++)
+    oidosRelleno += marcarOido(_cursorRelleno++);
+  bool perdido = azarHostUnidad(_azar) < _modelo.probabilidadPerdidaAck;
+  uint64_t ackUs = ahoraUs + 1000ULL * azarHostEntre(_azar, _modelo.ackMinMs, _modelo.ackMaxMs);
+  return perdido ? NUNCA : ackUs;
+}
+
+size_t GatewayAleatorio::ajustes(uint8_t *destino, size_t capacidad)
+{
+  if (_ajustes.empty() || _ajustes.size() > capacidad)
+    return 0;
+  memcpy(destino, _ajustes.data(), _ajustes.size());
+  return _ajustes.size();
+}
+
+void GatewayAleatorio::ajustesNotificados(const uint8_t *datos, size_t bytes)
+{
+  if (bytes == _ajustes.size() && memcmp(datos, _ajustes.data(), bytes) == 0)
+    _ajustes.clear(); // ya vigentes en el nodo
+}
+
+bool GatewayAleatorio::marcarOido(uint16_t secuencia)
+{
+  _oidos[(uint16_t)(secuencia + 32768)] = false;
+  bool nuevo = !_oidos[secuencia];
+  _oidos[secuencia] = true;
+  return nuevo;
+}
+
+void GatewayAleatorio::difusion(uint64_t, const uint8_t *datos, size_t bytes)
+{
+  VistaDifusion difusion;
+  if (azarHostUnidad(_azar) >= _modelo.probabilidadPresente || !difusion.leer(datos, bytes))
+    return;
+  for (size_t i = 0; i < difusion.registros(); i++)
+    oidosDifusion += marcarOido(difusion.secuencia(i));
+}
+
+bool GatewayAleatorio::relleno(const uint8_t *fabricante, size_t bytes, uint16_t &desde)
+{
+  CabeceraAnuncio anuncio;
+  if (!leerAnuncio(fabricante, bytes, anuncio) || !(anuncio.banderas & ANUNCIO_SECUENCIA))
+    return false;
+  desde = anuncio.secuencia + 1; // nada que pedir
+  for (uint16_t i = anuncio.registrosPendientes; i > 0; i--)
+  {
+    uint16_t secuencia = anuncio.secuencia - i + 1;
+    if (!_oidos[secuencia])
+    {
+      desde = secuencia;
+      break;
+    }
+  }
+  _cursorRelleno = desde;
+  return true;
+}
+
+void iniciarNodoHost(NodoHost &n, GatewaySimulado *gateway)
+{
+  n.gateway = gateway;
+  memset(&n.estadisticas, 0, sizeof(n.estadisticas));
+  n.fin = FIN_NINGUNO;
+  n.mhz = 240;
+  n.despertarEnUs = 0;
+  n.inicioRadioUs = 0;
+  n.conexionUs = NUNCA;
+  n.conectado = false;
+  n.ackUs = NUNCA;
+  n.bytesPendientes = 0;
+  n.registrosPendientes = 0;
+  n.ledEncendido = false;
+  n.ledDesdeUs = 0;
+  n.numPasosLed = 0;
+  n.pasoLed = 0;
+  n.repeticionesLed = 0;
+  n.efectoActivo = false;
+  n.finPasoLedUs = 0;
+  n.archivo.clear();
+  n.nvs.clear();
+  n.reinicioPedido = false;
+  n.fabricante.clear();
+  n.ajustesRecibidos.clear();
+  n.hayRelleno = false;
+  n.rellenoDesde = 0;
+}
+
+void usarNodoHost(NodoHost *n)
+{
+  nodo = n ? n : &nodoPorDefecto;
+}
+
+void iniciarHalHost(uint32_t semilla)
+{
+  delete gatewayPorDefecto;
+  gatewayPorDefecto = new GatewayAleatorio(modeloGateway, semilla);
+  iniciarNodoHost(nodoPorDefecto, gatewayPorDefecto);
+  usarNodoHost(&nodoPorDefecto);
+}
+
+GatewayAleatorio &gatewayHost() { return *gatewayPorDefecto; }
+
+const EstadisticasHost &estadisticasHost() { return nodo->estadisticas; }
+
+// --- RELOJ ---
+
+uint32_t relojMs() { return millis(); }
+uint32_t relojUs() { return micros(); }
+uint32_t relojNodoS() { return (uint32_t)(relojHostUs() / 1000000); } // la simulación no tiene cortes
+void esperarMs(uint32_t ms) { delay(ms); }
+uint32_t cpuMhz() { return nodo->mhz; }
+void fijarCpuMhz(uint32_t mhz) { nodo->mhz = mhz; }
+
+// --- SUEÑO ---
+void empezarDespertarHost()
+{
+  nodo->fin = FIN_NINGUNO;
+  nodo->mhz = 240;
+}
+
+FinDespertar finDespertarHost() { return nodo->fin; }
+
+void programarDespertar(uint64_t us)
+{
+  nodo->despertarEnUs = us;
+}
+
+void pararLedHost(); // en --- LED ---: aplica los pasos vencidos y corta el efecto
+
+void dormirProfundo()
+{
+  pararLedHost();
+  avanzarRelojHost(nodo->despertarEnUs);
+  nodo->estadisticas.suenoProfundoUs += nodo->despertarEnUs;
+  nodo->fin = FIN_SUENO_PROFUNDO;
+}
+
+void dormirLigero()
+{
+  pararLedHost();
+  avanzarRelojHost(nodo->despertarEnUs);
+  nodo->estadisticas.suenoLigeroUs += nodo->despertarEnUs;
+}
+
+void reiniciarNodo()
+{
+  nodo->fin = FIN_REINICIO;
+  nodo->reinicioPedido = true;
+}
+
+bool reinicioPedido()
+{
+  return nodo->reinicioPedido;
+}
+
+// --- ALMACÉN ---
+size_t bytesAlmacenHost() { return nodo->archivo.size(); }
+
+bool almacenMontar()
+{
+  avanzarRelojHost(costesHost.montajeUs);
+  nodo->estadisticas.montajes++;
+  return true;
+}
+
+size_t almacenBytes()
+{
+  return nodo->archivo.size();
+}
+
+bool almacenAnadir(const void *datos, size_t bytes)
+{
+  avanzarRelojHost(costesHost.escrituraUs);
+  nodo->estadisticas.escrituras++;
+  nodo->archivo.insert(nodo->archivo.end(), (const uint8_t *)datos, (const uint8_t *)datos + bytes);
+  nodo->estadisticas.maxBytesAlmacen = max(nodo->estadisticas.maxBytesAlmacen, nodo->archivo.size());
+  return true;
+}
+
+bool almacenLeer(size_t desplazamiento, void *destino, size_t bytes)
+{
+  avanzarRelojHost(costesHost.lecturaUs);
+  nodo->estadisticas.lecturas++;
+  if (desplazamiento + bytes > nodo->archivo.size())
+    return false;
+  memcpy(destino, nodo->archivo.data() + desplazamiento, bytes);
+  return true;
+}
+
+void almacenBorrar()
+{
+  avanzarRelojHost(costesHost.borradoUs);
+  nodo->estadisticas.borrados++;
+  nodo->archivo.clear();
+}
+
+// --- NVS ---
+size_t nvsLeer(const char *clave, void *destino, size_t capacidad)
+{
+  auto it = nodo->nvs.find(clave);
+  if (it == nodo->nvs.end() || it->second.empty() || it->second.size() > capacidad)
+    return 0;
+  memcpy(destino, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+bool nvsGuardar(const char *clave, const void *datos, size_t bytes)
+{
+  avanzarRelojHost(costesHost.escrituraNvsUs);
+  nodo->estadisticas.escriturasNvs++;
+  nodo->nvs[clave].assign((const uint8_t *)datos, (const uint8_t *)datos + bytes);
+  return true;
+}
+
+// --- TRANSPORTE ---
+// El gateway decide al anunciarse cuándo se conecta y, por paquete, cuándo llega el ACK
+void transporteIniciar(const uint8_t *fabricante, size_t bytes)
+{
+  nodo->fabricante.assign(fabricante, fabricante + bytes); // para el relleno
+  nodo->inicioRadioUs = relojHostUs();
+  avanzarRelojHost(costesHost.inicioTransporteUs);
+  nodo->estadisticas.drenajesIntentados++;
+  nodo->conectado = false;
+  nodo->ackUs = NUNCA;
+  nodo->ajustesRecibidos.clear();
+  nodo->hayRelleno = false;
+  nodo->conexionUs = nodo->gateway->anunciar(relojHostUs());
+}
+
+bool transporteConectado()
+{
+  if (relojHostUs() < nodo->conexionUs)
+    return false;
+  if (!nodo->conectado)
+  {
+    nodo->estadisticas.conexiones++;
+    nodo->conectado = true;
+    // Lo que escriba el gateway al conectarse ya está cuando el nodo lo mira
+    uint8_t blob[32];
+    size_t bytes = nodo->gateway->ajustes(blob, sizeof(blob));
+    nodo->ajustesRecibidos.assign(blob, blob + bytes);
+    nodo->hayRelleno = nodo->gateway->relleno(nodo->fabricante.data(), nodo->fabricante.size(), nodo->rellenoDesde);
+  }
+  return true;
+}
+
+static void notificarDatos(size_t bytes, size_t registros)
+{
+  nodo->estadisticas.paquetesEnviados++;
+  nodo->ackUs = nodo->conectado ? nodo->gateway->notificar(relojHostUs(), bytes, registros) : NUNCA;
+  nodo->bytesPendientes = bytes;
+  nodo->registrosPendientes = registros;
+}
+
+void transporteEnviarDatos(const uint8_t *datos, size_t bytes)
+{
+  (void)datos;
+  notificarDatos(bytes, bytes / sizeof(SensorData));
+}
+
+size_t registrosLote(const uint8_t *datos, size_t bytes)
+{
+  JsonDocument filtro;
+  filtro["v"] = true;
+  filtro["r"] = true;
+  JsonDocument lote;
+  if (deserializeMsgPack(lote, datos, bytes, DeserializationOption::Filter(filtro)) != DeserializationError::Ok)
+    return 0;
+  if (lote["v"] != VERSION_LOTE || !lote["r"].is<JsonArrayConst>())
+    return 0;
+  return lote["r"].size();
+}
+
+void transporteEnviarLote(const uint8_t *datos, size_t bytes)
+{
+  notificarDatos(bytes, registrosLote(datos, bytes));
+}
+
+bool transporteAckRecibido()
+{
+  if (relojHostUs() < nodo->ackUs)
+    return false;
+  if (nodo->bytesPendientes)
+  {
+    nodo->estadisticas.acks++;
+    nodo->estadisticas.bytesConfirmados += nodo->bytesPendientes;
+    nodo->estadisticas.registrosConfirmados += nodo->registrosPendientes;
+    nodo->bytesPendientes = 0;
+    nodo->registrosPendientes = 0;
+  }
+  return true;
+}
+
+void transporteEnviarDiagnostico(const uint8_t *datos, size_t bytes)
+{
+  if (bytes < 4)
+    return;
+  EstadisticasHost &e = nodo->estadisticas;
+  uint16_t secuencia = datos[2] | (datos[3] << 8);
+  if (secuencia != (uint16_t)(e.ultimaSecuenciaDiag + 1))
+    e.saltosSecuenciaDiag++;
+  e.ultimaSecuenciaDiag = secuencia;
+  e.diagnosticos++;
+}
+
+size_t transporteAjustesRecibidos(uint8_t *destino, size_t capacidad)
+{
+  size_t bytes = nodo->ajustesRecibidos.size();
+  if (bytes == 0 || bytes > capacidad)
+    return 0;
+  memcpy(destino, nodo->ajustesRecibidos.data(), bytes);
+  nodo->ajustesRecibidos.clear();
+  nodo->estadisticas.ajustesRecibidos++;
+  return bytes;
+}
+
+void transporteEnviarAjustes(const uint8_t *datos, size_t bytes)
+{
+  if (nodo->conectado)
+    nodo->gateway->ajustesNotificados(datos, bytes);
+}
+
+void transporteParar()
+{
+  avanzarRelojHost(costesHost.pararTransporteUs);
+  nodo->estadisticas.radioUs += relojHostUs() - nodo->inicioRadioUs;
+  nodo->gateway->desconectar(relojHostUs(), nodo->conectado ? nodo->conexionUs : NUNCA);
+  nodo->conectado = false;
+  nodo->conexionUs = NUNCA;
+  nodo->ackUs = NUNCA;
+}
+
+#ifdef MODO_ANUNCIO
+// Arranque y parada del controlador como en transporteIniciar()/transporteParar(); entre
+// medias los anuncios, y de radio solo lo que dura cada uno
+void transporteDifundir(const uint8_t *datos, size_t bytes, uint8_t eventos)
+{
+  avanzarRelojHost(costesHost.inicioTransporteUs);
+  nodo->gateway->difusion(relojHostUs(), datos, bytes);
+  avanzarRelojHost(eventos * 20000ULL); // INTERVALO_DIFUSION en hal_esp32.cpp
+  avanzarRelojHost(costesHost.pararTransporteUs);
+  nodo->estadisticas.radioUs += eventos * costesHost.eventoDifusionUs;
+  nodo->estadisticas.difusiones++;
+}
+
+bool transporteRellenoDesde(uint16_t &secuencia)
+{
+  if (!nodo->hayRelleno)
+    return false;
+  secuencia = nodo->rellenoDesde;
+  return true;
+}
+#endif
+
+// --- ADC Y GPIO ---
+uint16_t leerADC(uint8_t pin)
+{
+  return analogRead(pin);
+}
+
+void activarSalida(uint8_t pin, bool nivel)
+{
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, nivel);
+}
+
+// --- LED ---
+#ifdef LED_ESTADO
+// Cambia el color a la hora tUs (≤ ahora) y lleva la cuenta del tiempo encendido
+static void fijarLedHost(uint32_t color, uint64_t tUs)
+{
+  if (color && !nodo->ledEncendido)
+    nodo->ledDesdeUs = tUs;
+  else if (!color && nodo->ledEncendido)
+    nodo->estadisticas.ledUs += tUs - nodo->ledDesdeUs;
+  nodo->ledEncendido = color != 0;
+}
+
+// Aplica los pasos del efecto que han vencido hasta ahora
+static void avanzarEfectoHost()
+{
+  while (nodo->efectoActivo && nodo->finPasoLedUs <= relojHostUs())
+  {
+    uint64_t t = nodo->finPasoLedUs;
+    if (++nodo->pasoLed == nodo->numPasosLed)
+    {
+      nodo->pasoLed = 0;
+      if (--nodo->repeticionesLed == 0)
+      {
+        nodo->efectoActivo = false; // el último paso se queda
+        break;
+      }
+    }
+    const PasoLed &paso = nodo->pasosLed[nodo->pasoLed];
+    fijarLedHost(paso.color, t);
+    nodo->finPasoLedUs = t + paso.ms * 1000ULL;
+    nodo->efectoActivo = paso.ms > 0;
+  }
+}
+
+void pararLedHost()
+{
+  avanzarEfectoHost();
+  nodo->efectoActivo = false;
+}
+
+void ledIniciar()
+{
+  ledApagar();
+}
+
+void ledColor(uint32_t color)
+{
+  pararLedHost();
+  fijarLedHost(color, relojHostUs());
+}
+
+void ledApagar()
+{
+  ledColor(0);
+}
+
+void ledEfecto(const PasoLed *pasos, uint8_t numPasos, uint8_t repeticiones)
+{
+  pararLedHost();
+  if (numPasos == 0 || repeticiones == 0)
+    return;
+  numPasos = numPasos < MAX_PASOS_LED ? numPasos : MAX_PASOS_LED;
+  memcpy(nodo->pasosLed, pasos, numPasos * sizeof(PasoLed));
+  nodo->numPasosLed = numPasos;
+  nodo->pasoLed = 0;
+  nodo->repeticionesLed = repeticiones;
+  nodo->finPasoLedUs = relojHostUs() + pasos[0].ms * 1000ULL;
+  nodo->efectoActivo = pasos[0].ms > 0;
+  fijarLedHost(pasos[0].color, relojHostUs());
+}
+
+bool ledEfectoActivo()
+{
+  avanzarEfectoHost();
+  return nodo->efectoActivo;
+}
+
+// Como la placa: lo que queda del efecto se pasa en light sleep
+uint32_t ledEsperarEfecto(uint32_t maxMs)
+{
+  uint64_t inicio = relojHostUs();
+  uint64_t limite = inicio + maxMs * 1000ULL;
+  avanzarEfectoHost();
+  while (nodo->efectoActivo && relojHostUs() < limite)
+  {
+    uint64_t hasta = nodo->finPasoLedUs < limite ? nodo->finPasoLedUs : limite;
+    avanzarRelojHost(hasta - relojHostUs());
+    avanzarEfectoHost();
+  }
+  uint32_t dormidoUs = (uint32_t)(relojHostUs() - inicio);
+  nodo->estadisticas.suenoLigeroUs += dormidoUs;
+  return dormidoUs;
+}
+#else
+void pararLedHost() {}
+#endif
@@ -0,0 +1,236 @@
+// Controles y medidas de la implementación de include/hal.h en el host. El tiempo es
+// el reloj virtual de arduino/Arduino.cpp; la flash y la NVS son vectores en RAM que
+// sobreviven a los arranques simulados; el transporte habla con un GatewaySimulado.
+//
+// Todo lo que el HAL guarda de un nodo está en un NodoHost. simulador_nodo usa uno por
+// defecto; el simulador de flota tiene uno por nodo y cada hilo activa el del nodo que
+// ejecuta con usarNodoHost().
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "hal.h"
+
+#define NUNCA UINT64_MAX
+
+// Lo que tarda la placa desde que despierta hasta setup() (ROM, bootloader, init del core)
+#define T_ARRANQUE_US 40000
+
+// Consumos fuera de los despertares (mA); los despiertos salen del perfil de main.cpp
+#define CORRIENTE_SUENO_PROFUNDO_MA 0.02
+#define CORRIENTE_SUENO_LIGERO_MA 0.25
+#define CORRIENTE_LED_MA 5.0
+#define TENSION_SIMULADA 3.3
+
+struct ModeloGateway
+{
+  float probabilidadPresente; // de que alguien escuche en cada intento de drenaje
+  uint32_t conexionMinMs;     // desde el inicio del advertising
+  uint32_t conexionMaxMs;
+  uint32_t ackMinMs; // desde la notificación
+  uint32_t ackMaxMs;
+  float probabilidadPerdidaAck;
+};
+
+// Lo que tardan en la placa las operaciones que en el host son instantáneas.
+// Estimaciones de orden de magnitud; sustituir por medidas del banco si las hay.
+struct CostesHost
+{
+  uint32_t montajeUs;
+  uint32_t escrituraUs;
+  uint32_t lecturaUs;
+  uint32_t borradoUs;
+  uint32_t escrituraNvsUs;
+  uint32_t inicioTransporteUs;
+  uint32_t pararTransporteUs;
+  uint32_t eventoDifusionUs; // radio encendida por anuncio extendido (MODO_ANUNCIO)
+};
+
+enum FinDespertar
+{
+  FIN_NINGUNO, // setup() volvió sin dormir: fallo de la máquina de estados
+  FIN_SUENO_PROFUNDO,
+  FIN_REINICIO
+};
+
+struct EstadisticasHost
+{
+  uint32_t montajes;
+  uint32_t escrituras;
+  uint32_t lecturas;
+  uint32_t borrados;
+  size_t maxBytesAlmacen;
+  uint32_t drenajesIntentados;
+  uint32_t conexiones;
+  uint32_t paquetesEnviados;
+  uint32_t acks;
+  uint64_t bytesConfirmados; // de datos, tal como viajan (crudos o en lote)
+  uint64_t registrosConfirmados;
+  uint32_t diagnosticos;
+  uint16_t ultimaSecuenciaDiag;
+  uint32_t saltosSecuenciaDiag; // diagnósticos cuya secuencia no sigue a la anterior
+  uint32_t ajustesRecibidos;
+  uint32_t escriturasNvs;
+  uint32_t difusiones;
+  uint64_t radioUs;
+  uint64_t ledUs;
+  uint64_t suenoProfundoUs;
+  uint64_t suenoLigeroUs;
+};
+
+// xorshift32: reproducible con la misma semilla en cualquier máquina
+inline uint32_t azarHost(uint32_t &estado)
+{
+  estado ^= estado << 13;
+  estado ^= estado >> 17;
+  estado ^= estado << 5;
+  return estado;
+}
+
+inline uint32_t azarHostEntre(uint32_t &estado, uint32_t minimo, uint32_t maximo)
+{
+  return maximo > minimo ? minimo + azarHost(estado) % (maximo - minimo + 1) : minimo;
+}
+
+inline float azarHostUnidad(uint32_t &estado)
+{
+  return (azarHost(estado) >> 8) * (1.0f / 16777216.0f);
+}
+
+// El otro extremo del transporte. Los tiempos son del reloj absoluto (relojHostUs()).
+class GatewaySimulado
+{
+public:
+  virtual ~GatewaySimulado() {}
+  // El nodo empieza a anunciarse: cuándo se conecta el gateway, NUNCA si no lo hace
+  virtual uint64_t anunciar(uint64_t ahoraUs) = 0;
+  // Paquete de datos notificado: cuándo llega el "OK", NUNCA si se pierde
+  virtual uint64_t notificar(uint64_t ahoraUs, size_t bytes, size_t registros) = 0;
+  // El nodo apaga la radio; conexionUs es lo que devolvió anunciar() si llegó a conectarse
+  // y NUNCA si se rindió antes
+  virtual void desconectar(uint64_t ahoraUs, uint64_t conexionUs) = 0;
+  // Blob que escribe en la característica de ajustes al conectarse; 0 si ninguno
+  virtual size_t ajustes(uint8_t *destino, size_t capacidad)
+  {
+    (void)destino;
+    (void)capacidad;
+    return 0;
+  }
+  // El nodo notifica sus ajustes vigentes
+  virtual void ajustesNotificados(const uint8_t *datos, size_t bytes)
+  {
+    (void)datos;
+    (void)bytes;
+  }
+  // Difusión sin conexión (MODO_ANUNCIO): los datos de fabricante de src/anuncio.h
+  virtual void difusion(uint64_t ahoraUs, const uint8_t *datos, size_t bytes)
+  {
+    (void)ahoraUs;
+    (void)datos;
+    (void)bytes;
+  }
+  // Al conectarse, con los datos de fabricante del advertising: la secuencia desde la que
+  // quiere el relleno. false si no la escribe.
+  virtual bool relleno(const uint8_t *fabricante, size_t bytes, uint16_t &desde)
+  {
+    (void)fabricante;
+    (void)bytes;
+    (void)desde;
+    return false;
+  }
+};
+
+// Un gateway que aparece con cierta probabilidad en cada drenaje, con latencias
+// uniformes y ACKs que se pierden al azar (ModeloGateway)
+class GatewayAleatorio : public GatewaySimulado
+{
+public:
+  GatewayAleatorio(const ModeloGateway &modelo, uint32_t semilla) : _modelo(modelo), _azar(semilla ? semilla : 1) {}
+  uint64_t anunciar(uint64_t ahoraUs) override;
+  uint64_t notificar(uint64_t ahoraUs, size_t bytes, size_t registros) override;
+  void desconectar(uint64_t, uint64_t) override {}
+  // Los escribe en cada conexión hasta que el nodo los notifica como vigentes
+  size_t ajustes(uint8_t *destino, size_t capacidad) override;
+  void programarAjustes(const uint8_t *datos, size_t bytes) { _ajustes.assign(datos, datos + bytes); }
+  void ajustesNotificados(const uint8_t *datos, size_t bytes) override;
+  // Oye cada difusión con la probabilidad de estar presente y pide de relleno desde el
+  // primer registro pendiente del nodo que no ha oído
+  void difusion(uint64_t ahoraUs, const uint8_t *datos, size_t bytes) override;
+  bool relleno(const uint8_t *fabricante, size_t bytes, uint16_t &desde) override;
+
+  uint64_t oidosDifusion = 0; // registros distintos que llegaron por cada camino
+  uint64_t oidosRelleno = 0;
+
+private:
+  bool marcarOido(uint16_t secuencia);
+
+  ModeloGateway _modelo;
+  uint32_t _azar;
+  std::vector<uint8_t> _ajustes;
+  // Por secuencia: solo vale media ventana, al marcar una se olvida la opuesta
+  std::vector<bool> _oidos = std::vector<bool>(65536, false);
+  uint16_t _cursorRelleno = 0; // secuencia del siguiente registro que llega por conexión
+};
+
+struct NodoHost
+{
+  GatewaySimulado *gateway;
+  EstadisticasHost estadisticas;
+  FinDespertar fin;
+  uint32_t mhz;
+  uint64_t despertarEnUs;
+
+  uint64_t inicioRadioUs;
+  uint64_t conexionUs;
+  bool conectado;
+  uint64_t ackUs;
+  size_t bytesPendientes;
+  size_t registrosPendientes;
+
+  bool ledEncendido;
+  uint64_t ledDesdeUs;
+  // Efecto en curso: sin temporizadores, los pasos vencidos se aplican en la siguiente
+  // llamada al HAL del LED o del sueño, con la hora a la que tocaban
+  PasoLed pasosLed[MAX_PASOS_LED];
+  uint8_t numPasosLed;
+  uint8_t pasoLed;
+  uint8_t repeticionesLed;
+  bool efectoActivo;
+  uint64_t finPasoLedUs;
+
+  std::vector<uint8_t> archivo; // la flash: solo crece salvo en almacenBorrar()
+  std::map<std::string, std::vector<uint8_t>> nvs;
+  bool reinicioPedido; // el arranque siguiente viene de reiniciarNodo()
+  std::vector<uint8_t> fabricante;       // del advertising en curso
+  std::vector<uint8_t> ajustesRecibidos; // escritos por el gateway en esta conexión
+  bool hayRelleno;
+  uint16_t rellenoDesde;
+};
+
+extern ModeloGateway modeloGateway;
+extern CostesHost costesHost;
+
+// Deja el nodo como recién flasheado: archivo vacío y estadísticas a cero
+void iniciarNodoHost(NodoHost &nodo, GatewaySimulado *gateway);
+// Nodo al que van las llamadas de hal.h desde el hilo actual
+void usarNodoHost(NodoHost *nodo);
+
+// Nodo por defecto con un GatewayAleatorio sobre modeloGateway
+void iniciarHalHost(uint32_t semilla);
+GatewayAleatorio &gatewayHost();
+// Llamar antes de cada setup(); devuelve cómo terminó el despertar después
+void empezarDespertarHost();
+FinDespertar finDespertarHost();
+const EstadisticasHost &estadisticasHost();
+size_t bytesAlmacenHost();
+
+// Registros de un lote de src/lote.h (para contar lo confirmado); 0 si no es un lote válido.
+// Lo decodifica con JsonDocument en el heap: en el nodo no hace falta.
+size_t registrosLote(const uint8_t *datos, size_t bytes);
+
+#endif
@@ -0,0 +1,103 @@
+#include "pool_trabajo.h"
+
+// Índice del hilo del pool que está ejecutando, -1 fuera del pool
+static thread_local int hiloActual = -1;
+static thread_local PoolTrabajo *poolActual = nullptr;
+
+PoolTrabajo::PoolTrabajo(unsigned hilos)
+    : _colas(hilos ? hilos : 1), _pendientes(0), _robos(0), _turno(0), _parar(false)
+{
+  for (unsigned i = 0; i < _colas.size(); i++)
+    _hilos.emplace_back(&PoolTrabajo::trabajar, this, i);
+}
+
+PoolTrabajo::~PoolTrabajo()
+{
+  esperar();
+  {
+    std::lock_guard<std::mutex> l(_m);
+    _parar = true;
+  }
+  _hayTrabajo.notify_all();
+  for (std::thread &h : _hilos)
+    h.join();
+}
+
+void PoolTrabajo::encolar(std::function<void()> tarea)
+{
+  unsigned i = poolActual == this ? (unsigned)hiloActual : _turno++ % _colas.size();
+  _pendientes++;
+  {
+    std::lock_guard<std::mutex> l(_colas[i].m);
+    _colas[i].tareas.push_back(std::move(tarea));
+  }
+  // Bajo _m para que un hilo que va a dormir no se pierda el aviso
+  std::lock_guard<std::mutex> l(_m);
+  _hayTrabajo.notify_one();
+}
+
+void PoolTrabajo::esperar()
+{
+  std::unique_lock<std::mutex> l(_m);
+  _vacio.wait(l, [this] { return _pendientes == 0; });
+}
+
+bool PoolTrabajo::sacar(unsigned indice, std::function<void()> &tarea)
+{
+  {
+    Cola &propia = _colas[indice];
+    std::lock_guard<std::mutex> l(propia.m);
+    if (!propia.tareas.empty())
+    {
+      tarea = std::move(propia.tareas.back());
+      propia.tareas.pop_back();
+      return true;
+    }
+  }
+  for (unsigned k = 1; k < _colas.size(); k++)
+  {
+    Cola &victima = _colas[(indice + k) % _colas.size()];
+    std::lock_guard<std::mutex> l(victima.m);
+    if (!victima.tareas.empty())
+    {
+      tarea = std::move(victima.tareas.front());
+      victima.tareas.pop_front();
+      _robos++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void PoolTrabajo::trabajar(unsigned indice)
+{
+  hiloActual = (int)indice;
+  poolActual = this;
+  std::function<void()> tarea;
+  while (true)
+  {
+    if (sacar(indice, tarea))
+    {
+      tarea();
+      tarea = nullptr;
+      if (--_pendientes == 0)
+      {
+        std::lock_guard<std::mutex> l(_m);
+        _vacio.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> l(_m);
+    if (_parar)
+      return;
+    // Se vuelve a mirar con _m tomado: encolar() avisa con _m, así que no hay carrera
+    bool hay = false;
+    for (Cola &c : _colas)
+    {
+      std::lock_guard<std::mutex> lc(c.m);
+      hay |= !c.tareas.empty();
+    }
+    if (!hay)
+      _hayTrabajo.wait(l);
+  }
+}
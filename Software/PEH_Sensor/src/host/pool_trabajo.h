@@ -0,0 +1,52 @@
+// Pool de hilos con robo de trabajo para los simuladores del host. Cada hilo tiene su
+// propia cola: encola y saca por el final (lo último que encoló, aún en caché) y, cuando
+// se queda sin nada, roba por el principio de la cola de otro hilo. Lo que se encola
+// desde fuera del pool se reparte por turnos.
+
+#ifndef POOL_TRABAJO_H
+#define POOL_TRABAJO_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class PoolTrabajo
+{
+public:
+  explicit PoolTrabajo(unsigned hilos);
+  ~PoolTrabajo();
+
+  void encolar(std::function<void()> tarea);
+  // Vuelve cuando no queda ninguna tarea en cola ni en curso
+  void esperar();
+
+  unsigned hilos() const { return (unsigned)_hilos.size(); }
+  uint64_t robos() const { return _robos; }
+
+private:
+  struct Cola
+  {
+    std::mutex m;
+    std::deque<std::function<void()>> tareas;
+  };
+
+  void trabajar(unsigned indice);
+  bool sacar(unsigned indice, std::function<void()> &tarea);
+
+  std::vector<std::thread> _hilos;
+  std::vector<Cola> _colas;
+  std::atomic<uint64_t> _pendientes; // en cola o en curso
+  std::atomic<uint64_t> _robos;
+  std::atomic<unsigned> _turno;
+  std::atomic<bool> _parar;
+  std::mutex _m;
+  std::condition_variable _hayTrabajo;
+  std::condition_variable _vacio;
+};
+
+#endif
@@ -0,0 +1,483 @@
+// Simulador de flota en el host ([env:native_flota]): muchos nodos con main.cpp entero,
+// cada uno con su reloj virtual, su traza de sensores, su flash y su enlace BLE, frente a
+// un único gateway con un número limitado de conexiones simultáneas. Da, por tamaño de
+// flota, el caudal de drenaje, el crecimiento del backlog y la contención en el aire.
+//
+//   pio run -e native_flota && .pio/build/native_flota/program [nodos] [dias] [ranuras] [hilos] [semilla]
+//
+// nodos admite una lista (5,10,20,50): una fila por tamaño de flota con el mismo resto de
+// parámetros. NUM_REGISTROS, BLE_TIMEOUT_SECONDS y el ciclo se fijan en build_flags.
+//
+// Cómo se reparte: cada hilo del pool lleva su propia copia del firmware (RTC_DATA_ATTR
+// y RAM_NODO son thread_local en el host) y un nodo pasa de un hilo a otro llevándose
+// su memoria RTC, su NodoHost y sus sensores simulados. Los nodos solo se influyen a
+// través del gateway, así que cada uno avanza por su cuenta hasta que un despertar
+// intenta drenar. Ese despertar se deshace (antes del drenaje la flash solo crece) y el
+// nodo queda aparcado hasta que ningún otro nodo pueda anunciarse antes que él; entonces
+// se repite con permiso. Los drenajes se resuelven así en orden de tiempo virtual y el
+// resultado no depende del número de hilos.
+
+#include <stdlib.h>
+#include <chrono>
+#include <set>
+#include <string>
+#include <Wire.h>
+#include "sensores.h"
+#include "hal_host.h"
+#include "entorno.h"
+#include "pool_trabajo.h"
+
+#if !defined(NUM_REGISTROS) || !defined(BLE_TIMEOUT_SECONDS) || !defined(MEASURE_CYCLE_MINUTES)
+#error "native_flota: fijar NUM_REGISTROS, BLE_TIMEOUT_SECONDS y MEASURE_CYCLE_MINUTES en build_flags"
+#endif
+
+void setup();
+extern RAM_NODO double perfilUltimoCicloMJ; // main.cpp, al cerrar cada ciclo
+
+// Lanzada desde el transporte cuando un nodo sin permiso intenta anunciarse
+struct DrenajeAplazado
+{
+};
+
+// --- GATEWAY ---
+// Atiende a la vez tantos nodos como ranuras. Un nodo que se anuncia se conecta tras la
+// latencia de escaneo o, si están todas ocupadas, cuando se libera la primera; si se
+// rinde antes, la ranura vuelve a quedar como estaba. Solo se llama desde despertares con
+// permiso, que van de uno en uno y en orden de tiempo virtual.
+struct GatewayFlota
+{
+  ModeloGateway modelo;
+  std::vector<uint64_t> libreUs; // por ranura; NUNCA mientras hay alguien conectado
+
+  uint64_t anuncios;
+  uint64_t conexiones;
+  uint64_t rendidosSinRanura; // se rindieron con el gateway lleno
+  uint64_t esperaRanuraUs;
+  uint64_t ocupadoUs;
+  std::vector<std::pair<uint64_t, uint64_t>> intervalosAnuncio; // para el solape en el aire
+};
+
+class EnlaceFlota : public GatewaySimulado
+{
+public:
+  GatewayFlota *gateway = nullptr;
+  uint32_t azar = 1;
+  bool autorizado = false;
+
+  uint64_t anunciar(uint64_t ahoraUs) override
+  {
+    if (!autorizado)
+      throw DrenajeAplazado();
+    GatewayFlota &g = *gateway;
+    _anuncioUs = ahoraUs;
+    _visibleUs = ahoraUs + 1000ULL * azarHostEntre(azar, g.modelo.conexionMinMs, g.modelo.conexionMaxMs);
+    _ranura = 0;
+    for (size_t i = 1; i < g.libreUs.size(); i++)
+      if (g.libreUs[i] < g.libreUs[_ranura])
+        _ranura = i;
+    _libreAntesUs = g.libreUs[_ranura];
+    g.libreUs[_ranura] = NUNCA;
+    g.anuncios++;
+    return max(_visibleUs, _libreAntesUs);
+  }
+
+  uint64_t notificar(uint64_t ahoraUs, size_t, size_t) override
+  {
+    bool perdido = azarHostUnidad(azar) < gateway->modelo.probabilidadPerdidaAck;
+    uint64_t ackUs = ahoraUs + 1000ULL * azarHostEntre(azar, gateway->modelo.ackMinMs, gateway->modelo.ackMaxMs);
+    return perdido ? NUNCA : ackUs;
+  }
+
+  void desconectar(uint64_t ahoraUs, uint64_t conexionUs) override
+  {
+    GatewayFlota &g = *gateway;
+    if (conexionUs == NUNCA)
+    {
+      g.libreUs[_ranura] = _libreAntesUs;
+      if (_libreAntesUs > _visibleUs)
+        g.rendidosSinRanura++;
+      g.intervalosAnuncio.push_back({_anuncioUs, ahoraUs});
+      return;
+    }
+    g.libreUs[_ranura] = ahoraUs;
+    g.conexiones++;
+    g.esperaRanuraUs += conexionUs - _visibleUs;
+    g.ocupadoUs += ahoraUs - conexionUs;
+    g.intervalosAnuncio.push_back({_anuncioUs, conexionUs});
+  }
+
+private:
+  uint64_t _anuncioUs = 0;
+  uint64_t _visibleUs = 0;
+  size_t _ranura = 0;
+  uint64_t _libreAntesUs = 0;
+};
+
+// --- NODOS ---
+struct NodoFlota
+{
+  uint32_t id;
+  NodoHost hal;
+  EnlaceFlota enlace;
+  EntornoNodo entorno;
+  Shtc3Simulado shtc3;
+  Veml7700Simulado veml;
+  Ina226Simulado ina;
+  std::vector<uint8_t> rtc;
+  uint64_t relojUs;
+  uint64_t cotaUs; // no se anunciará antes; vale mientras el nodo no está aparcado
+
+  uint64_t despertares;
+  uint64_t despiertoUs;
+  double despiertoMJ;
+  uint64_t repeticiones; // despertares deshechos para drenar en orden
+  bool mitadMedida;
+  size_t bytesMitad; // backlog a mitad de la simulación
+};
+
+typedef std::pair<uint64_t, uint32_t> ClaveNodo; // (tiempo, id): desempata nodos con el mismo tiempo
+
+struct ResultadoFlota
+{
+  double segundosReales;
+  uint64_t despertares;
+  uint64_t repeticiones;
+  uint64_t robos;
+};
+
+class Flota
+{
+public:
+  Flota(uint32_t nodos, double dias, uint32_t ranuras, uint32_t semilla);
+  ResultadoFlota ejecutar(PoolTrabajo &pool);
+  void informe(const ResultadoFlota &r, bool cabecera) const;
+
+private:
+  void correr(NodoFlota &n);
+  void despertar(NodoFlota &n);
+  void moverCota(NodoFlota &n, uint64_t nuevaUs);
+  void despachar();
+
+  std::vector<NodoFlota> _nodos;
+  GatewayFlota _gateway;
+  uint64_t _finUs;
+  std::vector<uint8_t> _imagenInicialRTC;
+  PoolTrabajo *_pool = nullptr;
+
+  std::mutex _m;
+  std::set<ClaveNodo> _corriendo;
+  std::set<ClaveNodo> _aparcados;
+  std::atomic<uint64_t> _minAparcadoUs;
+  std::atomic<bool> _fallo;
+};
+
+Flota::Flota(uint32_t nodos, double dias, uint32_t ranuras, uint32_t semilla)
+    : _nodos(nodos), _finUs((uint64_t)(dias * US_POR_DIA)), _minAparcadoUs(NUNCA), _fallo(false)
+{
+  _gateway.modelo = modeloGateway;
+  _gateway.libreUs.assign(ranuras ? ranuras : 1, 0);
+  _gateway.anuncios = _gateway.conexiones = _gateway.rendidosSinRanura = 0;
+  _gateway.esperaRanuraUs = _gateway.ocupadoUs = 0;
+
+  // El hilo principal no ha ejecutado nunca el firmware: su RTC es la de un arranque en frío
+  _imagenInicialRTC.resize(bytesMemoriaRTC());
+  copiarMemoriaRTC(_imagenInicialRTC.data());
+
+  uint32_t azar = semilla ? semilla : 1;
+  uint64_t cicloUs = (uint64_t)(MEASURE_CYCLE_MINUTES * 60e6);
+  for (uint32_t i = 0; i < nodos; i++)
+  {
+    NodoFlota &n = _nodos[i];
+    n.id = i;
+    n.enlace.gateway = &_gateway;
+    n.enlace.azar = azarHost(azar) | 1;
+    iniciarNodoHost(n.hal, &n.enlace);
+    iniciarEntorno(n.entorno, azarHost(azar));
+    n.rtc = _imagenInicialRTC;
+    // Cada nodo se enciende en un momento distinto del primer ciclo
+    n.relojUs = n.cotaUs = azarHost(azar) % cicloUs;
+    n.despertares = n.despiertoUs = n.repeticiones = 0;
+    n.despiertoMJ = 0;
+    n.mitadMedida = false;
+    n.bytesMitad = 0;
+  }
+}
+
+ResultadoFlota Flota::ejecutar(PoolTrabajo &pool)
+{
+  _pool = &pool;
+  uint64_t robosAntes = pool.robos();
+  auto inicio = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> l(_m);
+    for (NodoFlota &n : _nodos)
+    {
+      _corriendo.insert({n.cotaUs, n.id});
+      pool.encolar([this, &n] { correr(n); });
+    }
+  }
+  pool.esperar();
+
+  ResultadoFlota r;
+  r.segundosReales = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+  r.despertares = r.repeticiones = 0;
+  for (const NodoFlota &n : _nodos)
+  {
+    r.despertares += n.despertares;
+    r.repeticiones += n.repeticiones;
+  }
+  r.robos = pool.robos() - robosAntes;
+  if (_fallo || !_aparcados.empty() || !_corriendo.empty())
+  {
+    printf("flota de %zu nodos: la máquina de estados no terminó limpia\n", _nodos.size());
+    exit(1);
+  }
+  return r;
+}
+
+// Con _m tomado. El aparcado más antiguo puede drenar cuando ningún nodo en marcha puede
+// anunciarse antes que él. Al ponerlo en marcha su cota bloquea a los demás aparcados
+// hasta que termina ese despertar, así que los drenajes van de uno en uno.
+void Flota::despachar()
+{
+  while (!_aparcados.empty())
+  {
+    ClaveNodo primero = *_aparcados.begin();
+    if (!_corriendo.empty() && *_corriendo.begin() < primero)
+      break;
+    _aparcados.erase(_aparcados.begin());
+    NodoFlota &n = _nodos[primero.second];
+    n.enlace.autorizado = true;
+    n.cotaUs = primero.first;
+    _corriendo.insert(primero);
+    _pool->encolar([this, &n] { correr(n); });
+  }
+  _minAparcadoUs = _aparcados.empty() ? NUNCA : _aparcados.begin()->first;
+}
+
+void Flota::moverCota(NodoFlota &n, uint64_t nuevaUs)
+{
+  std::lock_guard<std::mutex> l(_m);
+  _corriendo.erase({n.cotaUs, n.id});
+  n.cotaUs = nuevaUs;
+  if (nuevaUs != NUNCA)
+    _corriendo.insert({nuevaUs, n.id});
+  despachar();
+}
+
+void Flota::despertar(NodoFlota &n)
+{
+  aplicarEntorno(n.entorno, relojHostUs(), n.shtc3, n.veml, n.ina);
+  uint64_t inicio = relojHostUs();
+  uint64_t suenoAntes = n.hal.estadisticas.suenoProfundoUs + n.hal.estadisticas.suenoLigeroUs;
+  arrancarHost();
+  avanzarRelojHost(T_ARRANQUE_US);
+  empezarDespertarHost();
+
+  setup();
+
+  uint64_t sueno = n.hal.estadisticas.suenoProfundoUs + n.hal.estadisticas.suenoLigeroUs - suenoAntes;
+  n.despiertoUs += relojHostUs() - inicio - sueno;
+  n.despiertoMJ += perfilUltimoCicloMJ;
+  n.despertares++;
+  if (finDespertarHost() == FIN_REINICIO)
+    cargarMemoriaRTC(_imagenInicialRTC.data());
+  else if (finDespertarHost() == FIN_NINGUNO)
+    _fallo = true;
+  n.relojUs = relojHostUs();
+  if (!n.mitadMedida && n.relojUs >= _finUs / 2)
+  {
+    n.mitadMedida = true;
+    n.bytesMitad = n.hal.archivo.size();
+  }
+}
+
+// Ejecuta el nodo en este hilo hasta el final de la simulación o hasta aparcarlo
+void Flota::correr(NodoFlota &n)
+{
+  static thread_local std::vector<uint8_t> copiaRTC;
+  usarNodoHost(&n.hal);
+  cargarMemoriaRTC(n.rtc.data());
+  fijarRelojHost(n.relojUs);
+  Wire.desconectar();
+  Wire1.desconectar();
+  WIRE_I2C(BUS_SHTC3).conectar(n.shtc3);
+  WIRE_I2C(BUS_VEML7700).conectar(n.veml);
+  WIRE_I2C(BUS_INA226).conectar(n.ina);
+  copiaRTC.resize(n.rtc.size());
+
+  while (n.relojUs < _finUs && !_fallo)
+  {
+    // Avisar de que ya se pasó el aparcado más antiguo; sin esto esperaría a que este
+    // nodo aparque o termine
+    if (!n.enlace.autorizado && n.relojUs > _minAparcadoUs && n.cotaUs < _minAparcadoUs)
+      moverCota(n, n.relojUs);
+
+    // Punto de restauración: hasta el drenaje, la flash solo crece
+    copiarMemoriaRTC(copiaRTC.data());
+    Shtc3Simulado shtc3 = n.shtc3;
+    Veml7700Simulado veml = n.veml;
+    Ina226Simulado ina = n.ina;
+    EntornoNodo entorno = n.entorno;
+    std::vector<uint8_t> archivo;
+    archivo.swap(n.hal.archivo);
+    NodoHost hal = n.hal;
+    archivo.swap(n.hal.archivo);
+    size_t bytesArchivo = n.hal.archivo.size();
+    uint64_t inicioUs = n.relojUs;
+
+    try
+    {
+      despertar(n);
+    }
+    catch (const DrenajeAplazado &)
+    {
+      if (n.hal.estadisticas.borrados != hal.estadisticas.borrados)
+      {
+        printf("nodo %u: borrado antes de anunciarse, no se puede repetir el despertar\n", n.id);
+        _fallo = true;
+        break;
+      }
+      cargarMemoriaRTC(copiaRTC.data());
+      n.shtc3 = shtc3;
+      n.veml = veml;
+      n.ina = ina;
+      n.entorno = entorno;
+      n.hal.archivo.resize(bytesArchivo);
+      hal.archivo.swap(n.hal.archivo);
+      n.hal = std::move(hal);
+      n.relojUs = inicioUs;
+      n.repeticiones++;
+      copiarMemoriaRTC(n.rtc.data());
+
+      std::lock_guard<std::mutex> l(_m);
+      _corriendo.erase({n.cotaUs, n.id});
+      _aparcados.insert({inicioUs, n.id});
+      despachar();
+      return;
+    }
+
+    if (n.enlace.autorizado)
+    {
+      n.enlace.autorizado = false;
+      moverCota(n, n.relojUs);
+    }
+  }
+
+  copiarMemoriaRTC(n.rtc.data());
+  moverCota(n, NUNCA);
+}
+
+// Fracción del tiempo de anuncio con dos o más nodos anunciándose a la vez y máximo simultáneo
+static void solapeAnuncios(const std::vector<std::pair<uint64_t, uint64_t>> &intervalos, double &fraccion,
+                            int &maximo)
+{
+  std::vector<std::pair<uint64_t, int>> eventos;
+  for (const auto &i : intervalos)
+  {
+    eventos.push_back({i.first, +1});
+    eventos.push_back({i.second, -1});
+  }
+  std::sort(eventos.begin(), eventos.end());
+  uint64_t total = 0, solapado = 0, anterior = 0;
+  int activos = 0;
+  maximo = 0;
+  for (const auto &e : eventos)
+  {
+    if (activos >= 1)
+      total += e.first - anterior;
+    if (activos >= 2)
+      solapado += e.first - anterior;
+    activos += e.second;
+    maximo = max(maximo, activos);
+    anterior = e.first;
+  }
+  fraccion = total ? (double)solapado / total : 0;
+}
+
+void Flota::informe(const ResultadoFlota &r, bool cabecera) const
+{
+  if (cabecera)
+    printf("%6s %9s %8s %8s %9s %8s %8s %7s %8s %9s %8s %8s %8s\n", "nodos", "reg/día", "entrega", "conex",
+           "espera s", "ocup", "solape", "max anc", "backlog", "crec/día", "radio s", "J/día", "nd/s");
+
+  double dias = (double)_finUs / US_POR_DIA;
+  uint64_t guardados = 0, pendientes = 0, intentos = 0, conexiones = 0, radioUs = 0;
+  size_t maxBacklog = 0;
+  double crecimiento = 0, energiaMJ = 0;
+  for (const NodoFlota &n : _nodos)
+  {
+    const EstadisticasHost &e = n.hal.estadisticas;
+    guardados += e.escrituras;
+    pendientes += n.hal.archivo.size() / sizeof(SensorData);
+    intentos += e.drenajesIntentados;
+    conexiones += e.conexiones;
+    radioUs += e.radioUs;
+    maxBacklog = max(maxBacklog, e.maxBytesAlmacen / sizeof(SensorData));
+    crecimiento += ((double)n.hal.archivo.size() - n.bytesMitad) / sizeof(SensorData) / (dias / 2);
+    energiaMJ += n.despiertoMJ +
+                 (e.suenoProfundoUs * CORRIENTE_SUENO_PROFUNDO_MA + e.suenoLigeroUs * CORRIENTE_SUENO_LIGERO_MA +
+                  e.ledUs * CORRIENTE_LED_MA) *
+                     TENSION_SIMULADA / 1e6;
+  }
+  size_t nodos = _nodos.size();
+  double solape;
+  int maxAnunciando;
+  solapeAnuncios(_gateway.intervalosAnuncio, solape, maxAnunciando);
+
+  printf("%6zu %9.0f %7.1f%% %7.1f%% %9.2f %7.1f%% %7.1f%% %7d %8zu %9.2f %8.1f %8.2f %8.0f\n", nodos,
+         (guardados - pendientes) / dias, guardados ? 100.0 * (guardados - pendientes) / guardados : 0,
+         intentos ? 100.0 * conexiones / intentos : 0,
+         _gateway.conexiones ? _gateway.esperaRanuraUs / 1e6 / _gateway.conexiones : 0,
+         100.0 * _gateway.ocupadoUs / (_finUs * (double)_gateway.libreUs.size()), 100.0 * solape, maxAnunciando,
+         maxBacklog, crecimiento / nodos, radioUs / 1e6 / dias / nodos, energiaMJ / 1000 / dias / nodos,
+         nodos * dias / r.segundosReales);
+}
+
+int main(int argc, char **argv)
+{
+  std::string listaNodos = argc > 1 ? argv[1] : "5,10,20,50";
+  double dias = argc > 2 ? atof(argv[2]) : 90;
+  uint32_t ranuras = argc > 3 ? (uint32_t)atoi(argv[3]) : 3;
+  unsigned hilos = argc > 4 ? (unsigned)atoi(argv[4]) : std::thread::hardware_concurrency();
+  uint32_t semilla = argc > 5 ? (uint32_t)strtoul(argv[5], nullptr, 10) : 1;
+
+  PoolTrabajo pool(hilos ? hilos : 1);
+  printf("flota: %.0f días, %u ranuras en el gateway, %u hilos, semilla %u\n", dias, ranuras, pool.hilos(),
+         semilla);
+  printf("NUM_REGISTROS=%d BLE_TIMEOUT_SECONDS=%d ciclo %.1f min\n\n", NUM_REGISTROS, BLE_TIMEOUT_SECONDS,
+         (double)MEASURE_CYCLE_MINUTES);
+
+  bool cabecera = true;
+  uint64_t despertares = 0, repeticiones = 0, robos = 0;
+  double segundos = 0;
+  size_t desde = 0;
+  while (desde < listaNodos.size())
+  {
+    size_t hasta = listaNodos.find(',', desde);
+    if (hasta == std::string::npos)
+      hasta = listaNodos.size();
+    uint32_t nodos = (uint32_t)atoi(listaNodos.substr(desde, hasta - desde).c_str());
+    desde = hasta + 1;
+    if (nodos == 0)
+      continue;
+
+    Flota flota(nodos, dias, ranuras, semilla);
+    ResultadoFlota r = flota.ejecutar(pool);
+    flota.informe(r, cabecera);
+    cabecera = false;
+    despertares += r.despertares;
+    repeticiones += r.repeticiones;
+    robos += r.robos;
+    segundos += r.segundosReales;
+  }
+
+  printf("\nreg/día: registros entregados por día en toda la flota; entrega: fracción de lo guardado\n");
+  printf("conex: drenajes que llegaron a conectarse; espera: media hasta ranura libre tras el escaneo\n");
+  printf("ocup: ranuras ocupadas; solape: tiempo de anuncio con otro nodo anunciándose a la vez\n");
+  printf("backlog: máximo de registros en flash de un nodo; crec/día: pendiente media en la segunda mitad\n");
+  printf("radio s y J/día: por nodo; nd/s: nodo-días simulados por segundo\n");
+  printf("\n%llu despertares en %.2f s, %llu repetidos para drenar en orden, %llu robos de trabajo\n",
+         (unsigned long long)despertares, segundos, (unsigned long long)repeticiones, (unsigned long long)robos);
+  return 0;
+}
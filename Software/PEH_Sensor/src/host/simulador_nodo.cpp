@@ -0,0 +1,157 @@
+// Simulador del nodo en el host ([env:native_nodo]): main.cpp entero (medida, filtro de
+// cambios, almacén, drenaje y sueño) sobre hal_host y los sensores simulados, en tiempo
+// virtual. Cada vuelta es un arranque: se llama a setup() y hal_host avanza el reloj lo
+// que dure el sueño; un reiniciarNodo() devuelve la memoria RTC a sus valores iniciales.
+// Sirve para comparar cambios de planificación o de protocolo en días simulados.
+//
+//   pio run -e native_nodo && .pio/build/native_nodo/program [dias] [semilla] [ajustes]
+//
+// `ajustes` ("ciclo_s,registros,paquete,timeout_s") los escribe el gateway simulado en la
+// primera conexión, como haría peh_gateway con la característica de ajustes. Con
+// -DMODO_ANUNCIO en build_flags el gateway simulado oye las difusiones y pide relleno.
+
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <Wire.h>
+#include <Shtc3Simulado.h>
+#include <Veml7700Simulado.h>
+#include <Ina226Simulado.h>
+#include "sensores.h"
+#include "hal_host.h"
+#include "entorno.h"
+#include "ajustes.h"
+#include "anuncio.h"
+
+void setup();
+extern RAM_NODO double perfilUltimoCicloMJ; // main.cpp, al cerrar cada ciclo
+
+Shtc3Simulado shtc3Sim;
+Veml7700Simulado vemlSim;
+Ina226Simulado inaSim;
+EntornoNodo entorno;
+
+int main(int argc, char **argv)
+{
+  double dias = argc > 1 ? atof(argv[1]) : 365;
+  uint32_t semilla = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1;
+  uint64_t finUs = (uint64_t)(dias * US_POR_DIA);
+
+  guardarMemoriaRTC();
+  iniciarHalHost(semilla);
+  iniciarEntorno(entorno, semilla);
+  WIRE_I2C(BUS_SHTC3).conectar(shtc3Sim);
+  WIRE_I2C(BUS_VEML7700).conectar(vemlSim);
+  WIRE_I2C(BUS_INA226).conectar(inaSim);
+
+  if (argc > 3)
+  {
+    unsigned ciclo, registros, paquete, timeout;
+    if (sscanf(argv[3], "%u,%u,%u,%u", &ciclo, &registros, &paquete, &timeout) != 4)
+    {
+      printf("ajustes: se esperaba ciclo_s,registros,paquete,timeout_s\n");
+      return 1;
+    }
+    AjustesNodo a;
+    memset(&a, 0, sizeof(a));
+    a.version = VERSION_AJUSTES;
+    a.tamPaquete = (uint8_t)paquete;
+    a.cicloS = (uint16_t)ciclo;
+    a.numRegistros = (uint16_t)registros;
+    a.timeoutBleS = (uint8_t)timeout;
+    a.gananciaVeml = GANANCIA_VEML_FABRICA;
+    a.integracionVeml = INTEGRACION_VEML_FABRICA;
+    a.crc = crcAjustes(a);
+    if (!ajustesValidos(a))
+    {
+      printf("ajustes fuera de rango\n");
+      return 1;
+    }
+    gatewayHost().programarAjustes((const uint8_t *)&a, sizeof(a));
+  }
+
+  uint64_t despertares = 0;
+  uint64_t reinicios = 0;
+  uint64_t despiertoUs = 0;
+  double despiertoMJ = 0;
+  auto inicioReal = std::chrono::steady_clock::now();
+
+  while (relojHostUs() < finUs)
+  {
+    aplicarEntorno(entorno, relojHostUs(), shtc3Sim, vemlSim, inaSim);
+    uint64_t inicio = relojHostUs();
+    uint64_t suenoAntes = estadisticasHost().suenoProfundoUs + estadisticasHost().suenoLigeroUs;
+    arrancarHost();
+    avanzarRelojHost(T_ARRANQUE_US);
+    empezarDespertarHost();
+
+    setup();
+
+    uint64_t sueno = estadisticasHost().suenoProfundoUs + estadisticasHost().suenoLigeroUs - suenoAntes;
+    despiertoUs += relojHostUs() - inicio - sueno;
+    despiertoMJ += perfilUltimoCicloMJ;
+    despertares++;
+    switch (finDespertarHost())
+    {
+    case FIN_REINICIO:
+      restaurarMemoriaRTC();
+      reinicios++;
+      break;
+    case FIN_SUENO_PROFUNDO:
+      break;
+    case FIN_NINGUNO:
+      printf("despertar %llu: setup() terminó sin dormir\n", (unsigned long long)despertares);
+      return 1;
+    }
+  }
+
+  double segundosReales = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicioReal).count();
+  const EstadisticasHost &e = estadisticasHost();
+  double diasSimulados = (double)relojHostUs() / US_POR_DIA;
+  uint64_t registrosConfirmados = e.registrosConfirmados;
+  uint64_t registrosPendientes = bytesAlmacenHost() / sizeof(SensorData);
+
+  double suenoMJ = (e.suenoProfundoUs * CORRIENTE_SUENO_PROFUNDO_MA + e.suenoLigeroUs * CORRIENTE_SUENO_LIGERO_MA) *
+                   TENSION_SIMULADA / 1e6;
+  double ledMJ = e.ledUs * CORRIENTE_LED_MA * TENSION_SIMULADA / 1e6;
+
+  printf("%.1f días simulados en %.3f s (%.0f días/s), semilla %u\n\n", diasSimulados, segundosReales,
+         diasSimulados / segundosReales, semilla);
+  printf("despertares          %10llu  (%.1f/día, %llu reinicios)\n", (unsigned long long)despertares,
+         despertares / diasSimulados, (unsigned long long)reinicios);
+  printf("despierto            %10.1f s/día\n", despiertoUs / 1e6 / diasSimulados);
+  printf("radio encendida      %10.1f s/día\n", e.radioUs / 1e6 / diasSimulados);
+  printf("LED encendido        %10.1f s/día\n", e.ledUs / 1e6 / diasSimulados);
+  printf("montajes de flash    %10.1f /día\n", e.montajes / diasSimulados);
+  printf("escrituras           %10.1f /día\n", e.escrituras / diasSimulados);
+  printf("escrituras en NVS    %10.1f /día (ajustes, diagnóstico, secuencia)\n", e.escriturasNvs / diasSimulados);
+  printf("drenajes             %10u intentados, %u con conexión\n", e.drenajesIntentados, e.conexiones);
+  printf("paquetes             %10u enviados, %u confirmados\n", e.paquetesEnviados, e.acks);
+  printf("registros            %10u guardados, %llu confirmados, %llu pendientes\n", e.escrituras,
+         (unsigned long long)registrosConfirmados, (unsigned long long)registrosPendientes);
+  if (registrosConfirmados + registrosPendientes > e.escrituras)
+    printf("                     %10llu confirmados más de una vez (reenvío tras drenaje parcial)\n",
+           (unsigned long long)(registrosConfirmados + registrosPendientes - e.escrituras));
+  if (registrosConfirmados)
+    printf("bytes de datos       %10.1f /registro confirmado\n", (double)e.bytesConfirmados / registrosConfirmados);
+  printf("almacén máximo       %10zu bytes\n", e.maxBytesAlmacen);
+  printf("energía              %10.2f J/día (despierto %.2f, sueño %.2f, LED %.2f)\n",
+         (despiertoMJ + suenoMJ + ledMJ) / 1000 / diasSimulados, despiertoMJ / 1000 / diasSimulados,
+         suenoMJ / 1000 / diasSimulados, ledMJ / 1000 / diasSimulados);
+  printf("diagnóstico I2C      %10u secuencias enviadas, la última %u\n", e.diagnosticos, e.ultimaSecuenciaDiag);
+  printf("ajustes              %10u recibidos (ciclo %u s, %u registros)\n", e.ajustesRecibidos, ajustes.cicloS,
+         ajustes.numRegistros);
+#ifdef MODO_ANUNCIO
+  printf("difusiones           %10.1f /día, %.1f ms de radio cada una\n", e.difusiones / diasSimulados,
+         EVENTOS_DIFUSION * costesHost.eventoDifusionUs / 1000.0);
+  printf("oídos por el gateway %10llu por difusión, %llu por relleno\n",
+         (unsigned long long)gatewayHost().oidosDifusion, (unsigned long long)gatewayHost().oidosRelleno);
+#endif
+  // Cada drenaje reinicia el nodo: la secuencia del diagnóstico tiene que seguir contando
+  if (e.saltosSecuenciaDiag > 0)
+  {
+    printf("diagnóstico I2C: %u secuencias no siguen a la anterior\n", e.saltosSecuenciaDiag);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include "lote.h"
+#include <ArduinoJson.h>
+
+using ArduinoJson::detail::MsgPackSerializer;
+using ArduinoJson::detail::Writer;
+
+// El serializador solo guarda un puntero al escritor y su cuenta: se crea en cada llamada.
+// Sin ResourceManager: los valores sueltos (números y cadenas) no lo usan.
+typedef MsgPackSerializer<Writer<EscritorLote>> SerializadorLote;
+
+void CodificadorLote::empezar(uint8_t registros)
+{
+  SerializadorLote msgpack(Writer<EscritorLote>(_escritor), nullptr);
+  esquema::cabeceraMsgPack(_escritor, 0x80, 0xDE, 3);
+  msgpack.visit("v");
+  msgpack.visit(ArduinoJson::JsonUInt(VERSION_LOTE));
+  msgpack.visit("c");
+  EsquemaSensorData::escribirNombresMsgPack(_escritor);
+  msgpack.visit("r");
+  esquema::cabeceraMsgPack(_escritor, 0x90, 0xDC, registros);
+  _faltan = registros;
+}
+
+void CodificadorLote::anadir(const SensorData &registro)
+{
+  if (_faltan == 0)
+  {
+    _faltan = 0xFF; // más de los anunciados: el lote ya no vale
+    return;
+  }
+  _faltan--;
+  EsquemaSensorData::escribirFilaMsgPack(registro, _escritor);
+}
+
+size_t CodificadorLote::terminar() const
+{
+  return _faltan == 0 && !_escritor.desbordado() ? _escritor.bytes() : 0;
+}
+
+size_t codificarLote(const SensorData *registros, uint8_t cantidad, uint8_t *destino, size_t capacidad)
+{
+  CodificadorLote lote(destino, capacidad);
+  lote.empezar(cantidad);
+  for (uint8_t i = 0; i < cantidad; i++)
+    lote.anadir(registros[i]);
+  return lote.terminar();
+}
@@ -0,0 +1,86 @@
+// Lotes de registros en MessagePack para la característica de lotes (LOTES_MSGPACK en
+// config.h). A diferencia del paquete crudo (SensorData tal cual, con su disposición y
+// endianness implícitas) el lote lleva la versión y el nombre de cada columna, así que el
+// gateway puede leer firmwares con campos nuevos o reordenados sin actualizarse a la vez:
+//
+//   {"v": 1, "c": ["temp", "humAir", "humSoil", "lux", "batt", "edadS"], "r": [[...], ...]}
+//
+// Columnas y filas salen del esquema de SensorData (lib/Esquema) y cada valor del
+// MsgPackSerializer de ArduinoJson: float32, o entero corto si el valor es entero (humSoil
+// en cuentas de ADC, los centinelas -99 y -1, edadS). Se escribe directamente en el buffer de la
+// notificación, sin JsonDocument ni heap.
+
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <Esquema.h>
+#include "sensores.h"
+
+CAMPO_ESQUEMA(SensorData, temp);
+CAMPO_ESQUEMA(SensorData, humAir);
+CAMPO_ESQUEMA(SensorData, humSoil);
+CAMPO_ESQUEMA(SensorData, lux);
+CAMPO_ESQUEMA(SensorData, batt);
+// En el paquete tiempoS ya es la edad del registro (fijarEdades() en main.cpp)
+CAMPO_ESQUEMA_CLAVE(SensorData, tiempoS, edadS);
+typedef Esquema<CAMPO(SensorData, temp), CAMPO(SensorData, humAir), CAMPO(SensorData, humSoil),
+                CAMPO(SensorData, lux), CAMPO(SensorData, batt), CAMPO(SensorData, tiempoS)>
+    EsquemaSensorData;
+
+#define VERSION_LOTE 1
+#define NUM_COLUMNAS_LOTE EsquemaSensorData::NUM_CAMPOS
+#define MAX_BYTES_CABECERA_LOTE 48
+#define MAX_BYTES_FILA_LOTE (1 + NUM_COLUMNAS_LOTE * 5) // cabecera de array y float32 o uint32 con su tipo
+#define MAX_BYTES_LOTE(registros) (MAX_BYTES_CABECERA_LOTE + (registros) * MAX_BYTES_FILA_LOTE)
+
+// Destino del MsgPackSerializer: el buffer de la notificación. Si no cabe, no escribe y
+// devuelve 0, como un Print lleno.
+class EscritorLote
+{
+public:
+  EscritorLote(uint8_t *buffer, size_t capacidad) : _buffer(buffer), _capacidad(capacidad), _bytes(0), _desbordado(false) {}
+
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t *datos, size_t n)
+  {
+    if (_desbordado || n > _capacidad - _bytes)
+    {
+      _desbordado = true;
+      return 0;
+    }
+    memcpy(_buffer + _bytes, datos, n);
+    _bytes += n;
+    return n;
+  }
+
+  size_t bytes() const { return _bytes; }
+  bool desbordado() const { return _desbordado; }
+
+private:
+  uint8_t *_buffer;
+  size_t _capacidad;
+  size_t _bytes;
+  bool _desbordado;
+};
+
+// Codifica un lote registro a registro: empezar(n), n veces anadir() y terminar()
+class CodificadorLote
+{
+public:
+  CodificadorLote(uint8_t *buffer, size_t capacidad) : _escritor(buffer, capacidad), _faltan(0) {}
+
+  void empezar(uint8_t registros);
+  void anadir(const SensorData &registro);
+  size_t terminar() const; // bytes del lote; 0 si no cupo o no se añadieron los anunciados
+
+private:
+  EscritorLote _escritor;
+  uint8_t _faltan;
+};
+
+size_t codificarLote(const SensorData *registros, uint8_t cantidad, uint8_t *destino, size_t capacidad);
+
+#endif
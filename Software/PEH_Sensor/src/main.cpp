@@ -1,313 +1,346 @@
 #include <Arduino.h>
-#include <BLEDevice.h>
-#include <BLEServer.h>
-#include <BLEUtils.h>
-#include <BLE2902.h>
-
-#define DEVICE_ID "NODE_SENSOR"
-#define SERVICE_UUID "12345678-1234-1234-1234-1234567890ab"
-#define CHAR_ALL_SENSORS_UUID "0000aaaa-0000-1000-8000-00805f9b34fb"
-#define CHAR_ACK_UUID "0000aaff-0000-1000-8000-00805f9b34fb"
-
-#define PACKET_SIZE 5
-#define MEASURE_CYCLE_MINUTES 0.1
-#define BLE_TIMEOUT_SECONDS 20
-#define NUM_REGISTROS 10
-
-// ACTIVAR/DESACTIVAR DEBUG SERIAL
-// #define DEBUG_SERIAL
-
-#include <Wire.h>
-#include <SparkFun_SHTC3.h>
-#include <Adafruit_VEML7700.h>
-#include <INA226.h>
-#include <FS.h>
-#include <SPIFFS.h>
-#include <Adafruit_NeoPixel.h>
-
-#define SPIFFS_PATH "/sensores.dat"
-
-#define SDA_PIN 4
-#define SCL_PIN 5
-#define A_IN_SKU 6
-#define EN_SKU 7
-#define LED_PIN 48
-#define LED_COUNT 1
-Adafruit_NeoPixel pixel(LED_COUNT, LED_PIN, NEO_GRB + NEO_KHZ800);
-
-SHTC3 shtc3;
-Adafruit_VEML7700 veml = Adafruit_VEML7700();
-INA226 ina(0x40, &Wire);
-
-bool shtc3_ok = false;
-bool veml_ok = false;
-bool ina_ok = false;
-
-struct SensorData
-{
-  float temp;
-  float humAir;
-  float humSoil;
-  float lux;
-  float batt;
-};
 
-// BLE
-BLEServer *pServer;
-BLEService *pService;
-BLECharacteristic *pCharAllSensors;
-BLECharacteristic *pCharAck;
+// Ciclo, bloque de drenaje, tamaño de paquete, timeout BLE y VEML7700: src/ajustes.h
+
+// FILTRO DE CAMBIOS (deadband por campo respecto al último registro guardado)
+#define DEADBAND_TEMP 0.2      // ºC
+#define DEADBAND_HUM_AIRE 1.0  // %HR
+#define DEADBAND_HUM_SUELO 40  // cuentas ADC
+#define DEADBAND_LUX_ABS 2.0   // lux
+#define DEADBAND_LUX_REL 0.05  // fracción del último valor (la luz varía en órdenes de magnitud)
+#define DEADBAND_BATT 0.02     // V
+#define HEARTBEAT_CICLOS 6     // como máximo N-1 ciclos seguidos sin guardar
+
+// RELOJ DE CPU POR FASE (MHz válidos: 240, 160, 80, 40, 20, 10)
+// I2C, ADC y SPIFFS no necesitan cálculo: 80 MHz mantiene el APB a 80 MHz.
+// El stack BLE exige >= 80 MHz; 160 acorta la inicialización del controlador.
+#define CPU_MHZ_SENSORES 80
+#define CPU_MHZ_ALMACEN 80
+#define CPU_MHZ_BLE 160
+
+// Corrientes típicas del ESP32-S3 (mA, 3.3 V) para estimar la energía por ciclo.
+// Son valores aproximados de hoja de datos; sustituir por medidas del banco si las hay.
+#define CORRIENTE_240MHZ_MA 43.0
+#define CORRIENTE_160MHZ_MA 32.0
+#define CORRIENTE_80MHZ_MA 22.0
+#define CORRIENTE_40MHZ_MA 13.0
+#define CORRIENTE_RADIO_MA 40.0  // extra medio con BLE anunciando/conectado
+#define TENSION_ALIMENTACION 3.3
+
+#include "config.h"
+#include "hal.h"
+#include "sensores.h"
+#include "ajustes.h"
+#include "anuncio.h"
+#ifdef LOTES_MSGPACK
+#include "lote.h"
+#endif
 
-volatile bool ack_received = false;
+// El ULP hace bit-bang de un solo bus
+#if defined(USAR_ULP) && BUS_I2C_USADO(1)
+#error "USAR_ULP requiere los tres sensores en el bus 0"
+#endif
 
-// --- BLE CALLBACKS ---
-class MyServerCallbacks : public BLEServerCallbacks
-{
-  void onConnect(BLEServer *pServer)
-  {
-#ifdef DEBUG_SERIAL
-    Serial.println("Cliente BLE conectado.");
+#ifdef USAR_ULP
+#include "esp_idf_version.h"
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 1, 0)
+#error "USAR_ULP requiere ESP-IDF >= 5.1 (pio run -e esp32-s3-ulp)"
 #endif
-  }
-  void onDisconnect(BLEServer *pServer)
-  {
-#ifdef DEBUG_SERIAL
-    Serial.println("Cliente BLE desconectado.");
+#include "ulp_riscv.h"
+#include "ulp_riscv_adc.h"
+#include "driver/rtc_io.h"
+#include "ulp_main.h" // generado al embeber ulp/: ulp_estado
+#include "../ulp/muestreo_ulp.h"
+
+extern const uint8_t ulp_main_bin_start[] asm("_binary_ulp_main_bin_start");
+extern const uint8_t ulp_main_bin_end[] asm("_binary_ulp_main_bin_end");
 #endif
-  }
-};
 
-class AckCallbacks : public BLECharacteristicCallbacks
-{
-  void onWrite(BLECharacteristic *pCharacteristic)
-  {
-    std::string value = pCharacteristic->getValue();
-    if (value == "OK")
-    {
-      ack_received = true;
-#ifdef DEBUG_SERIAL
-      Serial.println("ACK recibido.");
+// Estado del filtro de cambios: sobrevive al deep sleep en memoria RTC y al reinicio de
+// cada bloque en NVS (guardarEstadoFiltro()). Tras un power-on el primer registro se
+// guarda siempre.
+#define CLAVE_NVS_FILTRO "filtro"
+RTC_DATA_ATTR SensorData ultimoGuardado;
+RTC_DATA_ATTR bool ultimoGuardadoValido = false;
+RTC_DATA_ATTR uint16_t ciclosSinGuardar = 0;
+RTC_DATA_ATTR uint32_t registrosDescartados = 0;
+
+// Registros en SPIFFS conocidos sin abrir el archivo (-1 = desconocido, hay que contarlos).
+// Permite que un despertar cuya medida cae en el deadband no monte SPIFFS.
+RTC_DATA_ATTR int registrosSPIFFS = -1;
+RAM_NODO bool spiffsMontado = false;
+
+// Registros del almacén medidos antes del último corte de alimentación: su tiempoS es de
+// un relojNodoS() que ya no existe y salen con EDAD_DESCONOCIDA. En NVS porque el almacén
+// sobrevive al corte y a los reinicios de cada bloque; vuelve a 0 al borrar el almacén.
+#define CLAVE_NVS_PREVIOS_CORTE "previosCorte"
+RTC_DATA_ATTR int registrosPreviosCorte = -1; // -1: sin leer de NVS
+
+#ifdef MODO_ANUNCIO
+// Secuencia del último registro guardado: el gateway ve con ella los huecos entre
+// difusiones y sitúa los registros del relleno (el último del almacén es el de la
+// secuencia). Pasa a NVS antes del reinicio de cada bloque; tras un corte se salta
+// SALTO_SECUENCIA para no repetir números ya difundidos.
+#define CLAVE_NVS_SECUENCIA "secuencia"
+#define SALTO_SECUENCIA 1024 // más que los guardados entre dos reinicios (MAX_NUM_REGISTROS)
+RTC_DATA_ATTR uint16_t secuenciaRegistros = 0;
+RTC_DATA_ATTR bool secuenciaValida = false;
+
+// El relleno por conexión espera a que el almacén tenga BLOQUES_RELLENO bloques: el
+// advertising conectable es lo que más radio gasta y las difusiones ya llevan los
+// registros. Va en cada bloque mientras el gateway pida registros en el relleno (pierde
+// difusiones) o queden registros de antes de un corte, que no se difunden. En NVS solo
+// cuando cambia.
+#define BLOQUES_RELLENO 4
+#define CLAVE_NVS_HUECOS "huecos"
+RTC_DATA_ATTR bool gatewayConHuecos = false;
 #endif
-    }
-  }
-};
 
-// --- BLE INIT ---
-void iniciarBLE()
+// --- PERFIL DE DESPERTAR Y RELOJ DE CPU ---
+// Cada fase del ciclo fija su frecuencia de CPU y el perfil mide cuánto dura.
+// Los acumulados en RTC dan la energía media por ciclo para comparar configuraciones.
+enum FaseDespertar
 {
-#ifdef DEBUG_SERIAL
-  Serial.println("Inicializando BLE...");
-#endif
-
-  BLEDevice::init(DEVICE_ID);
-  pServer = BLEDevice::createServer();
-  pServer->setCallbacks(new MyServerCallbacks());
-
-  pService = pServer->createService(SERVICE_UUID);
-
-  pCharAllSensors = pService->createCharacteristic(CHAR_ALL_SENSORS_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
-  BLE2902 *p2902 = new BLE2902();
-  pCharAllSensors->addDescriptor(p2902);
-
-  pCharAck = pService->createCharacteristic(CHAR_ACK_UUID, BLECharacteristic::PROPERTY_WRITE);
-  pCharAck->setCallbacks(new AckCallbacks());
-
-  pService->start();
+  FASE_ARRANQUE, // desde el arranque de la app hasta setup()
+  FASE_SENSORES,
+  FASE_ALMACEN,
+  FASE_BLE,
+  FASE_DORMIR,
+  NUM_FASES
+};
 
-  BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
-  pAdvertising->addServiceUUID(SERVICE_UUID);
-  pAdvertising->setScanResponse(true);
-  pAdvertising->setMinPreferred(0x06);
-  pAdvertising->setMinPreferred(0x12);
+const char *NOMBRE_FASE[NUM_FASES] = {"arranque", "sensores", "almacen", "ble", "dormir"};
 
-  BLEDevice::startAdvertising();
+RTC_DATA_ATTR uint32_t perfilCiclos = 0;
+RTC_DATA_ATTR uint64_t perfilAcumUs[NUM_FASES];
+RTC_DATA_ATTR double perfilAcumMJ[NUM_FASES];
+RTC_DATA_ATTR uint64_t perfilAcumPrimeraMuestraUs = 0;
 
-  pixel.setPixelColor(0, pixel.Color(55, 0, 0)); // 🔴 Rojo para advertising
-  pixel.show();
+RAM_NODO uint32_t perfilCicloUs[NUM_FASES];
+RAM_NODO double perfilCicloMJ[NUM_FASES];
+RAM_NODO double perfilUltimoCicloMJ = 0; // total del último ciclo cerrado (lo suma el simulador del host)
+RAM_NODO FaseDespertar faseActual = FASE_ARRANQUE;
+RAM_NODO uint32_t inicioFaseUs = 0;
 
-#ifdef DEBUG_SERIAL
-  Serial.println("BLE advertising activo.");
-#endif
+float corrienteEstimadaMA(uint32_t mhz, FaseDespertar fase)
+{
+  float i;
+  if (mhz >= 240)
+    i = CORRIENTE_240MHZ_MA;
+  else if (mhz >= 160)
+    i = CORRIENTE_160MHZ_MA;
+  else if (mhz >= 80)
+    i = CORRIENTE_80MHZ_MA;
+  else
+    i = CORRIENTE_40MHZ_MA;
+  if (fase == FASE_BLE)
+    i += CORRIENTE_RADIO_MA;
+  return i;
 }
 
-void pararBLE()
+void cerrarFase()
 {
-  BLEDevice::deinit(false);
-#ifdef DEBUG_SERIAL
-  Serial.println("BLE detenido.");
-#endif
+  uint32_t ahora = relojUs();
+  uint32_t dur = ahora - inicioFaseUs;
+  double mJ = corrienteEstimadaMA(cpuMhz(), faseActual) * TENSION_ALIMENTACION * dur / 1e6;
+  perfilCicloUs[faseActual] += dur;
+  perfilCicloMJ[faseActual] += mJ;
+  inicioFaseUs = ahora;
 }
 
-// --- UTILIDAD: desbloquear bus I2C ---
-void desbloquearBusI2C()
+// Cambia de fase: cierra la medida de la anterior y ajusta el reloj de la nueva.
+void entrarFase(FaseDespertar fase)
 {
-  Wire.end();
-  pinMode(SDA_PIN, INPUT_PULLUP);
-  pinMode(SCL_PIN, OUTPUT_OPEN_DRAIN);
-  digitalWrite(SCL_PIN, HIGH);
-  delay(1);
-  for (int i = 0; i < 9; i++)
+  cerrarFase();
+  faseActual = fase;
+
+  uint32_t mhz = 0;
+  switch (fase)
   {
-    digitalWrite(SCL_PIN, LOW);
-    delayMicroseconds(5);
-    digitalWrite(SCL_PIN, HIGH);
-    delayMicroseconds(5);
+  case FASE_SENSORES:
+    mhz = CPU_MHZ_SENSORES;
+    break;
+  case FASE_ALMACEN:
+    mhz = CPU_MHZ_ALMACEN;
+    break;
+  case FASE_BLE:
+    mhz = CPU_MHZ_BLE;
+    break;
+  default:
+    break;
   }
-  pinMode(SDA_PIN, OUTPUT_OPEN_DRAIN);
-  digitalWrite(SDA_PIN, LOW);
-  delayMicroseconds(5);
-  digitalWrite(SDA_PIN, HIGH);
-  delayMicroseconds(5);
+  if (mhz && cpuMhz() != mhz)
+    fijarCpuMhz(mhz);
 }
 
-// --- REINTENTO BEGIN ---
-template <typename SensorClass>
-bool intentarReintentoBegin(SensorClass &sensor, TwoWire *wire = &Wire, int intentos = 3)
+// Llamar justo antes de dormir: vuelca el ciclo a los acumulados RTC.
+void finalizarPerfil()
 {
-  for (int i = 0; i < intentos; i++)
+  cerrarFase();
+  perfilCiclos++;
+  perfilAcumPrimeraMuestraUs += primeraMuestraUs;
+  double totalMJ = 0;
+  for (int f = 0; f < NUM_FASES; f++)
   {
-    if (sensor.begin(wire))
-      return true;
-    delay(150);
+    perfilAcumUs[f] += perfilCicloUs[f];
+    perfilAcumMJ[f] += perfilCicloMJ[f];
+    totalMJ += perfilCicloMJ[f];
   }
-  return false;
-}
+  perfilUltimoCicloMJ = totalMJ;
 
-void parpadearVeces(int veces, uint32_t color = pixel.Color(0, 55, 0), int duracion = 150)
-{
-  for (int i = 0; i < veces; i++)
+#ifdef DEBUG_SERIAL
+  Serial.println("[PERFIL] fase       us ciclo   mJ ciclo   us medio   mJ medio");
+  double totalAcumMJ = 0;
+  for (int f = 0; f < NUM_FASES; f++)
   {
-    pixel.setPixelColor(0, color);
-    pixel.show();
-    delay(duracion);
-    pixel.clear();
-    pixel.show();
-    delay(duracion);
+    totalAcumMJ += perfilAcumMJ[f];
+    Serial.printf("[PERFIL] %-9s %9lu %10.3f %10lu %10.3f\n", NOMBRE_FASE[f],
+                  (unsigned long)perfilCicloUs[f], perfilCicloMJ[f],
+                  (unsigned long)(perfilAcumUs[f] / perfilCiclos), perfilAcumMJ[f] / perfilCiclos);
   }
+  Serial.printf("[PERFIL] total ciclo %.3f mJ | media %.3f mJ/ciclo en %lu ciclos\n",
+                totalMJ, totalAcumMJ / perfilCiclos, (unsigned long)perfilCiclos);
+  Serial.printf("[PERFIL] primera muestra a %lu us de la app (media %lu us)\n",
+                (unsigned long)primeraMuestraUs, (unsigned long)(perfilAcumPrimeraMuestraUs / perfilCiclos));
+#endif
 }
 
-// --- SENSORES ---
-void iniciarSensores()
+// Lo más que se espera a un efecto del LED antes de dormir
+#define ESPERA_MAX_LED_MS 2000
+
+// Parpadeos sin bloquear: siguen mientras se prepara el sueño
+void parpadearVeces(int veces, uint32_t color = COLOR_RGB(0, 55, 0), int duracion = 150)
 {
-  delay(100); // Espera tras I2C
+  const PasoLed parpadeo[] = {{color, (uint16_t)duracion}, {0, (uint16_t)duracion}};
+  ledEfecto(parpadeo, 2, veces);
+}
 
-  // --- SHTC3 SparkFun ---
-  shtc3_ok = (shtc3.begin(Wire) == SHTC3_Status_Nominal);
-  if (!shtc3_ok)
-  {
-#ifdef DEBUG_SERIAL
-    Serial.println("SHTC3 no encontrado.");
-#endif
-  }
+// Lo que quede del efecto se pasa en light sleep; ese tiempo no cuenta como despierto
+void esperarLed()
+{
+  inicioFaseUs += ledEsperarEfecto(ESPERA_MAX_LED_MS);
+  ledApagar();
+}
 
-  // --- VEML7700 ---
-  veml_ok = intentarReintentoBegin(veml);
-  if (veml_ok)
-  {
-    veml.setGain(VEML7700_GAIN_1);
-    veml.setIntegrationTime(VEML7700_IT_100MS);
-    veml.powerSaveEnable(true);
-  }
+// --- DIAGNÓSTICO I2C ---
+// bajadasVelocidadI2C vuelve a cero con la RTC en cada reinicio; el diagnóstico, que
+// sobrevive en NVS, suma solo las nuevas desde el último envío
+RTC_DATA_ATTR uint32_t bajadasDiagnosticadas = 0;
 
-  // --- INA226 ---
-  ina_ok = ina.begin();
-  if (ina_ok)
-  {
-    int status = ina.setMaxCurrentShunt(0.5, 0.1);
-    if (status != INA226_ERR_NONE)
-    {
+// Se notifica tras los datos; sin ACK: si se pierde, el siguiente drenaje lleva los acumulados
+void enviarDiagnosticoI2C()
+{
+  diagnosticoI2C.secuencia++;
+  uint32_t bajadas = diagnosticoI2C.bajadasVelocidad + (bajadasVelocidadI2C - bajadasDiagnosticadas);
+  diagnosticoI2C.bajadasVelocidad = min(bajadas, (uint32_t)UINT16_MAX);
+  bajadasDiagnosticadas = bajadasVelocidadI2C;
+  transporteEnviarDiagnostico((const uint8_t *)&diagnosticoI2C, sizeof(diagnosticoI2C));
 #ifdef DEBUG_SERIAL
-      Serial.printf("INA226 calibración fallida: código 0x%04X\n", status);
-#endif
-      ina_ok = false;
-    }
+  for (uint8_t d = 0; d < NUM_DISP_I2C; d++)
+  {
+    const SaludDispositivoI2C &s = diagnosticoI2C.dispositivos[d];
+    Serial.printf("[DIAG] %s 0x%02X: %lu transacciones, %u NACK, %u CRC, %u reintentos, %u recuperaciones | latencia",
+                  NOMBRE_DISP_I2C[d], s.direccion, (unsigned long)s.transacciones, s.nacks, s.erroresCRC,
+                  s.reintentos, s.recuperaciones);
+    for (uint8_t c = 0; c < NUM_CUBETAS_LATENCIA; c++)
+      Serial.printf(" %u", s.latencia[c]);
+    Serial.println();
   }
-
-#ifdef DEBUG_SERIAL
-  Serial.printf("SHTC3: %s | VEML7700: %s | INA226: %s\n",
-                shtc3_ok ? "OK" : "FAIL",
-                veml_ok ? "OK" : "FAIL",
-                ina_ok ? "OK" : "FAIL");
 #endif
 }
 
-SensorData leerSensores()
+// Montaje perezoso: solo se paga el montaje en los despertares que tocan la flash
+bool montarSPIFFS()
 {
-  SensorData data;
-
-  // --- SHTC3 (SparkFun) ---
-  if (shtc3_ok && shtc3.update() == SHTC3_Status_Nominal)
-  {
-    data.temp = shtc3.toDegC();
-    data.humAir = shtc3.toPercent();
-  }
-  else
-  {
-    data.temp = -99.0;
-    data.humAir = -1.0;
-  }
-
-  // --- VEML7700 ---
-  data.lux = veml_ok ? veml.readLux() : -1.0;
-
-  // --- INA226 ---
-  data.batt = ina_ok ? ina.getBusVoltage() : -1.0;
-
-  // --- Humedad del suelo
-  digitalWrite(EN_SKU, 1);
-  delay(100);
-  data.humSoil = analogRead(A_IN_SKU);
-  digitalWrite(EN_SKU, 0);
-
-  return data;
+  if (spiffsMontado)
+    return true;
+  spiffsMontado = almacenMontar();
+#ifdef DEBUG_SERIAL
+  if (!spiffsMontado)
+    Serial.println("Error al montar SPIFFS");
+#endif
+  return spiffsMontado;
 }
 
 int contarRegistrosSPIFFS()
 {
-  File file = SPIFFS.open(SPIFFS_PATH, FILE_READ);
-  if (!file)
+  if (registrosSPIFFS >= 0)
+    return registrosSPIFFS;
+  if (!montarSPIFFS())
     return 0;
-  int size = file.size();
-  file.close();
-  return size / sizeof(SensorData);
+  return registrosSPIFFS = almacenBytes() / sizeof(SensorData);
 }
 
 void borrarArchivoSPIFFS()
 {
-  SPIFFS.remove(SPIFFS_PATH);
+  if (!montarSPIFFS())
+    return;
+  almacenBorrar();
+  registrosSPIFFS = 0;
+  if (registrosPreviosCorte != 0)
+  {
+    registrosPreviosCorte = 0;
+    uint32_t ninguno = 0;
+    nvsGuardar(CLAVE_NVS_PREVIOS_CORTE, &ninguno, sizeof(ninguno));
+  }
+}
+
+// Una vez por arranque con la RTC perdida. Tras reiniciarNodo() vale lo de NVS; tras un
+// corte, todo lo que haya en el almacén es de antes.
+void cargarRegistrosPreviosCorte()
+{
+  if (registrosPreviosCorte >= 0)
+    return;
+  uint32_t previos = 0;
+  nvsLeer(CLAVE_NVS_PREVIOS_CORTE, &previos, sizeof(previos));
+  registrosPreviosCorte = previos;
+  if (reinicioPedido())
+    return;
+  int count = contarRegistrosSPIFFS();
+  if (count != registrosPreviosCorte)
+  {
+    registrosPreviosCorte = count;
+    previos = count;
+    nvsGuardar(CLAVE_NVS_PREVIOS_CORTE, &previos, sizeof(previos));
+  }
+#ifdef DEBUG_SERIAL
+  if (count > 0)
+    Serial.printf("Arranque tras un corte: %d registros sin hora en el almacén\n", count);
+#endif
 }
 
 bool leerPaqueteSPIFFS(int inicio, int cantidad, SensorData *destino)
 {
-  File file = SPIFFS.open(SPIFFS_PATH, FILE_READ);
-  if (!file)
+  if (!montarSPIFFS())
     return false;
-  file.seek(inicio * sizeof(SensorData));
+  return almacenLeer(inicio * sizeof(SensorData), destino, cantidad * sizeof(SensorData));
+}
+
+// --- ENVIAR PAQUETES ---
+// En el paquete tiempoS pasa a ser la edad del registro al enviarlo. `primero` es su
+// posición en el almacén.
+void fijarEdades(SensorData *registros, int cantidad, int primero)
+{
+  uint32_t ahora = relojNodoS();
   for (int i = 0; i < cantidad; i++)
   {
-    if (file.read((uint8_t *)&destino[i], sizeof(SensorData)) != sizeof(SensorData))
-    {
-      file.close();
-      return false;
-    }
+    uint32_t medido = registros[i].tiempoS;
+    registros[i].tiempoS = primero + i < registrosPreviosCorte || medido > ahora ? EDAD_DESCONOCIDA : ahora - medido;
   }
-  file.close();
-  return true;
 }
 
-// --- ENVIAR PAQUETES ---
-void enviarPaquetesSPIFFS()
+// Desde el registro `index` hasta el final; el archivo se borra entero al terminar
+void enviarPaquetesSPIFFS(int index)
 {
-  int total = contarRegistrosSPIFFS();
+  int total = contarRegistrosSPIFFS() - index;
 #ifdef DEBUG_SERIAL
-  Serial.printf("SPIFFS contiene %d registros\n", total);
+  Serial.printf("SPIFFS contiene %d registros, se envían %d\n", total + index, total);
 #endif
-  int index = 0;
 
   while (total > 0)
   {
-    int currentPacketSize = min(PACKET_SIZE, total);
-    SensorData packet[PACKET_SIZE];
+    int currentPacketSize = min((int)ajustes.tamPaquete, total);
+    SensorData packet[MAX_PACKET_SIZE];
 
     if (!leerPaqueteSPIFFS(index, currentPacketSize, packet))
     {
@@ -316,16 +349,23 @@ void enviarPaquetesSPIFFS()
 #endif
       return;
     }
+    fijarEdades(packet, currentPacketSize, index);
+
+#ifdef LOTES_MSGPACK
+    uint8_t lote[MAX_BYTES_LOTE(MAX_PACKET_SIZE)];
+    size_t bytesLote = codificarLote(packet, currentPacketSize, lote, sizeof(lote));
+    if (bytesLote == 0)
+      return; // no pasa con MAX_BYTES_LOTE: el peor caso cabe
+    transporteEnviarLote(lote, bytesLote);
+#else
+    transporteEnviarDatos((const uint8_t *)packet, currentPacketSize * sizeof(SensorData));
+#endif
 
-    ack_received = false;
-    pCharAllSensors->setValue((uint8_t *)packet, currentPacketSize * sizeof(SensorData));
-    pCharAllSensors->notify();
-
-    unsigned long ackStartTime = millis();
-    while (!ack_received && (millis() - ackStartTime) < 4000)
-      delay(10);
+    unsigned long ackStartTime = relojMs();
+    while (!transporteAckRecibido() && (relojMs() - ackStartTime) < 4000)
+      esperarMs(10);
 
-    if (ack_received)
+    if (transporteAckRecibido())
     {
 #ifdef DEBUG_SERIAL
       Serial.println("[SPIFFS] ACK OK → avanzando...");
@@ -348,119 +388,497 @@ void enviarPaquetesSPIFFS()
 #endif
 }
 
-void irSleep(int count)
+#ifdef USAR_ULP
+void arrancarULP(int registrosHastaBloque, uint64_t periodo_us);
+#endif
+void guardarEstadoFiltro();
+
+// finBloque: este despertar completó un bloque de registros (con o sin drenaje)
+void irSleep(int count, bool finBloque)
 {
-  Wire.end();
-  delay(100);
-  btStop();
+  entrarFase(FASE_DORMIR);
+  int numRegistros = ajustes.numRegistros;
+  if (count % numRegistros != 0)
+    parpadearVeces(count % numRegistros);
+  terminarBusesI2C();
+  esperarMs(100);
 
-  uint64_t sleep_us = (uint64_t)(MEASURE_CYCLE_MINUTES * 60ULL * 1000000ULL);
+  uint64_t sleep_us = cicloUs();
 
 #ifdef DEBUG_SERIAL
   Serial.printf("Ciclo %d → ", count);
 #endif
+  esperarLed(); // antes de programar el despertar: ledEsperarEfecto() lo anula
 
+#ifdef USAR_ULP
+  arrancarULP(numRegistros - count % numRegistros, sleep_us);
   esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
-  esp_sleep_enable_timer_wakeup(sleep_us);
+  esp_sleep_enable_ulp_wakeup();
+#else
+  programarDespertar(sleep_us);
+#endif
 
-  if (count % NUM_REGISTROS == 0)
+  // Una vez por bloque: con el filtro de cambios el contador puede quedarse varios ciclos en
+  // un múltiplo (drenaje fallido) o en 0 (almacén vacío), y esos se duermen en profundo
+  if (finBloque)
   {
 #ifdef DEBUG_SERIAL
-    Serial.printf("entrando en LIGHT sleep (%.2f min)...\n", MEASURE_CYCLE_MINUTES);
+    Serial.printf("entrando en LIGHT sleep (%.2f min)...\n", ajustes.cicloS / 60.0);
 #endif
-    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
-    esp_light_sleep_start();
+    finalizarPerfil();
+    dormirLigero();
 
     // 🔦 Señal de salida de light sleep (indicador visual)
-    pixel.setPixelColor(0, pixel.Color(0, 0, 255)); // Azul
-    pixel.show();
-    delay(250); 
-    pixel.clear();
-    pixel.show();
-
+    const PasoLed destello[] = {{COLOR_RGB(0, 0, 255), 250}, {0, 0}}; // Azul
+    ledEfecto(destello, 2, 1);
+    esperarLed();
+
+    guardarDiagnosticoI2C();
+    guardarEstadoFiltro();
+#ifdef MODO_ANUNCIO
+    nvsGuardar(CLAVE_NVS_SECUENCIA, &secuenciaRegistros, sizeof(secuenciaRegistros));
+#endif
 #ifdef DEBUG_SERIAL
     Serial.println("Reiniciando tras light sleep (fallback)");
 #endif
-    esp_restart();
+    reiniciarNodo();
   }
   else
   {
-    int numParpadeos = count % NUM_REGISTROS;
-    parpadearVeces(numParpadeos);
 #ifdef DEBUG_SERIAL
-    Serial.printf("entrando en DEEP sleep (%.2f min)...\n", MEASURE_CYCLE_MINUTES);
+    Serial.printf("entrando en DEEP sleep (%.2f min)...\n", ajustes.cicloS / 60.0);
 #endif
-    esp_deep_sleep_start();
+    finalizarPerfil();
+    dormirProfundo();
   }
 }
 
-void guardarEnSPIFFS(const SensorData &data)
+bool guardarEnSPIFFS(const SensorData &data)
 {
-  File file = SPIFFS.open(SPIFFS_PATH, FILE_APPEND);
-  if (!file)
-  {
+  if (!montarSPIFFS())
+    return false;
+  bool ok = almacenAnadir(&data, sizeof(SensorData));
 #ifdef DEBUG_SERIAL
-    Serial.println("Error abriendo archivo para guardar");
+  if (!ok)
+    Serial.println("Error escribiendo el registro");
+#endif
+#ifdef MODO_ANUNCIO
+  if (ok)
+    secuenciaRegistros++;
 #endif
+  // Una escritura parcial deja el tamaño del archivo en duda: se vuelve a contar
+  if (ok && registrosSPIFFS >= 0)
+    registrosSPIFFS++;
+  else if (!ok)
+    registrosSPIFFS = -1;
+  return ok;
+}
+
+// --- FILTRO DE CAMBIOS ---
+// Cada registro guardado lleva su tiempoS: entre dos registros el gateway ve cuántos ciclos
+// se quedaron en la banda
+bool fueraDeBanda(float actual, float anterior, float banda)
+{
+  return fabsf(actual - anterior) > banda;
+}
+
+// Decide si la medida merece un registro: hay cambio en algún campo o toca heartbeat.
+// Los valores centinela (-99, -1) de un sensor caído quedan siempre fuera de banda.
+bool debeGuardarse(const SensorData &data)
+{
+  if (!ultimoGuardadoValido || ciclosSinGuardar + 1 >= HEARTBEAT_CICLOS)
+    return true;
+
+  float bandaLux = max((float)DEADBAND_LUX_ABS, (float)DEADBAND_LUX_REL * fabsf(ultimoGuardado.lux));
+
+  return fueraDeBanda(data.temp, ultimoGuardado.temp, DEADBAND_TEMP) ||
+         fueraDeBanda(data.humAir, ultimoGuardado.humAir, DEADBAND_HUM_AIRE) ||
+         fueraDeBanda(data.humSoil, ultimoGuardado.humSoil, DEADBAND_HUM_SUELO) ||
+         fueraDeBanda(data.lux, ultimoGuardado.lux, bandaLux) ||
+         fueraDeBanda(data.batt, ultimoGuardado.batt, DEADBAND_BATT);
+}
+
+// Copia del estado del filtro que pasa el reinicio de cada bloque: sin ella el primer
+// despertar tras cada drenaje guardaría un registro aunque nada haya cambiado
+struct __attribute__((packed)) EstadoFiltro
+{
+  SensorData ultimo;
+  uint16_t ciclosSinGuardar;
+  uint32_t descartados;
+};
+
+void guardarEstadoFiltro()
+{
+  if (!ultimoGuardadoValido)
     return;
+  EstadoFiltro e = {ultimoGuardado, ciclosSinGuardar, registrosDescartados};
+  nvsGuardar(CLAVE_NVS_FILTRO, &e, sizeof(e));
+}
+
+// Solo tras reiniciarNodo(): tras un corte la copia puede ser de hace mucho
+void cargarEstadoFiltro()
+{
+  if (ultimoGuardadoValido || !reinicioPedido())
+    return;
+  EstadoFiltro e;
+  if (nvsLeer(CLAVE_NVS_FILTRO, &e, sizeof(e)) != sizeof(e))
+    return;
+  ultimoGuardado = e.ultimo;
+  ciclosSinGuardar = e.ciclosSinGuardar;
+  registrosDescartados = e.descartados;
+  ultimoGuardadoValido = true;
+}
+
+// Devuelve true si la medida se ha escrito en SPIFFS.
+bool filtrarYGuardar(const SensorData &data)
+{
+  if (!debeGuardarse(data))
+  {
+    ciclosSinGuardar++;
+    registrosDescartados++;
+    return false;
   }
-  file.write((uint8_t *)&data, sizeof(SensorData));
-  file.close();
+
+  if (!guardarEnSPIFFS(data))
+    return false;
+
+  ultimoGuardado = data;
+  ultimoGuardadoValido = true;
+  ciclosSinGuardar = 0;
+  return true;
+}
+
+#ifdef USAR_ULP
+// --- COPROCESADOR ULP ---
+estado_ulp_t *estadoULP()
+{
+  return (estado_ulp_t *)&ulp_estado;
+}
+
+SensorData convertirRegistroULP(const registro_ulp_t &r)
+{
+  SensorData data;
+  if (r.fallos & ULP_FALLO_SHTC3)
+  {
+    data.temp = -99.0;
+    data.humAir = -1.0;
+  }
+  else
+  {
+    data.temp = -45.0 + 175.0 * r.temp / 65536.0;
+    data.humAir = 100.0 * r.hum / 65536.0;
+  }
+  data.lux = (r.fallos & ULP_FALLO_VEML7700) ? -1.0 : r.als * luxPorCuentaVeml();
+  data.batt = (r.fallos & ULP_FALLO_INA226) ? -1.0 : r.vbus * 0.00125;
+  data.humSoil = r.suelo;
+  data.tiempoS = 0; // lo fija quien vuelca el buffer
+  return data;
+}
+
+// Pasa los registros del buffer RTC del ULP por el filtro de cambios y a SPIFFS.
+// También recupera el buffer tras un esp_restart(): la memoria RTC conserva la firma.
+int volcarBufferULP()
+{
+  estado_ulp_t *e = estadoULP();
+  if (e->firma != ULP_FIRMA)
+    return 0; // power-on: el programa ULP aún no se ha cargado
+
+  ulp_riscv_timer_stop();
+  int guardados = 0;
+  uint32_t n = min(e->num_registros, (uint32_t)ULP_BUFFER_REGISTROS);
+  // Una muestra por ciclo y la última justo antes de despertar al núcleo principal
+  uint32_t ahora = relojNodoS();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    SensorData data = convertirRegistroULP(e->buffer[i]);
+    uint32_t atras = (n - 1 - i) * ajustes.cicloS;
+    data.tiempoS = ahora > atras ? ahora - atras : 0;
+    if (filtrarYGuardar(data))
+      guardados++;
+  }
+  e->num_registros = 0;
+
+#ifdef DEBUG_SERIAL
+  Serial.printf("[ULP] %lu registros volcados (%d guardados), motivo %lu, %lu muestras, %lu err I2C, %lu err CRC\n",
+                (unsigned long)n, guardados, (unsigned long)e->motivo_despertar, (unsigned long)e->muestras,
+                (unsigned long)e->errores_i2c, (unsigned long)e->errores_crc);
+#endif
+  return guardados;
+}
+
+// Se llama con Wire ya liberado: el ULP pasa a controlar SDA/SCL por RTC GPIO.
+void arrancarULP(int registrosHastaBloque, uint64_t periodo_us)
+{
+  // Tras un despertar por ULP el programa sigue residente; en cualquier otro arranque se recarga
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_ULP)
+    ulp_riscv_load_binary(ulp_main_bin_start, ulp_main_bin_end - ulp_main_bin_start);
+
+  estado_ulp_t *e = estadoULP();
+  e->ciclos_hasta_drenaje = registrosHastaBloque;
+  e->num_registros = 0;
+
+  const gpio_num_t pinesBus[] = {(gpio_num_t)I2C0_SDA_PIN, (gpio_num_t)I2C0_SCL_PIN};
+  for (gpio_num_t pin : pinesBus)
+  {
+    rtc_gpio_init(pin);
+    rtc_gpio_set_direction(pin, RTC_GPIO_MODE_INPUT_OUTPUT_OD);
+    rtc_gpio_set_level(pin, 1);
+  }
+  rtc_gpio_init((gpio_num_t)EN_SKU);
+  rtc_gpio_set_direction((gpio_num_t)EN_SKU, RTC_GPIO_MODE_OUTPUT_ONLY);
+  rtc_gpio_set_level((gpio_num_t)EN_SKU, 0);
+
+  // Misma atenuación que analogRead() para que humSoil no cambie de escala
+  ulp_riscv_adc_cfg_t cfgAdc = {};
+  cfgAdc.adc_n = ADC_UNIT_1;
+  cfgAdc.channel = ADC_CHANNEL_5;
+  cfgAdc.atten = ADC_ATTEN_DB_11;
+  cfgAdc.width = ADC_BITWIDTH_12;
+  ulp_riscv_adc_init(&cfgAdc);
+
+  ulp_set_wakeup_period(0, periodo_us);
+  ulp_riscv_run();
+}
+#endif
+
+// --- AJUSTES REMOTOS ---
+// Se aplican tras el drenaje, todos a la vez: el drenaje en curso termina con los
+// anteriores. El nodo notifica siempre los vigentes para que el gateway sepa si ya están.
+void recibirAjustes()
+{
+  uint8_t blob[sizeof(AjustesNodo)];
+  size_t bytes = transporteAjustesRecibidos(blob, sizeof(blob));
+  if (bytes > 0)
+  {
+    uint8_t veml[2] = {ajustes.gananciaVeml, ajustes.integracionVeml};
+    bool aplicados = aplicarAjustes(blob, bytes);
+#ifdef DEBUG_SERIAL
+    Serial.printf("[AJUSTES] %s: ciclo %u s, %u registros, paquete %u, BLE %u s, VEML ganancia 0x%02X integración %u ms\n",
+                  aplicados ? "aplicados" : "rechazados", ajustes.cicloS, ajustes.numRegistros, ajustes.tamPaquete,
+                  ajustes.timeoutBleS, ajustes.gananciaVeml, msIntegracionVeml(ajustes.integracionVeml));
+#endif
+#ifdef USAR_ULP
+    // Con el ULP el VEML7700 solo se configura en frío: se reconfigura aquí si ha cambiado
+    if (aplicados && (veml[0] != ajustes.gananciaVeml || veml[1] != ajustes.integracionVeml))
+    {
+      iniciarBusesI2C();
+      iniciarSensores();
+    }
+#else
+    (void)veml;
+    (void)aplicados;
+#endif
+  }
+  transporteEnviarAjustes((const uint8_t *)&ajustes, sizeof(ajustes));
+}
+
+// --- ANUNCIO ---
+AnuncioNodo anuncioNodo(int count)
+{
+  AnuncioNodo anuncio;
+  anuncio.registrosPendientes = (uint16_t)min(count, 0xFFFF);
+  // La batería del último registro guardado: en RTC tanto con el ULP como sin él
+  anuncio.bateriaMv = ultimoGuardadoValido && ultimoGuardado.batt > 0 ? (uint16_t)(ultimoGuardado.batt * 1000) : 0;
+#ifdef MODO_ANUNCIO
+  anuncio.conSecuencia = true;
+  anuncio.secuencia = secuenciaRegistros;
+#else
+  anuncio.conSecuencia = false;
+  anuncio.secuencia = 0;
+#endif
+  return anuncio;
+}
+
+#ifdef MODO_ANUNCIO
+// --- DIFUSIÓN SIN CONEXIÓN ---
+void cargarSecuencia()
+{
+  if (secuenciaValida)
+    return;
+  uint16_t guardada = 0;
+  bool hay = nvsLeer(CLAVE_NVS_SECUENCIA, &guardada, sizeof(guardada)) == sizeof(guardada);
+  secuenciaRegistros = hay && !reinicioPedido() ? guardada + SALTO_SECUENCIA : guardada;
+  secuenciaValida = true;
+  uint8_t huecos = 0;
+  nvsLeer(CLAVE_NVS_HUECOS, &huecos, sizeof(huecos));
+  gatewayConHuecos = huecos != 0;
+#ifdef DEBUG_SERIAL
+  Serial.printf("[ANUNCIO] secuencia %u (%s)\n", secuenciaRegistros,
+                !hay ? "primera vez" : reinicioPedido() ? "de NVS" : "de NVS tras un corte");
+#endif
+}
+
+// Los últimos registros del almacén en un anuncio extendido: el gateway los recoge sin
+// conectarse. Tras un drenaje el almacén empieza vacío y van menos. Los de antes de un
+// corte no van: la secuencia saltó SALTO_SECUENCIA y no les corresponde ninguna.
+void difundirRegistros(int count)
+{
+  SensorData ultimos[REGISTROS_DIFUSION];
+  int cantidad = min(count - registrosPreviosCorte, REGISTROS_DIFUSION);
+  if (cantidad <= 0 || !leerPaqueteSPIFFS(count - cantidad, cantidad, ultimos))
+    return;
+  uint8_t datos[MAX_BYTES_ANUNCIO];
+  size_t bytes = codificarDifusion(anuncioNodo(count), ultimos, cantidad, relojNodoS(), datos, sizeof(datos));
+  if (bytes > 0)
+    transporteDifundir(datos, bytes, EVENTOS_DIFUSION);
+}
+
+void anotarHuecos(bool huecos)
+{
+  if (huecos == gatewayConHuecos)
+    return;
+  gatewayConHuecos = huecos;
+  uint8_t valor = huecos;
+  nvsGuardar(CLAVE_NVS_HUECOS, &valor, sizeof(valor));
+}
+
+// El bloque que completa `count` registros: ¿toca conectarse para el relleno?
+bool tocaRelleno(int count)
+{
+  return gatewayConHuecos || registrosPreviosCorte > 0 || count >= BLOQUES_RELLENO * ajustes.numRegistros;
+}
+
+// Primer registro del almacén que le falta al gateway; sin petición, el primero. Con
+// registros de antes de un corte en el almacén va todo: la petición solo sitúa los
+// posteriores, y los anteriores no se han difundido con esta secuencia.
+int inicioRelleno(int count)
+{
+  uint16_t desde;
+  bool pedido = transporteRellenoDesde(desde);
+  // Sin petición el gateway no recoge difusiones (la app): todo y relleno en cada bloque
+  uint16_t faltan = pedido ? secuenciaRegistros - desde + 1 : count; // módulo 2^16: 0 si lo tiene todo
+  anotarHuecos(faltan > 0);
+  if (!pedido || registrosPreviosCorte > 0)
+    return 0;
+  int inicio = faltan > count ? 0 : count - faltan; // pide algo que ya no está: todo
+#ifdef DEBUG_SERIAL
+  Serial.printf("[ANUNCIO] relleno desde la secuencia %u: %d de %d registros\n", desde, count - inicio, count);
+#endif
+  return inicio;
+}
+#endif
+
+// Lo que solo hace falta para guardar: tras la primera muestra, ya en FASE_ALMACEN. En un
+// arranque tras un corte cuenta el almacén (monta SPIFFS) y escribe NVS.
+void cargarPersistenciaAlmacen()
+{
+#ifdef MODO_ANUNCIO
+  cargarSecuencia();
+#endif
+  cargarRegistrosPreviosCorte(); // antes de guardar nada en este arranque
+  cargarEstadoFiltro();
 }
 
 // --- SETUP ---
 void setup()
 {
+  // Todo lo anterior a setup() (init del core Arduino) se atribuye a FASE_ARRANQUE.
+  // El estado en RAM se fija aquí y no solo en su definición: en el host setup() se
+  // llama una vez por despertar simulado sin reiniciar el proceso.
+  spiffsMontado = false;
+  faseActual = FASE_ARRANQUE;
+  memset(perfilCicloUs, 0, sizeof(perfilCicloUs));
+  memset(perfilCicloMJ, 0, sizeof(perfilCicloMJ));
+  inicioFaseUs = 0;
+
 #ifdef DEBUG_SERIAL
   Serial.begin(115200);
   while (!Serial)
   {
   }
-  pixel.begin(); // Inicializa el pin
-  pixel.clear(); // Apaga cualquier LED residual
-  pixel.show();
+  ledIniciar();
 
-  delay(200);
+  esperarMs(200);
   Serial.println("--- Ciclo de medida ---");
 #endif
-
-  if (!SPIFFS.begin(true))
+  // El reloj se fija antes de Wire.begin para que el divisor I2C se calcule con el APB final,
+  // y antes de cualquier carga: nada del despertar corre al reloj de arranque
+  entrarFase(FASE_SENSORES);
+  // Antes de la primera muestra solo lo que la necesita. Después de Serial.begin: con
+  // DEBUG_SERIAL informan de dónde salen.
+  cargarAjustes();        // ganancia e integración del VEML7700; en un despertar normal solo el CRC
+  cargarDiagnosticoI2C(); // antes de la primera transacción I2C
+  int guardados = 0;
+#ifdef USAR_ULP
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_ULP)
   {
-#ifdef DEBUG_SERIAL
-    Serial.println("Error al montar SPIFFS");
-#endif
+    // Arranque en frío: el núcleo principal deja configurados VEML7700 e INA226 para el ULP
+    comprobarBusI2CArranque();
+    iniciarBusesI2C();
+    iniciarSensores();
   }
-
-  desbloquearBusI2C();
-  Wire.begin(SDA_PIN, SCL_PIN);
+  entrarFase(FASE_ALMACEN);
+  cargarPersistenciaAlmacen();
+  guardados = volcarBufferULP();
+#else
+  comprobarBusI2CArranque();
+  iniciarBusesI2C();
   iniciarSensores();
 
   SensorData data = leerSensores();
-  guardarEnSPIFFS(data);
+  entrarFase(FASE_ALMACEN);
+  cargarPersistenciaAlmacen();
+  if (filtrarYGuardar(data))
+    guardados = 1;
+#endif
   int count = contarRegistrosSPIFFS();
 
 #ifdef DEBUG_SERIAL
-  Serial.printf("Guardada medida → Total en SPIFFS = %d\n", count);
+  if (guardados > 0)
+    Serial.printf("Guardadas %d medidas → Total en SPIFFS = %d\n", guardados, count);
+  else
+    Serial.printf("Medida dentro de deadband (%u ciclos sin guardar, %lu descartadas) → Total en SPIFFS = %d\n",
+                  ciclosSinGuardar, (unsigned long)registrosDescartados, count);
+  Serial.printf("[I2C] %lu arranques | recuperaciones: %lu al arrancar, %lu en ejecución | %lu reintentos (%lu fallidos)\n",
+                (unsigned long)estadisticasI2C.arranquesComprobados, (unsigned long)estadisticasI2C.recuperacionesArranque,
+                (unsigned long)estadisticasI2C.recuperacionesEjecucion, (unsigned long)estadisticasI2C.reintentos,
+                (unsigned long)estadisticasI2C.reintentosFallidos);
+  Serial.printf("[I2C] velocidades: SHTC3 %lu kHz | VEML7700 %lu kHz | INA226 %lu kHz | %lu bajadas\n",
+                (unsigned long)(velocidadI2C(DISP_SHTC3) / 1000), (unsigned long)(velocidadI2C(DISP_VEML7700) / 1000),
+                (unsigned long)(velocidadI2C(DISP_INA226) / 1000), (unsigned long)bajadasVelocidadI2C);
 #endif
 
-  if ((count % NUM_REGISTROS) == 0 && count > 0)
+#ifdef MODO_ANUNCIO
+  // Cada registro nuevo sale al aire con los anteriores; el drenaje por conexión de abajo
+  // queda como relleno de lo que el gateway no haya oído
+  if (guardados > 0)
+  {
+    entrarFase(FASE_BLE);
+    difundirRegistros(count);
+    entrarFase(FASE_ALMACEN);
+  }
+#endif
+
+  // Solo se intenta el envío en el despertar que completa un bloque de NUM_REGISTROS; si no se
+  // guardó nada, el contador de SPIFFS no ha cambiado y ese bloque ya se intentó antes.
+  // Con MODO_ANUNCIO, además, solo en los bloques en que toca el relleno.
+  int numRegistros = ajustes.numRegistros;
+  bool finBloque = guardados > 0 && count / numRegistros > (count - guardados) / numRegistros;
+  bool intentarEnvio = finBloque;
+#ifdef MODO_ANUNCIO
+  intentarEnvio = intentarEnvio && tocaRelleno(count);
+#endif
+  if (intentarEnvio)
   {
 #ifdef DEBUG_SERIAL
-    Serial.println("Cantidad de registros es múltiplo de " + String(NUM_REGISTROS) + " → intentar enviar BLE.");
+    Serial.printf("Cantidad de registros es múltiplo de %d → intentar enviar BLE.\n", numRegistros);
 #endif
 
-    iniciarBLE();
-    unsigned long startTime = millis();
+    entrarFase(FASE_BLE);
+    uint8_t fabricante[MAX_BYTES_ANUNCIO];
+    transporteIniciar(fabricante, codificarAnuncio(anuncioNodo(count), fabricante, sizeof(fabricante)));
+    ledColor(COLOR_RGB(55, 0, 0)); // 🔴 Rojo para advertising
+    unsigned long startTime = relojMs();
     bool connected = false;
 
-    while ((millis() - startTime) < (BLE_TIMEOUT_SECONDS * 1000))
+    while ((relojMs() - startTime) < (ajustes.timeoutBleS * 1000UL))
     {
-      if (pServer->getConnectedCount() > 0)
+      if (transporteConectado())
       {
         connected = true;
         break;
       }
-      delay(100);
+      esperarMs(100);
     }
 
     if (connected)
@@ -469,8 +887,19 @@ void setup()
       Serial.println("Conexión BLE establecida.");
       Serial.println("Esperando 1500 ms para que app active notify...");
 #endif
-      delay(1500);
-      enviarPaquetesSPIFFS();
+#ifdef MODO_ANUNCIO
+      // El gateway escribe el relleno tras activar las notificaciones: no hace falta
+      // esperar más, y si lo tiene todo el drenaje se queda en borrar el almacén
+      uint16_t desde;
+      for (uint32_t esperado = 0; esperado < 1500 && !transporteRellenoDesde(desde); esperado += 10)
+        esperarMs(10);
+      enviarPaquetesSPIFFS(inicioRelleno(count));
+#else
+      esperarMs(1500);
+      enviarPaquetesSPIFFS(0);
+#endif
+      enviarDiagnosticoI2C();
+      recibirAjustes();
     }
     else
     {
@@ -479,20 +908,22 @@ void setup()
 #endif
     }
 
-    pararBLE();
+    transporteParar();
+    ledApagar(); // el rojo del advertising seguía encendido durante el light sleep
+    entrarFase(FASE_ALMACEN);
   }
   else
   {
 #ifdef DEBUG_SERIAL
-    Serial.println("Cantidad de registros no es múltiplo de " + String(NUM_REGISTROS) + ". Volviendo a dormir.");
+    Serial.printf("Cantidad de registros no es múltiplo de %d. Volviendo a dormir.\n", numRegistros);
 #endif
   }
 
-  irSleep(count);
+  irSleep(count, finBloque);
 }
 
 void loop()
 {
   Serial.println("loop");
-  esp_restart();
+  reiniciarNodo();
 }
\ No newline at end of file
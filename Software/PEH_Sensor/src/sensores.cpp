@@ -0,0 +1,805 @@
+#include "sensores.h"
+#include "hal.h"
+#include "ajustes.h"
+#include <Wire.h>
+#include <SparkFun_SHTC3.h>
+#include <Adafruit_VEML7700.h>
+#include <INA226.h>
+
+#ifdef USAR_COLA_I2C
+#include <ColaI2C.h>
+#include <LecturasI2C.h>
+#include <BackendI2CEsp32.h>
+#include <BackendI2CWire.h>
+#endif
+
+// La cola intercala un solo bus
+#if defined(USAR_COLA_I2C) && (BUS_SHTC3 != BUS_INA226 || BUS_VEML7700 != BUS_INA226)
+#error "USAR_COLA_I2C requiere los tres sensores en el mismo bus"
+#endif
+
+RAM_NODO SHTC3 shtc3;
+RAM_NODO Adafruit_VEML7700 veml = Adafruit_VEML7700();
+RAM_NODO INA226 ina(0x40, &WIRE_I2C(BUS_INA226));
+
+RAM_NODO bool shtc3_ok = false;
+RAM_NODO bool veml_ok = false;
+RAM_NODO bool ina_ok = false;
+
+#ifdef USAR_COLA_I2C
+#ifdef BACKEND_I2C_ESP32
+// Core 2.x: el mismo driver de ESP-IDF que instala Wire, sin pasar por sus buffers
+BackendI2CEsp32 backendI2C(BUS_INA226 == 0 ? I2C_NUM_0 : I2C_NUM_1);
+#else
+// Core 3.x y host: a través de Wire
+BackendI2CWire backendI2C(WIRE_I2C(BUS_INA226));
+#endif
+ColaI2C colaI2C(backendI2C);
+RAM_NODO unsigned long vemlConfiguradoMs = 0;
+#endif
+
+RAM_NODO uint32_t primeraMuestraUs = 0;
+
+// Contadores de todo el bus (estadisticasI2C, bajadasVelocidadI2C). Con el INA226 en bus
+// propio su tarea de registro (otro núcleo) también los incrementa a través del reintento:
+// cada incremento va en una sección crítica. Lo demás que toca esa tarea es solo del INA226.
+#if INA226_EN_BUS_PROPIO
+static portMUX_TYPE muxContadoresI2C = portMUX_INITIALIZER_UNLOCKED;
+#define SUMAR_CONTADOR_I2C(contador)          \
+  do                                          \
+  {                                           \
+    portENTER_CRITICAL(&muxContadoresI2C);    \
+    (contador)++;                             \
+    portEXIT_CRITICAL(&muxContadoresI2C);     \
+  } while (0)
+#else
+#define SUMAR_CONTADOR_I2C(contador) ((contador)++)
+#endif
+
+// --- VELOCIDAD I2C POR DISPOSITIVO ---
+// Máximo de cada sensor en modo Fast. El HS-mode de 2.94 MHz del INA226 necesita un
+// código maestro que el controlador del ESP32-S3 no genera, así que su techo también es 400 kHz.
+#define I2C_HZ_MAX_SHTC3 400000
+#define I2C_HZ_MAX_VEML7700 400000
+#define I2C_HZ_MAX_INA226 400000
+// Despertares seguidos sin fallos tras los que se vuelve a probar el escalón superior
+#define I2C_CICLOS_PARA_SUBIR 50
+// Fija una velocidad para todos y compara el perfil de despertar entre compilaciones
+// #define I2C_HZ_FORZADO 100000
+
+const char *const NOMBRE_DISP_I2C[NUM_DISP_I2C] = {"SHTC3", "VEML7700", "INA226"};
+const uint32_t MAX_HZ_DISP_I2C[NUM_DISP_I2C] = {I2C_HZ_MAX_SHTC3, I2C_HZ_MAX_VEML7700, I2C_HZ_MAX_INA226};
+const uint8_t BUS_DISP_I2C[NUM_DISP_I2C] = {BUS_SHTC3, BUS_VEML7700, BUS_INA226};
+
+// Escalones de caída ante errores, de mayor a menor
+#define NUM_ESCALONES_I2C 3
+const uint32_t ESCALONES_I2C_HZ[NUM_ESCALONES_I2C] = {1000000, 400000, 100000};
+
+// Escalón en uso por dispositivo (0xFF = sin negociar, tras power-on) y racha sin fallos
+RTC_DATA_ATTR uint8_t escalonI2C[NUM_DISP_I2C] = {0xFF, 0xFF, 0xFF};
+RTC_DATA_ATTR uint16_t ciclosSinFalloI2C[NUM_DISP_I2C];
+RTC_DATA_ATTR uint32_t bajadasVelocidadI2C = 0;
+
+RAM_NODO bool falloI2CEsteCiclo[NUM_DISP_I2C];
+RAM_NODO uint32_t relojBusHz[NUM_BUSES_I2C];                  // 0 = desconocido, hay que fijarlo
+RAM_NODO int8_t dispositivoActivoI2C[NUM_BUSES_I2C] = {-1, -1}; // a quién atribuir un fallo en el gancho
+
+uint8_t escalonMaximoI2C(uint8_t disp)
+{
+  uint32_t techo = min((uint32_t)MAX_HZ_DISP_I2C[disp], (uint32_t)I2C_HZ_MAX_PLACA);
+  for (uint8_t i = 0; i < NUM_ESCALONES_I2C; i++)
+    if (ESCALONES_I2C_HZ[i] <= techo)
+      return i;
+  return NUM_ESCALONES_I2C - 1;
+}
+
+// Una vez por despertar: primera negociación tras power-on o subida tras una racha limpia
+void negociarVelocidadesI2C()
+{
+  for (uint8_t d = 0; d < NUM_DISP_I2C; d++)
+  {
+    falloI2CEsteCiclo[d] = false;
+    uint8_t maximo = escalonMaximoI2C(d);
+    if (escalonI2C[d] == 0xFF || escalonI2C[d] < maximo)
+    {
+      escalonI2C[d] = maximo;
+      ciclosSinFalloI2C[d] = 0;
+    }
+    else if (escalonI2C[d] > maximo && ciclosSinFalloI2C[d] >= I2C_CICLOS_PARA_SUBIR)
+    {
+      escalonI2C[d]--;
+      ciclosSinFalloI2C[d] = 0;
+    }
+  }
+  for (uint8_t bus = 0; bus < NUM_BUSES_I2C; bus++)
+    relojBusHz[bus] = 0;
+}
+
+uint32_t velocidadI2C(uint8_t disp)
+{
+#ifdef I2C_HZ_FORZADO
+  return I2C_HZ_FORZADO;
+#else
+  return ESCALONES_I2C_HZ[escalonI2C[disp]];
+#endif
+}
+
+// Antes de las transacciones de cada dispositivo: equivale a Adafruit_I2CDevice::setSpeed(),
+// que en ESP32 es Wire.setClock(), y solo reconfigura el controlador si cambia el reloj
+void usarDispositivoI2C(uint8_t disp)
+{
+  uint8_t bus = BUS_DISP_I2C[disp];
+  dispositivoActivoI2C[bus] = disp;
+  uint32_t hz = velocidadI2C(disp);
+  if (relojBusHz[bus] != hz)
+  {
+    WIRE_I2C(bus).setClock(hz);
+    relojBusHz[bus] = hz;
+  }
+}
+
+// Tras un fallo el dispositivo baja un escalón; false si ya estaba en el mínimo
+bool bajarVelocidadI2C(uint8_t disp)
+{
+  falloI2CEsteCiclo[disp] = true;
+  ciclosSinFalloI2C[disp] = 0;
+  if (escalonI2C[disp] + 1 >= NUM_ESCALONES_I2C)
+    return false;
+  escalonI2C[disp]++;
+  SUMAR_CONTADOR_I2C(bajadasVelocidadI2C);
+#ifdef DEBUG_SERIAL
+  Serial.printf("[I2C] %s baja a %lu kHz\n", NOMBRE_DISP_I2C[disp], (unsigned long)(ESCALONES_I2C_HZ[escalonI2C[disp]] / 1000));
+#endif
+  return true;
+}
+
+void cerrarCicloVelocidadI2C()
+{
+  for (uint8_t d = 0; d < NUM_DISP_I2C; d++)
+    if (!falloI2CEsteCiclo[d] && ciclosSinFalloI2C[d] < UINT16_MAX)
+      ciclosSinFalloI2C[d]++;
+}
+
+// --- SALUD DEL BUS I2C ---
+// Contadores por dispositivo e histograma de latencia de cada operación (lectura o
+// configuración completa, reintento incluido), acumulados desde el primer arranque.
+// Cada drenaje BLE adjunta una copia en CHAR_DIAG; el gateway calcula las diferencias.
+// Viven en RTC y pasan por NVS antes de cada reiniciarNodo(), que borra la RTC: si no,
+// la secuencia y los acumulados volverían a cero tras cada drenaje. Tras un corte se
+// pierde solo lo contado desde el último reinicio, que aún no se había enviado.
+#define CLAVE_NVS_DIAGNOSTICO "diagI2C"
+#define SALUD_I2C(direccion) {direccion, 0, 0, 0, 0, 0, 0, {}}
+RTC_DATA_ATTR DiagnosticoI2C diagnosticoI2C = {VERSION_DIAG_I2C, NUM_DISP_I2C, 0, 0,
+                                               {SALUD_I2C(0x70), SALUD_I2C(0x10), SALUD_I2C(0x40)},
+                                               {0, 0, 0, 0}};
+RTC_DATA_ATTR bool diagnosticoCargado = false;
+
+// Una vez por arranque con la RTC perdida; una copia de otra versión se descarta
+void cargarDiagnosticoI2C()
+{
+  if (diagnosticoCargado)
+    return;
+  diagnosticoCargado = true;
+  DiagnosticoI2C guardado;
+  if (nvsLeer(CLAVE_NVS_DIAGNOSTICO, &guardado, sizeof(guardado)) != sizeof(guardado) ||
+      guardado.version != VERSION_DIAG_I2C || guardado.numDispositivos != NUM_DISP_I2C)
+    return;
+  diagnosticoI2C = guardado;
+#ifdef DEBUG_SERIAL
+  Serial.printf("[DIAG] acumulados de NVS, secuencia %u\n", diagnosticoI2C.secuencia);
+#endif
+}
+
+void guardarDiagnosticoI2C()
+{
+  nvsGuardar(CLAVE_NVS_DIAGNOSTICO, &diagnosticoI2C, sizeof(diagnosticoI2C));
+}
+
+RAM_NODO uint32_t inicioOperacionI2CUs[NUM_DISP_I2C];
+// El gancho cuenta como error de bus los fallos que le llegan desde BusIO; los que
+// clasifica quien llama (CRC, getLastError) llegan por reintentarFalloContadoI2C()
+RAM_NODO bool falloClasificadoI2C[NUM_BUSES_I2C];
+// El fallo clasificado fue de datos (CRC): el bus respondió y no se baja la velocidad
+RAM_NODO bool falloDatosI2C[NUM_BUSES_I2C];
+
+// Macro y no función: los campos de la estructura empaquetada no admiten referencias
+#define SUMAR_SATURADO(contador) \
+  do                             \
+  {                              \
+    if ((contador) < UINT16_MAX) \
+      (contador)++;              \
+  } while (0)
+
+void iniciarOperacionI2C(uint8_t disp)
+{
+  usarDispositivoI2C(disp);
+  diagnosticoI2C.dispositivos[disp].transacciones++;
+  inicioOperacionI2CUs[disp] = micros();
+}
+
+void terminarOperacionI2C(uint8_t disp)
+{
+  uint32_t us = micros() - inicioOperacionI2CUs[disp];
+  uint8_t cubeta = 0;
+  for (uint32_t limite = LATENCIA_BASE_US; us >= limite && cubeta < NUM_CUBETAS_LATENCIA - 1; limite <<= 1)
+    cubeta++;
+  SUMAR_SATURADO(diagnosticoI2C.dispositivos[disp].latencia[cubeta]);
+}
+
+void registrarErrorBusI2C(uint8_t disp)
+{
+  SUMAR_SATURADO(diagnosticoI2C.dispositivos[disp].nacks);
+}
+
+void registrarErrorCRCI2C(uint8_t disp)
+{
+  SUMAR_SATURADO(diagnosticoI2C.dispositivos[disp].erroresCRC);
+}
+
+void registrarFalloSHTC3(SHTC3_Status_TypeDef estado)
+{
+  if (estado == SHTC3_Status_CRC_Fail)
+    registrarErrorCRCI2C(DISP_SHTC3);
+  else
+    registrarErrorBusI2C(DISP_SHTC3);
+}
+
+// --- RECUPERACIÓN DEL BUS I2C ---
+RTC_DATA_ATTR EstadisticasBusI2C estadisticasI2C;
+
+const uint8_t PIN_SDA_BUS[NUM_BUSES_I2C] = {I2C0_SDA_PIN, I2C1_SDA_PIN};
+const uint8_t PIN_SCL_BUS[NUM_BUSES_I2C] = {I2C0_SCL_PIN, I2C1_SCL_PIN};
+
+uint8_t busDeWire(TwoWire *wire)
+{
+  return wire == &Wire1 ? 1 : 0;
+}
+
+// Solo se arrancan los controladores que tienen algún sensor asignado
+void iniciarBusesI2C()
+{
+  for (uint8_t bus = 0; bus < NUM_BUSES_I2C; bus++)
+  {
+    if (BUS_I2C_USADO(bus))
+      WIRE_I2C(bus).begin(PIN_SDA_BUS[bus], PIN_SCL_BUS[bus]);
+    relojBusHz[bus] = 0;
+    dispositivoActivoI2C[bus] = -1;
+    falloClasificadoI2C[bus] = false;
+    falloDatosI2C[bus] = false;
+  }
+}
+
+void terminarBusesI2C()
+{
+  for (uint8_t bus = 0; bus < NUM_BUSES_I2C; bus++)
+    if (BUS_I2C_USADO(bus))
+      WIRE_I2C(bus).end();
+}
+
+// Un esclavo que se quedó a mitad de un byte mantiene SDA a nivel bajo. Con el bus libre
+// las dos líneas están altas por los pull-ups. digitalRead lee el pad aunque el pin esté
+// asignado al periférico I2C, así que sirve con Wire activo.
+bool busI2CBloqueado(uint8_t bus)
+{
+  return digitalRead(PIN_SDA_BUS[bus]) == LOW;
+}
+
+// Nueve pulsos de SCL liberan a cualquier esclavo a mitad de byte, luego un STOP
+void desbloquearBusI2C(uint8_t bus)
+{
+  uint8_t sda = PIN_SDA_BUS[bus];
+  uint8_t scl = PIN_SCL_BUS[bus];
+  WIRE_I2C(bus).end();
+  pinMode(sda, INPUT_PULLUP);
+  pinMode(scl, OUTPUT_OPEN_DRAIN);
+  digitalWrite(scl, HIGH);
+  delay(1);
+  for (int i = 0; i < 9; i++)
+  {
+    digitalWrite(scl, LOW);
+    delayMicroseconds(5);
+    digitalWrite(scl, HIGH);
+    delayMicroseconds(5);
+  }
+  pinMode(sda, OUTPUT_OPEN_DRAIN);
+  digitalWrite(sda, LOW);
+  delayMicroseconds(5);
+  digitalWrite(sda, HIGH);
+  delayMicroseconds(5);
+}
+
+// Arranque: solo se generan pulsos si SDA está retenida; el caso normal cuesta una lectura de pin
+void comprobarBusI2CArranque()
+{
+  SUMAR_CONTADOR_I2C(estadisticasI2C.arranquesComprobados);
+  for (uint8_t bus = 0; bus < NUM_BUSES_I2C; bus++)
+  {
+    if (!BUS_I2C_USADO(bus))
+      continue;
+    pinMode(PIN_SDA_BUS[bus], INPUT_PULLUP);
+    pinMode(PIN_SCL_BUS[bus], INPUT_PULLUP);
+    delayMicroseconds(5); // con el pull-up interno la línea tarda unos us en subir
+    if (busI2CBloqueado(bus))
+    {
+      SUMAR_CONTADOR_I2C(estadisticasI2C.recuperacionesArranque);
+      desbloquearBusI2C(bus);
+#ifdef DEBUG_SERIAL
+      Serial.printf("[I2C] SDA del bus %u retenida al arrancar → bus recuperado\n", bus);
+#endif
+    }
+  }
+}
+
+// Gancho de reintento de la capa de transacciones (Adafruit_I2CDevice y lecturas directas).
+// Se llama una vez por transferencia fallida; si SDA está retenida recupera el bus antes.
+// Tras un error de bus el reintento va un escalón de velocidad más abajo para el
+// dispositivo que falló; tras un CRC malo, a la misma velocidad.
+bool reintentarTransferenciaI2C(TwoWire *wire)
+{
+  uint8_t bus = busDeWire(wire);
+  int8_t disp = dispositivoActivoI2C[bus];
+  SUMAR_CONTADOR_I2C(estadisticasI2C.reintentos);
+  if (disp >= 0)
+  {
+    if (!falloClasificadoI2C[bus])
+      SUMAR_SATURADO(diagnosticoI2C.dispositivos[disp].nacks);
+    SUMAR_SATURADO(diagnosticoI2C.dispositivos[disp].reintentos);
+  }
+  bool errorBus = !falloDatosI2C[bus];
+  falloClasificadoI2C[bus] = false;
+  falloDatosI2C[bus] = false;
+  if (busI2CBloqueado(bus))
+  {
+    SUMAR_CONTADOR_I2C(estadisticasI2C.recuperacionesEjecucion);
+    if (disp >= 0)
+      SUMAR_SATURADO(diagnosticoI2C.dispositivos[disp].recuperaciones);
+    desbloquearBusI2C(bus);
+    wire->begin(PIN_SDA_BUS[bus], PIN_SCL_BUS[bus]);
+    relojBusHz[bus] = 0;
+    // Una escritura cortada a medias puede haber dejado otra configuración en el VEML7700
+    if (bus == BUS_VEML7700 && veml_ok)
+      veml.invalidateCache();
+#ifdef DEBUG_SERIAL
+    Serial.printf("[I2C] SDA del bus %u retenida tras fallo → bus recuperado\n", bus);
+#endif
+  }
+  if (disp >= 0)
+  {
+    if (errorBus)
+      bajarVelocidadI2C(disp);
+    usarDispositivoI2C(disp);
+  }
+  return true;
+}
+
+// Resultado del reintento de BusIO: un reintento fallido cuenta igual que en las lecturas
+// directas (error de bus del dispositivo y reintentosFallidos)
+void resultadoReintentoI2C(TwoWire *wire, bool ok)
+{
+  if (ok)
+    return;
+  int8_t disp = dispositivoActivoI2C[busDeWire(wire)];
+  if (disp >= 0)
+    registrarErrorBusI2C(disp);
+  SUMAR_CONTADOR_I2C(estadisticasI2C.reintentosFallidos);
+}
+
+// Reintento tras un fallo que quien llama ya ha contado (de CRC si `errorDatos`)
+bool reintentarFalloContadoI2C(uint8_t disp, bool errorDatos)
+{
+  falloClasificadoI2C[BUS_DISP_I2C[disp]] = true;
+  falloDatosI2C[BUS_DISP_I2C[disp]] = errorDatos;
+  return reintentarTransferenciaI2C(&WIRE_I2C(BUS_DISP_I2C[disp]));
+}
+
+// --- REINTENTO BEGIN ---
+// Cada intento fallido cuenta en la salud del dispositivo como error de bus y reintento.
+// `args` sigue al bus en la llamada a begin().
+#define INTENTOS_BEGIN 3
+
+template <typename SensorClass, typename... Args>
+bool intentarReintentoBegin(SensorClass &sensor, uint8_t disp, Args... args)
+{
+  for (int i = 0; i < INTENTOS_BEGIN; i++)
+  {
+    if (sensor.begin(&WIRE_I2C(BUS_DISP_I2C[disp]), args...))
+      return true;
+    registrarErrorBusI2C(disp);
+    if (i + 1 < INTENTOS_BEGIN)
+      SUMAR_SATURADO(diagnosticoI2C.dispositivos[disp].reintentos);
+    delay(150);
+  }
+  return false;
+}
+
+// --- SENSORES ---
+// Sin espera previa: los sensores están siempre alimentados y los drivers ya cubren sus
+// tiempos de arranque (SHTC3 wake 240 us, VEML7700 5 ms solo tras power-on del sensor).
+void iniciarSensores()
+{
+  Adafruit_I2CDevice::setRecoveryHook(reintentarTransferenciaI2C, resultadoReintentoI2C);
+  negociarVelocidadesI2C();
+
+  // --- SHTC3 SparkFun ---
+  iniciarOperacionI2C(DISP_SHTC3);
+  shtc3_ok = (shtc3.begin(WIRE_I2C(BUS_SHTC3)) == SHTC3_Status_Nominal);
+  if (!shtc3_ok)
+    registrarErrorBusI2C(DISP_SHTC3);
+  terminarOperacionI2C(DISP_SHTC3);
+  if (!shtc3_ok)
+  {
+#ifdef DEBUG_SERIAL
+    Serial.println("SHTC3 no encontrado.");
+#endif
+  }
+
+  // --- VEML7700 ---
+  iniciarOperacionI2C(DISP_VEML7700);
+  // begin() con los ajustes vigentes: una sola escritura de ALS_CONF por despertar y sin
+  // releer registros (caché de configuración de BusIO)
+  veml_ok = intentarReintentoBegin(veml, DISP_VEML7700, ajustes.gananciaVeml, ajustes.integracionVeml, true);
+#ifdef USAR_COLA_I2C
+  if (veml_ok)
+    vemlConfiguradoMs = millis();
+#endif
+  terminarOperacionI2C(DISP_VEML7700);
+
+  // --- INA226 ---
+  iniciarOperacionI2C(DISP_INA226);
+  ina_ok = ina.begin();
+  if (ina_ok)
+  {
+    int status = ina.setMaxCurrentShunt(0.5, 0.1);
+    if (status != INA226_ERR_NONE)
+    {
+#ifdef DEBUG_SERIAL
+      Serial.printf("INA226 calibración fallida: código 0x%04X\n", status);
+#endif
+      ina_ok = false;
+    }
+  }
+  if (!ina_ok)
+    registrarErrorBusI2C(DISP_INA226);
+  terminarOperacionI2C(DISP_INA226);
+
+#ifdef DEBUG_SERIAL
+  Serial.printf("SHTC3: %s | VEML7700: %s | INA226: %s\n",
+                shtc3_ok ? "OK" : "FAIL",
+                veml_ok ? "OK" : "FAIL",
+                ina_ok ? "OK" : "FAIL");
+#endif
+}
+
+#ifdef USAR_COLA_I2C
+// --- LECTURA I2C ENCOLADA ---
+// La cola intercala los tres sensores en un mismo bus: va a la velocidad del más lento
+void usarVelocidadComunI2C()
+{
+  uint32_t hz = velocidadI2C(DISP_SHTC3);
+  hz = min(hz, velocidadI2C(DISP_VEML7700));
+  hz = min(hz, velocidadI2C(DISP_INA226));
+  dispositivoActivoI2C[BUS_INA226] = -1; // los fallos se atribuyen por transacción
+  if (relojBusHz[BUS_INA226] != hz)
+  {
+    WIRE_I2C(BUS_INA226).setClock(hz);
+    relojBusHz[BUS_INA226] = hz;
+  }
+}
+
+// Un fallo de una lectura encolada: de CRC si los datos llegaron, si no de bus
+void registrarFalloEnCola(uint8_t disp, const LecturaI2C &lectura)
+{
+  if (lectura.errorDatos())
+    registrarErrorCRCI2C(disp);
+  else
+    registrarErrorBusI2C(disp);
+}
+
+// Reintenta una vez las lecturas fallidas (bus o CRC), tras el gancho de recuperación del
+// bus. Solo un error de bus baja un escalón al dispositivo que falló: la cola va a la
+// velocidad del más lento, y un CRC malo no dice nada del reloj.
+void reintentarEnCola(LecturaI2C **lecturas, const uint8_t *disps, int n)
+{
+  bool reintento = false;
+  for (int i = 0; i < n; i++)
+  {
+    if (lecturas[i]->valida())
+      continue;
+    registrarFalloEnCola(disps[i], *lecturas[i]);
+    SUMAR_SATURADO(diagnosticoI2C.dispositivos[disps[i]].reintentos);
+    if (!reintento && !reintentarTransferenciaI2C(&WIRE_I2C(BUS_INA226)))
+      return;
+    reintento = true;
+    if (!lecturas[i]->errorDatos())
+      bajarVelocidadI2C(disps[i]);
+    colaI2C.enviar(lecturas[i]->transaccion);
+  }
+  if (!reintento)
+    return;
+  usarVelocidadComunI2C();
+  colaI2C.ejecutarTodo();
+  for (int i = 0; i < n; i++)
+    if (!lecturas[i]->valida())
+    {
+      registrarFalloEnCola(disps[i], *lecturas[i]);
+      SUMAR_CONTADOR_I2C(estadisticasI2C.reintentosFallidos);
+    }
+}
+
+// Las tres lecturas se encolan juntas: INA226 y el registro ALS del VEML7700 se leen
+// mientras el SHTC3 convierte, y la cola duerme hasta que termina la integración del VEML.
+void leerSensoresEnCola(SensorData &data)
+{
+  // Misma espera que readLux(): dos integraciones desde la configuración
+  unsigned long desdeConfig = millis() - vemlConfiguradoMs;
+  unsigned long integracionMs = msIntegracionVeml(ajustes.integracionVeml);
+  uint32_t esperaVemlUs = desdeConfig < 2 * integracionMs ? (2 * integracionMs - desdeConfig) * 1000 : 0;
+
+  LecturaShtc3 lecturaShtc3;
+  LecturaIna226 lecturaIna;
+  LecturaVeml7700 lecturaVeml(esperaVemlUs);
+
+  LecturaI2C *enviadas[NUM_DISP_I2C] = {};
+  uint8_t disps[NUM_DISP_I2C] = {};
+  int n = 0;
+  if (shtc3_ok)
+  {
+    disps[n] = DISP_SHTC3;
+    enviadas[n++] = &lecturaShtc3;
+  }
+  if (ina_ok)
+  {
+    disps[n] = DISP_INA226;
+    enviadas[n++] = &lecturaIna;
+  }
+  if (veml_ok)
+  {
+    disps[n] = DISP_VEML7700;
+    enviadas[n++] = &lecturaVeml;
+  }
+  usarVelocidadComunI2C();
+  for (int i = 0; i < n; i++)
+    colaI2C.enviar(enviadas[i]->transaccion);
+  colaI2C.ejecutarTodo();
+  lecturaVeml.fijarEspera(0); // en un reintento la integración ya ha terminado
+  reintentarEnCola(enviadas, disps, n);
+
+  // La latencia de cada lectura es la de su transacción en la cola, esperas incluidas
+  for (int i = 0; i < n; i++)
+  {
+    diagnosticoI2C.dispositivos[disps[i]].transacciones++;
+    inicioOperacionI2CUs[disps[i]] = micros() - enviadas[i]->transaccion.duracionUs;
+    terminarOperacionI2C(disps[i]);
+  }
+
+  // Una lectura que no se envió nunca no es válida
+  bool shtc3Valida = lecturaShtc3.valida();
+  data.temp = shtc3Valida ? lecturaShtc3.temperatura() : -99.0;
+  data.humAir = shtc3Valida ? lecturaShtc3.humedad() : -1.0;
+  data.batt = lecturaIna.valida() ? lecturaIna.tensionBus() : -1.0;
+  data.lux = lecturaVeml.valida() ? lecturaVeml.cuentas() * luxPorCuentaVeml() : -1.0;
+
+#ifdef DEBUG_SERIAL
+  const EstadisticasColaI2C &e = colaI2C.estadisticas();
+  Serial.printf("[COLA I2C] %u transacciones, %u segmentos, %u errores | bus %u us de %u us (%.1f %%), %u us cedidos\n",
+                e.transacciones, e.segmentos, e.errores, e.ocupadoUs, e.ejecucionUs,
+                colaI2C.utilizacion() * 100, e.dormidoUs);
+#endif
+}
+#endif
+
+#ifndef USAR_COLA_I2C
+// --- INA226 --- Una lectura suelta (getLastError() también limpia el error); -1 si falla
+float leerTensionINA()
+{
+  if (!ina_ok)
+    return -1.0;
+  iniciarOperacionI2C(DISP_INA226);
+  float v = ina.getBusVoltage();
+  if (ina.getLastError() != 0)
+  {
+    registrarErrorBusI2C(DISP_INA226);
+    if (reintentarFalloContadoI2C(DISP_INA226, false))
+    {
+      v = ina.getBusVoltage();
+      if (ina.getLastError() != 0)
+      {
+        registrarErrorBusI2C(DISP_INA226);
+        SUMAR_CONTADOR_I2C(estadisticasI2C.reintentosFallidos);
+        v = -1.0;
+      }
+    }
+  }
+  terminarOperacionI2C(DISP_INA226);
+  return v;
+}
+#endif
+
+#if INA226_EN_BUS_PROPIO
+// --- REGISTRO DEL COSECHADOR EN BUS PROPIO ---
+// Con el INA226 solo en su controlador, una tarea en el otro núcleo lo muestrea durante
+// toda la adquisición mientras SHTC3 y VEML7700 convierten (con clock stretching) en el
+// otro bus. batt pasa a ser la media de la ventana en vez de una lectura suelta.
+// La tarea solo escribe la ventana; terminarRegistroINA() la suma a diagnosticoI2C.cosecha
+// tras la espera, así que el registro viaja con el diagnóstico y pasa por NVS con él.
+// Si la tarea no se puede crear, batt sale de una lectura suelta como con el bus compartido.
+#define INA_PERIODO_REGISTRO_MS 5
+
+// Ventana del despertar actual
+uint32_t muestrasVentanaINA = 0;
+uint32_t erroresVentanaINA = 0;
+float sumaTensionINA = 0;
+double cargaVentanaMC = 0;
+float picoVentanaMA = 0;
+bool registroINAEnTarea = false;
+volatile bool detenerRegistroINA = false;
+SemaphoreHandle_t finRegistroINA = NULL;
+StaticSemaphore_t bufferFinRegistroINA;
+
+void tareaRegistroINA(void *)
+{
+  TickType_t siguiente = xTaskGetTickCount();
+  uint32_t anteriorUs = micros();
+  while (!detenerRegistroINA)
+  {
+    iniciarOperacionI2C(DISP_INA226);
+    float v = ina.getBusVoltage();
+    float ma = ina.getCurrent_mA();
+    bool correcta = ina.getLastError() == 0;
+    terminarOperacionI2C(DISP_INA226);
+    if (correcta)
+    {
+      uint32_t ahoraUs = micros();
+      cargaVentanaMC += ma * (ahoraUs - anteriorUs) * 1e-6;
+      anteriorUs = ahoraUs;
+      if (ma > picoVentanaMA)
+        picoVentanaMA = ma;
+      muestrasVentanaINA++;
+      sumaTensionINA += v;
+    }
+    else
+    {
+      erroresVentanaINA++;
+      registrarErrorBusI2C(DISP_INA226);
+      reintentarFalloContadoI2C(DISP_INA226, false);
+    }
+    vTaskDelayUntil(&siguiente, pdMS_TO_TICKS(INA_PERIODO_REGISTRO_MS));
+  }
+  xSemaphoreGive(finRegistroINA);
+  vTaskDelete(NULL);
+}
+
+void iniciarRegistroINA()
+{
+  if (!ina_ok)
+    return;
+  if (finRegistroINA == NULL)
+    finRegistroINA = xSemaphoreCreateBinaryStatic(&bufferFinRegistroINA);
+  muestrasVentanaINA = 0;
+  erroresVentanaINA = 0;
+  sumaTensionINA = 0;
+  cargaVentanaMC = 0;
+  picoVentanaMA = 0;
+  detenerRegistroINA = false;
+  // Núcleo 0: el bucle de Arduino (SHTC3/VEML7700) corre en el 1
+  registroINAEnTarea = finRegistroINA != NULL &&
+                       xTaskCreatePinnedToCore(tareaRegistroINA, "registroINA", 3072, NULL, 2, NULL, 0) == pdPASS;
+#ifdef DEBUG_SERIAL
+  if (!registroINAEnTarea)
+    Serial.println("[COSECHA] sin tarea de registro: lectura suelta del INA226");
+#endif
+}
+
+// Devuelve la tensión media de la ventana, -1 si no hubo ninguna muestra válida
+float terminarRegistroINA()
+{
+  if (!ina_ok)
+    return -1.0;
+  if (!registroINAEnTarea)
+    return leerTensionINA();
+  detenerRegistroINA = true;
+  xSemaphoreTake(finRegistroINA, portMAX_DELAY);
+
+  CosechaINA226 &c = diagnosticoI2C.cosecha;
+  c.muestras += muestrasVentanaINA;
+  c.errores += erroresVentanaINA;
+  c.cargaMC += cargaVentanaMC;
+  if (picoVentanaMA > c.corrienteMaxMA)
+    c.corrienteMaxMA = picoVentanaMA;
+#ifdef DEBUG_SERIAL
+  Serial.printf("[COSECHA] %lu muestras en esta ventana | total %lu (%lu errores), %.2f mA·s, pico %.2f mA\n",
+                (unsigned long)muestrasVentanaINA, (unsigned long)c.muestras, (unsigned long)c.errores, c.cargaMC,
+                c.corrienteMaxMA);
+#endif
+  return muestrasVentanaINA > 0 ? sumaTensionINA / muestrasVentanaINA : -1.0;
+}
+#endif
+
+#ifndef USAR_COLA_I2C
+// update() devuelve Nominal aunque el CRC no cuadre: solo marca passTcrc/passRHcrc
+SHTC3_Status_TypeDef medirSHTC3()
+{
+  SHTC3_Status_TypeDef estado = shtc3.update();
+  if (estado == SHTC3_Status_Nominal && !(shtc3.passTcrc && shtc3.passRHcrc))
+    estado = SHTC3_Status_CRC_Fail;
+  return estado;
+}
+#endif
+
+// Orden pensado para solapar esperas: el sensor de suelo se alimenta primero y el
+// VEML7700 se lee el último, porque readLux() espera 2 × integración desde su begin().
+SensorData leerSensores()
+{
+  SensorData data;
+  primeraMuestraUs = relojUs();
+  data.tiempoS = relojNodoS();
+
+  activarSalida(EN_SKU, true);
+  unsigned long inicioSuelo = millis();
+#if INA226_EN_BUS_PROPIO
+  iniciarRegistroINA();
+#endif
+
+#ifdef USAR_COLA_I2C
+  leerSensoresEnCola(data);
+#else
+  // --- SHTC3 (SparkFun) ---
+  SHTC3_Status_TypeDef estadoShtc3 = SHTC3_Status_Error;
+  if (shtc3_ok)
+  {
+    iniciarOperacionI2C(DISP_SHTC3);
+    estadoShtc3 = medirSHTC3();
+    if (estadoShtc3 != SHTC3_Status_Nominal)
+    {
+      registrarFalloSHTC3(estadoShtc3);
+      if (reintentarFalloContadoI2C(DISP_SHTC3, estadoShtc3 == SHTC3_Status_CRC_Fail))
+      {
+        estadoShtc3 = medirSHTC3();
+        if (estadoShtc3 != SHTC3_Status_Nominal)
+        {
+          registrarFalloSHTC3(estadoShtc3);
+          SUMAR_CONTADOR_I2C(estadisticasI2C.reintentosFallidos);
+        }
+      }
+    }
+    terminarOperacionI2C(DISP_SHTC3);
+  }
+  if (estadoShtc3 == SHTC3_Status_Nominal)
+  {
+    data.temp = shtc3.toDegC();
+    data.humAir = shtc3.toPercent();
+  }
+  else
+  {
+    data.temp = -99.0;
+    data.humAir = -1.0;
+  }
+
+#if !INA226_EN_BUS_PROPIO
+  data.batt = leerTensionINA();
+#endif
+
+  // --- VEML7700 ---
+  data.lux = -1.0;
+  if (veml_ok)
+  {
+    // Los fallos de BusIO los cuenta el gancho de recuperación
+    iniciarOperacionI2C(DISP_VEML7700);
+    data.lux = veml.readLux();
+    terminarOperacionI2C(DISP_VEML7700);
+  }
+#endif
+
+  // --- Humedad del suelo: solo se espera lo que falte del calentamiento
+  unsigned long transcurrido = millis() - inicioSuelo;
+  if (transcurrido < T_CALENTAMIENTO_SUELO_MS)
+    delay(T_CALENTAMIENTO_SUELO_MS - transcurrido);
+  data.humSoil = leerADC(A_IN_SKU);
+  activarSalida(EN_SKU, false);
+
+#if INA226_EN_BUS_PROPIO
+  data.batt = terminarRegistroINA();
+#endif
+  cerrarCicloVelocidadI2C();
+  return data;
+}
@@ -0,0 +1,108 @@
+// Adquisición de los sensores I2C y del sensor de suelo: buses, velocidad por
+// dispositivo, recuperación, salud del bus y lectura de un registro completo.
+
+#ifndef SENSORES_H
+#define SENSORES_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "placa.h"
+#include "hal.h"
+
+#define T_CALENTAMIENTO_SUELO_MS 100
+
+// La ganancia y la integración del VEML7700 son ajustes remotos (src/ajustes.h): la
+// resolución de cada cuenta la da luxPorCuentaVeml()
+
+// Tal como se guarda y se envía (24 bytes). tiempoS es relojNodoS() al medir en el almacén
+// y, en los paquetes que salen, los segundos desde la medida: el gateway sitúa cada registro
+// respecto a la llegada sin conocer el reloj del nodo.
+struct SensorData
+{
+  float temp;
+  float humAir;
+  float humSoil;
+  float lux;
+  float batt;
+  uint32_t tiempoS;
+};
+
+#define EDAD_DESCONOCIDA UINT32_MAX // registro medido antes de un corte de alimentación
+
+enum DispositivoI2C
+{
+  DISP_SHTC3,
+  DISP_VEML7700,
+  DISP_INA226,
+  NUM_DISP_I2C
+};
+
+// Contadores en RTC de cuántas veces hizo falta recuperar o reintentar
+struct EstadisticasBusI2C
+{
+  uint32_t arranquesComprobados;
+  uint32_t recuperacionesArranque;
+  uint32_t recuperacionesEjecucion;
+  uint32_t reintentos;
+  uint32_t reintentosFallidos;
+};
+
+// --- SALUD DEL BUS I2C ---
+#define VERSION_DIAG_I2C 2
+#define NUM_CUBETAS_LATENCIA 8
+#define LATENCIA_BASE_US 256 // cubeta 0: < 256 us; cubeta i: [256·2^(i-1), 256·2^i); la última, el resto
+
+struct __attribute__((packed)) SaludDispositivoI2C
+{
+  uint8_t direccion;
+  uint8_t reservado;
+  uint32_t transacciones;
+  uint16_t nacks; // fallos de bus: NACK, timeout o arbitraje
+  uint16_t erroresCRC;
+  uint16_t reintentos;
+  uint16_t recuperaciones; // SDA retenida liberada con pulsos de SCL
+  uint16_t latencia[NUM_CUBETAS_LATENCIA];
+};
+
+// Registro del cosechador: el INA226 muestreado durante la adquisición cuando va en su
+// propio bus (INA226_EN_BUS_PROPIO); a cero si comparte bus con los demás
+struct __attribute__((packed)) CosechaINA226
+{
+  uint32_t muestras;
+  uint32_t errores;
+  float cargaMC; // carga acumulada por el shunt, mA·s
+  float corrienteMaxMA;
+};
+
+// Registro de diagnóstico tal como viaja por BLE (little-endian, 112 bytes)
+struct __attribute__((packed)) DiagnosticoI2C
+{
+  uint8_t version;
+  uint8_t numDispositivos;
+  uint16_t secuencia; // drenajes con diagnóstico desde el primer arranque
+  uint16_t bajadasVelocidad;
+  SaludDispositivoI2C dispositivos[NUM_DISP_I2C];
+  CosechaINA226 cosecha;
+};
+
+extern RAM_NODO bool shtc3_ok;
+extern RAM_NODO bool veml_ok;
+extern RAM_NODO bool ina_ok;
+
+extern const char *const NOMBRE_DISP_I2C[NUM_DISP_I2C];
+extern RAM_NODO uint32_t bajadasVelocidadI2C;
+extern RAM_NODO EstadisticasBusI2C estadisticasI2C;
+extern RAM_NODO DiagnosticoI2C diagnosticoI2C;
+extern RAM_NODO uint32_t primeraMuestraUs; // desde el arranque de la app (no incluye ROM ni bootloader)
+
+void cargarDiagnosticoI2C();
+void guardarDiagnosticoI2C(); // antes de reiniciarNodo()
+void comprobarBusI2CArranque();
+void iniciarBusesI2C();
+void terminarBusesI2C();
+uint32_t velocidadI2C(uint8_t disp);
+
+void iniciarSensores();
+SensorData leerSensores();
+
+#endif
@@ -0,0 +1,57 @@
+// Ejecuta el programa del ULP contra la plataforma simulada.
+//   cc -I.. -o sim_ulp main_host.c sim_ulp.c ../muestreo_ulp.c && ./sim_ulp [ciclos]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim_ulp.h"
+
+int main(int argc, char **argv)
+{
+  int ciclos = argc > 1 ? atoi(argv[1]) : 40;
+  sim_ulp_t sim;
+  sim_ulp_iniciar(&sim);
+  plataforma_ulp_t p = sim_ulp_plataforma(&sim);
+
+  estado_ulp_t estado = {0};
+  estado.firma = ULP_FIRMA;
+  estado.ciclos_hasta_drenaje = 10;
+  int despertares = 0;
+
+  for (int c = 0; c < ciclos; c++)
+  {
+    if (c == 25)
+      sim.shtc3_corromper_crc = 1;
+    if (c == 28)
+      sim.shtc3_corromper_crc = 0;
+
+    uint64_t t0 = sim.tiempo_us;
+    uint32_t motivo = muestreo_paso(&estado, &p);
+    uint64_t activo = sim.tiempo_us - t0;
+
+    if (motivo != ULP_MOTIVO_NINGUNO)
+    {
+      // Lo que haría el núcleo principal: vaciar el buffer y programar el próximo drenaje
+      despertares++;
+      printf("ciclo %3d: despertar (%s) con %lu registros, ULP activo %llu us\n", c,
+             motivo == ULP_MOTIVO_BUFFER_LLENO ? "buffer lleno" : "drenaje",
+             (unsigned long)estado.num_registros, (unsigned long long)activo);
+      for (uint32_t i = 0; i < estado.num_registros; i++)
+      {
+        const registro_ulp_t *r = &estado.buffer[i];
+        printf("    T=%6.2f HR=%5.1f ALS=%5u Vbus=%5.3f suelo=%4u fallos=0x%02x\n",
+               -45.0 + 175.0 * r->temp / 65536.0, 100.0 * r->hum / 65536.0, r->als,
+               r->vbus * 0.00125, r->suelo, r->fallos);
+      }
+      estado.num_registros = 0;
+      estado.ciclos_hasta_drenaje = 10;
+    }
+    sim.tiempo_us += 6000000; // ciclo de medida
+  }
+
+  printf("%d ciclos, %d despertares del núcleo principal, %lu transacciones I2C, "
+         "%lu errores CRC, %lu errores I2C, %lu lecturas de suelo sin calentar\n",
+         ciclos, despertares, (unsigned long)sim.transacciones, (unsigned long)estado.errores_crc,
+         (unsigned long)estado.errores_i2c, (unsigned long)sim.lecturas_suelo_frias);
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include "sim_ulp.h"
+
+#include <string.h>
+
+void sim_ulp_iniciar(sim_ulp_t *sim)
+{
+  memset(sim, 0, sizeof(*sim));
+  sim->shtc3_presente = 1;
+  sim->veml_presente = 1;
+  sim->ina_presente = 1;
+  sim->shtc3_temp = 0x6666; // ~25 ºC
+  sim->shtc3_hum = 0x8000;  // 50 %HR
+  sim->veml_regs[ULP_VEML7700_REG_ALS] = 5000;
+  sim->ina_regs[ULP_INA226_REG_BUS] = 3000; // 3.75 V
+  sim->adc_suelo = 1800;
+}
+
+static int i2c_shtc3(sim_ulp_t *sim, const uint8_t *esc, uint8_t n_esc, uint8_t *lee, uint8_t n_lee)
+{
+  if (n_esc == 2)
+  {
+    uint16_t cmd = (uint16_t)((esc[0] << 8) | esc[1]);
+    if (cmd == ULP_SHTC3_CMD_WAKE)
+    {
+      sim->shtc3_despierto = 1;
+      return 0;
+    }
+    if (!sim->shtc3_despierto)
+      return -1; // dormido: solo responde a WAKE
+    if (cmd == ULP_SHTC3_CMD_SLEEP)
+      sim->shtc3_despierto = 0;
+    else if (cmd == ULP_SHTC3_CMD_MEDIR)
+      sim->shtc3_listo_us = sim->tiempo_us + ULP_SHTC3_T_MEDIDA_US;
+    else
+      return -1;
+  }
+
+  if (n_lee > 0)
+  {
+    // En modo polling el sensor hace NACK mientras convierte
+    if (!sim->shtc3_despierto || sim->tiempo_us < sim->shtc3_listo_us || n_lee != 6)
+      return -1;
+    lee[0] = (uint8_t)(sim->shtc3_temp >> 8);
+    lee[1] = (uint8_t)sim->shtc3_temp;
+    lee[2] = muestreo_crc8(&lee[0], 2);
+    lee[3] = (uint8_t)(sim->shtc3_hum >> 8);
+    lee[4] = (uint8_t)sim->shtc3_hum;
+    lee[5] = muestreo_crc8(&lee[3], 2);
+    if (sim->shtc3_corromper_crc)
+      lee[5] ^= 0x01;
+  }
+  return 0;
+}
+
+static int i2c_veml(sim_ulp_t *sim, const uint8_t *esc, uint8_t n_esc, uint8_t *lee, uint8_t n_lee)
+{
+  // El VEML7700 exige código de comando antes de cada lectura
+  if (n_esc < 1 || esc[0] > 7)
+    return -1;
+  if (n_esc == 3)
+    sim->veml_regs[esc[0]] = (uint16_t)(esc[1] | (esc[2] << 8));
+  if (n_lee == 2)
+  {
+    lee[0] = (uint8_t)sim->veml_regs[esc[0]];
+    lee[1] = (uint8_t)(sim->veml_regs[esc[0]] >> 8);
+  }
+  return 0;
+}
+
+static int i2c_ina(sim_ulp_t *sim, const uint8_t *esc, uint8_t n_esc, uint8_t *lee, uint8_t n_lee)
+{
+  if (n_esc >= 1)
+  {
+    if (esc[0] > 7)
+      return -1;
+    sim->ina_puntero = esc[0];
+  }
+  if (n_esc == 3)
+    sim->ina_regs[sim->ina_puntero] = (uint16_t)((esc[1] << 8) | esc[2]);
+  if (n_lee == 2)
+  {
+    lee[0] = (uint8_t)(sim->ina_regs[sim->ina_puntero] >> 8);
+    lee[1] = (uint8_t)sim->ina_regs[sim->ina_puntero];
+  }
+  return 0;
+}
+
+static int i2c_escribir_leer(void *ctx, uint8_t dir, const uint8_t *esc, uint8_t n_esc, uint8_t *lee, uint8_t n_lee)
+{
+  sim_ulp_t *sim = (sim_ulp_t *)ctx;
+  sim->transacciones++;
+  // Coste aproximado a 100 kHz: 9 bits por byte más dirección
+  sim->tiempo_us += (uint64_t)(n_esc + n_lee + 2) * 90;
+
+  if (dir == ULP_DIR_SHTC3 && sim->shtc3_presente)
+    return i2c_shtc3(sim, esc, n_esc, lee, n_lee);
+  if (dir == ULP_DIR_VEML7700 && sim->veml_presente)
+    return i2c_veml(sim, esc, n_esc, lee, n_lee);
+  if (dir == ULP_DIR_INA226 && sim->ina_presente)
+    return i2c_ina(sim, esc, n_esc, lee, n_lee);
+  return -1;
+}
+
+static void gpio_nivel(void *ctx, int pin, int nivel)
+{
+  sim_ulp_t *sim = (sim_ulp_t *)ctx;
+  if (pin == ULP_PIN_EN_SUELO && nivel && !sim->gpio[pin])
+    sim->suelo_on_us = sim->tiempo_us;
+  sim->gpio[pin] = nivel;
+}
+
+static uint16_t adc_leer(void *ctx)
+{
+  sim_ulp_t *sim = (sim_ulp_t *)ctx;
+  if (!sim->gpio[ULP_PIN_EN_SUELO])
+    return 0;
+  if (sim->tiempo_us - sim->suelo_on_us < ULP_T_CALENTAMIENTO_SUELO_US)
+    sim->lecturas_suelo_frias++;
+  return sim->adc_suelo;
+}
+
+static void esperar_us(void *ctx, uint32_t us)
+{
+  ((sim_ulp_t *)ctx)->tiempo_us += us;
+}
+
+plataforma_ulp_t sim_ulp_plataforma(sim_ulp_t *sim)
+{
+  plataforma_ulp_t p = {i2c_escribir_leer, gpio_nivel, adc_leer, esperar_us, sim};
+  return p;
+}
@@ -0,0 +1,39 @@
+// Plataforma del ULP simulada en el host: mapa de registros de SHTC3, VEML7700 e
+// INA226, GPIO y ADC, con tiempo virtual. Permite ejecutar muestreo_ulp.c con gcc.
+
+#ifndef SIM_ULP_H
+#define SIM_ULP_H
+
+#include "../muestreo_ulp.h"
+
+typedef struct
+{
+  uint64_t tiempo_us;
+  uint32_t transacciones;
+
+  // SHTC3
+  int shtc3_presente;
+  int shtc3_despierto;
+  uint64_t shtc3_listo_us; // instante en que termina la conversión
+  uint16_t shtc3_temp;
+  uint16_t shtc3_hum;
+  int shtc3_corromper_crc;
+
+  // VEML7700 e INA226: registros de 16 bits direccionados por puntero
+  int veml_presente;
+  uint16_t veml_regs[8];
+  int ina_presente;
+  uint8_t ina_puntero;
+  uint16_t ina_regs[8];
+
+  // Suelo: la lectura solo es válida con el sensor alimentado el tiempo suficiente
+  int gpio[48];
+  uint64_t suelo_on_us;
+  uint16_t adc_suelo;
+  uint32_t lecturas_suelo_frias;
+} sim_ulp_t;
+
+void sim_ulp_iniciar(sim_ulp_t *sim);
+plataforma_ulp_t sim_ulp_plataforma(sim_ulp_t *sim);
+
+#endif
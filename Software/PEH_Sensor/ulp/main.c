@@ -0,0 +1,22 @@
+// Programa del ULP RISC-V. En env:esp32-s3-ulp (framework = arduino, espidf, con ESP-IDF
+// >= 5.1 por la API de ADC del ULP) PlatformIO compila los .c de este directorio con el
+// toolchain del ULP y los embebe en la app como ulp_main (ulp_main.h); host/ queda fuera:
+//
+//   pio run -e esp32-s3-ulp
+// El temporizador del ULP lo ejecuta una vez por ciclo de medida; al volver de main()
+// el coprocesador se detiene hasta el siguiente disparo.
+
+#include "ulp_riscv_utils.h"
+#include "muestreo_ulp.h"
+
+extern const plataforma_ulp_t plataforma_riscv;
+
+// Exportado al núcleo principal como ulp_estado
+estado_ulp_t estado = {.firma = ULP_FIRMA};
+
+int main(void)
+{
+  if (muestreo_paso(&estado, &plataforma_riscv) != ULP_MOTIVO_NINGUNO)
+    ulp_riscv_wakeup_main_processor();
+  return 0;
+}
@@ -0,0 +1,107 @@
+#include "muestreo_ulp.h"
+
+// CRC-8 del SHTC3: polinomio 0x31, valor inicial 0xFF
+uint8_t muestreo_crc8(const uint8_t *datos, int n)
+{
+  uint8_t crc = 0xFF;
+  for (int i = 0; i < n; i++)
+  {
+    crc ^= datos[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+static int comando_shtc3(const plataforma_ulp_t *p, uint16_t cmd)
+{
+  uint8_t buf[2] = {(uint8_t)(cmd >> 8), (uint8_t)cmd};
+  return p->i2c_escribir_leer(p->ctx, ULP_DIR_SHTC3, buf, 2, 0, 0);
+}
+
+static uint16_t leer_shtc3(estado_ulp_t *e, const plataforma_ulp_t *p, registro_ulp_t *r)
+{
+  uint8_t d[6];
+
+  int err = comando_shtc3(p, ULP_SHTC3_CMD_WAKE);
+  if (err == 0)
+  {
+    p->esperar_us(p->ctx, ULP_SHTC3_T_DESPERTAR_US);
+    err = comando_shtc3(p, ULP_SHTC3_CMD_MEDIR);
+  }
+  if (err == 0)
+  {
+    p->esperar_us(p->ctx, ULP_SHTC3_T_MEDIDA_US);
+    err = p->i2c_escribir_leer(p->ctx, ULP_DIR_SHTC3, 0, 0, d, 6);
+    comando_shtc3(p, ULP_SHTC3_CMD_SLEEP);
+  }
+  if (err != 0)
+  {
+    e->errores_i2c++;
+    return ULP_FALLO_SHTC3;
+  }
+
+  if (muestreo_crc8(&d[0], 2) != d[2] || muestreo_crc8(&d[3], 2) != d[5])
+  {
+    e->errores_crc++;
+    return ULP_FALLO_SHTC3 | ULP_FALLO_CRC;
+  }
+
+  r->temp = (uint16_t)((d[0] << 8) | d[1]);
+  r->hum = (uint16_t)((d[3] << 8) | d[4]);
+  return 0;
+}
+
+static int leer_registro16(const plataforma_ulp_t *p, uint8_t dir, uint8_t reg, int big_endian, uint16_t *valor)
+{
+  uint8_t d[2];
+  if (p->i2c_escribir_leer(p->ctx, dir, &reg, 1, d, 2) != 0)
+    return -1;
+  *valor = big_endian ? (uint16_t)((d[0] << 8) | d[1]) : (uint16_t)((d[1] << 8) | d[0]);
+  return 0;
+}
+
+uint32_t muestreo_paso(estado_ulp_t *e, const plataforma_ulp_t *p)
+{
+  registro_ulp_t r = {0, 0, 0, 0, 0, 0};
+
+  // El sensor de suelo se alimenta primero para que su calentamiento se solape con el I2C
+  p->gpio_nivel(p->ctx, ULP_PIN_EN_SUELO, 1);
+
+  r.fallos |= leer_shtc3(e, p, &r);
+
+  // VEML7700 en modo ahorro: se lee la última integración, la configuración la deja el núcleo principal
+  if (leer_registro16(p, ULP_DIR_VEML7700, ULP_VEML7700_REG_ALS, 0, &r.als) != 0)
+  {
+    r.fallos |= ULP_FALLO_VEML7700;
+    e->errores_i2c++;
+  }
+
+  // Los registros del INA226 son big-endian, los del VEML7700 little-endian
+  if (leer_registro16(p, ULP_DIR_INA226, ULP_INA226_REG_BUS, 1, &r.vbus) != 0)
+  {
+    r.fallos |= ULP_FALLO_INA226;
+    e->errores_i2c++;
+  }
+
+  // Lo que quede del calentamiento del sensor de suelo (el I2C ya consumió ~13 ms)
+  p->esperar_us(p->ctx, ULP_T_CALENTAMIENTO_SUELO_US - ULP_SHTC3_T_MEDIDA_US - ULP_SHTC3_T_DESPERTAR_US);
+  r.suelo = p->adc_leer(p->ctx);
+  p->gpio_nivel(p->ctx, ULP_PIN_EN_SUELO, 0);
+
+  if (e->num_registros < ULP_BUFFER_REGISTROS)
+    e->buffer[e->num_registros++] = r;
+  e->muestras++;
+
+  if (e->ciclos_hasta_drenaje > 0)
+    e->ciclos_hasta_drenaje--;
+
+  if (e->num_registros >= ULP_BUFFER_REGISTROS)
+    e->motivo_despertar = ULP_MOTIVO_BUFFER_LLENO;
+  else if (e->ciclos_hasta_drenaje == 0)
+    e->motivo_despertar = ULP_MOTIVO_DRENAJE;
+  else
+    e->motivo_despertar = ULP_MOTIVO_NINGUNO;
+
+  return e->motivo_despertar;
+}
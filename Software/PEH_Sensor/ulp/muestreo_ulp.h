@@ -0,0 +1,99 @@
+// Muestreo en el coprocesador ULP RISC-V del ESP32-S3.
+//
+// El ULP lee SHTC3, VEML7700, INA226 y la humedad del suelo mientras el núcleo
+// principal duerme, guarda registros en bruto en memoria RTC y solo despierta al
+// núcleo principal cuando el buffer se llena o toca drenar por BLE.
+//
+// La lógica es C plano sin dependencias del SDK: todo el acceso al hardware pasa
+// por plataforma_ulp_t, que en el ULP es I2C bit-bang sobre RTC GPIO y en el host
+// un mapa de registros simulado (ver host/).
+
+#ifndef MUESTREO_ULP_H
+#define MUESTREO_ULP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ULP_BUFFER_REGISTROS 16
+#define ULP_FIRMA 0x50454855 // "PEHU": el programa ULP está cargado y su estado es válido
+
+// Pines (deben coincidir con main.cpp; todos son RTC GPIO en el S3)
+#define ULP_PIN_SDA 4
+#define ULP_PIN_SCL 5
+#define ULP_PIN_EN_SUELO 7
+
+#define ULP_DIR_SHTC3 0x70
+#define ULP_DIR_VEML7700 0x10
+#define ULP_DIR_INA226 0x40
+
+#define ULP_SHTC3_CMD_WAKE 0x3517
+#define ULP_SHTC3_CMD_SLEEP 0xB098
+#define ULP_SHTC3_CMD_MEDIR 0x7866 // polling, T primero, modo normal
+#define ULP_SHTC3_T_DESPERTAR_US 240
+#define ULP_SHTC3_T_MEDIDA_US 12100
+
+#define ULP_VEML7700_REG_ALS 0x04
+#define ULP_INA226_REG_BUS 0x02
+#define ULP_T_CALENTAMIENTO_SUELO_US 100000
+
+// Bits de registro_ulp_t.fallos
+#define ULP_FALLO_SHTC3 0x01
+#define ULP_FALLO_CRC 0x02
+#define ULP_FALLO_VEML7700 0x04
+#define ULP_FALLO_INA226 0x08
+
+// Motivo por el que el ULP despierta al núcleo principal
+#define ULP_MOTIVO_NINGUNO 0
+#define ULP_MOTIVO_BUFFER_LLENO 1
+#define ULP_MOTIVO_DRENAJE 2
+
+  // Valores en bruto: el ULP no usa coma flotante, la conversión la hace el núcleo principal
+  typedef struct
+  {
+    uint16_t temp;  // SHTC3, T = -45 + 175 * raw / 65536
+    uint16_t hum;   // SHTC3, RH = 100 * raw / 65536
+    uint16_t als;   // VEML7700 registro ALS
+    uint16_t vbus;  // INA226 registro bus, 1.25 mV/LSB
+    uint16_t suelo; // ADC1 12 bits
+    uint16_t fallos;
+  } registro_ulp_t;
+
+  // Estado compartido en memoria RTC; el núcleo principal lo ve como ulp_estado
+  typedef struct
+  {
+    uint32_t firma;
+    uint32_t num_registros;
+    uint32_t ciclos_hasta_drenaje; // lo fija el núcleo principal antes de dormir
+    uint32_t motivo_despertar;
+    uint32_t muestras;
+    uint32_t errores_i2c;
+    uint32_t errores_crc;
+    registro_ulp_t buffer[ULP_BUFFER_REGISTROS];
+  } estado_ulp_t;
+
+  typedef struct
+  {
+    // Escribe n_esc bytes y, si n_lee > 0, lee n_lee con repeated start. 0 = ACK en todo.
+    int (*i2c_escribir_leer)(void *ctx, uint8_t dir, const uint8_t *esc, uint8_t n_esc,
+                             uint8_t *lee, uint8_t n_lee);
+    void (*gpio_nivel)(void *ctx, int pin, int nivel);
+    uint16_t (*adc_leer)(void *ctx);
+    void (*esperar_us)(void *ctx, uint32_t us);
+    void *ctx;
+  } plataforma_ulp_t;
+
+  uint8_t muestreo_crc8(const uint8_t *datos, int n);
+
+  // Toma una muestra de todos los sensores y la añade al buffer.
+  // Devuelve el motivo para despertar al núcleo principal o ULP_MOTIVO_NINGUNO.
+  uint32_t muestreo_paso(estado_ulp_t *estado, const plataforma_ulp_t *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
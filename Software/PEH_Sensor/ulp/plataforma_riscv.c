@@ -0,0 +1,153 @@
+// Acceso al hardware desde el ULP RISC-V: I2C bit-bang sobre RTC GPIO (SDA/SCL en
+// GPIO4/5 no son los pines del RTC I2C del S3) y ADC1 para la humedad del suelo.
+
+#include "ulp_riscv_utils.h"
+#include "ulp_riscv_gpio.h"
+#include "ulp_riscv_adc_ulp_core.h"
+#include "muestreo_ulp.h"
+
+#define ADC_CANAL_SUELO ADC_CHANNEL_5 // GPIO6 = ADC1_CH5
+#define MEDIO_PERIODO_US 5            // ~100 kHz
+#define TIMEOUT_STRETCH_US 20000
+
+static void esperar_us(void *ctx, uint32_t us)
+{
+  (void)ctx;
+  ulp_riscv_delay_cycles(us * ULP_RISCV_CYCLES_PER_US);
+}
+
+// Colector abierto: soltar la línea = entrada (pull-up externo), bajar = salida a 0
+static void linea_suelta(int pin)
+{
+  ulp_riscv_gpio_output_disable((gpio_num_t)pin);
+  ulp_riscv_gpio_input_enable((gpio_num_t)pin);
+}
+
+static void linea_baja(int pin)
+{
+  ulp_riscv_gpio_output_level((gpio_num_t)pin, 0);
+  ulp_riscv_gpio_output_enable((gpio_num_t)pin);
+}
+
+static int scl_alto(void)
+{
+  linea_suelta(ULP_PIN_SCL);
+  for (uint32_t t = 0; t < TIMEOUT_STRETCH_US; t++)
+  {
+    if (ulp_riscv_gpio_get_level((gpio_num_t)ULP_PIN_SCL))
+      return 0;
+    esperar_us(0, 1);
+  }
+  return -1;
+}
+
+// -1 si SCL no sube (clock stretching sin fin) o un esclavo retiene SDA: sin start
+static int i2c_start(void)
+{
+  linea_suelta(ULP_PIN_SDA);
+  if (scl_alto() != 0)
+    return -1;
+  esperar_us(0, MEDIO_PERIODO_US);
+  if (!ulp_riscv_gpio_get_level((gpio_num_t)ULP_PIN_SDA))
+    return -1;
+  linea_baja(ULP_PIN_SDA);
+  esperar_us(0, MEDIO_PERIODO_US);
+  linea_baja(ULP_PIN_SCL);
+  return 0;
+}
+
+static int i2c_stop(void)
+{
+  linea_baja(ULP_PIN_SDA);
+  esperar_us(0, MEDIO_PERIODO_US);
+  int err = scl_alto();
+  esperar_us(0, MEDIO_PERIODO_US);
+  linea_suelta(ULP_PIN_SDA);
+  esperar_us(0, MEDIO_PERIODO_US);
+  return err;
+}
+
+static int i2c_bit(int bit)
+{
+  if (bit)
+    linea_suelta(ULP_PIN_SDA);
+  else
+    linea_baja(ULP_PIN_SDA);
+  esperar_us(0, MEDIO_PERIODO_US);
+  if (scl_alto() != 0)
+    return -1;
+  int leido = ulp_riscv_gpio_get_level((gpio_num_t)ULP_PIN_SDA);
+  esperar_us(0, MEDIO_PERIODO_US);
+  linea_baja(ULP_PIN_SCL);
+  return leido;
+}
+
+// Devuelve 0 si el esclavo hace ACK
+static int i2c_escribir_byte(uint8_t b)
+{
+  for (int i = 7; i >= 0; i--)
+    if (i2c_bit((b >> i) & 1) < 0)
+      return -1;
+  return i2c_bit(1) == 0 ? 0 : -1;
+}
+
+// Devuelve 0 si todos los bits se pudieron leer
+static int i2c_leer_byte(int ack, uint8_t *b)
+{
+  *b = 0;
+  for (int i = 0; i < 8; i++)
+  {
+    int bit = i2c_bit(1);
+    if (bit < 0)
+      return -1;
+    *b = (uint8_t)((*b << 1) | bit);
+  }
+  return i2c_bit(ack ? 0 : 1) < 0 ? -1 : 0;
+}
+
+static int i2c_escribir_leer(void *ctx, uint8_t dir, const uint8_t *esc, uint8_t n_esc, uint8_t *lee, uint8_t n_lee)
+{
+  (void)ctx;
+  int err = 0;
+
+  if (n_esc > 0)
+  {
+    err = i2c_start();
+    if (err == 0)
+      err = i2c_escribir_byte((uint8_t)(dir << 1));
+    for (uint8_t i = 0; i < n_esc && err == 0; i++)
+      err = i2c_escribir_byte(esc[i]);
+    if (err != 0 || n_lee == 0)
+      return i2c_stop() != 0 ? -1 : err;
+    linea_suelta(ULP_PIN_SDA);
+  }
+
+  // Start (o repeated start) para la lectura
+  err = i2c_start();
+  if (err == 0)
+    err = i2c_escribir_byte((uint8_t)((dir << 1) | 1));
+  for (uint8_t i = 0; i < n_lee && err == 0; i++)
+    err = i2c_leer_byte(i + 1 < n_lee, &lee[i]);
+  return i2c_stop() != 0 ? -1 : err;
+}
+
+static void gpio_nivel(void *ctx, int pin, int nivel)
+{
+  (void)ctx;
+  ulp_riscv_gpio_output_level((gpio_num_t)pin, nivel);
+}
+
+static uint16_t adc_leer(void *ctx)
+{
+  (void)ctx;
+  int32_t v = ulp_riscv_adc_read_channel(ADC_UNIT_1, ADC_CANAL_SUELO);
+  return v < 0 ? 0 : (uint16_t)v;
+}
+
+const plataforma_ulp_t plataforma_riscv = {
+    i2c_escribir_leer,
+    gpio_nivel,
+    adc_leer,
+    esperar_us,
+    0,
+};